@@ -0,0 +1,76 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "vm/vm.h"
+#include "vm/cp0.h"
+#include "vm/opctable.h"
+#include "fift/utils.h"
+
+#include "td/utils/benchmark.h"
+#include "td/utils/logging.h"
+
+namespace {
+// a loop jumping between a few code cells, like the main loop of a typical smart contract
+const char* const loop_code = R"A(
+0 INT
+1000 INT
+REPEAT:<{
+  CONT:<{ 3 INT ADD }>
+  EXECUTE
+  DUP 7 INT MOD
+  IFNOT:<{ INC }>
+  DUP 1 LSHIFT# 2 INT DIV
+  SWAP DROP
+}>
+)A";
+
+class RunVmBench : public td::Benchmark {
+ public:
+  explicit RunVmBench(bool decode_cache) : decode_cache_(decode_cache) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << "TVM loop, decode cache " << (decode_cache_ ? "on" : "off");
+  }
+  void start_up() override {
+    vm::init_op_cp0();
+    code_ = fift::compile_asm(td::Slice(loop_code)).move_as_ok();
+    vm::OpcodeTable::enable_decode_cache(decode_cache_);
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      vm::Stack stack;
+      vm::GasLimits gas_limits{1000000};
+      CHECK(vm::run_vm_code(vm::load_cell_slice_ref(code_), stack, 0, nullptr, {}, nullptr, &gas_limits) == 0);
+    }
+  }
+  void tear_down() override {
+    vm::OpcodeTable::enable_decode_cache(false);
+  }
+
+ private:
+  bool decode_cache_;
+  td::Ref<vm::Cell> code_;
+};
+}  // namespace
+
+int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  bench(RunVmBench(false));
+  bench(RunVmBench(true));
+  return 0;
+}
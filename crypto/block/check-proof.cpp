@@ -158,58 +158,73 @@ td::Status check_shard_proof(ton::BlockIdExt blk, ton::BlockIdExt shard_blk, td:
   return td::Status::OK();
 }
 
+namespace {
+td::Status check_shard_account(vm::AugmentedDictionary& accounts_dict, const block::StdAddress& addr,
+                               const td::Ref<vm::Cell>& root, ton::LogicalTime* last_trans_lt,
+                               ton::Bits256* last_trans_hash) {
+  auto acc_csr = accounts_dict.lookup(addr.addr);
+  if (acc_csr.not_null()) {
+    if (root.is_null()) {
+      return td::Status::Error(PSLICE() << "account state proof shows that account state for " << addr
+                                        << " must be non-empty, but it actually is empty");
+    }
+    block::gen::ShardAccount::Record acc_info;
+    if (!tlb::csr_unpack(std::move(acc_csr), acc_info)) {
+      return td::Status::Error("cannot unpack ShardAccount from proof");
+    }
+    if (acc_info.account->get_hash().bits().compare(root->get_hash().bits(), 256)) {
+      return td::Status::Error(PSLICE() << "account state hash mismatch: Merkle proof expects "
+                                        << acc_info.account->get_hash().bits().to_hex(256)
+                                        << " but received data has " << root->get_hash().bits().to_hex(256));
+    }
+    if (last_trans_hash) {
+      *last_trans_hash = acc_info.last_trans_hash;
+    }
+    if (last_trans_lt) {
+      *last_trans_lt = acc_info.last_trans_lt;
+    }
+  } else if (root.not_null()) {
+    return td::Status::Error(PSLICE() << "account state proof shows that account state for " << addr
+                                      << " must be empty, but it is not");
+  }
+  return td::Status::OK();
+}
+
+// checks the shard block header and returns the root of the accounts dictionary of the shard state
+td::Result<td::Ref<vm::Cell>> check_accounts_proof(std::vector<td::Ref<vm::Cell>> roots, ton::BlockIdExt shard_blk,
+                                                  td::uint32* save_utime, ton::LogicalTime* save_lt) {
+  if (roots.size() != 2) {
+    return td::Status::Error(PSLICE() << "account state proof must have exactly two roots");
+  }
+  auto state_root = vm::MerkleProof::virtualize(std::move(roots[1]), 1);
+  if (state_root.is_null()) {
+    return td::Status::Error("account state proof is invalid");
+  }
+  ton::Bits256 state_hash = state_root->get_hash().bits();
+  TRY_STATUS_PREFIX(check_block_header_proof(vm::MerkleProof::virtualize(std::move(roots[0]), 1), shard_blk,
+                                             &state_hash, true, save_utime, save_lt),
+                    "error in account shard block header proof : ");
+  block::gen::ShardStateUnsplit::Record sstate;
+  if (!(tlb::unpack_cell(std::move(state_root), sstate))) {
+    return td::Status::Error("cannot unpack state header");
+  }
+  return vm::load_cell_slice(sstate.accounts).prefetch_ref();
+}
+}  // namespace
+
 td::Status check_account_proof(td::Slice proof, ton::BlockIdExt shard_blk, const block::StdAddress& addr,
                                td::Ref<vm::Cell> root, ton::LogicalTime* last_trans_lt, ton::Bits256* last_trans_hash,
                                td::uint32* save_utime, ton::LogicalTime* save_lt) {
   TRY_RESULT_PREFIX(Q_roots, vm::std_boc_deserialize_multi(std::move(proof)), "cannot deserialize account proof");
-  if (Q_roots.size() != 2) {
-    return td::Status::Error(PSLICE() << "account state proof must have exactly two roots");
-  }
 
   if (last_trans_lt) {
     last_trans_hash->set_zero();
   }
 
   try {
-    auto state_root = vm::MerkleProof::virtualize(std::move(Q_roots[1]), 1);
-    if (state_root.is_null()) {
-      return td::Status::Error("account state proof is invalid");
-    }
-    ton::Bits256 state_hash = state_root->get_hash().bits();
-    TRY_STATUS_PREFIX(check_block_header_proof(vm::MerkleProof::virtualize(std::move(Q_roots[0]), 1), shard_blk,
-                                               &state_hash, true, save_utime, save_lt),
-                      "error in account shard block header proof : ");
-    block::gen::ShardStateUnsplit::Record sstate;
-    if (!(tlb::unpack_cell(std::move(state_root), sstate))) {
-      return td::Status::Error("cannot unpack state header");
-    }
-    vm::AugmentedDictionary accounts_dict{vm::load_cell_slice(sstate.accounts).prefetch_ref(), 256,
-                                          block::tlb::aug_ShardAccounts};
-    auto acc_csr = accounts_dict.lookup(addr.addr);
-    if (acc_csr.not_null()) {
-      if (root.is_null()) {
-        return td::Status::Error(PSLICE() << "account state proof shows that account state for " << addr
-                                          << " must be non-empty, but it actually is empty");
-      }
-      block::gen::ShardAccount::Record acc_info;
-      if (!tlb::csr_unpack(std::move(acc_csr), acc_info)) {
-        return td::Status::Error("cannot unpack ShardAccount from proof");
-      }
-      if (acc_info.account->get_hash().bits().compare(root->get_hash().bits(), 256)) {
-        return td::Status::Error(PSLICE() << "account state hash mismatch: Merkle proof expects "
-                                          << acc_info.account->get_hash().bits().to_hex(256)
-                                          << " but received data has " << root->get_hash().bits().to_hex(256));
-      }
-      if (last_trans_hash) {
-        *last_trans_hash = acc_info.last_trans_hash;
-      }
-      if (last_trans_lt) {
-        *last_trans_lt = acc_info.last_trans_lt;
-      }
-    } else if (root.not_null()) {
-      return td::Status::Error(PSLICE() << "account state proof shows that account state for " << addr
-                                        << " must be empty, but it is not");
-    }
+    TRY_RESULT(accounts_root, check_accounts_proof(std::move(Q_roots), shard_blk, save_utime, save_lt));
+    vm::AugmentedDictionary accounts_dict{std::move(accounts_root), 256, block::tlb::aug_ShardAccounts};
+    TRY_STATUS(check_shard_account(accounts_dict, addr, root, last_trans_lt, last_trans_hash));
   } catch (vm::VmError err) {
     return td::Status::Error(PSLICE() << "error while traversing account proof : " << err.get_msg());
   } catch (vm::VmVirtError err) {
@@ -218,7 +233,8 @@ td::Status check_account_proof(td::Slice proof, ton::BlockIdExt shard_blk, const
   return td::Status::OK();
 }
 
-td::Result<AccountState::Info> AccountState::validate(ton::BlockIdExt ref_blk, block::StdAddress addr) const {
+td::Result<AccountState::Info> AccountState::validate(ton::BlockIdExt ref_blk, block::StdAddress addr,
+                                                      bool skip_shard_proof) const {
   TRY_RESULT_PREFIX(true_root, vm::std_boc_deserialize(state.as_slice(), true), "cannot deserialize account state");
   Ref<vm::Cell> root;
 
@@ -245,7 +261,9 @@ td::Result<AccountState::Info> AccountState::validate(ton::BlockIdExt ref_blk, b
                                       << " that cannot contain requested account");
   }
 
-  TRY_STATUS(block::check_shard_proof(blk, shard_blk, shard_proof.as_slice()));
+  if (!skip_shard_proof) {
+    TRY_STATUS(block::check_shard_proof(blk, shard_blk, shard_proof.as_slice()));
+  }
 
   Info res;
   TRY_STATUS(block::check_account_proof(proof.as_slice(), shard_blk, addr, root, &res.last_trans_lt,
@@ -256,6 +274,101 @@ td::Result<AccountState::Info> AccountState::validate(ton::BlockIdExt ref_blk, b
   return res;
 }
 
+td::Result<std::vector<AccountState::Info>> AccountStates::validate(ton::BlockIdExt ref_blk,
+                                                                    ton::WorkchainId workchain,
+                                                                    const std::vector<ton::StdSmcAddress>& addrs,
+                                                                    bool skip_shard_proof) const {
+  if (blk != ref_blk && ref_blk.id.seqno != ~0U) {
+    return td::Status::Error(PSLICE() << "obtained getAccountStates() for a different reference block " << blk.to_str()
+                                      << " instead of requested " << ref_blk.to_str());
+  }
+
+  if (!shard_blk.is_valid_full()) {
+    return td::Status::Error(PSLICE() << "shard block id " << shard_blk.to_str() << " in answer is invalid");
+  }
+
+  auto shard = shard_blk.shard_full();
+  if (addrs.empty() || !ton::shard_contains(shard, ton::extract_addr_prefix(workchain, addrs[0]))) {
+    return td::Status::Error(PSLICE() << "received data from shard block " << shard_blk.to_str()
+                                      << " that cannot contain the first requested account");
+  }
+
+  if (!skip_shard_proof) {
+    TRY_STATUS(block::check_shard_proof(blk, shard_blk, shard_proof.as_slice()));
+  }
+
+  TRY_RESULT_PREFIX(Q_roots, vm::std_boc_deserialize_multi(proof.as_slice()),
+                    "cannot deserialize account states proof");
+  std::vector<AccountState::Info> res;
+  try {
+    td::uint32 gen_utime = 0;
+    ton::LogicalTime gen_lt = 0;
+    TRY_RESULT(accounts_root, check_accounts_proof(std::move(Q_roots), shard_blk, &gen_utime, &gen_lt));
+    vm::AugmentedDictionary accounts_dict{std::move(accounts_root), 256, block::tlb::aug_ShardAccounts};
+    for (const auto& addr : addrs) {
+      if (!ton::shard_contains(shard, ton::extract_addr_prefix(workchain, addr))) {
+        continue;
+      }
+      if (res.size() == states.size()) {
+        return td::Status::Error("too few account states in getAccountStates() answer");
+      }
+      TRY_RESULT_PREFIX(root, vm::std_boc_deserialize(states[res.size()].as_slice(), true),
+                        "cannot deserialize account state");
+      AccountState::Info info;
+      info.last_trans_hash.set_zero();
+      TRY_STATUS(check_shard_account(accounts_dict, block::StdAddress(workchain, addr), root, &info.last_trans_lt,
+                                     &info.last_trans_hash));
+      info.root = root;
+      info.true_root = std::move(root);
+      info.gen_utime = gen_utime;
+      info.gen_lt = gen_lt;
+      res.push_back(std::move(info));
+    }
+    if (res.size() != states.size()) {
+      return td::Status::Error("too many account states in getAccountStates() answer");
+    }
+  } catch (vm::VmError err) {
+    return td::Status::Error(PSLICE() << "error while traversing account states proof : " << err.get_msg());
+  } catch (vm::VmVirtError err) {
+    return td::Status::Error(PSLICE() << "virtualization error while traversing account states proof : "
+                                      << err.get_msg());
+  }
+  return std::move(res);
+}
+
+td::Status make_account_states_proof(Ref<vm::Cell> state_root, ton::ShardIdFull shard, ton::WorkchainId workchain,
+                                     const std::vector<ton::StdSmcAddress>& addrs, Ref<vm::Cell>& proof,
+                                     std::vector<td::BufferSlice>& states) {
+  states.clear();
+  try {
+    // all lookups share one Merkle proof, so the common upper part of the accounts dictionary is sent only once
+    vm::MerkleProofBuilder pb{std::move(state_root)};
+    block::gen::ShardStateUnsplit::Record sstate;
+    if (!tlb::unpack_cell(pb.root(), sstate)) {
+      return td::Status::Error("cannot unpack state header");
+    }
+    vm::AugmentedDictionary accounts_dict{vm::load_cell_slice_ref(sstate.accounts), 256,
+                                          block::tlb::aug_ShardAccounts};
+    for (const auto& addr : addrs) {
+      if (!ton::shard_contains(shard, ton::extract_addr_prefix(workchain, addr))) {
+        continue;
+      }
+      td::BufferSlice data;
+      auto acc_csr = accounts_dict.lookup(addr);
+      if (acc_csr.not_null()) {
+        TRY_RESULT_ASSIGN(data, vm::std_boc_serialize(acc_csr->prefetch_ref()));
+      }
+      states.push_back(std::move(data));
+    }
+    if (!pb.extract_proof_to(proof)) {
+      return td::Status::Error("unknown error creating Merkle proof");
+    }
+  } catch (vm::VmError err) {
+    return td::Status::Error(PSLICE() << "error while building account states proof : " << err.get_msg());
+  }
+  return td::Status::OK();
+}
+
 td::Result<Transaction::Info> Transaction::validate() {
   if (root.is_null()) {
     return td::Status::Error("transactions are expected to be non-empty");
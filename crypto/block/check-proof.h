@@ -54,9 +54,32 @@ struct AccountState {
     td::uint32 gen_utime{0};
   };
 
-  td::Result<Info> validate(ton::BlockIdExt ref_blk, block::StdAddress addr) const;
+  // skip_shard_proof may be set if shard_blk is already known to be the shard block of blk
+  td::Result<Info> validate(ton::BlockIdExt ref_blk, block::StdAddress addr, bool skip_shard_proof = false) const;
 };
 
+// states of several accounts of one shard proven by a single Merkle proof of the shard state,
+// as returned by liteServer.getAccountStates
+struct AccountStates {
+  ton::BlockIdExt blk;
+  ton::BlockIdExt shard_blk;
+  td::BufferSlice shard_proof;
+  td::BufferSlice proof;
+  std::vector<td::BufferSlice> states;
+
+  // returns the states of those of addrs that belong to shard_blk, in the same order;
+  // shard_blk must contain the first of addrs
+  td::Result<std::vector<AccountState::Info>> validate(ton::BlockIdExt ref_blk, ton::WorkchainId workchain,
+                                                       const std::vector<ton::StdSmcAddress>& addrs,
+                                                       bool skip_shard_proof = false) const;
+};
+
+// builds the shard state part of a liteServer.getAccountStates answer: collects the states of those of addrs
+// that belong to shard (empty for missing accounts) and a single Merkle proof of all of them
+td::Status make_account_states_proof(Ref<vm::Cell> state_root, ton::ShardIdFull shard, ton::WorkchainId workchain,
+                                     const std::vector<ton::StdSmcAddress>& addrs, Ref<vm::Cell>& proof,
+                                     std::vector<td::BufferSlice>& states);
+
 struct Transaction {
   ton::BlockIdExt blkid;
   ton::LogicalTime lt;
@@ -553,18 +553,18 @@ Ref<vm::Cell> Config::get_config_param(int idx) const {
   if (!config_dict) {
     return {};
   }
-  return config_dict->lookup_ref(td::BitArray<32>{idx});
+  return vm::FrozenDictionary::lookup_ref_in(*config_dict, td::BitArray<32>{idx});
 }
 
 Ref<vm::Cell> Config::get_config_param(int idx, int idx2) const {
   if (!config_dict) {
     return {};
   }
-  auto res = config_dict->lookup_ref(td::BitArray<32>{idx});
+  auto res = vm::FrozenDictionary::lookup_ref_in(*config_dict, td::BitArray<32>{idx});
   if (res.not_null()) {
     return res;
   } else {
-    return config_dict->lookup_ref(td::BitArray<32>{idx2});
+    return vm::FrozenDictionary::lookup_ref_in(*config_dict, td::BitArray<32>{idx2});
   }
 }
 
@@ -978,7 +978,7 @@ bool ShardConfig::get_shard_hash_raw_from(vm::Dictionary& dict, vm::CellSlice& c
   if (id.is_masterchain() || !id.is_valid()) {
     return false;
   }
-  auto root = dict.lookup_ref(td::BitArray<32>{id.workchain});
+  auto root = vm::FrozenDictionary::lookup_ref_in(dict, td::BitArray<32>{id.workchain});
   if (root.is_null()) {
     return false;
   }
@@ -2089,7 +2089,7 @@ Ref<vm::Cell> ConfigInfo::lookup_library(td::ConstBitPtr root_hash) const {
   if (!libraries_dict_) {
     return {};
   }
-  auto csr = libraries_dict_->lookup(root_hash, 256);
+  auto csr = vm::FrozenDictionary::lookup_in(*libraries_dict_, root_hash, 256);
   if (csr.is_null() || csr->prefetch_ulong(8) != 0 || !csr->have_refs()) {  // shared_lib_descr$00 lib:^Cell
     return {};
   }
@@ -359,6 +359,9 @@ struct Transaction {
   bool update_limits(block::BlockLimitStatus& blk_lim_st) const;
 
   Ref<vm::Cell> commit(Account& _account);  // _account should point to the same account
+  // exports the transaction into _account, which must be in the same state as the account the transaction was
+  // created for (e.g. a copy of it); the transaction itself is left unchanged
+  Ref<vm::Cell> commit_to(Account& _account) const;
   LtCellRef extract_out_msg(unsigned i);
   NewOutMsg extract_out_msg_ext(unsigned i);
   void extract_out_msgs(std::vector<LtCellRef>& list);
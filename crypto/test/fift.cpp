@@ -19,6 +19,8 @@
 #include "fift/words.h"
 #include "fift/Fift.h"
 #include "fift/utils.h"
+#include "vm/opctable.h"
+#include "vm/cp0.h"
 
 #include "td/utils/tests.h"
 #include "td/utils/PathView.h"
@@ -39,6 +41,30 @@ td::Status run_fift(std::string name, bool preload_fift = true) {
   return td::Status::OK();
 }
 
+void run_fift_decode_cache_conformance(std::string name) {
+  auto code = load_test(name);
+  vm::OpcodeTable::enable_decode_cache(false);
+  auto plain = fift::mem_run_fift(code);
+  vm::OpcodeTable::enable_decode_cache(true);
+  auto cached = fift::mem_run_fift(code);
+  auto cached_again = fift::mem_run_fift(code);
+  vm::OpcodeTable::enable_decode_cache(false);
+  ASSERT_TRUE(plain.is_ok());
+  ASSERT_TRUE(cached.is_ok());
+  ASSERT_TRUE(cached_again.is_ok());
+  ASSERT_EQ(plain.ok().output, cached.ok().output);
+  ASSERT_EQ(plain.ok().output, cached_again.ok().output);
+}
+
+TEST(Fift, testvm_decode_cache) {
+  for (auto name : {"testvm.fif", "testvm2.fif", "testvm3.fif", "testvm4.fif", "testvm4a.fif", "testvm4b.fif",
+                    "testvm4c.fif", "testvm4d.fif", "testvm4e.fif", "testvm5.fif", "testvm6.fif", "testvm7.fif",
+                    "testvm8.fif", "testvm9.fif", "testvmprog.fif"}) {
+    run_fift_decode_cache_conformance(name);
+  }
+  ASSERT_TRUE(vm::init_op_cp0()->decode_cache_size() > 0);
+}
+
 TEST(Fift, testvm) {
   run_fift("testvm.fif");
 }
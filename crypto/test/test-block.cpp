@@ -0,0 +1,263 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "block/block.h"
+#include "block/block-parse.h"
+#include "block/block-auto.h"
+#include "block/check-proof.h"
+#include "vm/boc.h"
+#include "vm/dict.h"
+#include "vm/cells/MerkleProof.h"
+#include "vm/cells/MerkleUpdate.h"
+
+#include "td/utils/tests.h"
+
+namespace {
+// a basechain shard block with the given accounts, and a masterchain block referring to it
+struct TestShard {
+  ton::ShardIdFull shard{ton::basechainId, 0x4000000000000000ULL};  // accounts starting with bit 0
+  ton::BlockIdExt mc_blk{ton::masterchainId, ton::shardIdAll, 2, ton::RootHash::zero(), ton::FileHash::zero()};
+  ton::BlockIdExt blk;
+  td::Ref<vm::Cell> state_root, block_root;
+  std::map<ton::StdSmcAddress, td::Ref<vm::Cell>> accounts;
+};
+
+ton::StdSmcAddress make_addr(unsigned char first_byte, unsigned char last_byte) {
+  ton::StdSmcAddress addr = ton::StdSmcAddress::zero();
+  addr.as_slice()[0] = first_byte;
+  addr.as_slice()[31] = last_byte;
+  return addr;
+}
+
+td::Ref<vm::Cell> make_account(ton::WorkchainId workchain, const ton::StdSmcAddress& addr, td::uint64 balance,
+                               ton::LogicalTime lt) {
+  vm::CellBuilder cb;
+  CHECK(cb.store_long_bool(1, 1)                                                   // account$1
+        && cb.store_long_bool(4, 3)                                                // addr_std$10 anycast:nothing
+        && cb.store_long_bool(workchain, 8) && cb.store_bits_bool(addr)            // workchain_id address
+        && cb.store_zeroes_bool(9) && cb.store_long_bool(0, 32)                    // used:StorageUsed last_paid
+        && cb.store_long_bool(0, 1)                                                // due_payment:nothing
+        && cb.store_long_bool(lt, 64)                                              // last_trans_lt
+        && block::tlb::t_Grams.store_long(cb, balance)                             // balance:grams
+        && cb.store_long_bool(0, 1)                                                // other:empty
+        && cb.store_long_bool(0, 2));                                              // account_uninit$00
+  return cb.finalize();
+}
+
+td::Ref<vm::Cell> make_ext_blk_ref(ton::LogicalTime end_lt, ton::BlockSeqno seqno) {
+  vm::CellBuilder cb;
+  CHECK(cb.store_long_bool(end_lt, 64) && cb.store_long_bool(seqno, 32) && cb.store_zeroes_bool(512));
+  return cb.finalize();
+}
+
+void build_shard(TestShard& t, td::uint64 balance_delta = 0) {
+  vm::AugmentedDictionary accounts_dict{256, block::tlb::aug_ShardAccounts};
+  td::uint64 balance = 1000000000 + balance_delta;
+  ton::LogicalTime lt = 1000;
+  for (auto& p : t.accounts) {
+    p.second = make_account(ton::basechainId, p.first, balance++, lt);
+    vm::CellBuilder cb;
+    td::Bits256 last_trans_hash;
+    last_trans_hash.as_slice().fill(static_cast<char>(lt));
+    CHECK(cb.store_ref_bool(p.second) && cb.store_bits_bool(last_trans_hash) && cb.store_long_bool(lt++, 64));
+    CHECK(accounts_dict.set_builder(p.first, cb));
+  }
+  vm::CellBuilder cb;
+  CHECK(cb.append_cellslice_bool(accounts_dict.get_root()));
+  auto accounts = cb.finalize();
+
+  vm::CellBuilder aux;
+  CHECK(aux.store_zeroes_bool(128)                               // overload_history underload_history
+        && block::tlb::t_CurrencyCollection.null_value(aux)      // total_balance
+        && block::tlb::t_CurrencyCollection.null_value(aux)      // total_validator_fees
+        && aux.store_long_bool(0, 1) && aux.store_long_bool(0, 1));  // libraries master_ref
+  CHECK(cb.store_long_bool(0x9023afe2, 32) && cb.store_long_bool(0, 32)  // shard_state#9023afe2 global_id
+        && block::tlb::t_ShardIdent.pack(cb, t.shard)                      // shard_id
+        && cb.store_long_bool(1, 32) && cb.store_long_bool(0, 32)          // seq_no vert_seq_no
+        && cb.store_long_bool(1600000000, 32) && cb.store_long_bool(lt, 64)  // gen_utime gen_lt
+        && cb.store_long_bool(1, 32)                                         // min_ref_mc_seqno
+        && cb.store_ref_bool(vm::CellBuilder().finalize())                   // out_msg_queue_info
+        && cb.store_long_bool(0, 1) && cb.store_ref_bool(accounts)           // before_split accounts
+        && cb.store_ref_bool(aux.finalize()) && cb.store_long_bool(0, 1));   // ^[...] custom
+  t.state_root = cb.finalize();
+
+  vm::CellBuilder info;
+  CHECK(info.store_long_bool(0x9bc7a987, 32) && info.store_long_bool(0, 32)  // block_info#9bc7a987 version
+        && info.store_long_bool(0x80, 8) && info.store_long_bool(0, 8)       // not_master ... vert_seqno_incr flags
+        && info.store_long_bool(1, 32) && info.store_long_bool(0, 32)        // seq_no vert_seq_no
+        && block::tlb::t_ShardIdent.pack(info, t.shard)                      // shard
+        && info.store_long_bool(1600000000, 32)                              // gen_utime
+        && info.store_long_bool(1000, 64) && info.store_long_bool(lt, 64)    // start_lt end_lt
+        && info.store_zeroes_bool(128)                                       // validator list .. prev_key_block_seqno
+        && info.store_ref_bool(make_ext_blk_ref(900, 1))                     // master_ref
+        && info.store_ref_bool(make_ext_blk_ref(900, 0)));                   // prev_ref
+  // nothing of the state is used, so only the hashes of the old and the new state get into the update
+  vm::CellUsageTree usage_tree;
+  auto state_update = vm::MerkleUpdate::generate(vm::CellBuilder().finalize(), t.state_root, &usage_tree);
+  CHECK(state_update.not_null());
+  CHECK(cb.store_long_bool(0x11ef55aa, 32) && cb.store_long_bool(0, 32)  // block#11ef55aa global_id
+        && cb.store_ref_bool(info.finalize())                              // info
+        && cb.store_ref_bool(vm::CellBuilder().finalize())                 // value_flow
+        && cb.store_ref_bool(std::move(state_update))                      // state_update
+        && cb.store_ref_bool(vm::CellBuilder().finalize()));               // extra
+  t.block_root = cb.finalize();
+  // the file hash is not checked by the proof, any non-zero value will do
+  t.blk = ton::BlockIdExt{ton::BlockId{t.shard, 1}, t.block_root->get_hash().bits(), t.block_root->get_hash().bits()};
+}
+
+// the same steps as the liteserver takes to prove the state hash of a block
+td::Ref<vm::Cell> make_state_root_proof(td::Ref<vm::Cell> block_root) {
+  vm::MerkleProofBuilder pb{std::move(block_root)};
+  block::gen::Block::Record blk;
+  block::gen::BlockInfo::Record info;
+  CHECK(tlb::unpack_cell(pb.root(), blk) && tlb::unpack_cell(blk.info, info));
+  vm::CellSlice upd_cs{vm::NoVmSpec(), blk.state_update};
+  CHECK(upd_cs.is_special());
+  return pb.extract_proof();
+}
+
+block::AccountStates make_answer(const TestShard& t, const std::vector<ton::StdSmcAddress>& addrs,
+                                 td::Ref<vm::Cell> header_proof = {}) {
+  block::AccountStates answer;
+  answer.blk = t.mc_blk;
+  answer.shard_blk = t.blk;
+  td::Ref<vm::Cell> state_proof;
+  block::make_account_states_proof(t.state_root, t.blk.shard_full(), ton::basechainId, addrs, state_proof,
+                                   answer.states)
+      .ensure();
+  if (header_proof.is_null()) {
+    header_proof = make_state_root_proof(t.block_root);
+  }
+  answer.proof = vm::std_boc_serialize_multi({std::move(header_proof), std::move(state_proof)}).move_as_ok();
+  return answer;
+}
+
+bool has_error(const td::Result<std::vector<block::AccountState::Info>>& r, td::Slice text) {
+  if (r.is_ok()) {
+    return false;
+  }
+  LOG(INFO) << r.error();
+  return r.error().message().str().find(text.str()) != std::string::npos;
+}
+}  // namespace
+
+TEST(Block, account_states_proof) {
+  TestShard t;
+  auto a0 = make_addr(0x12, 1), a1 = make_addr(0x34, 2), a2 = make_addr(0x56, 3);
+  for (auto& addr : {a0, a1, a2}) {
+    t.accounts[addr] = {};
+  }
+  build_shard(t);
+  auto missing = make_addr(0x20, 4);
+  auto other_shard = make_addr(0x80, 5);
+
+  std::vector<ton::StdSmcAddress> addrs{a2, other_shard, missing, a0};
+  auto answer = make_answer(t, addrs);
+  ASSERT_EQ(3u, answer.states.size());
+  ASSERT_TRUE(answer.states[1].empty());
+
+  auto r = answer.validate(t.mc_blk, ton::basechainId, addrs, true);
+  r.ensure();
+  auto infos = r.move_as_ok();
+  ASSERT_EQ(3u, infos.size());
+  ASSERT_TRUE(infos[0].root->get_hash() == t.accounts[a2]->get_hash());
+  ASSERT_TRUE(infos[1].root.is_null());
+  ASSERT_TRUE(infos[2].root->get_hash() == t.accounts[a0]->get_hash());
+  ASSERT_EQ(1002u, infos[0].last_trans_lt);
+  ASSERT_EQ(1000u, infos[2].last_trans_lt);
+  ASSERT_EQ(static_cast<char>(1000), static_cast<char>(infos[2].last_trans_hash.as_slice()[0]));
+  for (auto& info : infos) {
+    ASSERT_EQ(1600000000u, info.gen_utime);
+    ASSERT_EQ(1003u, info.gen_lt);
+  }
+
+  // a reference block other than the requested one, unless any block was requested
+  ton::BlockIdExt other_mc_blk{ton::masterchainId, ton::shardIdAll, 3, ton::RootHash::zero(), ton::FileHash::zero()};
+  ASSERT_TRUE(has_error(answer.validate(other_mc_blk, ton::basechainId, addrs, true), "different reference block"));
+  ton::BlockIdExt any_mc_blk = other_mc_blk;
+  any_mc_blk.id.seqno = ~0U;
+  answer.validate(any_mc_blk, ton::basechainId, addrs, true).ensure();
+
+  // the shard block must contain the first requested account
+  std::vector<ton::StdSmcAddress> other_first{other_shard, a0};
+  ASSERT_TRUE(has_error(make_answer(t, other_first).validate(t.mc_blk, ton::basechainId, other_first, true),
+                        "cannot contain the first requested account"));
+  // the shard proof is required unless it is skipped
+  ASSERT_TRUE(answer.validate(t.mc_blk, ton::basechainId, addrs).is_error());
+}
+
+TEST(Block, account_states_proof_tampered) {
+  TestShard t;
+  auto a0 = make_addr(0x12, 1), a1 = make_addr(0x34, 2);
+  t.accounts[a0] = {};
+  t.accounts[a1] = {};
+  build_shard(t);
+  auto missing = make_addr(0x20, 4);
+  std::vector<ton::StdSmcAddress> addrs{a0, missing, a1};
+  auto answer = make_answer(t, addrs);
+  answer.validate(t.mc_blk, ton::basechainId, addrs, true).ensure();
+
+  // swapped account states
+  {
+    auto tampered = make_answer(t, addrs);
+    std::swap(tampered.states[0], tampered.states[2]);
+    ASSERT_TRUE(has_error(tampered.validate(t.mc_blk, ton::basechainId, addrs, true), "hash mismatch"));
+  }
+  // a state for an account that does not exist, and no state for one that does
+  {
+    auto tampered = make_answer(t, addrs);
+    tampered.states[1] = tampered.states[0].copy();
+    ASSERT_TRUE(has_error(tampered.validate(t.mc_blk, ton::basechainId, addrs, true), "must be empty"));
+    tampered = make_answer(t, addrs);
+    tampered.states[0] = td::BufferSlice();
+    ASSERT_TRUE(has_error(tampered.validate(t.mc_blk, ton::basechainId, addrs, true), "must be non-empty"));
+  }
+  // too few or too many states
+  {
+    auto tampered = make_answer(t, addrs);
+    tampered.states.pop_back();
+    ASSERT_TRUE(has_error(tampered.validate(t.mc_blk, ton::basechainId, addrs, true), "too few"));
+    tampered = make_answer(t, addrs);
+    tampered.states.push_back(td::BufferSlice());
+    ASSERT_TRUE(has_error(tampered.validate(t.mc_blk, ton::basechainId, addrs, true), "too many"));
+  }
+  // the state proof and the states of a different state, with the header proof of the real block
+  {
+    TestShard forged = t;
+    build_shard(forged, 1);
+    ASSERT_TRUE(forged.state_root->get_hash() != t.state_root->get_hash());
+    auto tampered = make_answer(forged, addrs, make_state_root_proof(t.block_root));
+    tampered.shard_blk = t.blk;
+    ASSERT_TRUE(has_error(tampered.validate(t.mc_blk, ton::basechainId, addrs, true), "state hash mismatch"));
+  }
+  // the proof of a different block
+  {
+    TestShard forged = t;
+    build_shard(forged, 1);
+    auto tampered = make_answer(forged, addrs);
+    tampered.shard_blk = t.blk;
+    ASSERT_TRUE(has_error(tampered.validate(t.mc_blk, ton::basechainId, addrs, true), "incorrect root hash"));
+  }
+  // a corrupted proof
+  {
+    auto tampered = make_answer(t, addrs);
+    auto data = tampered.proof.as_slice();
+    data[data.size() / 2] ^= 0x55;
+    ASSERT_TRUE(tampered.validate(t.mc_blk, ton::basechainId, addrs, true).is_error());
+  }
+}
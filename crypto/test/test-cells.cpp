@@ -33,10 +33,14 @@
 #include "common/util.h"
 #include "vm/cells.h"
 #include "vm/cellslice.h"
+#include "vm/boc.h"
 
+#include "td/utils/benchmark.h"
 #include "td/utils/tests.h"
 #include "td/utils/crypto.h"
 #include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/ThreadPool.h"
 
 static std::stringstream create_ss() {
   std::stringstream ss;
@@ -654,3 +658,90 @@ TEST(uint64_exp, main) {
   }
   REGRESSION_VERIFY(os.str());
 }
+
+static td::Ref<vm::Cell> gen_random_dag(int cells_n, td::Random::Xorshift128plus& rnd) {
+  // cell i refers to cells 3i+1..3i+3 and to one more random cell with a larger index, so the depth stays small
+  std::vector<td::Ref<vm::Cell>> cells(cells_n);
+  for (int i = cells_n - 1; i >= 0; i--) {
+    vm::CellBuilder cb;
+    auto bits = rnd.fast(0, 1023);
+    for (int j = 0; j + 64 <= bits; j += 64) {
+      cb.store_long(rnd(), 64);
+    }
+    cb.store_long(rnd(), bits % 64);
+    for (int j = 3 * i + 1; j <= 3 * i + 3 && j < cells_n; j++) {
+      cb.store_ref(cells[j]);
+    }
+    if (3 * i + 1 < cells_n && rnd.fast(0, 1) == 1) {
+      cb.store_ref(cells[rnd.fast(3 * i + 1, cells_n - 1)]);
+    }
+    cells[i] = cb.finalize();
+  }
+  return cells[0];
+}
+
+TEST(Cells, boc_deserialize_threads) {
+  td::Random::Xorshift128plus rnd{123};
+  td::ThreadPool pool1(1);
+  td::ThreadPool pool3(3);
+  for (int cells_n : {1, 10, 1000, 5000}) {
+    auto root = gen_random_dag(cells_n, rnd);
+    for (int mode : {0, 31}) {
+      auto data = vm::std_boc_serialize(root, mode).move_as_ok();
+      for (td::ThreadPool *pool : {static_cast<td::ThreadPool *>(nullptr), &pool1, &pool3}) {
+        auto r_root = vm::std_boc_deserialize(data, false, pool);
+        ASSERT_TRUE(r_root.is_ok());
+        ASSERT_EQ(root->get_hash(), r_root.ok()->get_hash());
+      }
+      // a corrupted cell must be rejected in the same way by the sequential and the parallel path
+      if (mode == 0 && cells_n > 1) {
+        auto broken = data.as_slice().str();
+        broken[broken.size() / 2] ^= 1;
+        auto r_sequential = vm::std_boc_deserialize(broken, false);
+        auto r_parallel = vm::std_boc_deserialize(broken, false, &pool3);
+        ASSERT_EQ(r_sequential.is_error(), r_parallel.is_error());
+        if (r_sequential.is_error()) {
+          ASSERT_EQ(r_sequential.error().message(), r_parallel.error().message());
+        } else {
+          ASSERT_EQ(r_sequential.ok()->get_hash(), r_parallel.ok()->get_hash());
+        }
+      }
+    }
+  }
+}
+
+class BenchBocDeserialize : public td::Benchmark {
+ public:
+  explicit BenchBocDeserialize(int threads_n) : threads_n_(threads_n) {
+    if (threads_n > 1) {
+      pool_ = std::make_unique<td::ThreadPool>(threads_n - 1);
+    }
+  }
+  std::string get_description() const override {
+    return PSTRING() << "BagOfCells deserialize (cells) threads_n=" << threads_n_;
+  }
+
+  void start_up() override {
+    td::Random::Xorshift128plus rnd{123};
+    data_ = vm::std_boc_serialize(gen_random_dag(cells_n, rnd), 31).move_as_ok();
+  }
+
+  void run(int n) override {
+    for (int i = 0; i < n; i += cells_n) {
+      vm::BagOfCells boc;
+      boc.deserialize(data_, 1, pool_.get()).ensure();
+    }
+  }
+
+ private:
+  static constexpr int cells_n = 100000;
+  int threads_n_;
+  std::unique_ptr<td::ThreadPool> pool_;
+  td::BufferSlice data_;
+};
+
+TEST(Cells, bench_boc_deserialize) {
+  for (int threads_n : {1, 4}) {
+    td::bench(BenchBocDeserialize(threads_n));
+  }
+}
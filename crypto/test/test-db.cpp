@@ -17,6 +17,7 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "vm/boc.h"
+#include "vm/boc-writers.h"
 #include "vm/cellslice.h"
 #include "vm/cells.h"
 #include "common/AtomicRef.h"
@@ -24,7 +25,9 @@
 #include "vm/cells/MerkleProof.h"
 #include "vm/cells/MerkleUpdate.h"
 #include "vm/db/CellStorage.h"
+#include "vm/db/CellCache.h"
 #include "vm/db/CellHashTable.h"
+#include "vm/db/CellPrefetcher.h"
 #include "vm/db/TonDb.h"
 #include "vm/db/StaticBagOfCellsDb.h"
 
@@ -38,6 +41,9 @@
 #include "td/utils/Timer.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/sleep.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/port/Stat.h"
 #include "td/utils/format.h"
 #include "td/utils/misc.h"
 #include "td/utils/optional.h"
@@ -568,6 +574,45 @@ TEST(Cell, MerkleProofCombine) {
   }
 };
 
+TEST(Cell, MerkleProofLoadJournal) {
+  td::Random::Xorshift128plus rnd{123};
+  for (int t = 0; t < 100; t++) {
+    auto cell = gen_random_cell(rnd.fast(1, 1000), rnd, true);
+    auto exploration1 = CellExplorer::random_explore(cell, rnd);
+    auto exploration2 = CellExplorer::random_explore(cell, rnd);
+
+    auto get_proof = [&](std::vector<CellExplorer::Exploration *> explorations) {
+      auto usage_tree = std::make_shared<CellUsageTree>();
+      auto usage_cell = UsageCell::create(cell, usage_tree->root_ptr());
+      for (auto exploration : explorations) {
+        CellExplorer::explore(usage_cell, exploration->ops);
+      }
+      return MerkleProof::generate(cell, usage_tree.get());
+    };
+
+    // loads from two threads are journaled separately and marked only when the journal is applied
+    auto usage_tree = std::make_shared<CellUsageTree>();
+    auto usage_cell = UsageCell::create(cell, usage_tree->root_ptr());
+    CellUsageTree::LoadJournal journal1{usage_tree}, journal2{usage_tree};
+    usage_tree->set_concurrent();
+    auto explore = [&](CellUsageTree::LoadJournal *journal, CellExplorer::Exploration *exploration) {
+      CellUsageTree::LoadJournal::Guard guard{journal};
+      auto res = CellExplorer::explore(usage_cell, exploration->ops);
+      ASSERT_EQ(exploration->log, res.log);
+    };
+    td::thread thread([&] { explore(&journal2, &exploration2); });
+    explore(&journal1, &exploration1);
+    thread.join();
+    usage_tree->set_concurrent(false);
+
+    journal1.apply();
+    ASSERT_EQ(get_proof({&exploration1})->get_hash(), MerkleProof::generate(cell, usage_tree.get())->get_hash());
+    journal2.apply();
+    ASSERT_EQ(get_proof({&exploration1, &exploration2})->get_hash(),
+              MerkleProof::generate(cell, usage_tree.get())->get_hash());
+  }
+};
+
 int X = 20;
 Ref<Cell> gen_random_cell(int size, Ref<Cell> from, td::Random::Xorshift128plus &rnd,
                           bool with_prunned_branches = true) {
@@ -762,6 +807,41 @@ TEST(TonDb, BocMultipleRoots) {
   }
 };
 
+TEST(TonDb, BocSerializeToFile) {
+  td::Random::Xorshift128plus rnd{123};
+  std::string path = "boc_serialize_to_file";
+  for (int t = 0; t < 100; t++) {
+    auto cell = gen_random_cell(rnd.fast(1, 1000), rnd);
+    auto mode = get_random_serialization_mode(rnd);
+    auto serialized = serialize_boc(cell, mode);
+
+    td::unlink(path).ignore();
+    auto fd = td::FileFd::open(path, td::FileFd::Write | td::FileFd::CreateNew).move_as_ok();
+    vm::std_boc_serialize_to_file(cell, fd, mode).ensure();
+    fd.close();
+    ASSERT_EQ(serialized, td::read_file_str(path).move_as_ok());
+  }
+
+  // data larger than the writer buffer is flushed in parts, and CRC32C is computed over all of them
+  for (size_t buffer_size : {1, 7, 1000}) {
+    td::unlink(path).ignore();
+    auto fd = td::FileFd::open(path, td::FileFd::Write | td::FileFd::CreateNew).move_as_ok();
+    std::string data;
+    vm::boc_writers::FileWriter writer{fd, 10000, buffer_size};
+    while (data.size() + 8 <= 10000) {
+      auto chunk = td::rand_string('a', 'z', rnd.fast(0, 8));
+      writer.store_bytes(td::Slice(chunk).ubegin(), chunk.size());
+      data += chunk;
+      ASSERT_EQ(td::crc32c(data), writer.get_crc32());
+    }
+    ASSERT_EQ(data.size(), writer.position());
+    writer.finalize().ensure();
+    fd.close();
+    ASSERT_EQ(data, td::read_file_str(path).move_as_ok());
+  }
+  td::unlink(path).ignore();
+}
+
 TEST(TonDb, DynamicBoc) {
   td::Random::Xorshift128plus rnd{123};
   std::string old_root_hash;
@@ -804,6 +884,260 @@ TEST(TonDb, DynamicBoc) {
   ASSERT_EQ(0u, kv->count("").ok());
 };
 
+TEST(TonDb, CellCache) {
+  CellCache cache(1 << 12, 1);
+  auto key = [](int i) {
+    std::string res(Cell::hash_bytes, '\0');
+    td::as<int>(&res[0]) = i;
+    return res;
+  };
+  std::string value;
+  for (int i = 0; i < 100; i++) {
+    cache.set(key(i), std::string(100, static_cast<char>(i)));
+    ASSERT_TRUE(cache.get(key(i), value));
+    ASSERT_EQ(std::string(100, static_cast<char>(i)), value);
+  }
+  auto stats = cache.get_stats();
+  ASSERT_TRUE(stats.cells_size <= 1 << 12);
+  ASSERT_TRUE(stats.cells_count > 0);
+  ASSERT_TRUE(!cache.get(key(0), value));
+  ASSERT_TRUE(cache.get(key(99), value));
+  cache.erase(key(99));
+  ASSERT_TRUE(!cache.get(key(99), value));
+  cache.set(key(1000), std::string(1 << 13, 'a'));
+  ASSERT_TRUE(!cache.get(key(1000), value));
+}
+
+TEST(TonDb, DynamicBocWithCellCache) {
+  td::Random::Xorshift128plus rnd{123};
+  auto kv = std::make_shared<td::MemoryKeyValue>();
+  auto cache = CellCache::create(1 << 20);
+  std::vector<Ref<Cell>> roots;
+  auto dboc = DynamicBagOfCellsDb::create();
+  for (int t = 0; t < 200; t++) {
+    dboc->set_loader(std::make_unique<CellLoader>(kv, cache));
+    if (roots.size() > 10 || (!roots.empty() && rnd() % 3 == 0)) {
+      auto root = dboc->load_cell(roots[0]->get_hash().as_slice()).move_as_ok();
+      ASSERT_EQ(serialize_boc(roots[0]), serialize_boc(root));
+      dboc->dec(root);
+      roots.erase(roots.begin());
+    } else {
+      Ref<Cell> from_root;
+      if (!roots.empty()) {
+        from_root = dboc->load_cell(roots.back()->get_hash().as_slice()).move_as_ok();
+      }
+      roots.push_back(gen_random_cell(rnd.fast(1, 100), from_root, rnd));
+      dboc->inc(roots.back());
+    }
+    dboc->prepare_commit();
+    CellStorer cell_storer(*kv, cache);
+    dboc->commit(cell_storer);
+  }
+  dboc->set_loader(std::make_unique<CellLoader>(kv, cache));
+  for (auto &root : roots) {
+    dboc->dec(dboc->load_cell(root->get_hash().as_slice()).move_as_ok());
+  }
+  dboc->prepare_commit();
+  CellStorer cell_storer(*kv, cache);
+  dboc->commit(cell_storer);
+  ASSERT_EQ(0u, kv->count("").ok());
+  ASSERT_TRUE(cache->get_stats().hits > 0);
+}
+
+TEST(TonDb, DynamicBocCommitThreads) {
+  td::Random::Xorshift128plus rnd{123};
+  auto kv = std::make_shared<td::MemoryKeyValue>();
+  auto kv_threads = std::make_shared<td::MemoryKeyValue>();
+  auto dboc = DynamicBagOfCellsDb::create();
+  auto dboc_threads = DynamicBagOfCellsDb::create();
+  dboc_threads->set_commit_threads(4);
+  std::vector<std::string> roots;
+  auto base_root = gen_random_cell(1000, rnd, false);
+  auto commit = [&] {
+    dboc->prepare_commit();
+    dboc_threads->prepare_commit();
+    auto stats = dboc->get_stats_diff();
+    auto stats_threads = dboc_threads->get_stats_diff();
+    ASSERT_EQ(stats.cells_total_count, stats_threads.cells_total_count);
+    ASSERT_EQ(stats.cells_total_size, stats_threads.cells_total_size);
+    CellStorer cell_storer(*kv);
+    dboc->commit(cell_storer);
+    CellStorer cell_storer_threads(*kv_threads);
+    dboc_threads->commit(cell_storer_threads);
+    ASSERT_EQ(kv->count("").ok(), kv_threads->count("").ok());
+  };
+  for (int t = 0; t < 200; t++) {
+    dboc->set_loader(std::make_unique<CellLoader>(kv));
+    dboc_threads->set_loader(std::make_unique<CellLoader>(kv_threads));
+    if (roots.size() > 10 || (!roots.empty() && rnd() % 3 == 0)) {
+      dboc->dec(dboc->load_cell(roots[0]).move_as_ok());
+      dboc_threads->dec(dboc_threads->load_cell(roots[0]).move_as_ok());
+      roots.erase(roots.begin());
+    } else {
+      // new roots share cells with base_root and are kept in memory, so the shared cells are looked up in db
+      auto root = deserialize_boc(serialize_boc(gen_random_cell(rnd.fast(1, 1000), base_root, rnd, false)));
+      dboc->inc(root);
+      dboc_threads->inc(root);
+      roots.push_back(root->get_hash().as_slice().str());
+    }
+    commit();
+  }
+  dboc->set_loader(std::make_unique<CellLoader>(kv));
+  dboc_threads->set_loader(std::make_unique<CellLoader>(kv_threads));
+  for (auto &root : roots) {
+    dboc->dec(dboc->load_cell(root).move_as_ok());
+    dboc_threads->dec(dboc_threads->load_cell(root).move_as_ok());
+  }
+  commit();
+  ASSERT_EQ(0u, kv_threads->count("").ok());
+}
+
+// Simulates disk latency of cell lookups
+class SlowKeyValueReader : public td::KeyValueReader {
+ public:
+  SlowKeyValueReader(std::shared_ptr<td::KeyValueReader> reader, td::int32 delay_us)
+      : reader_(std::move(reader)), delay_us_(delay_us) {
+  }
+  td::Result<GetStatus> get(td::Slice key, std::string &value) override {
+    td::usleep_for(delay_us_);
+    return reader_->get(key, value);
+  }
+  td::Result<size_t> count(td::Slice prefix) override {
+    return reader_->count(prefix);
+  }
+
+ private:
+  std::shared_ptr<td::KeyValueReader> reader_;
+  td::int32 delay_us_;
+};
+
+class BenchDynamicBocCommit : public td::Benchmark {
+ public:
+  explicit BenchDynamicBocCommit(size_t threads_n) : threads_n_(threads_n) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << "DynamicBagOfCellsDb commit (cells) threads_n=" << threads_n_;
+  }
+
+  void run(int n) override {
+    td::Random::Xorshift128plus rnd{123};
+    auto kv = std::make_shared<td::MemoryKeyValue>();
+    auto dboc = DynamicBagOfCellsDb::create();
+    dboc->set_commit_threads(threads_n_);
+    auto base_root = gen_random_cell(cells_per_commit, rnd, false);
+    for (int i = 0; i < n; i += cells_per_commit) {
+      dboc->set_loader(std::make_unique<CellLoader>(std::make_shared<SlowKeyValueReader>(kv, 20)));
+      dboc->inc(gen_random_cell(cells_per_commit, base_root, rnd, false));
+      dboc->prepare_commit();
+      CellStorer cell_storer(*kv);
+      dboc->commit(cell_storer);
+    }
+  }
+
+ private:
+  static constexpr int cells_per_commit = 1000;
+  size_t threads_n_;
+};
+
+TEST(TonDb, BenchDynamicBocCommit) {
+  for (size_t threads_n : {0, 4}) {
+    td::bench(BenchDynamicBocCommit(threads_n));
+  }
+}
+
+TEST(TonDb, CellLoaderLoadMulti) {
+  td::Random::Xorshift128plus rnd{123};
+  auto kv = std::make_shared<td::MemoryKeyValue>();
+  auto root = gen_random_cell(1000, rnd, false);
+  auto dboc = DynamicBagOfCellsDb::create();
+  dboc->set_loader(std::make_unique<CellLoader>(kv));
+  dboc->inc(root);
+  dboc->prepare_commit();
+  CellStorer cell_storer(*kv);
+  dboc->commit(cell_storer);
+
+  // cells without references, so that no ext cells have to be created
+  std::set<std::string> leaves, visited;
+  std::function<void(Ref<Cell>)> dfs = [&](Ref<Cell> cell) {
+    if (!visited.insert(cell->get_hash().as_slice().str()).second) {
+      return;
+    }
+    auto data_cell = cell->load_cell().move_as_ok().data_cell;
+    if (data_cell->size_refs() == 0) {
+      leaves.insert(cell->get_hash().as_slice().str());
+    }
+    for (unsigned i = 0; i < data_cell->size_refs(); i++) {
+      dfs(data_cell->get_ref(i));
+    }
+  };
+  dfs(root);
+  ASSERT_TRUE(leaves.size() >= 3);
+  std::vector<std::string> keys(leaves.begin(), leaves.end());
+  keys.push_back(std::string(32, 'x'));
+  kv->set(keys[1], "garbage").ensure();
+
+  class NoExtCells : public ExtCellCreator {
+   public:
+    td::Result<Ref<Cell>> ext_cell(Cell::LevelMask level_mask, td::Slice hash, td::Slice depth) override {
+      return td::Status::Error("unexpected reference");
+    }
+  } ext_cell_creator;
+  std::vector<td::Slice> hashes(keys.begin(), keys.end());
+  auto results = CellLoader(kv).load_multi(hashes, true, ext_cell_creator).move_as_ok();
+  ASSERT_EQ(keys.size(), results.size());
+  // one broken cell does not affect the others
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (i == 1) {
+      ASSERT_TRUE(results[i].is_error());
+    } else if (i + 1 == keys.size()) {
+      ASSERT_TRUE(results[i].ok().status == CellLoader::LoadResult::NotFound);
+    } else {
+      ASSERT_TRUE(results[i].ok().status == CellLoader::LoadResult::Ok);
+      ASSERT_EQ(keys[i], results[i].ok_ref().cell()->get_hash().as_slice().str());
+    }
+  }
+}
+
+TEST(TonDb, CellPrefetcher) {
+  td::Random::Xorshift128plus rnd{123};
+  auto kv = std::make_shared<td::MemoryKeyValue>();
+  auto root = gen_random_cell(1000, rnd, false);
+  auto dboc = DynamicBagOfCellsDb::create();
+  dboc->set_loader(std::make_unique<CellLoader>(kv));
+  dboc->inc(root);
+  dboc->prepare_commit();
+  CellStorer cell_storer(*kv);
+  dboc->commit(cell_storer);
+
+  std::string value;
+  ASSERT_TRUE(kv->get(root->get_hash().as_slice(), value).move_as_ok() == KeyValue::GetStatus::Ok);
+  std::vector<CellHash> hashes;
+  CellLoader::parse_ref_hashes(value, hashes).ensure();
+  auto data_cell = root->load_cell().move_as_ok().data_cell;
+  ASSERT_EQ(data_cell->size_refs(), hashes.size());
+  ASSERT_TRUE(!hashes.empty());
+  for (unsigned i = 0; i < hashes.size(); i++) {
+    ASSERT_TRUE(data_cell->get_ref(i)->get_hash() == hashes[i]);
+  }
+
+  auto cache = CellCache::create(1 << 24);
+  auto prefetcher = CellPrefetcher::create(cache, 2);
+  dboc->set_loader(std::make_unique<CellLoader>(std::make_shared<SlowKeyValueReader>(kv, 100), cache, prefetcher));
+  auto loaded_root = dboc->load_cell(root->get_hash().as_slice()).move_as_ok();
+  auto stats_before = cache->get_stats();
+  {
+    CellPrefetcher::Scope scope{3, 64};
+    loaded_root->get_ref(0)->load_cell().ensure();
+    prefetcher->wait_idle();
+    ASSERT_TRUE(cache->get_stats().prefetched > stats_before.prefetched);
+    ASSERT_EQ(serialize_boc(root), serialize_boc(loaded_root));
+  }
+  auto stats = cache->get_stats();
+  ASSERT_TRUE(stats.prefetched > stats_before.prefetched);
+  ASSERT_TRUE(stats.prefetch_hits > stats_before.prefetch_hits);
+  ASSERT_TRUE(prefetcher->get_stats().requests > 0);
+}
+
 TEST(TonDb, DynamicBoc2) {
   int VERBOSITY_NAME(boc) = VERBOSITY_NAME(DEBUG) + 10;
   td::Random::Xorshift128plus rnd{123};
@@ -1749,6 +2083,77 @@ TEST(TonDb, BenchBocDeserializerRocksDb) {
   td::bench(BenchBocDeserializer<vm::StaticBagOfCellsDbBaseline>("rockdb", config));
 }
 
+vm::Ref<vm::Cell> gen_wide_tree(int levels, td::Random::Xorshift128plus &rnd) {
+  vm::CellBuilder cb;
+  cb.store_bytes(td::rand_string('a', 'z', rnd.fast(16, 127)));
+  if (levels > 1) {
+    for (int i = 0; i < 4; i++) {
+      cb.store_ref(gen_wide_tree(levels - 1, rnd));
+    }
+  }
+  return cb.finalize();
+}
+
+struct LoadAllCellsStat {
+  size_t cells{0};
+  size_t external_data_cells{0};
+};
+
+void load_all_cells(vm::Ref<vm::Cell> cell, td::HashSet<vm::CellHash> &visited, LoadAllCellsStat &stat) {
+  if (!visited.insert(cell->get_hash()).second) {
+    return;
+  }
+  auto data_cell = cell->load_cell().move_as_ok().data_cell;
+  stat.cells++;
+  if (data_cell->has_external_data()) {
+    stat.external_data_cells++;
+  }
+  for (unsigned i = 0; i < data_cell->size_refs(); i++) {
+    load_all_cells(data_cell->get_ref(i), visited, stat);
+  }
+}
+
+TEST(TonDb, BocDeserializerMemoryMapping) {
+  td::Random::Xorshift128plus rnd{123};
+  auto root = gen_wide_tree(9, rnd);
+  std::string path = "boc_memory_mapping";
+  td::unlink(path).ignore();
+  td::write_file(path, vm::serialize_boc(root, vm::BagOfCells::WithIndex | vm::BagOfCells::WithCRC32C)).ensure();
+
+  for (bool memory_mapping : {false, true}) {
+    auto rss_before = td::mem_stat().move_as_ok().resident_size_;
+    td::Timer timer;
+    auto blob = memory_mapping
+                    ? td::FileMemoryMappingBlobView::create(path, 0, td::MemoryMapping::Advice::Random).move_as_ok()
+                    : td::FileBlobView::create(path).move_as_ok();
+    vm::StaticBagOfCellsDbLazy::Options options;
+    options.check_crc32c = true;
+    auto boc = vm::StaticBagOfCellsDbLazy::create(std::move(blob), options).move_as_ok();
+    auto loaded_root = boc->get_root_cell(0).move_as_ok();
+    ASSERT_EQ(root->get_hash(), loaded_root->get_hash());
+    td::HashSet<vm::CellHash> visited;
+    LoadAllCellsStat stat;
+    load_all_cells(loaded_root, visited, stat);
+    auto elapsed = timer.elapsed();
+    auto rss_after = td::mem_stat().move_as_ok().resident_size_;
+    LOG(INFO) << (memory_mapping ? "file mmap" : "file") << ": loaded " << stat.cells << " cells in " << elapsed
+              << "s, " << stat.external_data_cells << " cells with external data, RSS grew by "
+              << td::format::as_size(rss_after - td::min(rss_before, rss_after));
+    if (memory_mapping) {
+      ASSERT_TRUE(stat.external_data_cells > 0);
+    } else {
+      ASSERT_EQ(0u, stat.external_data_cells);
+    }
+
+    // cells with external data keep the mapping alive after the bag of cells is destroyed
+    vm::Ref<vm::Cell> root_data_cell = loaded_root->load_cell().move_as_ok().data_cell;
+    loaded_root.clear();
+    boc.reset();
+    ASSERT_EQ(vm::serialize_boc(root), vm::serialize_boc(root_data_cell));
+  }
+  td::unlink(path).ignore();
+}
+
 TEST(TonDb, CompactArray) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
   td::Slice db_path = "compact_array_db";
@@ -18,11 +18,15 @@
 */
 #include "vm/vm.h"
 #include "vm/cp0.h"
+#include "vm/opctable.h"
 #include "vm/dict.h"
+#include "vm/cells/CellUsageTree.h"
+#include "vm/cells/UsageCell.h"
 #include "fift/utils.h"
 #include "common/bigint.hpp"
 
 #include "td/utils/base64.h"
+#include "td/utils/Random.h"
 #include "td/utils/tests.h"
 #include "td/utils/ScopeGuard.h"
 #include "td/utils/StringBuilder.h"
@@ -69,16 +73,18 @@ td::Ref<vm::Cell> to_cell(const unsigned char *buff, int bits) {
 }
 void test_run_vm(td::Ref<vm::Cell> code) {
   auto a = run_vm(code);
-  auto b = run_vm(code);
-  ASSERT_EQ(a, b);
   REGRESSION_VERIFY(a);
 }
 
-void test_run_vm(td::Slice code_hex) {
+td::Ref<vm::Cell> parse_code_hex(td::Slice code_hex) {
   unsigned char buff[128];
   int bits = (int)td::bitstring::parse_bitstring_hex_literal(buff, sizeof(buff), code_hex.begin(), code_hex.end());
   CHECK(bits >= 0);
-  test_run_vm(to_cell(buff, bits));
+  return to_cell(buff, bits);
+}
+
+void test_run_vm(td::Slice code_hex) {
+  test_run_vm(parse_code_hex(code_hex));
 }
 
 void test_run_vm_raw(td::Slice code64) {
@@ -448,3 +454,113 @@ RETALT
 )A";
   test_run_vm(fift::compile_asm(test1).move_as_ok());
 }
+
+TEST(VM, frozen_dictionary) {
+  vm::FrozenDictionary::clear_cache();
+  vm::Dictionary dict{32};
+  std::vector<td::int32> keys;
+  for (int i = 0; i < 1000; i++) {
+    auto key = td::Random::fast(-100000, 100000);
+    keys.push_back(key);
+    dict.set_ref(td::BitArray<32>{key}, vm::CellBuilder().store_long(key, 32).finalize());
+  }
+  auto frozen = vm::FrozenDictionary::get(dict.get_root_cell(), 32);
+  ASSERT_TRUE(frozen.not_null());
+  ASSERT_EQ(frozen.get(), vm::FrozenDictionary::get(dict.get_root_cell(), 32).get());
+  for (int i = 0; i < 2000; i++) {
+    td::BitArray<32> key{i < 1000 ? keys[i] : td::Random::fast(-100000, 100000)};
+    auto expected = dict.lookup_ref(key);
+    auto found = frozen->lookup_ref(key.bits(), 32);
+    ASSERT_EQ(expected.is_null(), found.is_null());
+    if (expected.not_null()) {
+      ASSERT_EQ(expected->get_hash(), found->get_hash());
+    }
+    auto cs = frozen->lookup(key.bits(), 32);
+    ASSERT_EQ(found.is_null(), cs.is_null());
+  }
+  ASSERT_TRUE(frozen->lookup(td::BitArray<16>{}.bits(), 16).is_null());
+
+  vm::FrozenDictionary::enable(true);
+  SCOPE_EXIT {
+    vm::FrozenDictionary::enable(false);
+    vm::FrozenDictionary::clear_cache();
+  };
+  ASSERT_EQ(dict.lookup_ref(td::BitArray<32>{keys[0]})->get_hash(),
+            vm::FrozenDictionary::lookup_ref_in(dict, td::BitArray<32>{keys[0]})->get_hash());
+
+  // lookups in usage-tracked dictionaries must load their cells
+  auto usage_tree = std::make_shared<vm::CellUsageTree>();
+  auto usage_root = vm::UsageCell::create(dict.get_root_cell(), usage_tree->root_ptr());
+  ASSERT_TRUE(vm::FrozenDictionary::get(usage_root, 32).is_null());
+  vm::Dictionary usage_dict{usage_root, 32};
+  ASSERT_TRUE(vm::FrozenDictionary::lookup_ref_in(usage_dict, td::BitArray<32>{keys[0]}).not_null());
+  ASSERT_TRUE(usage_tree->is_loaded(usage_tree->root_id()));
+}
+
+TEST(VM, frozen_dictionary_cache_eviction) {
+  vm::FrozenDictionary::clear_cache();
+  SCOPE_EXIT {
+    vm::FrozenDictionary::clear_cache();
+  };
+  std::size_t max_cached = vm::FrozenDictionary::max_cached_dicts;
+  std::vector<td::Ref<vm::Cell>> roots;
+  for (std::size_t i = 0; i <= max_cached; i++) {
+    vm::Dictionary dict{32};
+    dict.set_ref(td::BitArray<32>{static_cast<td::int32>(i)}, vm::CellBuilder().store_long(i, 32).finalize());
+    roots.push_back(dict.get_root_cell());
+  }
+  auto first = vm::FrozenDictionary::get(roots[0], 32);
+  auto second = vm::FrozenDictionary::get(roots[1], 32);
+  ASSERT_TRUE(first.not_null() && second.not_null());
+  for (std::size_t i = 2; i < roots.size(); i++) {
+    // keeps the first view recently used
+    ASSERT_EQ(first.get(), vm::FrozenDictionary::get(roots[0], 32).get());
+    ASSERT_TRUE(vm::FrozenDictionary::get(roots[i], 32).not_null());
+  }
+  ASSERT_EQ(max_cached, vm::FrozenDictionary::cache_size());
+  ASSERT_EQ(first.get(), vm::FrozenDictionary::get(roots[0], 32).get());
+  ASSERT_TRUE(second.get() != vm::FrozenDictionary::get(roots[1], 32).get());
+}
+
+TEST(VM, decode_cache) {
+  std::vector<td::Ref<vm::Cell>> programs;
+  for (auto code_hex : {"ABCBABABABA", "90707FDB3B", "6883FF73A98D", "778B04216D73F43E018B04591277F473",
+                        "78E58B008B028B04010000016D90ED5272F43A755D77F4A8"}) {
+    programs.push_back(parse_code_hex(td::Slice(code_hex)));
+  }
+  programs.push_back(fift::compile_asm(R"A(
+0 INT
+20 INT
+REPEAT:<{
+  CONT:<{ 3 INT ADD }>
+  EXECUTE
+  DUP 7 INT MOD
+  IFNOT:<{ INC }>
+}>
+)A")
+                         .move_as_ok());
+  SCOPE_EXIT {
+    vm::OpcodeTable::enable_decode_cache(false);
+    vm::init_op_cp0()->clear_decode_cache();
+  };
+  for (auto &code : programs) {
+    vm::OpcodeTable::enable_decode_cache(false);
+    auto plain = run_vm(code);
+    vm::OpcodeTable::enable_decode_cache(true);
+    ASSERT_EQ(plain, run_vm(code));
+    ASSERT_EQ(plain, run_vm(code));
+  }
+  ASSERT_TRUE(vm::init_op_cp0()->decode_cache_size() > 0);
+
+  // the cache evicts old cells instead of dropping everything once it is full
+  const int max_cells = static_cast<int>(vm::OpcodeTable::max_decode_cache_cells);
+  for (int i = 0; i < max_cells + 1000; i++) {
+    // PUSHINT i; DROP
+    auto code = vm::CellBuilder().store_long(0x81, 8).store_long(i, 16).store_long(0x30, 8).finalize();
+    vm::Stack stack;
+    ASSERT_EQ(0, vm::run_vm_code(vm::load_cell_slice_ref(code), stack));
+  }
+  auto size = vm::init_op_cp0()->decode_cache_size();
+  ASSERT_TRUE(size <= vm::OpcodeTable::max_decode_cache_cells);
+  ASSERT_TRUE(size > vm::OpcodeTable::max_decode_cache_cells / 2);
+}
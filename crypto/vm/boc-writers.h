@@ -0,0 +1,155 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/crypto.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/Status.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace vm {
+namespace boc_writers {
+
+// Writers used by BagOfCells::serialize_to_impl. BufferWriter stores into a preallocated buffer,
+// FileWriter streams the data into a file through a bounded buffer and computes CRC32C on the fly.
+class BufferWriter {
+ public:
+  BufferWriter(unsigned char* store_start, unsigned char* store_end)
+      : store_start_(store_start), store_ptr_(store_start), store_end_(store_end) {
+  }
+
+  std::size_t position() const {
+    return store_ptr_ - store_start_;
+  }
+  std::size_t remaining() const {
+    return store_end_ - store_ptr_;
+  }
+  void chk() const {
+    DCHECK(store_ptr_ <= store_end_);
+  }
+  bool empty() const {
+    return store_ptr_ == store_end_;
+  }
+  void store_uint(unsigned long long value, unsigned bytes) {
+    unsigned char* ptr = store_ptr_ += bytes;
+    chk();
+    while (bytes) {
+      *--ptr = value & 0xff;
+      value >>= 8;
+      --bytes;
+    }
+  }
+  void store_bytes(const unsigned char* data, std::size_t size) {
+    std::memcpy(store_ptr_, data, size);
+    store_ptr_ += size;
+    chk();
+  }
+  unsigned get_crc32() const {
+    return td::crc32c(td::Slice{store_start_, store_ptr_});
+  }
+
+ private:
+  unsigned char* store_start_;
+  unsigned char* store_ptr_;
+  unsigned char* store_end_;
+};
+
+class FileWriter {
+ public:
+  static constexpr std::size_t default_buffer_size = 1 << 22;
+
+  FileWriter(td::FileFd& fd, std::size_t expected_size, std::size_t buffer_size = default_buffer_size)
+      : fd_(fd), expected_size_(expected_size), buffer_(buffer_size) {
+  }
+
+  std::size_t position() const {
+    return flushed_size_ + buffer_pos_;
+  }
+  std::size_t remaining() const {
+    return expected_size_ - position();
+  }
+  void chk() const {
+    DCHECK(position() <= expected_size_);
+  }
+  bool empty() const {
+    return position() == expected_size_;
+  }
+  void store_uint(unsigned long long value, unsigned bytes) {
+    unsigned char buf[8];
+    unsigned char* ptr = buf + bytes;
+    while (ptr != buf) {
+      *--ptr = value & 0xff;
+      value >>= 8;
+    }
+    store_bytes(buf, bytes);
+  }
+  void store_bytes(const unsigned char* data, std::size_t size) {
+    while (size > 0) {
+      if (buffer_pos_ == buffer_.size()) {
+        flush();
+      }
+      auto len = std::min(size, buffer_.size() - buffer_pos_);
+      std::memcpy(buffer_.data() + buffer_pos_, data, len);
+      buffer_pos_ += len;
+      data += len;
+      size -= len;
+    }
+    chk();
+  }
+  unsigned get_crc32() const {
+    return td::crc32c_extend(crc32c_, td::Slice{buffer_.data(), buffer_pos_});
+  }
+
+  // writes out the buffered data and returns the first error encountered while writing
+  td::Status finalize() {
+    flush();
+    return std::move(res_);
+  }
+
+ private:
+  void flush() {
+    td::Slice data{buffer_.data(), buffer_pos_};
+    crc32c_ = td::crc32c_extend(crc32c_, data);
+    flushed_size_ += buffer_pos_;
+    buffer_pos_ = 0;
+    while (res_.is_ok() && !data.empty()) {
+      auto r_written = fd_.write(data);
+      if (r_written.is_error()) {
+        res_ = r_written.move_as_error();
+        break;
+      }
+      data.remove_prefix(r_written.ok());
+    }
+  }
+
+  td::FileFd& fd_;
+  std::size_t expected_size_;
+  std::size_t flushed_size_{0};
+  std::vector<unsigned char> buffer_;
+  std::size_t buffer_pos_{0};
+  td::uint32 crc32c_{0};
+  td::Status res_;
+};
+
+}  // namespace boc_writers
+}  // namespace vm
@@ -20,12 +20,14 @@
 #include <iomanip>
 #include <algorithm>
 #include "vm/boc.h"
+#include "vm/boc-writers.h"
 #include "vm/cells.h"
 #include "vm/cellslice.h"
 #include "td/utils/bits.h"
 #include "td/utils/Slice-decl.h"
 #include "td/utils/format.h"
 #include "td/utils/crypto.h"
+#include "td/utils/ThreadPool.h"
 
 namespace vm {
 using td::Ref;
@@ -96,6 +98,27 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
   }
   TRY_RESULT(res, cb.finalize_novm_nothrow(special));
   CHECK(!res.is_null());
+  TRY_STATUS(check_data_cell(cell_slice, res));
+  return res;
+}
+
+td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell_slice, td::Span<Ref<Cell>> refs,
+                                                                  std::shared_ptr<const void> data_owner) const {
+  TRY_RESULT(bits, get_bits(cell_slice));
+  DCHECK(refs_cnt == (td::int64)refs.size());
+  std::array<Ref<Cell>, 4> copied_refs;
+  for (int k = 0; k < refs_cnt; k++) {
+    copied_refs[k] = refs[k];
+  }
+  TRY_RESULT(res, DataCell::create_external(cell_slice.substr(data_offset, (bits + 7) / 8), bits,
+                                            td::MutableSpan<Ref<Cell>>(copied_refs.data(), refs_cnt), special,
+                                            std::move(data_owner)));
+  CHECK(!res.is_null());
+  TRY_STATUS(check_data_cell(cell_slice, res));
+  return res;
+}
+
+td::Status CellSerializationInfo::check_data_cell(td::Slice cell_slice, const Ref<DataCell>& res) const {
   if (res->is_special() != special) {
     return td::Status::Error("is_special mismatch");
   }
@@ -134,7 +157,7 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
       hash_i++;
     }
   }
-  return res;
+  return td::Status::OK();
 }
 
 void BagOfCells::clear() {
@@ -474,17 +497,6 @@ std::string BagOfCells::extract_string() const {
   return std::string{serialized.data(), serialized.data() + serialized.size()};
 }
 
-void BagOfCells::store_uint(unsigned long long value, unsigned bytes) {
-  unsigned char* ptr = store_ptr += bytes;
-  store_chk();
-  while (bytes) {
-    *--ptr = value & 0xff;
-    value >>= 8;
-    --bytes;
-  }
-  DCHECK(!bytes);
-}
-
 //serialized_boc#672fb0ac has_idx:(## 1) has_crc32c:(## 1)
 //  has_cache_bits:(## 1) flags:(## 2) { flags = 0 }
 //  size:(## 3) { size <= 4 }
@@ -501,8 +513,30 @@ std::size_t BagOfCells::serialize_to(unsigned char* buffer, std::size_t buff_siz
   if (!size_est || size_est > buff_size) {
     return 0;
   }
-  init_store(buffer, buffer + size_est);
-  store_uint(info.magic, 4);
+  boc_writers::BufferWriter writer{buffer, buffer + size_est};
+  return serialize_to_impl(writer, mode);
+}
+
+td::Status BagOfCells::serialize_to_file(td::FileFd& fd, int mode) {
+  std::size_t size_est = estimate_serialized_size(mode);
+  if (!size_est) {
+    return td::Status::Error("no cells to serialize to this bag of cells");
+  }
+  boc_writers::FileWriter writer{fd, size_est};
+  std::size_t s = serialize_to_impl(writer, mode);
+  TRY_STATUS(writer.finalize());
+  if (s != size_est) {
+    return td::Status::Error("error while serializing a bag of cells: actual serialized size differs from estimated");
+  }
+  return td::Status::OK();
+}
+
+template <typename WriterT>
+std::size_t BagOfCells::serialize_to_impl(WriterT& writer, int mode) {
+  auto store_ref = [&](unsigned long long value) { writer.store_uint(value, info.ref_byte_size); };
+  auto store_offset = [&](unsigned long long value) { writer.store_uint(value, info.offset_byte_size); };
+
+  writer.store_uint(info.magic, 4);
 
   td::uint8 byte{0};
   if (info.has_index) {
@@ -519,9 +553,9 @@ std::size_t BagOfCells::serialize_to(unsigned char* buffer, std::size_t buff_siz
     return 0;
   }
   byte |= static_cast<td::uint8>(info.ref_byte_size);
-  store_uint(byte, 1);
+  writer.store_uint(byte, 1);
 
-  store_uint(info.offset_byte_size, 1);
+  writer.store_uint(info.offset_byte_size, 1);
   store_ref(cell_count);
   store_ref(root_count);
   store_ref(0);
@@ -531,7 +565,7 @@ std::size_t BagOfCells::serialize_to(unsigned char* buffer, std::size_t buff_siz
     DCHECK(k >= 0 && k < cell_count);
     store_ref(k);
   }
-  DCHECK(store_ptr - buffer == (long long)info.index_offset);
+  DCHECK(writer.position() == info.index_offset);
   DCHECK((unsigned)cell_count == cell_list_.size());
   if (info.has_index) {
     std::size_t offs = 0;
@@ -550,8 +584,9 @@ std::size_t BagOfCells::serialize_to(unsigned char* buffer, std::size_t buff_siz
     }
     DCHECK(offs == info.data_size);
   }
-  DCHECK(store_ptr - buffer == (long long)info.data_offset);
-  unsigned char* keep_ptr = store_ptr;
+  DCHECK(writer.position() == info.data_offset);
+  std::size_t keep_position = writer.position();
+  unsigned char buf[256];
   for (int i = 0; i < cell_count; ++i) {
     const auto& dc_info = cell_list_[cell_count - 1 - i];
     const Ref<DataCell>& dc = dc_info.dc_ref;
@@ -559,9 +594,8 @@ std::size_t BagOfCells::serialize_to(unsigned char* buffer, std::size_t buff_siz
     if (dc_info.is_root_cell && (mode & Mode::WithTopHash)) {
       with_hash = true;
     }
-    int s = dc->serialize(store_ptr, 256, with_hash);
-    store_ptr += s;
-    store_chk();
+    int s = dc->serialize(buf, 256, with_hash);
+    writer.store_bytes(buf, s);
     DCHECK(dc->size_refs() == dc_info.ref_num);
     // std::cerr << (dc_info.is_special() ? '*' : ' ') << i << '<' << (int)dc_info.wt << ">:";
     for (unsigned j = 0; j < dc_info.ref_num; ++j) {
@@ -572,16 +606,15 @@ std::size_t BagOfCells::serialize_to(unsigned char* buffer, std::size_t buff_siz
     }
     // std::cerr << std::endl;
   }
-  store_chk();
-  DCHECK(store_ptr - keep_ptr == (long long)info.data_size);
-  DCHECK(store_end - store_ptr == (info.has_crc32c ? 4 : 0));
+  writer.chk();
+  DCHECK(writer.position() - keep_position == info.data_size);
+  DCHECK(writer.remaining() == (info.has_crc32c ? 4 : 0));
   if (info.has_crc32c) {
-    // compute crc32c of buffer .. store_ptr
-    unsigned crc = td::crc32c(td::Slice{buffer, store_ptr});
-    store_uint(td::bswap32(crc), 4);
+    unsigned crc = writer.get_crc32();
+    writer.store_uint(td::bswap32(crc), 4);
   }
-  DCHECK(store_empty());
-  return store_ptr - buffer;
+  DCHECK(writer.empty());
+  return writer.position();
 }
 
 unsigned long long BagOfCells::Info::read_int(const unsigned char* ptr, unsigned bytes) {
@@ -715,19 +748,14 @@ td::Result<td::Slice> BagOfCells::get_cell_slice(int idx, td::Slice data) {
   return data.substr(offs, td::narrow_cast<size_t>(offs_end - offs));
 }
 
-td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slice cells_slice,
-                                                               td::Span<td::Ref<DataCell>> cells_span,
-                                                               std::vector<td::uint8>* cell_should_cache) {
+td::Result<td::Slice> BagOfCells::parse_cell(int idx, td::Slice cells_slice, CellSerializationInfo& cell_info,
+                                             std::array<int, 4>& refs_idx) {
   TRY_RESULT(cell_slice, get_cell_slice(idx, cells_slice));
-  std::array<td::Ref<Cell>, 4> refs_buf;
-
-  CellSerializationInfo cell_info;
   TRY_STATUS(cell_info.init(cell_slice, info.ref_byte_size));
   if (cell_info.end_offset != cell_slice.size()) {
     return td::Status::Error("unused space in cell serialization");
   }
 
-  auto refs = td::MutableSpan<td::Ref<Cell>>(refs_buf).substr(0, cell_info.refs_cnt);
   for (int k = 0; k < cell_info.refs_cnt; k++) {
     int ref_idx = (int)info.read_ref(cell_slice.ubegin() + cell_info.refs_offset + k * info.ref_byte_size);
     if (ref_idx <= idx) {
@@ -739,19 +767,12 @@ td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slic
                                         << " is to non-existent cell #" << ref_idx << ", only " << cell_count
                                         << " cells are defined");
     }
-    refs[k] = cells_span[cell_count - ref_idx - 1];
-    if (cell_should_cache) {
-      auto& cnt = (*cell_should_cache)[ref_idx];
-      if (cnt < 2) {
-        cnt++;
-      }
-    }
+    refs_idx[k] = ref_idx;
   }
-
-  return cell_info.create_data_cell(cell_slice, refs);
+  return cell_slice;
 }
 
-td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roots) {
+td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roots, td::ThreadPool* pool) {
   clear();
   long long size_est = info.parse_serialized_header(data);
   //LOG(INFO) << "estimated size " << size_est << ", true size " << data.size();
@@ -833,19 +854,124 @@ td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roo
     }
   }
   auto cells_slice = data.substr(info.data_offset, info.data_size);
-  std::vector<Ref<DataCell>> cell_list;
-  cell_list.reserve(cell_count);
-  std::array<td::Ref<Cell>, 4> refs_buf;
+  auto cell_error = [](int idx, const td::Status& error) {
+    return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " " << error);
+  };
+
+  // Cells are created layer by layer, starting from the cells without references, so that the hashes of
+  // many cells are computed at once. Position i corresponds to the cell with index cell_count - 1 - i.
+  std::vector<int> cell_height(cell_count);
+  int max_height = 0;
   for (int i = 0; i < cell_count; i++) {
-    // reconstruct cell with index cell_count - 1 - i
     int idx = cell_count - 1 - i;
-    auto r_cell = deserialize_cell(idx, cells_slice, cell_list, info.has_cache_bits ? &cell_should_cache : nullptr);
-    if (r_cell.is_error()) {
-      return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
-                                        << r_cell.error());
+    CellSerializationInfo cell_info;
+    std::array<int, 4> refs_idx;
+    auto r_cell_slice = parse_cell(idx, cells_slice, cell_info, refs_idx);
+    if (r_cell_slice.is_error()) {
+      return cell_error(idx, r_cell_slice.error());
+    }
+    int height = 0;
+    for (int k = 0; k < cell_info.refs_cnt; k++) {
+      height = std::max(height, cell_height[cell_count - 1 - refs_idx[k]] + 1);
+      if (info.has_cache_bits) {
+        auto& cnt = cell_should_cache[refs_idx[k]];
+        if (cnt < 2) {
+          cnt++;
+        }
+      }
+    }
+    cell_height[i] = height;
+    max_height = std::max(max_height, height);
+  }
+
+  std::vector<int> layer_begin(max_height + 2, 0);
+  for (int i = 0; i < cell_count; i++) {
+    layer_begin[cell_height[i] + 1]++;
+  }
+  for (int height = 0; height <= max_height; height++) {
+    layer_begin[height + 1] += layer_begin[height];
+  }
+  std::vector<int> layers(cell_count);
+  {
+    auto layer_end = layer_begin;
+    for (int i = 0; i < cell_count; i++) {
+      layers[layer_end[cell_height[i]]++] = i;
+    }
+  }
+  cell_height = {};
+
+  // Every layer is split into chunks of at most max_batch_size cells. The chunks of a layer are processed
+  // after all chunks of the previous layers are finished, so the references of their cells are already created.
+  // With a thread pool the chunks of a layer are processed by several threads.
+  constexpr int max_batch_size = 1024;
+  std::vector<Ref<DataCell>> cell_list(cell_count);
+  auto process_chunk = [&](int begin, int end) -> td::Status {
+    int batch_size = end - begin;
+    std::vector<CellSerializationInfo> batch_info(batch_size);
+    std::vector<td::Slice> batch_slices(batch_size);
+    std::vector<std::array<Ref<Cell>, 4>> batch_refs(batch_size);
+    std::vector<DataCell::CreateArgs> batch_args;
+    batch_args.reserve(batch_size);
+    for (int j = 0; j < batch_size; j++) {
+      int idx = cell_count - 1 - layers[begin + j];
+      auto& cell_info = batch_info[j];
+      std::array<int, 4> refs_idx;
+      // the cell was successfully parsed before
+      batch_slices[j] = parse_cell(idx, cells_slice, cell_info, refs_idx).move_as_ok();
+      auto r_bits = cell_info.get_bits(batch_slices[j]);
+      if (r_bits.is_error()) {
+        return cell_error(idx, r_bits.error());
+      }
+      if (r_bits.ok() < 0) {
+        return cell_error(idx, td::Status::Error("negative cell data length"));
+      }
+      for (int k = 0; k < cell_info.refs_cnt; k++) {
+        batch_refs[j][k] = cell_list[cell_count - 1 - refs_idx[k]];
+      }
+      batch_args.push_back(DataCell::CreateArgs{batch_slices[j].ubegin() + cell_info.data_offset,
+                                                static_cast<unsigned>(r_bits.ok()),
+                                                td::MutableSpan<Ref<Cell>>(batch_refs[j].data(), cell_info.refs_cnt),
+                                                cell_info.special});
+    }
+    auto cells = DataCell::create_batch(batch_args);
+    for (int j = 0; j < batch_size; j++) {
+      int idx = cell_count - 1 - layers[begin + j];
+      if (cells[j].is_error()) {
+        return cell_error(idx, cells[j].error());
+      }
+      auto cell = cells[j].move_as_ok();
+      auto status = batch_info[j].check_data_cell(batch_slices[j], cell);
+      if (status.is_error()) {
+        return cell_error(idx, status);
+      }
+      cell_list[layers[begin + j]] = std::move(cell);
+    }
+    return td::Status::OK();
+  };
+  std::vector<td::Status> chunk_status;
+  for (int height = 0; height <= max_height; height++) {
+    int begin = layer_begin[height];
+    int end = layer_begin[height + 1];
+    int chunks_n = (end - begin + max_batch_size - 1) / max_batch_size;
+    chunk_status.clear();
+    chunk_status.resize(chunks_n);
+    auto run_chunk = [&](size_t chunk) {
+      int chunk_begin = begin + static_cast<int>(chunk) * max_batch_size;
+      chunk_status[chunk] = process_chunk(chunk_begin, std::min(chunk_begin + max_batch_size, end));
+    };
+    if (pool) {
+      pool->parallel_for(chunks_n, pool->size() + 1, run_chunk);
+    } else {
+      for (int chunk = 0; chunk < chunks_n; chunk++) {
+        run_chunk(chunk);
+      }
+    }
+    // the error of the first failing chunk is the one the sequential processing would report
+    for (auto& status : chunk_status) {
+      if (status.is_error()) {
+        return std::move(status);
+      }
     }
-    cell_list.push_back(r_cell.move_as_ok());
-    DCHECK(cell_list.back().not_null());
   }
   if (info.has_cache_bits) {
     for (int idx = 0; idx < cell_count; idx++) {
@@ -907,12 +1033,12 @@ unsigned long long BagOfCells::get_idx_entry_raw(int index) {
  * 
  */
 
-td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty) {
+td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty, td::ThreadPool* pool) {
   if (data.empty() && can_be_empty) {
     return Ref<Cell>();
   }
   BagOfCells boc;
-  auto res = boc.deserialize(data, 1);
+  auto res = boc.deserialize(data, 1, pool);
   if (res.is_error()) {
     return res.move_as_error();
   }
@@ -966,6 +1092,16 @@ td::Result<td::BufferSlice> std_boc_serialize(Ref<Cell> root, int mode) {
   return boc.serialize_to_slice(mode);
 }
 
+td::Status std_boc_serialize_to_file(Ref<Cell> root, td::FileFd& fd, int mode) {
+  if (root.is_null()) {
+    return td::Status::Error("cannot serialize a null cell reference into a bag of cells");
+  }
+  BagOfCells boc;
+  boc.add_root(std::move(root));
+  TRY_STATUS(boc.import_cells());
+  return boc.serialize_to_file(fd, mode);
+}
+
 td::Result<td::BufferSlice> std_boc_serialize_multi(std::vector<Ref<Cell>> roots, int mode) {
   if (roots.empty()) {
     return td::BufferSlice{};
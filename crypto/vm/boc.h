@@ -17,12 +17,19 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #pragma once
+#include <array>
 #include <set>
+#include <memory>
 #include "vm/cells.h"
 #include "td/utils/Status.h"
 #include "td/utils/buffer.h"
 #include "td/utils/HashMap.h"
 #include "td/utils/HashSet.h"
+#include "td/utils/port/FileFd.h"
+
+namespace td {
+class ThreadPool;
+}  // namespace td
 
 namespace vm {
 using td::Ref;
@@ -165,6 +172,11 @@ struct CellSerializationInfo {
   td::Result<int> get_bits(td::Slice cell) const;
 
   td::Result<Ref<DataCell>> create_data_cell(td::Slice data, td::Span<Ref<Cell>> refs) const;
+  // the created cell may refer to the cell data instead of copying it, data must stay alive with data_owner
+  td::Result<Ref<DataCell>> create_data_cell(td::Slice data, td::Span<Ref<Cell>> refs,
+                                             std::shared_ptr<const void> data_owner) const;
+  // checks that the cell created from data has the serialized type, level and hashes
+  td::Status check_data_cell(td::Slice data, const Ref<DataCell>& cell) const;
 };
 
 class BagOfCells {
@@ -216,8 +228,6 @@ class BagOfCells {
   int max_depth{1024};
   Info info;
   unsigned long long data_bytes{0};
-  unsigned char* store_ptr{nullptr};
-  unsigned char* store_end{nullptr};
   td::HashMap<Hash, int> cells;
   struct CellInfo {
     Ref<DataCell> dc_ref;
@@ -267,9 +277,13 @@ class BagOfCells {
   std::string serialize_to_string(int mode = 0);
   td::Result<td::BufferSlice> serialize_to_slice(int mode = 0);
   std::size_t serialize_to(unsigned char* buffer, std::size_t buff_size, int mode = 0);
+  // writes the serialization through a bounded buffer, so the whole bag of cells is never kept in memory
+  td::Status serialize_to_file(td::FileFd& fd, int mode = 0);
   std::string extract_string() const;
 
-  td::Result<long long> deserialize(const td::Slice& data, int max_roots = default_max_roots);
+  // with a thread pool the cells of every dependency level are created and hashed by several threads
+  td::Result<long long> deserialize(const td::Slice& data, int max_roots = default_max_roots,
+                                    td::ThreadPool* pool = nullptr);
   td::Result<long long> deserialize(const unsigned char* buffer, std::size_t buff_size,
                                     int max_roots = default_max_roots) {
     return deserialize(td::Slice{buffer, buff_size}, max_roots);
@@ -295,35 +309,21 @@ class BagOfCells {
     cell_list_.clear();
   }
   td::uint64 compute_sizes(int mode, int& r_size, int& o_size);
-  void init_store(unsigned char* from, unsigned char* to) {
-    store_ptr = from;
-    store_end = to;
-  }
-  void store_chk() const {
-    DCHECK(store_ptr <= store_end);
-  }
-  bool store_empty() const {
-    return store_ptr == store_end;
-  }
-  void store_uint(unsigned long long value, unsigned bytes);
-  void store_ref(unsigned long long value) {
-    store_uint(value, info.ref_byte_size);
-  }
-  void store_offset(unsigned long long value) {
-    store_uint(value, info.offset_byte_size);
-  }
+  template <typename WriterT>
+  std::size_t serialize_to_impl(WriterT& writer, int mode);
   void reorder_cells();
   int revisit(int cell_idx, int force = 0);
   unsigned long long get_idx_entry_raw(int index);
   unsigned long long get_idx_entry(int index);
   bool get_cache_entry(int index);
   td::Result<td::Slice> get_cell_slice(int index, td::Slice data);
-  td::Result<td::Ref<vm::DataCell>> deserialize_cell(int index, td::Slice data, td::Span<td::Ref<DataCell>> cells,
-                                                     std::vector<td::uint8>* cell_should_cache);
+  td::Result<td::Slice> parse_cell(int index, td::Slice data, CellSerializationInfo& cell_info,
+                                   std::array<int, 4>& refs_idx);
 };
 
-td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty = false);
+td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty = false, td::ThreadPool* pool = nullptr);
 td::Result<td::BufferSlice> std_boc_serialize(Ref<Cell> root, int mode = 0);
+td::Status std_boc_serialize_to_file(Ref<Cell> root, td::FileFd& fd, int mode = 0);
 
 td::Result<std::vector<Ref<Cell>>> std_boc_deserialize_multi(td::Slice data,
                                                              int max_roots = BagOfCells::default_max_roots);
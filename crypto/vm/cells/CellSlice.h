@@ -140,6 +140,9 @@ class CellSlice : public td::CntObject {
   unsigned get_cell_level() const;
   unsigned get_level() const;
   Ref<Cell> get_base_cell() const;  // be careful with this one!
+  const Ref<DataCell>& get_data_cell() const {  // no virtualization and no usage tracking
+    return cell;
+  }
   int fetch_octet();
   int prefetch_octet() const;
   unsigned long long prefetch_ulong_top(unsigned& bits) const;
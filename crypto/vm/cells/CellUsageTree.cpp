@@ -19,6 +19,10 @@
 #include "vm/cells/CellUsageTree.h"
 
 namespace vm {
+namespace {
+thread_local CellUsageTree::LoadJournal* current_load_journal;
+}  // namespace
+
 //
 // CellUsageTree::NodePtr
 //
@@ -58,6 +62,24 @@ bool CellUsageTree::NodePtr::mark_path(CellUsageTree* master_tree) const {
   return true;
 }
 
+//
+// CellUsageTree::LoadJournal
+//
+void CellUsageTree::LoadJournal::apply() {
+  for (auto node_id : loaded_) {
+    tree_->nodes_[node_id].is_loaded = true;
+  }
+  loaded_.clear();
+}
+
+CellUsageTree::LoadJournal::Guard::Guard(LoadJournal* journal) : prev_(current_load_journal) {
+  current_load_journal = journal;
+}
+
+CellUsageTree::LoadJournal::Guard::~Guard() {
+  current_load_journal = prev_;
+}
+
 //
 // CellUsageTree
 //
@@ -111,12 +133,25 @@ void CellUsageTree::set_use_mark_for_is_loaded(bool use_mark) {
   use_mark_ = use_mark;
 }
 
+void CellUsageTree::set_concurrent(bool concurrent) {
+  concurrent_ = concurrent;
+}
+
 void CellUsageTree::on_load(NodeId node_id) {
+  auto journal = current_load_journal;
+  if (journal && journal->tree_.get() == this) {
+    journal->loaded_.push_back(node_id);
+    return;
+  }
   nodes_[node_id].is_loaded = true;
 }
 
 CellUsageTree::NodeId CellUsageTree::create_child(NodeId node_id, unsigned ref_id) {
   DCHECK(ref_id < CellTraits::max_refs);
+  std::unique_lock<std::mutex> lock;
+  if (concurrent_) {
+    lock = std::unique_lock<std::mutex>(mutex_);
+  }
   NodeId res = nodes_[node_id].children[ref_id];
   if (res) {
     return res;
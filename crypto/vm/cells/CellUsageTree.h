@@ -23,6 +23,10 @@
 #include "td/utils/int_types.h"
 #include "td/utils/logging.h"
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace vm {
 class CellUsageTree : public std::enable_shared_from_this<CellUsageTree> {
  public:
@@ -48,6 +52,32 @@ class CellUsageTree : public std::enable_shared_from_this<CellUsageTree> {
     NodeId node_id_{0};
   };
 
+  // Collects the loads of cells of one tree performed by the current thread instead of marking them at once,
+  // so that the loads of speculative work can be committed or dropped later.
+  class LoadJournal {
+   public:
+    explicit LoadJournal(std::shared_ptr<CellUsageTree> tree) : tree_(std::move(tree)) {
+    }
+    // marks all recorded nodes as loaded; must not run concurrently with other users of the tree
+    void apply();
+
+    class Guard {
+     public:
+      explicit Guard(LoadJournal* journal);
+      Guard(const Guard&) = delete;
+      Guard& operator=(const Guard&) = delete;
+      ~Guard();
+
+     private:
+      LoadJournal* prev_;
+    };
+
+   private:
+    friend class CellUsageTree;
+    std::shared_ptr<CellUsageTree> tree_;
+    std::vector<NodeId> loaded_;
+  };
+
   NodePtr root_ptr();
   NodeId root_id() const;
   bool is_loaded(NodeId node_id) const;
@@ -58,6 +88,9 @@ class CellUsageTree : public std::enable_shared_from_this<CellUsageTree> {
   NodeId get_child(NodeId node_id, unsigned ref_id);
   void set_use_mark_for_is_loaded(bool use_mark = true);
   NodeId create_child(NodeId node_id, unsigned ref_id);
+  // allows several threads to load cells of this tree at the same time, provided that each of them
+  // records its loads into a LoadJournal
+  void set_concurrent(bool concurrent = true);
 
  private:
   struct Node {
@@ -67,6 +100,8 @@ class CellUsageTree : public std::enable_shared_from_this<CellUsageTree> {
     std::array<td::uint32, CellTraits::max_refs> children{};
   };
   bool use_mark_{false};
+  bool concurrent_{false};
+  std::mutex mutex_;
   std::vector<Node> nodes_{2};
 
   void on_load(NodeId node_id);
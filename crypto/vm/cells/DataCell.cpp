@@ -20,10 +20,12 @@
 
 #include "openssl/digest.hpp"
 
-#include "td/utils/ScopeGuard.h"
+#include "td/utils/crypto.h"
 
 #include "vm/cells/CellWithStorage.h"
 
+#include <cstring>
+
 namespace vm {
 std::unique_ptr<DataCell> DataCell::create_empty_data_cell(Info info) {
   return detail::CellWithUniquePtrStorage<DataCell>::create(info.get_storage_size(), info);
@@ -41,6 +43,9 @@ void DataCell::destroy_storage(char* storage) {
   for (size_t i = 0; i < get_refs_cnt(); i++) {
     Ref<Cell>(refs[i], Ref<Cell>::acquire_t{});  // call destructor
   }
+  if (info_.has_external_data_) {
+    info_.get_external_data(storage)->~ExternalData();
+  }
 }
 
 td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits, td::Span<Ref<Cell>> refs,
@@ -60,8 +65,9 @@ DataCell::SpecialType DataCell::special_type() const {
   return SpecialType::Ordinary;
 }
 
-td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
-                                           bool special) {
+td::Result<std::unique_ptr<DataCell>> DataCell::create_unhashed(td::ConstBitPtr data, unsigned bits,
+                                                                td::MutableSpan<Ref<Cell>> refs, bool special,
+                                                                std::shared_ptr<const void> data_owner) {
   for (auto& ref : refs) {
     if (ref.is_null()) {
       return td::Status::Error("Has null cell reference");
@@ -187,18 +193,33 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
   info.level_mask_ = level_mask.get_mask() & 7;
   info.hash_count_ = hash_count & 7;
   info.virtualization_ = virtualization & 7;
+  info.has_external_data_ = false;
+  if (data_owner && data.offs == 0 && (bits + 7) / 8 >= min_external_data_size) {
+    // external data must already be prepared for serialization
+    if (bits & 7) {
+      int m = (0x80 >> (bits & 7));
+      unsigned l = bits / 8;
+      info.has_external_data_ = data.ptr[l] == static_cast<unsigned char>((data.ptr[l] & -m) | m);
+    } else {
+      info.has_external_data_ = true;
+    }
+  }
 
   auto data_cell = create_empty_data_cell(info);
   auto* storage = data_cell->get_storage();
 
   // init data
-  auto* data_ptr = info.get_data(storage);
-  td::BitPtr{data_ptr}.copy_from(data, bits);
-  // prepare for serialization
-  if (bits & 7) {
-    int m = (0x80 >> (bits & 7));
-    unsigned l = bits / 8;
-    data_ptr[l] = static_cast<unsigned char>((data_ptr[l] & -m) | m);
+  if (info.has_external_data_) {
+    new (info.get_external_data(storage)) ExternalData{data.ptr, std::move(data_owner)};
+  } else {
+    auto* data_ptr = info.get_data(storage);
+    td::BitPtr{data_ptr}.copy_from(data, bits);
+    // prepare for serialization
+    if (bits & 7) {
+      int m = (0x80 >> (bits & 7));
+      unsigned l = bits / 8;
+      data_ptr[l] = static_cast<unsigned char>((data_ptr[l] & -m) | m);
+    }
   }
 
   // init refs
@@ -207,81 +228,155 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
     refs_ptr[i] = refs[i].release();
   }
 
-  // init hashes and depth
-  auto* hashes_ptr = info.get_hashes(storage);
+  // init depth
   auto* depth_ptr = info.get_depth(storage);
+  for (td::uint32 dest_i = 0; dest_i < hash_count; dest_i++) {
+    auto child_level_i = data_cell->get_child_level(dest_i, type);
+    td::uint16 depth = 0;
+    for (int i = 0; i < info.refs_count_; i++) {
+      depth = std::max(depth, refs_ptr[i]->get_depth(child_level_i));
+    }
+    if (info.refs_count_ != 0) {
+      if (depth >= max_depth) {
+        return td::Status::Error("Depth is too big");
+      }
+      depth++;
+    }
+    depth_ptr[dest_i] = depth;
+  }
+
+  return std::move(data_cell);
+}
 
+td::uint32 DataCell::get_child_level(td::uint32 dest_i, SpecialType type) const {
   // NB: be careful with special cells
-  auto total_hash_count = level_mask.get_hashes_count();
-  auto hash_i_offset = total_hash_count - hash_count;
+  auto level_mask = get_level_mask();
+  auto hash_i_offset = level_mask.get_hashes_count() - info_.hash_count_;
   for (td::uint32 level_i = 0, hash_i = 0, level = level_mask.get_level(); level_i <= level; level_i++) {
     if (!level_mask.is_significant(level_i)) {
       continue;
     }
-    SCOPE_EXIT {
-      hash_i++;
-    };
-    if (hash_i < hash_i_offset) {
-      continue;
+    if (hash_i == hash_i_offset + dest_i) {
+      if (type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate) {
+        return level_i + 1;
+      }
+      return level_i;
     }
-    unsigned char tmp[2];
-    tmp[0] = info.d1(level_mask.apply(level_i));
-    tmp[1] = info.d2();
+    hash_i++;
+  }
+  UNREACHABLE();
+}
+
+size_t DataCell::store_hash_input(td::uint32 dest_i, SpecialType type, unsigned char* dest) const {
+  auto* storage = get_storage();
+  auto child_level_i = get_child_level(dest_i, type);
+  auto level_i = type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate ? child_level_i - 1
+                                                                                        : child_level_i;
+  auto* begin = dest;
+  *dest++ = info_.d1(get_level_mask().apply(level_i));
+  *dest++ = info_.d2();
+
+  if (dest_i == 0) {
+    DCHECK(level_i == 0 || type == SpecialType::PrunnedBranch);
+    auto size = (info_.bits_ + 7) >> 3;
+    std::memcpy(dest, info_.get_data(storage), size);
+    dest += size;
+  } else {
+    DCHECK(level_i != 0 && type != SpecialType::PrunnedBranch);
+    std::memcpy(dest, info_.get_hashes(storage)[dest_i - 1].as_slice().data(), hash_bytes);
+    dest += hash_bytes;
+  }
+
+  auto* refs_ptr = info_.get_refs(storage);
+  // children depth
+  for (int i = 0; i < info_.refs_count_; i++) {
+    store_depth(dest, refs_ptr[i]->get_depth(child_level_i));
+    dest += depth_bytes;
+  }
+  // children hash
+  for (int i = 0; i < info_.refs_count_; i++) {
+    std::memcpy(dest, refs_ptr[i]->get_hash(child_level_i).as_slice().data(), hash_bytes);
+    dest += hash_bytes;
+  }
+  DCHECK(static_cast<size_t>(dest - begin) <= max_hash_input_size);
+  return dest - begin;
+}
+
+td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
+                                           bool special) {
+  TRY_RESULT(data_cell, create_unhashed(std::move(data), bits, refs, special));
+  return compute_hashes(std::move(data_cell));
+}
+
+td::Result<Ref<DataCell>> DataCell::create_external(td::Slice data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
+                                                    bool special, std::shared_ptr<const void> data_owner) {
+  if (data.size() != (bits + 7) / 8) {
+    return td::Status::Error("Data size mismatch");
+  }
+  TRY_RESULT(data_cell, create_unhashed(td::ConstBitPtr{data.ubegin()}, bits, refs, special, std::move(data_owner)));
+  return compute_hashes(std::move(data_cell));
+}
+
+Ref<DataCell> DataCell::compute_hashes(std::unique_ptr<DataCell> data_cell) {
+  auto type = data_cell->special_type();
+  auto* hashes_ptr = data_cell->info_.get_hashes(data_cell->get_storage());
+  unsigned char buf[max_hash_input_size];
+  for (td::uint32 dest_i = 0; dest_i < data_cell->info_.hash_count_; dest_i++) {
+    auto size = data_cell->store_hash_input(dest_i, type, buf);
 
     static TD_THREAD_LOCAL digest::SHA256* hasher;
     td::init_thread_local<digest::SHA256>(hasher);
     hasher->reset();
+    hasher->feed(td::Slice(buf, size));
+    auto extracted_size = hasher->extract(hashes_ptr[dest_i].as_slice());
+    DCHECK(extracted_size == hash_bytes);
+  }
 
-    hasher->feed(td::Slice(tmp, 2));
+  return Ref<DataCell>(data_cell.release(), Ref<DataCell>::acquire_t{});
+}
 
-    if (hash_i == hash_i_offset) {
-      DCHECK(level_i == 0 || type == SpecialType::PrunnedBranch);
-      hasher->feed(td::Slice(data_ptr, (bits + 7) >> 3));
-    } else {
-      DCHECK(level_i != 0 && type != SpecialType::PrunnedBranch);
-      hasher->feed(hashes_ptr[hash_i - hash_i_offset - 1].as_slice());
+std::vector<td::Result<Ref<DataCell>>> DataCell::create_batch(td::Span<CreateArgs> args) {
+  std::vector<td::Result<Ref<DataCell>>> res(args.size());
+  std::vector<std::unique_ptr<DataCell>> data_cells(args.size());
+  std::vector<SpecialType> types(args.size());
+  for (size_t i = 0; i < args.size(); i++) {
+    auto r_data_cell = create_unhashed(args[i].data, args[i].bits, args[i].refs, args[i].special);
+    if (r_data_cell.is_error()) {
+      res[i] = r_data_cell.move_as_error();
+      continue;
     }
+    data_cells[i] = r_data_cell.move_as_ok();
+    types[i] = data_cells[i]->special_type();
+  }
 
-    auto dest_i = hash_i - hash_i_offset;
-
-    // calc depth
-    td::uint16 depth = 0;
-    for (int i = 0; i < info.refs_count_; i++) {
-      td::uint16 child_depth = 0;
-      if (type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate) {
-        child_depth = refs_ptr[i]->get_depth(level_i + 1);
-      } else {
-        child_depth = refs_ptr[i]->get_depth(level_i);
+  // higher hashes of a cell depend on its lower hashes, so the i-th hashes of all cells are computed together
+  std::vector<unsigned char> buf(args.size() * max_hash_input_size);
+  std::vector<td::Slice> inputs;
+  std::vector<td::MutableSlice> outputs;
+  for (td::uint32 dest_i = 0;; dest_i++) {
+    inputs.clear();
+    outputs.clear();
+    for (size_t i = 0; i < args.size(); i++) {
+      auto& data_cell = data_cells[i];
+      if (!data_cell || data_cell->info_.hash_count_ <= dest_i) {
+        continue;
       }
-
-      // add depth into hash
-      td::uint8 child_depth_buf[depth_bytes];
-      store_depth(child_depth_buf, child_depth);
-      hasher->feed(td::Slice(child_depth_buf, depth_bytes));
-
-      depth = std::max(depth, child_depth);
+      auto* ptr = buf.data() + inputs.size() * max_hash_input_size;
+      inputs.emplace_back(ptr, data_cell->store_hash_input(dest_i, types[i], ptr));
+      outputs.push_back(data_cell->info_.get_hashes(data_cell->get_storage())[dest_i].as_slice());
     }
-    if (info.refs_count_ != 0) {
-      if (depth >= max_depth) {
-        return td::Status::Error("Depth is too big");
-      }
-      depth++;
+    if (inputs.empty()) {
+      break;
     }
-    depth_ptr[dest_i] = depth;
+    td::sha256_batch(inputs, outputs);
+  }
 
-    // children hash
-    for (int i = 0; i < info.refs_count_; i++) {
-      if (type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate) {
-        hasher->feed(refs_ptr[i]->get_hash(level_i + 1).as_slice());
-      } else {
-        hasher->feed(refs_ptr[i]->get_hash(level_i).as_slice());
-      }
+  for (size_t i = 0; i < args.size(); i++) {
+    if (data_cells[i]) {
+      res[i] = Ref<DataCell>(data_cells[i].release(), Ref<DataCell>::acquire_t{});
     }
-    auto extracted_size = hasher->extract(hashes_ptr[dest_i].as_slice());
-    DCHECK(extracted_size == hash_bytes);
   }
-
-  return Ref<DataCell>(data_cell.release(), Ref<DataCell>::acquire_t{});
+  return res;
 }
 
 const DataCell::Hash DataCell::do_get_hash(td::uint32 level) const {
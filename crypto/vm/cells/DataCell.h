@@ -23,6 +23,8 @@
 
 #include "td/utils/ThreadSafeCounter.h"
 
+#include <memory>
+
 namespace vm {
 
 class DataCell : public Cell {
@@ -38,6 +40,12 @@ class DataCell : public Cell {
   }
 
  protected:
+  // data of the cell which is not copied into the cell, but stays in memory kept alive by owner
+  struct ExternalData {
+    const unsigned char* data;
+    std::shared_ptr<const void> owner;
+  };
+
   struct Info {
     unsigned bits_;
 
@@ -50,6 +58,8 @@ class DataCell : public Cell {
 
     unsigned char virtualization_ : 3;
 
+    bool has_external_data_ : 1;
+
     unsigned char d1() const {
       return d1(LevelMask{level_mask_});
     }
@@ -78,7 +88,13 @@ class DataCell : public Cell {
     size_t get_data_offset() const {
       return get_depth_offset() + sizeof(td::uint16) * hash_count_;
     }
+    size_t get_external_data_offset() const {
+      return (get_data_offset() + alignof(ExternalData) - 1) / alignof(ExternalData) * alignof(ExternalData);
+    }
     size_t get_storage_size() const {
+      if (has_external_data_) {
+        return get_external_data_offset() + sizeof(ExternalData);
+      }
       return get_data_offset() + (bits_ + 7) / 8;
     }
 
@@ -99,12 +115,23 @@ class DataCell : public Cell {
     }
 
     const unsigned char* get_data(const char* storage) const {
+      if (has_external_data_) {
+        return get_external_data(storage)->data;
+      }
       return reinterpret_cast<const unsigned char*>(storage + get_data_offset());
     }
     unsigned char* get_data(char* storage) const {
+      DCHECK(!has_external_data_);
       return reinterpret_cast<unsigned char*>(storage + get_data_offset());
     }
 
+    const ExternalData* get_external_data(const char* storage) const {
+      return reinterpret_cast<const ExternalData*>(storage + get_external_data_offset());
+    }
+    ExternalData* get_external_data(char* storage) const {
+      return reinterpret_cast<ExternalData*>(storage + get_external_data_offset());
+    }
+
     Cell* const* get_refs(const char* storage) const {
       return reinterpret_cast<Cell* const*>(storage + get_refs_offset());
     }
@@ -180,6 +207,23 @@ class DataCell : public Cell {
     return get_thread_safe_counter().sum();
   }
 
+  struct CreateArgs {
+    td::ConstBitPtr data;
+    unsigned bits;
+    td::MutableSpan<Ref<Cell>> refs;
+    bool special;
+  };
+  // Same as creating each cell with CellBuilder, but all hashes are computed at once by td::sha256_batch.
+  // Refs must be already created, so a bag of cells is to be created layer by layer.
+  static std::vector<td::Result<Ref<DataCell>>> create_batch(td::Span<CreateArgs> args);
+  // Creates a cell referring to data instead of copying it, if data is large enough to make it worthwhile.
+  // data must contain (bits + 7) / 8 bytes with the completion tag, and stay unchanged while data_owner is alive.
+  static td::Result<Ref<DataCell>> create_external(td::Slice data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
+                                                   bool special, std::shared_ptr<const void> data_owner);
+  bool has_external_data() const {
+    return info_.has_external_data_;
+  }
+
   template <class StorerT>
   void store(StorerT& storer) const {
     storer.template store_binary<td::uint8>(info_.d1());
@@ -189,6 +233,10 @@ class DataCell : public Cell {
 
  protected:
   static constexpr auto max_storage_size = max_refs * sizeof(void*) + (max_level + 1) * hash_bytes + max_bytes;
+  // d1, d2, data or lower hash, depth and hash of each child
+  static constexpr size_t max_hash_input_size = 2 + max_bytes + max_refs * (depth_bytes + hash_bytes);
+  // smaller data is cheaper to copy than to refer to
+  static constexpr size_t min_external_data_size = sizeof(ExternalData) + alignof(ExternalData);
 
  private:
   static td::NamedThreadSafeCounter::CounterRef get_thread_safe_counter() {
@@ -196,6 +244,13 @@ class DataCell : public Cell {
     return res;
   }
   static std::unique_ptr<DataCell> create_empty_data_cell(Info info);
+  // creates a cell with everything but hashes
+  static td::Result<std::unique_ptr<DataCell>> create_unhashed(td::ConstBitPtr data, unsigned bits,
+                                                               td::MutableSpan<Ref<Cell>> refs, bool special,
+                                                               std::shared_ptr<const void> data_owner = nullptr);
+  static Ref<DataCell> compute_hashes(std::unique_ptr<DataCell> data_cell);
+  td::uint32 get_child_level(td::uint32 dest_i, SpecialType type) const;
+  size_t store_hash_input(td::uint32 dest_i, SpecialType type, unsigned char* dest) const;
 
   const Hash do_get_hash(td::uint32 level) const override;
   td::uint16 do_get_depth(td::uint32 level) const override;
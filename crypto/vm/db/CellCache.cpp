@@ -0,0 +1,147 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "vm/db/CellCache.h"
+
+namespace vm {
+
+CellCache::CellCache(size_t max_bytes, size_t shards_count) : max_bytes_(max_bytes), shards_(shards_count) {
+  CHECK(shards_count > 0);
+  for (auto &shard : shards_) {
+    shard.max_size = max_bytes / shards_count;
+  }
+  auto &counters = td::NamedThreadSafeCounter::get_default();
+  hits_ = counters.get_counter("CellCacheHit");
+  misses_ = counters.get_counter("CellCacheMiss");
+  evictions_ = counters.get_counter("CellCacheEviction");
+  prefetched_ = counters.get_counter("CellCachePrefetched");
+  prefetch_hits_ = counters.get_counter("CellCachePrefetchHit");
+}
+
+std::shared_ptr<CellCache> CellCache::create(size_t max_bytes) {
+  if (max_bytes == 0) {
+    return nullptr;
+  }
+  return std::make_shared<CellCache>(max_bytes);
+}
+
+CellCache::Shard &CellCache::get_shard(const CellHash &hash) {
+  // first bytes are already used by std::hash, so take the shard index from the end of the hash
+  return shards_[hash.as_array()[CellTraits::hash_bytes - 1] % shards_.size()];
+}
+
+bool CellCache::get(td::Slice hash, std::string &value) {
+  auto key = CellHash::from_slice(hash);
+  auto &shard = get_shard(key);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto it = shard.entries.find(key);
+  if (it == shard.entries.end()) {
+    misses_.add(1);
+    return false;
+  }
+  hits_.add(1);
+  if (it->second->prefetched) {
+    it->second->prefetched = false;
+    prefetch_hits_.add(1);
+  }
+  it->second->remove();
+  shard.lru.put(it->second.get());
+  value = it->second->value;
+  return true;
+}
+
+bool CellCache::contains(td::Slice hash) {
+  auto key = CellHash::from_slice(hash);
+  auto &shard = get_shard(key);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  return shard.entries.count(key) != 0;
+}
+
+void CellCache::set(td::Slice hash, td::Slice value, bool prefetched) {
+  auto key = CellHash::from_slice(hash);
+  auto &shard = get_shard(key);
+  if (value.size() + entry_overhead > shard.max_size) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto &entry = shard.entries[key];
+  if (entry) {
+    shard.size -= entry_size(*entry);
+    entry->value = value.str();
+    entry->remove();
+  } else {
+    entry = std::make_unique<Entry>();
+    entry->hash = key;
+    entry->value = value.str();
+    entry->prefetched = prefetched;
+    if (prefetched) {
+      prefetched_.add(1);
+    }
+  }
+  shard.size += entry_size(*entry);
+  shard.lru.put(entry.get());
+
+  while (shard.size > shard.max_size) {
+    auto to_remove = Entry::from_list_node(shard.lru.get());
+    CHECK(to_remove);
+    remove_entry(shard, to_remove);
+    evictions_.add(1);
+  }
+}
+
+void CellCache::erase(td::Slice hash) {
+  auto key = CellHash::from_slice(hash);
+  auto &shard = get_shard(key);
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto it = shard.entries.find(key);
+  if (it != shard.entries.end()) {
+    remove_entry(shard, it->second.get());
+  }
+}
+
+void CellCache::clear() {
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    shard.entries.clear();
+    shard.size = 0;
+  }
+}
+
+void CellCache::remove_entry(Shard &shard, Entry *entry) {
+  shard.size -= entry_size(*entry);
+  // entry is unlinked from the lru list by its destructor; the key must outlive it
+  auto hash = entry->hash;
+  shard.entries.erase(hash);
+}
+
+CellCache::Stats CellCache::get_stats() const {
+  Stats res;
+  res.hits = hits_.sum();
+  res.misses = misses_.sum();
+  res.evictions = evictions_.sum();
+  res.prefetched = prefetched_.sum();
+  res.prefetch_hits = prefetch_hits_.sum();
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    res.cells_count += static_cast<td::int64>(shard.entries.size());
+    res.cells_size += static_cast<td::int64>(shard.size);
+  }
+  return res;
+}
+
+}  // namespace vm
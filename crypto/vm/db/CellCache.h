@@ -0,0 +1,104 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+#include "vm/cells/CellHash.h"
+
+#include "td/utils/common.h"
+#include "td/utils/List.h"
+#include "td/utils/Slice.h"
+#include "td/utils/ThreadSafeCounter.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace vm {
+
+// Bounded LRU cache of serialized cells (as stored by CellStorer) keyed by cell hash.
+// Cell data never changes for a given hash, so cached values stay valid regardless of snapshots;
+// only the refcnt prefix may be outdated and must not be used.
+class CellCache {
+ public:
+  struct Stats {
+    td::int64 hits{0};
+    td::int64 misses{0};
+    td::int64 evictions{0};
+    // entries inserted by prefetching, and the first hits of such entries
+    td::int64 prefetched{0};
+    td::int64 prefetch_hits{0};
+    td::int64 cells_count{0};
+    td::int64 cells_size{0};
+  };
+
+  explicit CellCache(size_t max_bytes, size_t shards_count = 16);
+  CellCache(const CellCache &) = delete;
+  CellCache &operator=(const CellCache &) = delete;
+
+  bool get(td::Slice hash, std::string &value);
+  // doesn't change the LRU order and the statistics
+  bool contains(td::Slice hash);
+  // prefetched entries are counted separately until their first hit
+  void set(td::Slice hash, td::Slice value, bool prefetched = false);
+  void erase(td::Slice hash);
+  void clear();
+
+  size_t max_bytes() const {
+    return max_bytes_;
+  }
+  Stats get_stats() const;
+
+  static std::shared_ptr<CellCache> create(size_t max_bytes);
+
+ private:
+  struct Entry : public td::ListNode {
+    CellHash hash;
+    std::string value;
+    bool prefetched{false};
+
+    static Entry *from_list_node(td::ListNode *node) {
+      return static_cast<Entry *>(node);
+    }
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<CellHash, std::unique_ptr<Entry>> entries;
+    td::ListNode lru;
+    size_t size{0};
+    size_t max_size{0};
+  };
+
+  size_t max_bytes_;
+  std::vector<Shard> shards_;
+
+  td::NamedThreadSafeCounter::CounterRef hits_;
+  td::NamedThreadSafeCounter::CounterRef misses_;
+  td::NamedThreadSafeCounter::CounterRef evictions_;
+  td::NamedThreadSafeCounter::CounterRef prefetched_;
+  td::NamedThreadSafeCounter::CounterRef prefetch_hits_;
+
+  static constexpr size_t entry_overhead = sizeof(Entry) + 2 * sizeof(void *);
+
+  Shard &get_shard(const CellHash &hash);
+  static size_t entry_size(const Entry &entry) {
+    return entry.value.size() + entry_overhead;
+  }
+  void remove_entry(Shard &shard, Entry *entry);
+};
+
+}  // namespace vm
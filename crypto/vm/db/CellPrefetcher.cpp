@@ -0,0 +1,191 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "vm/db/CellPrefetcher.h"
+#include "vm/db/CellStorage.h"
+
+#include "td/utils/logging.h"
+
+namespace vm {
+namespace {
+thread_local const CellPrefetcher::Scope *current_scope;
+}  // namespace
+
+CellPrefetcher::Scope::Scope(int depth, int width) : depth_(depth), width_(width), prev_(current_scope) {
+  current_scope = this;
+}
+
+CellPrefetcher::Scope::~Scope() {
+  current_scope = prev_;
+}
+
+const CellPrefetcher::Scope *CellPrefetcher::Scope::current() {
+  return current_scope;
+}
+
+CellPrefetcher::CellPrefetcher(std::shared_ptr<CellCache> cache, size_t threads_n, size_t max_queue_size)
+    : cache_(std::move(cache)), max_queue_size_(max_queue_size) {
+  CHECK(cache_);
+  auto &counters = td::NamedThreadSafeCounter::get_default();
+  requests_ = counters.get_counter("CellPrefetchRequest");
+  dropped_ = counters.get_counter("CellPrefetchDropped");
+  loaded_ = counters.get_counter("CellPrefetchLoaded");
+  cached_ = counters.get_counter("CellPrefetchCached");
+  for (size_t i = 0; i < threads_n; i++) {
+    threads_.emplace_back([this] { run_worker(); });
+  }
+}
+
+CellPrefetcher::~CellPrefetcher() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    closed_ = true;
+  }
+  cv_.notify_all();
+  idle_cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+std::shared_ptr<CellPrefetcher> CellPrefetcher::create(std::shared_ptr<CellCache> cache, size_t threads_n) {
+  if (!cache || threads_n == 0) {
+    return nullptr;
+  }
+  return std::make_shared<CellPrefetcher>(std::move(cache), threads_n);
+}
+
+void CellPrefetcher::on_load(const std::shared_ptr<td::KeyValueReader> &reader, td::Slice serialized) {
+  auto scope = Scope::current();
+  if (!scope || scope->depth() <= 0 || scope->width() <= 0) {
+    return;
+  }
+  Task task{reader, {}, scope->depth(), scope->width()};
+  if (CellLoader::parse_ref_hashes(serialized, task.hashes).is_error() || task.hashes.empty()) {
+    return;
+  }
+  requests_.add(1);
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (queue_.size() >= max_queue_size_) {
+      // the oldest requests are the least likely to be still ahead of the traversal
+      queue_.pop_front();
+      dropped_.add(1);
+    }
+    queue_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void CellPrefetcher::wait_idle() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock, [&] { return closed_ || (queue_.empty() && running_ == 0); });
+}
+
+CellPrefetcher::Stats CellPrefetcher::get_stats() const {
+  Stats res;
+  res.requests = requests_.sum();
+  res.dropped = dropped_.sum();
+  res.loaded = loaded_.sum();
+  res.cached = cached_.sum();
+  return res;
+}
+
+void CellPrefetcher::run_worker() {
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&] { return closed_ || !queue_.empty(); });
+      if (closed_) {
+        return;
+      }
+      task = std::move(queue_.front());
+      queue_.pop_front();
+      running_++;
+    }
+    run_task(task);
+    bool idle;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      running_--;
+      idle = queue_.empty() && running_ == 0;
+    }
+    if (idle) {
+      idle_cv_.notify_all();
+    }
+  }
+}
+
+// loads the cells level by level, with a single batched lookup for the missing cells of each level
+void CellPrefetcher::run_task(Task &task) {
+  auto hashes = std::move(task.hashes);
+  size_t width = task.width;
+  std::vector<td::Slice> keys;
+  std::vector<size_t> missing;
+  std::vector<std::string> values;
+  for (int level = 0; level < task.depth && !hashes.empty() && width > 0; level++) {
+    if (hashes.size() > width) {
+      hashes.resize(width);
+    }
+    width -= hashes.size();
+    bool expand = level + 1 < task.depth && width > 0;
+
+    std::vector<std::string> serialized(hashes.size());
+    keys.clear();
+    missing.clear();
+    for (size_t i = 0; i < hashes.size(); i++) {
+      // descendants of cached cells are not expanded, as they were most likely prefetched together with them
+      if (cache_->contains(hashes[i].as_slice())) {
+        cached_.add(1);
+      } else {
+        keys.push_back(hashes[i].as_slice());
+        missing.push_back(i);
+      }
+    }
+    if (!keys.empty()) {
+      auto r_statuses = task.reader->get_multi(keys, &values);
+      if (r_statuses.is_error()) {
+        LOG(WARNING) << "Failed to prefetch cells: " << r_statuses.error();
+        return;
+      }
+      auto statuses = r_statuses.move_as_ok();
+      for (size_t j = 0; j < keys.size(); j++) {
+        if (statuses[j] != td::KeyValueReader::GetStatus::Ok) {
+          continue;
+        }
+        cache_->set(keys[j], values[j], true);
+        loaded_.add(1);
+        serialized[missing[j]] = std::move(values[j]);
+      }
+    }
+    if (!expand) {
+      break;
+    }
+
+    std::vector<CellHash> next;
+    for (auto &value : serialized) {
+      if (!value.empty()) {
+        CellLoader::parse_ref_hashes(value, next).ignore();
+      }
+    }
+    hashes = std::move(next);
+  }
+}
+
+}  // namespace vm
@@ -0,0 +1,112 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+#include "vm/db/CellCache.h"
+#include "vm/cells/CellHash.h"
+
+#include "td/db/KeyValue.h"
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/ThreadSafeCounter.h"
+#include "td/utils/port/thread.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace vm {
+
+// Loads the descendants of cells loaded by CellLoader::load_data() into a CellCache in background threads, so that
+// the following loads of a traversal of a large tree are served from memory instead of blocking on the storage.
+// Only loads made by a thread inside a CellPrefetcher::Scope are followed by prefetching.
+class CellPrefetcher {
+ public:
+  struct Stats {
+    td::int64 requests{0};  // loads followed by prefetching
+    td::int64 dropped{0};   // requests dropped because the queue was full
+    td::int64 loaded{0};    // cells read from the storage and put into the cache
+    td::int64 cached{0};    // cells that were already in the cache
+  };
+
+  // Enables prefetching of descendants up to depth levels below each cell loaded by the current thread,
+  // at most width cells per loaded cell
+  class Scope {
+   public:
+    explicit Scope(int depth = 2, int width = 64);
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope();
+
+    int depth() const {
+      return depth_;
+    }
+    int width() const {
+      return width_;
+    }
+    static const Scope *current();
+
+   private:
+    int depth_;
+    int width_;
+    const Scope *prev_;
+  };
+
+  CellPrefetcher(std::shared_ptr<CellCache> cache, size_t threads_n, size_t max_queue_size = 1024);
+  CellPrefetcher(const CellPrefetcher &) = delete;
+  CellPrefetcher &operator=(const CellPrefetcher &) = delete;
+  ~CellPrefetcher();
+
+  // returns nullptr if there is no cache or threads_n is 0
+  static std::shared_ptr<CellPrefetcher> create(std::shared_ptr<CellCache> cache, size_t threads_n);
+
+  // serialized is the value of a cell just loaded from reader, as stored by CellStorer
+  void on_load(const std::shared_ptr<td::KeyValueReader> &reader, td::Slice serialized);
+  // blocks until all queued requests are processed
+  void wait_idle();
+  Stats get_stats() const;
+
+ private:
+  struct Task {
+    std::shared_ptr<td::KeyValueReader> reader;
+    std::vector<CellHash> hashes;
+    int depth;
+    int width;
+  };
+
+  std::shared_ptr<CellCache> cache_;
+  size_t max_queue_size_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable idle_cv_;
+  std::deque<Task> queue_;
+  size_t running_{0};
+  bool closed_{false};
+  std::vector<td::thread> threads_;
+
+  td::NamedThreadSafeCounter::CounterRef requests_;
+  td::NamedThreadSafeCounter::CounterRef dropped_;
+  td::NamedThreadSafeCounter::CounterRef loaded_;
+  td::NamedThreadSafeCounter::CounterRef cached_;
+
+  void run_worker();
+  void run_task(Task &task);
+};
+
+}  // namespace vm
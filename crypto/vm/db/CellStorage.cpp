@@ -122,20 +122,93 @@ class RefcntCellParser {
 };
 }  // namespace
 
-CellLoader::CellLoader(std::shared_ptr<KeyValueReader> reader) : reader_(std::move(reader)) {
+CellLoader::CellLoader(std::shared_ptr<KeyValueReader> reader, std::shared_ptr<CellCache> cache,
+                       std::shared_ptr<CellPrefetcher> prefetcher)
+    : reader_(std::move(reader)), cache_(std::move(cache)), prefetcher_(std::move(prefetcher)) {
   CHECK(reader_);
 }
 
 td::Result<CellLoader::LoadResult> CellLoader::load(td::Slice hash, bool need_data, ExtCellCreator &ext_cell_creator) {
   //LOG(ERROR) << "Storage: load cell " << hash.size() << " " << td::base64_encode(hash);
-  LoadResult res;
   std::string serialized;
   TRY_RESULT(get_status, reader_->get(hash, serialized));
   if (get_status != KeyValue::GetStatus::Ok) {
     DCHECK(get_status == KeyValue::GetStatus::NotFound);
-    return res;
+    return LoadResult{};
+  }
+  if (cache_) {
+    cache_->set(hash, serialized);
+  }
+  return parse(serialized, need_data, ext_cell_creator);
+}
+
+td::Result<std::vector<td::Result<CellLoader::LoadResult>>> CellLoader::load_multi(td::Span<td::Slice> hashes,
+                                                                                   bool need_data,
+                                                                                   ExtCellCreator &ext_cell_creator) {
+  std::vector<std::string> values;
+  TRY_RESULT(get_statuses, reader_->get_multi(hashes, &values));
+  std::vector<td::Result<LoadResult>> res;
+  res.reserve(hashes.size());
+  for (size_t i = 0; i < hashes.size(); i++) {
+    if (get_statuses[i] != KeyValue::GetStatus::Ok) {
+      DCHECK(get_statuses[i] == KeyValue::GetStatus::NotFound);
+      res.emplace_back(LoadResult{});
+      continue;
+    }
+    if (cache_) {
+      cache_->set(hashes[i], values[i]);
+    }
+    res.push_back(parse(values[i], need_data, ext_cell_creator));
   }
+  return std::move(res);
+}
+
+td::Result<CellLoader::LoadResult> CellLoader::load_data(td::Slice hash, ExtCellCreator &ext_cell_creator) {
+  std::string serialized;
+  if (!cache_ || !cache_->get(hash, serialized)) {
+    TRY_RESULT(get_status, reader_->get(hash, serialized));
+    if (get_status != KeyValue::GetStatus::Ok) {
+      DCHECK(get_status == KeyValue::GetStatus::NotFound);
+      return LoadResult{};
+    }
+    if (cache_) {
+      cache_->set(hash, serialized);
+    }
+  }
+  if (prefetcher_) {
+    prefetcher_->on_load(reader_, serialized);
+  }
+  return parse(serialized, true, ext_cell_creator);
+}
 
+td::Status CellLoader::parse_ref_hashes(td::Slice serialized, std::vector<CellHash> &hashes) {
+  td::TlParser parser(serialized);
+  parser.fetch_int();  // refcnt
+  TRY_STATUS(parser.get_status());
+  auto data = parser.fetch_string_raw<td::Slice>(parser.get_left_len());
+  CellSerializationInfo info;
+  TRY_STATUS(info.init(data, 0 /*ref_byte_size*/));
+  data = data.substr(info.end_offset);
+  for (int i = 0; i < info.refs_cnt; i++) {
+    if (data.size() < 1) {
+      return td::Status::Error("Not enough data");
+    }
+    Cell::LevelMask level_mask(data[0]);
+    auto n = level_mask.get_hashes_count();
+    auto end_offset = 1 + n * (Cell::hash_bytes + Cell::depth_bytes);
+    if (data.size() < end_offset) {
+      return td::Status::Error("Not enough data");
+    }
+    // cells are stored by their representation hash, which is the last one
+    hashes.push_back(CellHash::from_slice(data.substr(1 + (n - 1) * Cell::hash_bytes, Cell::hash_bytes)));
+    data = data.substr(end_offset);
+  }
+  return td::Status::OK();
+}
+
+td::Result<CellLoader::LoadResult> CellLoader::parse(td::Slice serialized, bool need_data,
+                                                     ExtCellCreator &ext_cell_creator) {
+  LoadResult res;
   res.status = LoadResult::Ok;
 
   RefcntCellParser refcnt_cell(need_data);
@@ -150,14 +223,28 @@ td::Result<CellLoader::LoadResult> CellLoader::load(td::Slice hash, bool need_da
   return res;
 }
 
-CellStorer::CellStorer(KeyValue &kv) : kv_(kv) {
+CellStorer::CellStorer(KeyValue &kv, std::shared_ptr<CellCache> cache) : kv_(kv), cache_(std::move(cache)) {
 }
 
 td::Status CellStorer::erase(td::Slice hash) {
+  if (cache_) {
+    cache_->erase(hash);
+  }
   return kv_.erase(hash);
 }
 
 td::Status CellStorer::set(td::int32 refcnt, const DataCell &cell) {
-  return kv_.set(cell.get_hash().as_slice(), td::serialize(RefcntCellStorer(refcnt, cell)));
+  return set_serialized(cell.get_hash().as_slice(), serialize_value(refcnt, cell));
+}
+
+td::Status CellStorer::set_serialized(td::Slice hash, td::Slice value) {
+  if (cache_) {
+    cache_->set(hash, value);
+  }
+  return kv_.set(hash, value);
+}
+
+std::string CellStorer::serialize_value(td::int32 refcnt, const DataCell &cell) {
+  return td::serialize(RefcntCellStorer(refcnt, cell));
 }
 }  // namespace vm
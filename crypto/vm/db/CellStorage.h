@@ -19,6 +19,8 @@
 #pragma once
 #include "td/db/KeyValue.h"
 #include "vm/db/DynamicBagOfCellsDb.h"
+#include "vm/db/CellCache.h"
+#include "vm/db/CellPrefetcher.h"
 #include "vm/cells.h"
 
 #include "td/utils/Slice.h"
@@ -46,20 +48,38 @@ class CellLoader {
     Ref<DataCell> cell_;
     td::int32 refcnt_{0};
   };
-  CellLoader(std::shared_ptr<KeyValueReader> reader);
+  CellLoader(std::shared_ptr<KeyValueReader> reader, std::shared_ptr<CellCache> cache = {},
+             std::shared_ptr<CellPrefetcher> prefetcher = {});
   td::Result<LoadResult> load(td::Slice hash, bool need_data, ExtCellCreator &ext_cell_creator);
+  // Same as load() for several cells, with a single batched lookup in the key-value storage;
+  // a cell that cannot be parsed fails only its own result
+  td::Result<std::vector<td::Result<LoadResult>>> load_multi(td::Span<td::Slice> hashes, bool need_data,
+                                                             ExtCellCreator &ext_cell_creator);
+  // Loads only the cell data, possibly from the shared cache. Refcnt of the result is not valid.
+  // Inside a CellPrefetcher::Scope, the descendants of the cell are then prefetched into the cache.
+  td::Result<LoadResult> load_data(td::Slice hash, ExtCellCreator &ext_cell_creator);
+  // Appends the hashes of the children of a cell serialized by CellStorer
+  static td::Status parse_ref_hashes(td::Slice serialized, std::vector<CellHash> &hashes);
 
  private:
   std::shared_ptr<KeyValueReader> reader_;
+  std::shared_ptr<CellCache> cache_;
+  std::shared_ptr<CellPrefetcher> prefetcher_;
+
+  static td::Result<LoadResult> parse(td::Slice serialized, bool need_data, ExtCellCreator &ext_cell_creator);
 };
 
 class CellStorer {
  public:
-  CellStorer(KeyValue &kv);
+  CellStorer(KeyValue &kv, std::shared_ptr<CellCache> cache = {});
   td::Status erase(td::Slice hash);
   td::Status set(td::int32 refcnt, const DataCell &cell);
+  // value must be produced by serialize_value(); serialization is thread-safe and may be done in advance
+  td::Status set_serialized(td::Slice hash, td::Slice value);
+  static std::string serialize_value(td::int32 refcnt, const DataCell &cell);
 
  private:
   KeyValue &kv_;
+  std::shared_ptr<CellCache> cache_;
 };
 }  // namespace vm
@@ -25,9 +25,12 @@
 #include "td/utils/base64.h"
 #include "td/utils/format.h"
 #include "td/utils/ThreadSafeCounter.h"
+#include "td/utils/ThreadPool.h"
 
 #include "vm/cellslice.h"
 
+#include <algorithm>
+
 namespace vm {
 namespace {
 
@@ -56,6 +59,7 @@ struct CellInfo {
 
   bool was_dfs_new_cells{false};
   bool was{false};
+  bool was_prefetch{false};
 
   td::int32 db_refcnt{0};
   td::int32 refcnt_diff{0};
@@ -139,6 +143,9 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     if (is_prepared_for_commit()) {
       return td::Status::OK();
     }
+    if (commit_threads_ > 0) {
+      prefetch_new_cells_in_db();
+    }
     //LOG(ERROR) << "dfs_new_cells_in_db";
     for (auto &new_cell : to_inc_) {
       auto &new_cell_info = get_cell_info(new_cell);
@@ -187,6 +194,12 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     return td::Status::OK();
   }
 
+  void set_commit_threads(size_t threads_n) override {
+    commit_threads_ = threads_n;
+    // the calling thread does a share of the work too
+    pool_ = threads_n > 1 ? std::make_unique<td::ThreadPool>(threads_n - 1) : nullptr;
+  }
+
  private:
   std::unique_ptr<CellLoader> loader_;
   std::vector<Ref<Cell>> to_inc_;
@@ -194,6 +207,8 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
   CellHashTable<CellInfo> hash_table_;
   std::vector<CellInfo *> visited_;
   Stats stats_diff_;
+  size_t commit_threads_{0};
+  std::unique_ptr<td::ThreadPool> pool_;
 
   static td::NamedThreadSafeCounter::CounterRef get_thread_safe_counter() {
     static auto res = td::NamedThreadSafeCounter::get_default().get_counter("DynamicBagOfCellsDb");
@@ -239,7 +254,7 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
       if (db_) {
         return db_->load_cell(hash);
       }
-      TRY_RESULT(load_result, cell_loader_->load(hash, true, *this));
+      TRY_RESULT(load_result, cell_loader_->load_data(hash, *this));
       CHECK(load_result.status == CellLoader::LoadResult::Ok);
       return std::move(load_result.cell());
     }
@@ -283,6 +298,34 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     do_load_cell(info);
   }
 
+  // same as load_cell for each of the cells, which must not be loaded yet
+  void load_cells(td::Span<CellInfo *> infos) {
+    if (infos.size() <= 1) {
+      for (auto info : infos) {
+        load_cell(*info);
+      }
+      return;
+    }
+    CHECK(loader_);
+    std::vector<Cell::Hash> cell_hashes;
+    cell_hashes.reserve(infos.size());
+    for (auto info : infos) {
+      cell_hashes.push_back(info->cell->get_hash());
+    }
+    std::vector<td::Slice> hashes(cell_hashes.size());
+    for (size_t i = 0; i < cell_hashes.size(); i++) {
+      hashes[i] = cell_hashes[i].as_slice();
+    }
+    auto r_res = loader_->load_multi(hashes, true, *this);
+    for (size_t i = 0; i < infos.size(); i++) {
+      if (r_res.is_error()) {
+        update_cell_info_loaded(*infos[i], hashes[i], r_res.error().clone());
+      } else {
+        update_cell_info_loaded(*infos[i], hashes[i], std::move(r_res.ok_ref()[i]));
+      }
+    }
+  }
+
   bool dfs_new_cells_in_db(CellInfo &info) {
     if (info.sync_with_db) {
       return is_in_db(info);
@@ -302,6 +345,106 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     return is_in_db(info);
   }
 
+  void parallel_for(size_t n, const std::function<void(size_t)> &f) {
+    if (pool_) {
+      pool_->parallel_for(n, commit_threads_, f);
+    } else {
+      for (size_t i = 0; i < n; i++) {
+        f(i);
+      }
+    }
+  }
+
+  // Does the same lookups as dfs_new_cells_in_db, but level by level, with the lookups of one level batched
+  // and split between threads.
+  // A cell is looked up only if all its children are known to be in db, so the number of lookups doesn't change.
+  void prefetch_new_cells_in_db() {
+    std::vector<CellInfo *> new_cells;
+    for (auto &new_cell : to_inc_) {
+      collect_new_cells(get_cell_info(new_cell), new_cells);
+    }
+    std::stable_sort(new_cells.begin(), new_cells.end(), [](const CellInfo *a, const CellInfo *b) {
+      return a->cell->get_depth() < b->cell->get_depth();
+    });
+
+    std::vector<CellInfo *> batch;
+    std::vector<Cell::Hash> cell_hashes;
+    std::vector<td::Slice> hashes;
+    std::vector<td::Result<CellLoader::LoadResult>> results;
+    for (size_t i = 0; i < new_cells.size();) {
+      auto depth = new_cells[i]->cell->get_depth();
+      batch.clear();
+      for (; i < new_cells.size() && new_cells[i]->cell->get_depth() == depth; i++) {
+        auto &info = *new_cells[i];
+        info.was_prefetch = false;
+        if (info.sync_with_db) {
+          continue;
+        }
+        bool not_in_db = false;
+        for_each(
+            info, [&not_in_db](auto &child_info) { not_in_db |= child_info.sync_with_db && !child_info.in_db; },
+            false);
+        if (not_in_db) {
+          info.sync_with_db = true;
+          continue;
+        }
+        batch.push_back(&info);
+      }
+
+      cell_hashes.clear();
+      hashes.clear();
+      for (auto info : batch) {
+        cell_hashes.push_back(info->cell->get_hash());
+      }
+      for (auto &hash : cell_hashes) {
+        hashes.push_back(hash.as_slice());
+      }
+      results.clear();
+      results.resize(batch.size());
+      size_t chunks_n = std::max<size_t>(commit_threads_, 1);
+      size_t chunk_size = (batch.size() + chunks_n - 1) / chunks_n;
+      parallel_for(chunks_n, [&](size_t chunk) {
+        size_t begin = std::min(chunk * chunk_size, batch.size());
+        size_t end = std::min(begin + chunk_size, batch.size());
+        if (begin == end) {
+          return;
+        }
+        // ext_cell creator is not used when need_data is false
+        auto r_chunk = loader_->load_multi(td::Span<td::Slice>(hashes.data() + begin, end - begin), false, *this);
+        for (size_t j = begin; j < end; j++) {
+          if (r_chunk.is_error()) {
+            results[j] = r_chunk.error().clone();
+          } else {
+            results[j] = std::move(r_chunk.ok_ref()[j - begin]);
+          }
+        }
+      });
+
+      for (size_t j = 0; j < batch.size(); j++) {
+        auto &info = *batch[j];
+        auto &r_res = results[j];
+        if (r_res.is_error()) {
+          //FIXME
+          LOG(ERROR) << "Failed to load cell from db" << r_res.error();
+        } else if (r_res.ok().status == CellLoader::LoadResult::Ok) {
+          info.in_db = true;
+          info.db_refcnt = r_res.ok().refcnt();
+        }
+        info.sync_with_db = true;
+      }
+    }
+  }
+
+  void collect_new_cells(CellInfo &info, std::vector<CellInfo *> &new_cells) {
+    if (info.sync_with_db || info.in_db || info.was_prefetch) {
+      return;
+    }
+    info.was_prefetch = true;
+    new_cells.push_back(&info);
+    for_each(
+        info, [&new_cells, this](auto &child_info) { collect_new_cells(child_info, new_cells); }, false);
+  }
+
   void dfs_new_cells(CellInfo &info) {
     info.refcnt_diff++;
     if (!info.was) {
@@ -339,6 +482,15 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
       return;
     }
 
+    // all children are going to be loaded, so load them with one batched lookup
+    std::vector<CellInfo *> children;
+    for_each(info, [&children, this](auto &child_info) {
+      if (!is_loaded(child_info) && std::find(children.begin(), children.end(), &child_info) == children.end()) {
+        children.push_back(&child_info);
+      }
+    });
+    load_cells(children);
+
     for_each(info, [this](auto &child_info) { dfs_old_cells(child_info); });
   }
 
@@ -351,10 +503,27 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
 
   void save_diff(CellStorer &storer) {
     //LOG(ERROR) << hash_table_.size();
+    if (commit_threads_ <= 1) {
+      for (auto info_ptr : visited_) {
+        save_cell(*info_ptr, storer, nullptr);
+      }
+      visited_.clear();
+      return;
+    }
+
+    std::vector<std::pair<td::int32, Ref<DataCell>>> to_save;
     for (auto info_ptr : visited_) {
-      save_cell(*info_ptr, storer);
+      save_cell(*info_ptr, storer, &to_save);
     }
     visited_.clear();
+
+    std::vector<std::string> serialized(to_save.size());
+    parallel_for(to_save.size(), [&](size_t i) {
+      serialized[i] = CellStorer::serialize_value(to_save[i].first, *to_save[i].second);
+    });
+    for (size_t i = 0; i < to_save.size(); i++) {
+      storer.set_serialized(to_save[i].second->get_hash().as_slice(), serialized[i]);
+    }
   }
 
   void save_cell_prepare(CellInfo &info) {
@@ -379,7 +548,8 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     }
   }
 
-  void save_cell(CellInfo &info, CellStorer &storer) {
+  // if to_save is not null, cells to be saved are returned there instead of being passed to the storer
+  void save_cell(CellInfo &info, CellStorer &storer, std::vector<std::pair<td::int32, Ref<DataCell>>> *to_save) {
     auto guard = td::ScopeExit{} + [&] {
       info.was_dfs_new_cells = false;
       info.was = false;
@@ -405,7 +575,11 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
       //LOG(ERROR) << "SAVE " << info.db_refcnt;
       //CellSlice(NoVm(), info.cell).print_rec(std::cout);
       auto loaded_cell = info.cell->load_cell().move_as_ok();
-      storer.set(info.db_refcnt, *loaded_cell.data_cell);
+      if (to_save) {
+        to_save->emplace_back(info.db_refcnt, std::move(loaded_cell.data_cell));
+      } else {
+        storer.set(info.db_refcnt, *loaded_cell.data_cell);
+      }
       info.in_db = true;
     }
   }
@@ -465,10 +639,12 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     if (info.sync_with_db) {
       return;
     }
+    CHECK(loader_);
+    update_cell_info_loaded(info, hash, loader_->load(hash, true, *this));
+  }
 
+  void update_cell_info_loaded(CellInfo &info, td::Slice hash, td::Result<CellLoader::LoadResult> r_res) {
     do {
-      CHECK(loader_);
-      auto r_res = loader_->load(hash, true, *this);
       if (r_res.is_error()) {
         //FIXME
         LOG(ERROR) << "Failed to load cell from db" << r_res.error();
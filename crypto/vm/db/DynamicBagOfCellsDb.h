@@ -56,6 +56,11 @@ class DynamicBagOfCellsDb {
   // restart with new loader will also reset stats_diff
   virtual td::Status set_loader(std::unique_ptr<CellLoader> loader) = 0;
 
+  // number of threads used to look up new cells in prepare_commit() and to serialize cells in commit();
+  // with 0 new cells are looked up one by one, with 1 they are looked up in batches, level by level,
+  // in the caller's thread; more threads are started once and reused by all commits
+  virtual void set_commit_threads(size_t threads_n) = 0;
+
   static std::unique_ptr<DynamicBagOfCellsDb> create();
 };
 
@@ -212,7 +212,7 @@ td::Result<std::shared_ptr<StaticBagOfCellsDb>> StaticBagOfCellsDbBaseline::crea
 class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
  public:
   explicit StaticBagOfCellsDbLazyImpl(td::BlobView data, StaticBagOfCellsDbLazy::Options options)
-      : data_(std::move(data)), options_(std::move(options)) {
+      : data_(std::move(data)), options_(std::move(options)), view_owner_(data_.get_view_owner()) {
     get_thread_safe_counter().add(1);
   }
   td::Result<size_t> get_root_count() override {
@@ -242,6 +242,8 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
   std::atomic<bool> should_cache_cells_{true};
   td::BlobView data_;
   StaticBagOfCellsDbLazy::Options options_;
+  // non-null if cells may refer to the data of the blob instead of copying it
+  std::shared_ptr<const void> view_owner_;
   bool has_info_{false};
   BagOfCells::Info info_;
 
@@ -378,10 +380,19 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
       return td::Status::Error("bag-of-cell error: not enough data");
     }
     if (options_.check_crc32c && info_.has_crc32c) {
-      std::string buf(td::narrow_cast<std::size_t>(info_.total_size), '\0');
-      TRY_RESULT(data, data_.view(td::MutableSlice(buf), 0));
-      unsigned crc_computed = td::crc32c(td::Slice{data.ubegin(), data.uend() - 4});
-      unsigned crc_stored = td::as<unsigned>(data.uend() - 4);
+      // the blob may be much larger than the available memory, so it is checked by chunks
+      td::uint64 crc_size = info_.total_size - 4;
+      std::string buf(td::narrow_cast<std::size_t>(td::min<td::uint64>(crc_size, 1 << 20)), '\0');
+      unsigned crc_computed = 0;
+      for (td::uint64 offset = 0; offset < crc_size;) {
+        auto size = td::narrow_cast<std::size_t>(td::min<td::uint64>(crc_size - offset, buf.size()));
+        TRY_RESULT(data, data_.view(td::MutableSlice(buf).truncate(size), offset));
+        crc_computed = td::crc32c_extend(crc_computed, data);
+        offset += size;
+      }
+      char crc_buf[4];
+      TRY_RESULT(crc_data, data_.view(td::MutableSlice(crc_buf, 4), crc_size));
+      unsigned crc_stored = td::as<unsigned>(crc_data.ubegin());
       if (crc_computed != crc_stored) {
         return td::Status::Error(PSLICE()
                                  << "bag-of-cells CRC32C mismatch: expected " << td::format::as_hex(crc_computed)
@@ -504,7 +515,14 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
       refs[k] = std::move(ref);
     }
 
-    TRY_RESULT(data_cell, cell_info.create_data_cell(cell_slice, td::Span<Ref<Cell>>(refs, cell_info.refs_cnt)));
+    td::Result<Ref<DataCell>> r_data_cell;
+    if (view_owner_) {
+      r_data_cell =
+          cell_info.create_data_cell(cell_slice, td::Span<Ref<Cell>>(refs, cell_info.refs_cnt), view_owner_);
+    } else {
+      r_data_cell = cell_info.create_data_cell(cell_slice, td::Span<Ref<Cell>>(refs, cell_info.refs_cnt));
+    }
+    TRY_RESULT(data_cell, std::move(r_data_cell));
     if (!should_cache) {
       return std::move(data_cell);
     }
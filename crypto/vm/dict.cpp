@@ -23,6 +23,12 @@
 #include "common/bitstring.h"
 
 #include "td/utils/bits.h"
+#include "td/utils/HashMap.h"
+#include "td/utils/List.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
 
 namespace vm {
 
@@ -2951,4 +2957,171 @@ bool AugmentedDictionary::validate_check_extra(const AugmentedDictionary::foreac
       invert_first);
 }
 
+/*
+ *
+ *   FROZEN DICTIONARIES
+ *
+ */
+
+std::atomic<bool> FrozenDictionary::enabled_{false};
+
+namespace {
+
+struct FrozenDictionaryCache {
+  struct Entry : public td::ListNode {
+    CellHash hash;
+    Ref<FrozenDictionary> dict;
+
+    static Entry* from_list_node(td::ListNode* node) {
+      return static_cast<Entry*>(node);
+    }
+  };
+
+  std::mutex mutex;
+  td::ListNode lru;
+  td::HashMap<CellHash, std::unique_ptr<Entry>> dicts;
+};
+
+FrozenDictionaryCache& frozen_dictionary_cache() {
+  static FrozenDictionaryCache cache;
+  return cache;
+}
+
+}  // namespace
+
+void FrozenDictionary::enable(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+std::size_t FrozenDictionary::cache_size() {
+  auto& cache = frozen_dictionary_cache();
+  std::lock_guard<std::mutex> guard(cache.mutex);
+  return cache.dicts.size();
+}
+
+void FrozenDictionary::clear_cache() {
+  auto& cache = frozen_dictionary_cache();
+  std::lock_guard<std::mutex> guard(cache.mutex);
+  cache.dicts.clear();
+}
+
+bool FrozenDictionary::can_freeze(const Ref<Cell>& root) {
+  // loads of usage-tracked cells must be recorded for Merkle proofs, and virtualized cells may prune the entries
+  return root.not_null() && root->get_tree_node().empty() && !root->get_virtualization();
+}
+
+Ref<FrozenDictionary> FrozenDictionary::build(Ref<Cell> root, int key_bits) {
+  std::vector<Entry> entries;
+  std::size_t key_bytes = (key_bits + 7) / 8;
+  try {
+    Dictionary dict{std::move(root), key_bits};
+    // keys are visited in increasing order, which is also the lexicographical order of their zero-padded bytes
+    bool ok = dict.check_for_each([&](Ref<CellSlice> value, td::ConstBitPtr key, int n) {
+      if (entries.size() >= max_entries) {
+        return false;
+      }
+      std::string key_str(key_bytes, '\0');
+      td::bitstring::bits_memcpy(td::BitPtr{reinterpret_cast<unsigned char*>(&key_str[0])}, key, n);
+      entries.push_back(Entry{std::move(key_str), std::move(value)});
+      return true;
+    });
+    if (!ok) {
+      return {};
+    }
+  } catch (VmError&) {
+    return {};
+  } catch (VmVirtError&) {
+    return {};
+  }
+  return Ref<FrozenDictionary>{true, key_bits, std::move(entries)};
+}
+
+Ref<FrozenDictionary> FrozenDictionary::get(Ref<Cell> root, int key_bits) {
+  if (!can_freeze(root) || key_bits <= 0 || key_bits > DictionaryBase::max_key_bits) {
+    return {};
+  }
+  auto hash = root->get_hash();
+  auto& cache = frozen_dictionary_cache();
+  {
+    std::lock_guard<std::mutex> guard(cache.mutex);
+    auto it = cache.dicts.find(hash);
+    if (it != cache.dicts.end() && it->second->dict->get_key_bits() == key_bits) {
+      it->second->remove();
+      cache.lru.put(it->second.get());
+      return it->second->dict;
+    }
+  }
+  // built outside of the lock, as it may load cells from the disk; a concurrent build of the same view is harmless
+  auto res = build(std::move(root), key_bits);
+  if (res.is_null()) {
+    return res;
+  }
+  std::lock_guard<std::mutex> guard(cache.mutex);
+  auto& entry = cache.dicts[hash];
+  if (entry) {
+    entry->remove();
+  } else {
+    entry = std::make_unique<FrozenDictionaryCache::Entry>();
+    entry->hash = hash;
+  }
+  entry->dict = res;
+  cache.lru.put(entry.get());
+  while (cache.dicts.size() > max_cached_dicts) {
+    auto to_remove = FrozenDictionaryCache::Entry::from_list_node(cache.lru.get());
+    CHECK(to_remove);
+    cache.dicts.erase(to_remove->hash);
+  }
+  return res;
+}
+
+Ref<CellSlice> FrozenDictionary::lookup(td::ConstBitPtr key, int key_len) const {
+  if (key_len != key_bits_) {
+    return {};
+  }
+  std::size_t key_bytes = (key_bits_ + 7) / 8;
+  unsigned char buffer[DictionaryBase::max_key_bytes];
+  std::memset(buffer, 0, key_bytes);
+  td::bitstring::bits_memcpy(td::BitPtr{buffer}, key, key_len);
+  auto it = std::lower_bound(entries_.begin(), entries_.end(), buffer,
+                             [key_bytes](const Entry& entry, const unsigned char* k) {
+                               return std::memcmp(entry.key.data(), k, key_bytes) < 0;
+                             });
+  if (it == entries_.end() || std::memcmp(it->key.data(), buffer, key_bytes)) {
+    return {};
+  }
+  // callers may modify the returned slice
+  return Ref<CellSlice>{true, *it->value};
+}
+
+Ref<Cell> FrozenDictionary::lookup_ref(td::ConstBitPtr key, int key_len) const {
+  auto cs = lookup(key, key_len);
+  if (cs.is_null()) {
+    return {};
+  } else if (!cs->size() && cs->size_refs() == 1) {
+    return cs->prefetch_ref();
+  } else {
+    throw VmError{Excno::dict_err, "dictionary value does not consist of exactly one reference"};
+  }
+}
+
+Ref<CellSlice> FrozenDictionary::lookup_in(Dictionary& dict, td::ConstBitPtr key, int key_len) {
+  if (is_enabled() && key_len == dict.get_key_bits()) {
+    auto frozen = get(dict.get_root_cell(), key_len);
+    if (frozen.not_null()) {
+      return frozen->lookup(key, key_len);
+    }
+  }
+  return dict.lookup(key, key_len);
+}
+
+Ref<Cell> FrozenDictionary::lookup_ref_in(Dictionary& dict, td::ConstBitPtr key, int key_len) {
+  if (is_enabled() && key_len == dict.get_key_bits()) {
+    auto frozen = get(dict.get_root_cell(), key_len);
+    if (frozen.not_null()) {
+      return frozen->lookup_ref(key, key_len);
+    }
+  }
+  return dict.lookup_ref(key, key_len);
+}
+
 }  // namespace vm
@@ -21,7 +21,10 @@
 #include "vm/cells.h"
 #include "vm/cellslice.h"
 #include "vm/stack.hpp"
+#include <atomic>
 #include <functional>
+#include <string>
+#include <vector>
 
 namespace vm {
 using td::BitSlice;
@@ -651,4 +654,52 @@ class AugmentedDictionary final : public DictionaryFixed {
                                                                 const traverse_func_t& traverse_node) const;
 };
 
+// Read-only view of an immutable dictionary with all its entries flattened into an array sorted by key, for repeated
+// lookups in hot dictionaries like the configuration or the public libraries. Views are built on first use and shared
+// by all threads of the process, keyed by the hash of the dictionary root.
+// A lookup in a view does not load any cells, so views are never used for usage-tracked or virtualized roots.
+class FrozenDictionary : public td::CntObject {
+ public:
+  struct Entry {
+    std::string key;  // (key_bits + 7) / 8 bytes, padded with zero bits
+    Ref<CellSlice> value;
+  };
+  FrozenDictionary(int key_bits, std::vector<Entry> entries) : key_bits_(key_bits), entries_(std::move(entries)) {
+  }
+  int get_key_bits() const {
+    return key_bits_;
+  }
+  std::size_t size() const {
+    return entries_.size();
+  }
+  Ref<CellSlice> lookup(td::ConstBitPtr key, int key_len) const;
+  Ref<Cell> lookup_ref(td::ConstBitPtr key, int key_len) const;
+
+  // returns a null Ref if the dictionary cannot be frozen (empty, usage-tracked, virtualized, too large or malformed)
+  static Ref<FrozenDictionary> get(Ref<Cell> root, int key_bits);
+  static bool can_freeze(const Ref<Cell>& root);
+  // same as dict.lookup() and dict.lookup_ref(), but served from the frozen view of dict when enabled
+  static Ref<CellSlice> lookup_in(Dictionary& dict, td::ConstBitPtr key, int key_len);
+  static Ref<Cell> lookup_ref_in(Dictionary& dict, td::ConstBitPtr key, int key_len);
+  template <typename T>
+  static Ref<Cell> lookup_ref_in(Dictionary& dict, const T& key) {
+    return lookup_ref_in(dict, key.bits(), key.size());
+  }
+  // disabled by default
+  static void enable(bool enabled);
+  static bool is_enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  static std::size_t cache_size();
+  static void clear_cache();
+  static constexpr std::size_t max_cached_dicts = 256;  // the least recently used views are evicted
+  static constexpr std::size_t max_entries = 1 << 16;
+
+ private:
+  int key_bits_;
+  std::vector<Entry> entries_;
+  static std::atomic<bool> enabled_;
+  static Ref<FrozenDictionary> build(Ref<Cell> root, int key_bits);
+};
+
 }  // namespace vm
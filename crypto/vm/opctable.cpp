@@ -57,6 +57,7 @@ DispatchTable* OpcodeTable::finalize() {
   }
 
   instruction_list.shrink_to_fit();
+  assert(instruction_list.size() < 0xffff);
   final = true;
   return this;
 }
@@ -100,7 +101,7 @@ bool OpcodeTable::insert_bool(const OpcodeInstr* instr) {
   return true;
 }
 
-const OpcodeInstr* OpcodeTable::lookup_instr(unsigned opcode, unsigned bits) const {
+std::size_t OpcodeTable::lookup_instr_idx(unsigned opcode) const {
   std::size_t i = 0, j = instruction_list.size();
   assert(j);
   while (j - i > 1) {
@@ -111,7 +112,11 @@ const OpcodeInstr* OpcodeTable::lookup_instr(unsigned opcode, unsigned bits) con
       j = k;
     }
   }
-  return instruction_list[i].second;
+  return i;
+}
+
+const OpcodeInstr* OpcodeTable::lookup_instr(unsigned opcode, unsigned bits) const {
+  return instruction_list[lookup_instr_idx(opcode)].second;
 }
 
 const OpcodeInstr* OpcodeTable::lookup_instr(const CellSlice& cs, unsigned& opcode, unsigned& bits) const {
@@ -122,10 +127,84 @@ const OpcodeInstr* OpcodeTable::lookup_instr(const CellSlice& cs, unsigned& opco
   return lookup_instr(opcode, bits);
 }
 
+const OpcodeInstr* OpcodeTable::lookup_instr_cached(DecodedCodeHint& hint, const CellSlice& cs, unsigned& opcode,
+                                                    unsigned& bits) const {
+  bits = max_opcode_bits;
+  opcode = (unsigned)(cs.prefetch_ulong_top(bits) >> (64 - max_opcode_bits));
+  const auto& cell = cs.get_data_cell();
+  if (hint.table != this) {
+    hint.entries = {};
+    hint.table = this;
+  }
+  auto& entry = hint.entries[(reinterpret_cast<std::uintptr_t>(cell.get()) >> 4) % DecodedCodeHint::size];
+  if (entry.cell.get() != cell.get()) {
+    entry.decoded = get_decoded_cell(*cell);
+    entry.cell = cell;
+  }
+  unsigned pos = cs.cur_pos();
+  auto slot = entry.decoded->get(pos);
+  if (!slot) {
+    slot = static_cast<td::uint16>(lookup_instr_idx(opcode) + 1);
+    entry.decoded->set(pos, slot);
+  }
+  return instruction_list[slot - 1].second;
+}
+
+std::shared_ptr<const DecodedCodeCell> OpcodeTable::get_decoded_cell(const DataCell& cell) const {
+  auto hash = cell.get_hash();
+  auto& shard = decode_cache[hash.as_array()[0] % decode_cache_shards];
+  std::lock_guard<std::mutex> guard(shard.mutex);
+  auto it = shard.entries.find(hash);
+  if (it != shard.entries.end()) {
+    auto entry = it->second.get();
+    entry->remove();
+    shard.lru.put(entry);
+    return entry->decoded;
+  }
+  if (shard.entries.size() >= max_decode_cache_cells / decode_cache_shards) {
+    auto oldest = DecodeCacheEntry::from_list_node(shard.lru.get());
+    shard.entries.erase(oldest->hash);
+  }
+  auto entry = std::make_unique<DecodeCacheEntry>();
+  entry->hash = hash;
+  entry->decoded = std::make_shared<const DecodedCodeCell>(cell.size());
+  shard.lru.put(entry.get());
+  auto res = entry->decoded;
+  shard.entries.emplace(hash, std::move(entry));
+  return res;
+}
+
+std::atomic<bool> OpcodeTable::decode_cache_enabled{false};
+
+void OpcodeTable::enable_decode_cache(bool enabled) {
+  decode_cache_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::size_t OpcodeTable::decode_cache_size() const {
+  std::size_t res = 0;
+  for (auto& shard : decode_cache) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    res += shard.entries.size();
+  }
+  return res;
+}
+
+void OpcodeTable::clear_decode_cache() const {
+  for (auto& shard : decode_cache) {
+    std::lock_guard<std::mutex> guard(shard.mutex);
+    shard.entries.clear();
+  }
+}
+
 int OpcodeTable::dispatch(VmState* st, CellSlice& cs) const {
   assert(final);
   unsigned bits, opcode;
-  auto instr = lookup_instr(cs, opcode, bits);
+  const OpcodeInstr* instr;
+  if (cs.size() >= max_opcode_bits && is_decode_cache_enabled()) {
+    instr = lookup_instr_cached(st->get_decoded_code_hint(), cs, opcode, bits);
+  } else {
+    instr = lookup_instr(cs, opcode, bits);
+  }
   //std::cerr << "lookup_instr: cs.size()=" << cs.size() << "; bits=" << bits << "; opcode=" << std::setw(6) << std::setfill('0') << std::hex << opcode << std::dec << std::endl;
   return instr->dispatch(st, cs, opcode, bits);
 }
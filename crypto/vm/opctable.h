@@ -18,7 +18,14 @@
 */
 #pragma once
 #include "vm/dispatch.h"
+#include "vm/cells.h"
+#include "td/utils/HashMap.h"
+#include "td/utils/List.h"
+#include <array>
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 #include <map>
@@ -85,12 +92,65 @@ dump_arg_instr_func_t dump_2c_add(unsigned add, std::string prefix, std::string
 
 }  // namespace instr
 
+// Instruction lookups memoized for one code cell: slot i keeps 1 + index (in the instruction list of the table)
+// of the instruction starting at bit i, or 0 if this position has not been decoded yet.
+// Only positions followed by at least max_opcode_bits bits are memoized, so that the result
+// does not depend on where the executed slice ends.
+class DecodedCodeCell {
+  unsigned size_;
+  std::unique_ptr<std::atomic<td::uint16>[]> slots_;
+
+ public:
+  explicit DecodedCodeCell(unsigned bits) : size_(bits), slots_(new std::atomic<td::uint16>[bits + 1]) {
+    for (unsigned i = 0; i <= bits; i++) {
+      slots_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+  unsigned size() const {
+    return size_;
+  }
+  td::uint16 get(unsigned pos) const {
+    return slots_[pos].load(std::memory_order_relaxed);
+  }
+  void set(unsigned pos, td::uint16 value) const {
+    slots_[pos].store(value, std::memory_order_relaxed);
+  }
+};
+
+// Code cells recently seen by a VmState, so that jumps between a few cells (loops, subroutines)
+// do not go to the shared cache
+struct DecodedCodeHint {
+  static constexpr std::size_t size = 8;
+  struct Entry {
+    Ref<DataCell> cell;
+    std::shared_ptr<const DecodedCodeCell> decoded;
+  };
+  const DispatchTable* table{nullptr};
+  std::array<Entry, size> entries;
+};
+
 class OpcodeTable : public DispatchTable {
   std::map<unsigned, const OpcodeInstr*> instructions;
   std::vector<std::pair<unsigned, const OpcodeInstr*>> instruction_list;
   std::string name;
   Codepage codepage;
   bool final;
+  struct DecodeCacheEntry : public td::ListNode {
+    CellHash hash;
+    std::shared_ptr<const DecodedCodeCell> decoded;
+    static DecodeCacheEntry* from_list_node(td::ListNode* node) {
+      return static_cast<DecodeCacheEntry*>(node);
+    }
+  };
+  // the cache is split by cell hash, so that VMs of different threads rarely wait for each other
+  struct DecodeCacheShard {
+    std::mutex mutex;
+    td::HashMap<CellHash, std::unique_ptr<DecodeCacheEntry>> entries;
+    td::ListNode lru;
+  };
+  static constexpr std::size_t decode_cache_shards = 16;
+  mutable std::array<DecodeCacheShard, decode_cache_shards> decode_cache;
+  static std::atomic<bool> decode_cache_enabled;
 
  public:
   OpcodeTable(std::string _name, Codepage cp) : name(_name), codepage(cp), final(false) {
@@ -109,10 +169,25 @@ class OpcodeTable : public DispatchTable {
   int instr_len(const CellSlice& cs) const override;
   bool insert_bool(const OpcodeInstr*);
   OpcodeTable& insert(const OpcodeInstr*);
+  // remembers which instruction of the table starts at each bit position of a code cell, per code cell hash, shared
+  // by all VmStates of the process (off by default, see --tvm-decode-cache of validator-engine); only the opcode
+  // lookup is skipped, arguments are still parsed by the instruction and every step still goes through the exception
+  // handlers of VmState::run; the least recently used cells are evicted once there are max_decode_cache_cells of them
+  static void enable_decode_cache(bool enabled);
+  static bool is_decode_cache_enabled() {
+    return decode_cache_enabled.load(std::memory_order_relaxed);
+  }
+  std::size_t decode_cache_size() const;
+  void clear_decode_cache() const;
+  static constexpr std::size_t max_decode_cache_cells = 1 << 14;
 
  private:
+  std::size_t lookup_instr_idx(unsigned opcode) const;
   const OpcodeInstr* lookup_instr(unsigned opcode, unsigned bits) const;
   const OpcodeInstr* lookup_instr(const CellSlice& cs, unsigned& opcode, unsigned& bits) const;
+  const OpcodeInstr* lookup_instr_cached(DecodedCodeHint& hint, const CellSlice& cs, unsigned& opcode,
+                                         unsigned& bits) const;
+  std::shared_ptr<const DecodedCodeCell> get_decoded_cell(const DataCell& cell) const;
 };
 
 class OpcodeInstrDummy : public OpcodeInstr {
@@ -647,7 +647,7 @@ td::BitArray<256> VmState::get_final_state_hash(int exit_code) const {
 
 Ref<vm::Cell> lookup_library_in(td::ConstBitPtr key, vm::Dictionary& dict) {
   try {
-    auto val = dict.lookup(key, 256);
+    auto val = FrozenDictionary::lookup_in(dict, key, 256);
     if (val.is_null() || !val->have_refs()) {
       return {};
     }
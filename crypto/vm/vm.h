@@ -24,6 +24,7 @@
 #include "vm/vmstate.h"
 #include "vm/log.h"
 #include "vm/continuation.h"
+#include "vm/opctable.h"
 #include "td/utils/HashSet.h"
 
 namespace vm {
@@ -88,6 +89,7 @@ class VmState final : public VmStateInterface {
   int cp;
   long long steps{0};
   const DispatchTable* dispatch;
+  DecodedCodeHint decoded_code;
   Ref<QuitCont> quit0, quit1;
   VmLog log;
   GasLimits gas;
@@ -181,6 +183,9 @@ class VmState final : public VmStateInterface {
   long long get_steps_count() const {
     return steps;
   }
+  DecodedCodeHint& get_decoded_code_hint() {
+    return decoded_code;
+  }
   td::BitArray<256> get_state_hash() const;
   td::BitArray<256> get_final_state_hash(int exit_code) const;
   int step();
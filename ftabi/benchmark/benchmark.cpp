@@ -0,0 +1,185 @@
+#include "ftabi/CompiledAbi.hpp"
+
+#include "td/utils/base64.h"
+#include "td/utils/benchmark.h"
+#include "td/utils/logging.h"
+#include "td/utils/Random.h"
+
+namespace {
+constexpr td::Slice ABI_JSON = R"abi({
+  "ABI version": 2,
+  "header": ["time", "expire"],
+  "functions": [
+    {
+      "name": "transfer",
+      "inputs": [
+        {"name": "to", "type": "address"},
+        {"name": "value", "type": "uint128"},
+        {"name": "bounce", "type": "bool"},
+        {"name": "payload", "type": "bytes"}
+      ],
+      "outputs": []
+    },
+    {
+      "name": "batch",
+      "inputs": [
+        {"name": "ids", "type": "uint64[]"},
+        {"name": "owner", "type": "tuple", "components": [
+          {"name": "key", "type": "uint256"},
+          {"name": "flags", "type": "uint8"}
+        ]}
+      ],
+      "outputs": [
+        {"name": "count", "type": "uint32"}
+      ]
+    }
+  ]
+})abi";
+
+auto random_hex256() -> std::string {
+  td::Bits256 bits;
+  td::Random::secure_bytes(bits.as_slice());
+  return bits.to_hex();
+}
+
+auto random_bytes(size_t size) -> std::string {
+  std::string result(size, '\0');
+  td::Random::secure_bytes(result);
+  return td::base64_encode(result);
+}
+
+auto encode_message(ftabi::ContractAbi& abi, std::string name, std::string inputs) -> td::Ref<vm::Cell> {
+  auto function = abi.create_function(std::move(name)).move_as_ok();
+  auto json_str = PSTRING() << "{\"internal\": true, \"inputs\": " << inputs << "}";
+  auto json = td::json_decode(json_str).move_as_ok();
+  auto call = ftabi::function_call_from_json(function, json).move_as_ok();
+  return function.encode_input(call).move_as_ok();
+}
+
+// the mix of messages an indexer sees: mostly transfers and some batches
+auto generate_messages(size_t count) -> std::vector<td::Ref<vm::Cell>> {
+  auto abi_json = ABI_JSON.str();
+  auto json = td::json_decode(abi_json).move_as_ok();
+  auto abi = ftabi::contract_abi_from_json(json).move_as_ok();
+
+  std::vector<td::Ref<vm::Cell>> result;
+  for (size_t i = 0; i < count; i++) {
+    if (i % 4 != 3) {
+      auto value = td::Random::fast(0, 1 << 30);
+      auto payload = random_bytes(td::Random::fast(1, 100));
+      result.push_back(encode_message(
+          abi, "transfer",
+          PSTRING() << "[\"0:" << random_hex256() << "\", \"" << value << "\", true, \"" << payload << "\"]"));
+    } else {
+      td::StringBuilder ids;
+      for (int j = 0; j < 8; j++) {
+        ids << (j == 0 ? "" : ", ") << td::Random::fast(0, 1 << 30);
+      }
+      result.push_back(encode_message(
+          abi, "batch",
+          PSTRING() << "[[" << ids.as_cslice() << "], [\"0x" << random_hex256() << "\", 7]]"));
+    }
+  }
+  return result;
+}
+
+class CountingVisitor : public ftabi::AbiVisitor {
+ public:
+  void on_uint(const ftabi::PlanItem& item, td::uint64 value) final {
+    sum += value;
+  }
+  void on_int(const ftabi::PlanItem& item, td::int64 value) final {
+    sum += value;
+  }
+  void on_big_int(const ftabi::PlanItem& item, const td::BigInt256& value) final {
+    sum++;
+  }
+  void on_bool(const ftabi::PlanItem& item, bool value) final {
+    sum += value;
+  }
+  void on_address(const ftabi::PlanItem& item, const block::StdAddress& value) final {
+    sum += value.addr[0];
+  }
+  void on_cell(const ftabi::PlanItem& item, const td::Ref<vm::Cell>& value) final {
+    sum++;
+  }
+  void on_bytes(const ftabi::PlanItem& item, td::Slice chunk, bool is_last_chunk) final {
+    sum += chunk.size();
+  }
+  void on_public_key(const ftabi::PlanItem& item, td::Slice value) final {
+    sum += value.size();
+  }
+
+  td::uint64 sum{0};
+};
+
+class DecodeValuesBench : public td::Benchmark {
+ public:
+  std::string get_description() const override {
+    return "decode_input (Value objects)";
+  }
+  void start_up() override {
+    messages_ = generate_messages(1024);
+    auto abi_json = ABI_JSON.str();
+    auto json = td::json_decode(abi_json).move_as_ok();
+    abi_ = ftabi::contract_abi_from_json(json).move_as_ok();
+    for (auto& it : abi_.functions) {
+      functions_.push_back(abi_.create_function(it.first).move_as_ok());
+    }
+  }
+  void run(int n) override {
+    size_t decoded = 0;
+    for (int i = 0; i < n; i++) {
+      auto& message = messages_[i % messages_.size()];
+      // the function has to be found by its id first
+      auto r_input_id = ftabi::decode_input_id(vm::load_cell_slice_ref(message), abi_.header, true);
+      CHECK(r_input_id.is_ok());
+      for (auto& function : functions_) {
+        if (function.input_id() == r_input_id.ok()) {
+          auto r_values = function.decode_input(vm::load_cell_slice_ref(message), true);
+          CHECK(r_values.is_ok());
+          decoded += r_values.ok().second.size();
+          break;
+        }
+      }
+    }
+    td::do_not_optimize_away(decoded);
+  }
+
+ private:
+  std::vector<td::Ref<vm::Cell>> messages_;
+  ftabi::ContractAbi abi_;
+  std::vector<ftabi::Function> functions_;
+};
+
+class DecodeCompiledBench : public td::Benchmark {
+ public:
+  std::string get_description() const override {
+    return "CompiledAbi::decode_input (visitor)";
+  }
+  void start_up() override {
+    messages_ = generate_messages(1024);
+    abi_ = ftabi::CompiledAbi::get(ABI_JSON).move_as_ok();
+  }
+  void run(int n) override {
+    CountingVisitor visitor;
+    for (int i = 0; i < n; i++) {
+      auto& message = messages_[i % messages_.size()];
+      auto r_function = abi_->decode_input(vm::load_cell_slice(message), true, visitor);
+      CHECK(r_function.is_ok());
+    }
+    td::do_not_optimize_away(visitor.sum);
+  }
+
+ private:
+  std::vector<td::Ref<vm::Cell>> messages_;
+  std::shared_ptr<const ftabi::CompiledAbi> abi_;
+};
+}  // namespace
+
+int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  bench(DecodeValuesBench());
+  bench(DecodeCompiledBench());
+  return 0;
+}
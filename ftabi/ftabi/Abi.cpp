@@ -411,7 +411,7 @@ auto abi_function_from_json(td::JsonValue& object) -> td::Result<FunctionAbi> {
   TRY_STATUS(check_missing_field("outputs", output_params))
 
   return FunctionAbi{std::move(*function_name), std::move(*input_params),
-                     std::move(*output_params), std::move(*function_id)};
+                     std::move(*output_params), function_id};
 }
 
 auto abi_functions_from_json(td::JsonValue& object) -> td::Result<std::unordered_map<std::string, FunctionAbi>> {
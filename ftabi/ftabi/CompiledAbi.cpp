@@ -0,0 +1,534 @@
+#include "CompiledAbi.hpp"
+
+#include <td/utils/crypto.h>
+#include <td/utils/List.h>
+
+#include <algorithm>
+#include <mutex>
+
+namespace ftabi {
+constexpr static uint32_t SIGNATURE_LENGTH = 64;
+constexpr static uint32_t STD_ADDRESS_BIT_LENGTH = 267;
+constexpr static uint32_t GRAMS_LEN_BITS = 4;  // VarUInteger 16
+
+namespace {
+struct CompiledAbiCache {
+  struct Entry : public td::ListNode {
+    std::string hash;
+    std::shared_ptr<const CompiledAbi> abi;
+
+    static Entry* from_list_node(td::ListNode* node) {
+      return static_cast<Entry*>(node);
+    }
+  };
+
+  std::mutex mutex;
+  td::ListNode lru;
+  std::unordered_map<std::string, std::unique_ptr<Entry>> abis;
+};
+
+auto compiled_abi_cache() -> CompiledAbiCache& {
+  static CompiledAbiCache cache;
+  return cache;
+}
+
+auto compile_param(const ParamRef& param, bool last, DecodePlan& plan) -> td::Status {
+  const auto index = plan.size();
+  plan.push_back(PlanItem{param->type(), 0, 0, last});
+
+  switch (param->type()) {
+    case ParamType::Uint:
+    case ParamType::Int:
+      plan[index].size = param->bit_len();
+      break;
+    case ParamType::Tuple: {
+      const auto& items = param->as<ParamTuple>().items;
+      for (size_t i = 0; i < items.size(); ++i) {
+        TRY_STATUS(compile_param(items[i], last && i + 1 == items.size(), plan))
+      }
+      break;
+    }
+    case ParamType::Array:
+      TRY_STATUS(compile_param(param->as<ParamArray>().param, true, plan))
+      break;
+    case ParamType::FixedArray: {
+      const auto& array = param->as<ParamFixedArray>();
+      plan[index].size = array.size;
+      TRY_STATUS(compile_param(array.param, true, plan))
+      break;
+    }
+    case ParamType::Map: {
+      const auto& map = param->as<ParamMap>();
+      if (map.key->type() == ParamType::Uint || map.key->type() == ParamType::Int) {
+        plan[index].size = map.key->bit_len();
+      } else if (map.key->type() == ParamType::Address) {
+        plan[index].size = STD_ADDRESS_BIT_LENGTH;
+      } else {
+        return td::Status::Error("only integer and std address values can be used as keys");
+      }
+      TRY_STATUS(compile_param(map.key, true, plan))
+      TRY_STATUS(compile_param(map.value, true, plan))
+      break;
+    }
+    case ParamType::FixedBytes:
+      plan[index].size = static_cast<uint32_t>(param->as<ParamFixedBytes>().size);
+      break;
+    default:
+      break;
+  }
+
+  plan[index].end = static_cast<uint32_t>(plan.size());
+  return td::Status::OK();
+}
+
+auto find_next_bits(vm::CellSlice& cs, uint32_t bits) -> td::Status {
+  if (cs.empty()) {
+    if (cs.size_refs() != 1) {
+      return td::Status::Error("invalid cellslice structure");
+    }
+    cs = vm::load_cell_slice(cs.prefetch_ref());
+    return td::Status::OK();
+  } else if (cs.size() >= bits) {
+    return td::Status::OK();
+  } else {
+    return td::Status::Error("not enough bits in the cell");
+  }
+}
+
+auto read_cell(vm::CellSlice& cs, bool last) -> td::Result<td::Ref<vm::Cell>> {
+  if (cs.size_refs() == 1 && !last && cs.empty()) {
+    cs = vm::load_cell_slice(cs.prefetch_ref());
+  }
+  if (cs.size_refs() == 0) {
+    return td::Status::Error("failed to fetch cell");
+  }
+  return cs.fetch_ref();
+}
+
+auto read_dictionary_root(vm::CellSlice& cs) -> td::Result<td::Ref<vm::Cell>> {
+  bool as_ref;
+  if (!cs.fetch_bool_to(as_ref)) {
+    return td::Status::Error("failed to fetch as_ref bit");
+  }
+  if (!as_ref) {
+    return td::Ref<vm::Cell>{};
+  }
+  if (cs.size_refs() == 0) {
+    return td::Status::Error("failed to get dictionary");
+  }
+  return cs.fetch_ref();
+}
+
+auto read_big_int(vm::CellSlice& cs, uint32_t bits, bool sgnd, td::BigInt256& value) -> bool {
+  return cs.have(bits) && value.import_bits(cs.data_bits(), bits, sgnd) && cs.advance(bits);
+}
+
+auto read_address(vm::CellSlice& cs, block::StdAddress& value) -> td::Status {
+  unsigned long long tag;
+  if (!cs.fetch_ulong_bool(2, tag)) {
+    return td::Status::Error("failed to fetch address. unknown format");
+  }
+  switch (tag) {
+    case 0b00:  // addr_none$00 = MsgAddressExt;
+      value = block::StdAddress{};
+      return td::Status::OK();
+    case 0b10: {  // addr_std$10
+      bool is_anycast;
+      int workchain;
+      ton::StdSmcAddress addr;
+      if (cs.fetch_bool_to(is_anycast)      // maybe anycast
+          && !is_anycast                    // anycast is not supported
+          && cs.fetch_int_to(8, workchain)  // workchain_id:int8
+          && cs.fetch_bits_to(addr))        // address:bits256  = MsgAddressInt;
+      {
+        value = block::StdAddress{workchain, addr};
+        return td::Status::OK();
+      }
+      return td::Status::Error("failed to fetch address. invalid format");
+    }
+    default:
+      return td::Status::Error("failed to fetch address. unknown format");
+  }
+}
+
+// map keys are not stored in cells, so they are parsed right from the key bits
+auto visit_key(const PlanItem& item, td::ConstBitPtr key, uint32_t key_len, AbiVisitor& visitor) -> td::Status {
+  switch (item.type) {
+    case ParamType::Uint:
+    case ParamType::Int: {
+      const auto sgnd = item.type == ParamType::Int;
+      if (key_len <= 64) {
+        if (sgnd) {
+          visitor.on_int(item, key.get_int(key_len));
+        } else {
+          visitor.on_uint(item, key.get_uint(key_len));
+        }
+        return td::Status::OK();
+      }
+      td::BigInt256 value;
+      if (!value.import_bits(key, key_len, sgnd)) {
+        return td::Status::Error("invalid map key");
+      }
+      visitor.on_big_int(item, value);
+      return td::Status::OK();
+    }
+    case ParamType::Address: {
+      block::StdAddress value{};
+      const auto tag = key.get_uint(2);
+      if (tag == 0b10 && (key + 2).get_uint(1) == 0) {
+        value = block::StdAddress{static_cast<ton::WorkchainId>((key + 3).get_int(8)), key + 11};
+      } else if (tag != 0b00) {
+        return td::Status::Error("failed to fetch address. unknown format");
+      }
+      visitor.on_address(item, value);
+      return td::Status::OK();
+    }
+    default:
+      return td::Status::Error("only integer and std address values can be used as keys");
+  }
+}
+
+auto visit_param(const DecodePlan& plan, size_t index, vm::CellSlice& cs, AbiVisitor& visitor) -> td::Status;
+
+auto visit_array(const DecodePlan& plan, size_t index, uint32_t size, vm::CellSlice& cs, AbiVisitor& visitor)
+    -> td::Status {
+  const auto& item = plan[index];
+  TRY_STATUS(find_next_bits(cs, 1))
+  TRY_RESULT(root, read_dictionary_root(cs))
+  vm::Dictionary dictionary{std::move(root), 32};
+
+  visitor.begin_array(item, size);
+  for (uint32_t i = 0; i < size; ++i) {
+    auto data = dictionary.lookup(td::BitArray<32>{i});
+    if (data.is_null()) {
+      return td::Status::Error("failed to find index");
+    }
+    vm::CellSlice value{*data};
+    TRY_STATUS(visit_param(plan, index + 1, value, visitor))
+  }
+  visitor.end_array(item);
+  return td::Status::OK();
+}
+
+auto visit_map(const DecodePlan& plan, size_t index, vm::CellSlice& cs, AbiVisitor& visitor) -> td::Status {
+  const auto& item = plan[index];
+  const auto& key_item = plan[index + 1];
+  TRY_STATUS(find_next_bits(cs, 1))
+  TRY_RESULT(root, read_dictionary_root(cs))
+  vm::Dictionary dictionary{std::move(root), static_cast<int>(item.size)};
+
+  visitor.begin_map(item);
+  for (auto&& entry : dictionary) {
+    TRY_STATUS(visit_key(key_item, entry.first, item.size, visitor))
+    vm::CellSlice value{*entry.second};
+    TRY_STATUS(visit_param(plan, key_item.end, value, visitor))
+  }
+  visitor.end_map(item);
+  return td::Status::OK();
+}
+
+auto visit_bytes(const PlanItem& item, vm::CellSlice& cs, AbiVisitor& visitor) -> td::Status {
+  TRY_RESULT(cell, read_cell(cs, item.last))
+
+  size_t total_size = 0;
+  while (true) {
+    // a freshly loaded slice starts at the beginning of the cell data, so its bytes can be passed as is
+    auto chunk = vm::load_cell_slice(cell);
+    const auto next = chunk.size_refs() > 0 ? chunk.prefetch_ref() : td::Ref<vm::Cell>{};
+    const auto chunk_size = chunk.size() / 8;
+    total_size += chunk_size;
+    visitor.on_bytes(item, td::Slice{chunk.data(), chunk_size}, next.is_null());
+    if (next.is_null()) {
+      break;
+    }
+    cell = std::move(next);
+  }
+
+  if (item.type == ParamType::FixedBytes && total_size != item.size) {
+    return td::Status::Error("size of fixed bytes is not correspond to expected size");
+  }
+  return td::Status::OK();
+}
+
+auto visit_param(const DecodePlan& plan, size_t index, vm::CellSlice& cs, AbiVisitor& visitor) -> td::Status {
+  const auto& item = plan[index];
+  switch (item.type) {
+    case ParamType::Uint:
+    case ParamType::Int: {
+      TRY_STATUS(find_next_bits(cs, item.size))
+      const auto sgnd = item.type == ParamType::Int;
+      if (item.size <= 64) {
+        if (sgnd) {
+          long long value;
+          if (!cs.fetch_long_bool(item.size, value)) {
+            return td::Status::Error("invalid value type. int or uint expected");
+          }
+          visitor.on_int(item, value);
+        } else {
+          unsigned long long value;
+          if (!cs.fetch_ulong_bool(item.size, value)) {
+            return td::Status::Error("invalid value type. int or uint expected");
+          }
+          visitor.on_uint(item, value);
+        }
+      } else {
+        td::BigInt256 value;
+        if (!read_big_int(cs, item.size, sgnd, value)) {
+          return td::Status::Error("invalid value type. int or uint expected");
+        }
+        visitor.on_big_int(item, value);
+      }
+      return td::Status::OK();
+    }
+    case ParamType::Bool: {
+      TRY_STATUS(find_next_bits(cs, 1))
+      bool value;
+      if (!cs.fetch_bool_to(value)) {
+        return td::Status::Error("invalid value type. bool expected");
+      }
+      visitor.on_bool(item, value);
+      return td::Status::OK();
+    }
+    case ParamType::Tuple: {
+      visitor.begin_tuple(item);
+      for (size_t i = index + 1; i < item.end; i = plan[i].end) {
+        TRY_STATUS(visit_param(plan, i, cs, visitor))
+      }
+      visitor.end_tuple(item);
+      return td::Status::OK();
+    }
+    case ParamType::Array: {
+      TRY_STATUS(find_next_bits(cs, 32))
+      unsigned long long size;
+      if (!cs.fetch_ulong_bool(32, size)) {
+        return td::Status::Error("failed to fetch array size");
+      }
+      return visit_array(plan, index, static_cast<uint32_t>(size), cs, visitor);
+    }
+    case ParamType::FixedArray:
+      return visit_array(plan, index, item.size, cs, visitor);
+    case ParamType::Cell: {
+      TRY_RESULT(cell, read_cell(cs, item.last))
+      visitor.on_cell(item, cell);
+      return td::Status::OK();
+    }
+    case ParamType::Map:
+      return visit_map(plan, index, cs, visitor);
+    case ParamType::Address: {
+      TRY_STATUS(find_next_bits(cs, 1))
+      block::StdAddress value{};
+      TRY_STATUS(read_address(cs, value))
+      visitor.on_address(item, value);
+      return td::Status::OK();
+    }
+    case ParamType::Bytes:
+    case ParamType::FixedBytes:
+      return visit_bytes(item, cs, visitor);
+    case ParamType::Gram: {
+      TRY_STATUS(find_next_bits(cs, 1))
+      unsigned long long len;
+      td::BigInt256 value;
+      if (!cs.fetch_ulong_bool(GRAMS_LEN_BITS, len) ||
+          !read_big_int(cs, static_cast<uint32_t>(len * 8), false, value)) {
+        return td::Status::Error("failed to parse grams");
+      }
+      visitor.on_big_int(item, value);
+      return td::Status::OK();
+    }
+    case ParamType::Time: {
+      TRY_STATUS(find_next_bits(cs, 64))
+      unsigned long long value;
+      if (!cs.fetch_ulong_bool(64, value)) {
+        return td::Status::Error("failed to fetch time");
+      }
+      visitor.on_uint(item, value);
+      return td::Status::OK();
+    }
+    case ParamType::Expire: {
+      TRY_STATUS(find_next_bits(cs, 32))
+      unsigned long long value;
+      if (!cs.fetch_ulong_bool(32, value)) {
+        return td::Status::Error("failed to fetch time");
+      }
+      visitor.on_uint(item, value);
+      return td::Status::OK();
+    }
+    case ParamType::PublicKey: {
+      TRY_STATUS(find_next_bits(cs, 1))
+      bool has_value;
+      if (!cs.fetch_bool_to(has_value)) {
+        return td::Status::Error("failed to fetch public key maybe tag");
+      }
+      unsigned char data[32];
+      if (has_value && !cs.fetch_bytes(data, sizeof(data))) {
+        return td::Status::Error("failed to fetch public key data");
+      }
+      visitor.on_public_key(item, has_value ? td::Slice{data, sizeof(data)} : td::Slice{});
+      return td::Status::OK();
+    }
+  }
+  return td::Status::Error("unknown param type");
+}
+}  // namespace
+
+auto compile_params(const std::vector<ParamRef>& params, bool last) -> td::Result<DecodePlan> {
+  DecodePlan plan;
+  for (size_t i = 0; i < params.size(); ++i) {
+    TRY_STATUS(compile_param(params[i], last && i + 1 == params.size(), plan))
+  }
+  return std::move(plan);
+}
+
+auto compile_header(const HeaderParams& header) -> td::Result<DecodePlan> {
+  DecodePlan plan;
+  for (const auto& item : header) {
+    TRY_STATUS(compile_param(item.second, false, plan))
+  }
+  return std::move(plan);
+}
+
+auto visit_params(vm::CellSlice& cs, const DecodePlan& plan, AbiVisitor& visitor, bool allow_partial) -> td::Status {
+  for (size_t i = 0; i < plan.size(); i = plan[i].end) {
+    TRY_STATUS(visit_param(plan, i, cs, visitor))
+  }
+  if (!allow_partial && !cs.empty_ext()) {
+    return td::Status::Error("incomplete deserialization");
+  }
+  return td::Status::OK();
+}
+
+auto CompiledAbi::compile(const ContractAbi& abi) -> td::Result<CompiledAbi> {
+  CompiledAbi result;
+  TRY_RESULT(header, compile_header(abi.header))
+  result.header_ = std::move(header);
+
+  result.functions_.reserve(abi.functions.size());
+  for (const auto& it : abi.functions) {
+    const auto& function = it.second;
+    CompiledFunction compiled;
+    compiled.name = function.name;
+    if (function.id.has_value()) {
+      compiled.input_id = *function.id;
+      compiled.output_id = *function.id;
+    } else {
+      const auto id = compute_function_id(compute_function_signature(function.name, function.inputs, function.outputs));
+      compiled.input_id = id & 0x7fffffffu;
+      compiled.output_id = id | 0x80000000u;
+    }
+    TRY_RESULT(inputs, compile_params(function.inputs, true))
+    TRY_RESULT(outputs, compile_params(function.outputs, true))
+    compiled.inputs = std::move(inputs);
+    compiled.outputs = std::move(outputs);
+    result.functions_.push_back(std::move(compiled));
+  }
+  std::sort(result.functions_.begin(), result.functions_.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.name < rhs.name; });
+
+  for (size_t i = 0; i < result.functions_.size(); ++i) {
+    const auto& function = result.functions_[i];
+    if (!result.by_input_id_.emplace(function.input_id, i).second ||
+        !result.by_output_id_.emplace(function.output_id, i).second) {
+      return td::Status::Error(400, "duplicate function id found");
+    }
+  }
+  return std::move(result);
+}
+
+auto CompiledAbi::get(td::Slice abi_json) -> td::Result<std::shared_ptr<const CompiledAbi>> {
+  auto& cache = compiled_abi_cache();
+
+  std::string hash(32, '\0');
+  td::sha256(abi_json, hash);
+  {
+    std::lock_guard<std::mutex> guard(cache.mutex);
+    auto it = cache.abis.find(hash);
+    if (it != cache.abis.end()) {
+      it->second->remove();
+      cache.lru.put(it->second.get());
+      return it->second->abi;
+    }
+  }
+
+  auto json = abi_json.str();
+  TRY_RESULT(value, td::json_decode(json))
+  TRY_RESULT(contract_abi, contract_abi_from_json(value))
+  TRY_RESULT(compiled, compile(contract_abi))
+  auto result = std::make_shared<const CompiledAbi>(std::move(compiled));
+
+  std::lock_guard<std::mutex> guard(cache.mutex);
+  auto& entry = cache.abis[hash];
+  if (entry) {
+    entry->remove();
+  } else {
+    entry = std::make_unique<CompiledAbiCache::Entry>();
+    entry->hash = std::move(hash);
+  }
+  entry->abi = result;
+  cache.lru.put(entry.get());
+  // the least recently used ABIs are evicted, so that a few hot ones are never compiled again
+  while (cache.abis.size() > MAX_CACHED_ABIS) {
+    auto to_remove = CompiledAbiCache::Entry::from_list_node(cache.lru.get());
+    CHECK(to_remove);
+    cache.abis.erase(to_remove->hash);
+  }
+  return std::move(result);
+}
+
+auto CompiledAbi::get_function(td::Slice name) const -> const CompiledFunction* {
+  auto it = std::lower_bound(
+      functions_.begin(), functions_.end(), name,
+      [](const CompiledFunction& function, td::Slice name) { return td::Slice{function.name} < name; });
+  if (it == functions_.end() || it->name != name) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+auto CompiledAbi::get_function_by_input_id(uint32_t input_id) const -> const CompiledFunction* {
+  auto it = by_input_id_.find(input_id);
+  return it == by_input_id_.end() ? nullptr : &functions_[it->second];
+}
+
+auto CompiledAbi::get_function_by_output_id(uint32_t output_id) const -> const CompiledFunction* {
+  auto it = by_output_id_.find(output_id);
+  return it == by_output_id_.end() ? nullptr : &functions_[it->second];
+}
+
+auto CompiledAbi::decode_input(vm::CellSlice cs, bool internal, AbiVisitor& visitor) const
+    -> td::Result<const CompiledFunction*> {
+  if (!internal) {
+    bool has_signature = false;
+    if (!cs.fetch_bool_to(has_signature)) {
+      return td::Status::Error("failed to fetch signature option bit");
+    }
+    if (has_signature && !cs.advance(SIGNATURE_LENGTH * 8)) {
+      return td::Status::Error("failed to fetch signature");
+    }
+    TRY_STATUS(visit_params(cs, header_, visitor, true))
+  }
+  unsigned long long input_id;
+  if (!cs.fetch_ulong_bool(32, input_id)) {
+    return td::Status::Error("failed to fetch function id");
+  }
+  auto function = get_function_by_input_id(static_cast<uint32_t>(input_id));
+  if (function == nullptr) {
+    return td::Status::Error("invalid input_id");
+  }
+  TRY_STATUS(visit_params(cs, function->inputs, visitor, false))
+  return function;
+}
+
+auto CompiledAbi::decode_output(vm::CellSlice cs, AbiVisitor& visitor) const -> td::Result<const CompiledFunction*> {
+  unsigned long long output_id;
+  if (!cs.fetch_ulong_bool(32, output_id)) {
+    return td::Status::Error("failed to fetch output_id");
+  }
+  auto function = get_function_by_output_id(static_cast<uint32_t>(output_id));
+  if (function == nullptr) {
+    return td::Status::Error("invalid output_id");
+  }
+  TRY_STATUS(visit_params(cs, function->outputs, visitor, false))
+  return function;
+}
+
+}  // namespace ftabi
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+
+#include "Abi.hpp"
+
+namespace ftabi {
+
+// One param of a flattened param tree. Params are stored in pre-order: tuple items, the array item
+// and the map key and value follow their parent, and `end` is the index right after the subtree
+struct PlanItem {
+  ParamType type;
+  uint32_t size;  // bit length of integers and map keys, size of fixed arrays and fixed bytes
+  uint32_t end;
+  bool last;  // same as the `last` flag passed to Value::deserialize
+};
+
+using DecodePlan = std::vector<PlanItem>;
+
+auto compile_params(const std::vector<ParamRef>& params, bool last) -> td::Result<DecodePlan>;
+auto compile_header(const HeaderParams& header) -> td::Result<DecodePlan>;
+
+// Receives decoded values in the same order as Value::deserialize would produce them.
+// Slices and cells passed to the callbacks point into the message and are valid only during the call
+class AbiVisitor {
+ public:
+  virtual ~AbiVisitor() = default;
+
+  // uint<M> with M <= 64, time and expire
+  virtual void on_uint(const PlanItem& item, td::uint64 value) = 0;
+  // int<M> with M <= 64
+  virtual void on_int(const PlanItem& item, td::int64 value) = 0;
+  // wider integers and grams
+  virtual void on_big_int(const PlanItem& item, const td::BigInt256& value) = 0;
+  virtual void on_bool(const PlanItem& item, bool value) = 0;
+  virtual void on_address(const PlanItem& item, const block::StdAddress& value) = 0;
+  virtual void on_cell(const PlanItem& item, const td::Ref<vm::Cell>& value) = 0;
+  // bytes are passed in chunks, one per cell of the chain
+  virtual void on_bytes(const PlanItem& item, td::Slice chunk, bool is_last_chunk) = 0;
+  // empty if the key is absent
+  virtual void on_public_key(const PlanItem& item, td::Slice value) = 0;
+
+  virtual void begin_tuple(const PlanItem& item) {
+  }
+  virtual void end_tuple(const PlanItem& item) {
+  }
+  // also used for fixed arrays
+  virtual void begin_array(const PlanItem& item, uint32_t size) {
+  }
+  virtual void end_array(const PlanItem& item) {
+  }
+  // each entry is a key followed by a value
+  virtual void begin_map(const PlanItem& item) {
+  }
+  virtual void end_map(const PlanItem& item) {
+  }
+};
+
+// Same as decode_params, but without creating Value objects
+auto visit_params(vm::CellSlice& cs, const DecodePlan& plan, AbiVisitor& visitor, bool allow_partial) -> td::Status;
+
+struct CompiledFunction {
+  std::string name;
+  uint32_t input_id{};
+  uint32_t output_id{};
+  DecodePlan inputs;
+  DecodePlan outputs;
+};
+
+// Contract ABI with precomputed function ids and decoding plans, meant for decoding many messages
+class CompiledAbi {
+ public:
+  static constexpr size_t MAX_CACHED_ABIS = 1024;
+
+  static auto compile(const ContractAbi& abi) -> td::Result<CompiledAbi>;
+  // abi_json is hashed and compiled ABIs are cached by the hash, so that it is parsed only once;
+  // at most MAX_CACHED_ABIS are kept, the least recently used are evicted
+  static auto get(td::Slice abi_json) -> td::Result<std::shared_ptr<const CompiledAbi>>;
+
+  auto get_function(td::Slice name) const -> const CompiledFunction*;
+  auto get_function_by_input_id(uint32_t input_id) const -> const CompiledFunction*;
+  auto get_function_by_output_id(uint32_t output_id) const -> const CompiledFunction*;
+
+  // header values are visited first, then the inputs of the function found by the id
+  auto decode_input(vm::CellSlice cs, bool internal, AbiVisitor& visitor) const -> td::Result<const CompiledFunction*>;
+  auto decode_output(vm::CellSlice cs, AbiVisitor& visitor) const -> td::Result<const CompiledFunction*>;
+
+  auto functions() const -> const std::vector<CompiledFunction>& {
+    return functions_;
+  }
+
+ private:
+  DecodePlan header_;
+  std::vector<CompiledFunction> functions_;
+  std::unordered_map<uint32_t, size_t> by_input_id_;
+  std::unordered_map<uint32_t, size_t> by_output_id_;
+};
+
+}  // namespace ftabi
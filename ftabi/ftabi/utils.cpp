@@ -444,15 +444,14 @@ auto ValueMap::serialize() const -> td::Result<std::vector<BuilderData>> {
     return td::Status::Error("only integer and std address values can be used as keys");
   }
 
-  vm::CellBuilder cb{};
-  block::gen::HashmapE map(static_cast<int>(bit_len), tlb::Anything{});
+  vm::Dictionary dictionary{static_cast<int>(bit_len)};
   for (const auto& item : values) {
     TRY_RESULT(serialized_key, item.first->serialize())
-    if (serialized_key.size() != 1) {
+    if (serialized_key.size() != 1 || serialized_key[0]->size() != bit_len) {
       return td::Status::Error("map key must be one-cell length");
     }
 
-    if (param_->type() == ParamType::Address && serialized_key[0]->size() != STD_ADDRESS_BIT_LENGTH) {
+    if (param_key.type() == ParamType::Address && serialized_key[0]->size() != STD_ADDRESS_BIT_LENGTH) {
       return td::Status::Error("only std non-anycast address can be used as map key");
     }
 
@@ -460,10 +459,14 @@ auto ValueMap::serialize() const -> td::Result<std::vector<BuilderData>> {
     TRY_RESULT(packed_value, pack_cells_into_chain(std::move(serialized_value)))
 
     auto key_cs = vm::load_cell_slice(serialized_key[0]);
-    auto value_cs = vm::load_cell_slice(packed_value);
-    CHECK(map.add_values(cb, key_cs, value_cs))
+    if (!dictionary.set(key_cs.data_bits(), static_cast<int>(bit_len), vm::load_cell_slice_ref(packed_value),
+                        vm::DictionaryBase::SetMode::Add)) {
+      return td::Status::Error("failed to add map value");
+    }
   }
 
+  vm::CellBuilder cb{};
+  CHECK(cb.append_cellslice_bool(dictionary.get_root()))
   return std::vector<BuilderData>{cb.finalize()};
 }
 
@@ -0,0 +1,353 @@
+#include "ftabi/CompiledAbi.hpp"
+
+#include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <algorithm>
+
+namespace {
+using namespace ftabi;
+
+// Decoded values as a flat list of events, so that both decoders can be compared item by item
+class RecordingVisitor : public AbiVisitor {
+ public:
+  void on_uint(const PlanItem& item, td::uint64 value) final {
+    record(item.type, PSTRING() << value);
+  }
+  void on_int(const PlanItem& item, td::int64 value) final {
+    record(item.type, PSTRING() << value);
+  }
+  void on_big_int(const PlanItem& item, const td::BigInt256& value) final {
+    record(item.type, value.to_dec_string());
+  }
+  void on_bool(const PlanItem& item, bool value) final {
+    record(item.type, value ? "true" : "false");
+  }
+  void on_address(const PlanItem& item, const block::StdAddress& value) final {
+    record(item.type, PSTRING() << value.workchain << ':' << value.addr.to_hex());
+  }
+  void on_cell(const PlanItem& item, const td::Ref<vm::Cell>& value) final {
+    record(item.type, value->get_hash().to_hex());
+  }
+  void on_bytes(const PlanItem& item, td::Slice chunk, bool is_last_chunk) final {
+    bytes_.append(chunk.begin(), chunk.size());
+    if (is_last_chunk) {
+      record(item.type, td::buffer_to_hex(bytes_));
+      bytes_.clear();
+    }
+  }
+  void on_public_key(const PlanItem& item, td::Slice value) final {
+    record(item.type, td::buffer_to_hex(value));
+  }
+  void begin_tuple(const PlanItem& item) final {
+    record(item.type, "(");
+  }
+  void end_tuple(const PlanItem& item) final {
+    events.emplace_back(")");
+  }
+  void begin_array(const PlanItem& item, uint32_t size) final {
+    record(item.type, PSTRING() << size << " (");
+  }
+  void end_array(const PlanItem& item) final {
+    events.emplace_back(")");
+  }
+  void begin_map(const PlanItem& item) final {
+    record(item.type, "(");
+  }
+  void end_map(const PlanItem& item) final {
+    events.emplace_back(")");
+  }
+
+  std::vector<std::string> events;
+
+ private:
+  std::string bytes_;
+
+  void record(ParamType type, std::string value) {
+    events.push_back(PSTRING() << static_cast<int>(type) << ' ' << value);
+  }
+};
+
+void record_value(const ValueRef& value, std::vector<std::string>& events) {
+  const auto type = value->param()->type();
+  auto record = [&](std::string str) { events.push_back(PSTRING() << static_cast<int>(type) << ' ' << str); };
+  switch (type) {
+    case ParamType::Uint:
+    case ParamType::Int:
+      record(value->as<ValueInt>().value.to_dec_string());
+      break;
+    case ParamType::Bool:
+      record(value->as<ValueBool>().value ? "true" : "false");
+      break;
+    case ParamType::Tuple:
+      record("(");
+      for (const auto& item : value->as<ValueTuple>().values) {
+        record_value(item, events);
+      }
+      events.emplace_back(")");
+      break;
+    case ParamType::Array:
+    case ParamType::FixedArray: {
+      const auto& values =
+          type == ParamType::Array ? value->as<ValueArray>().values : value->as<ValueFixedArray>().values;
+      record(PSTRING() << values.size() << " (");
+      for (const auto& item : values) {
+        record_value(item, events);
+      }
+      events.emplace_back(")");
+      break;
+    }
+    case ParamType::Cell:
+      record(value->as<ValueCell>().value->get_hash().to_hex());
+      break;
+    case ParamType::Map:
+      record("(");
+      for (const auto& item : value->as<ValueMap>().values) {
+        record_value(item.first, events);
+        record_value(item.second, events);
+      }
+      events.emplace_back(")");
+      break;
+    case ParamType::Address: {
+      const auto& address = value->as<ValueAddress>().value;
+      record(PSTRING() << address.workchain << ':' << address.addr.to_hex());
+      break;
+    }
+    case ParamType::Bytes:
+    case ParamType::FixedBytes: {
+      const auto& bytes = value->as<ValueBytes>().value;
+      record(td::buffer_to_hex(td::Slice{bytes.data(), bytes.size()}));
+      break;
+    }
+    case ParamType::Gram:
+      record(value->as<ValueGram>().value.to_dec_string());
+      break;
+    case ParamType::Time:
+      record(PSTRING() << value->as<ValueTime>().value);
+      break;
+    case ParamType::Expire:
+      record(PSTRING() << value->as<ValueExpire>().value);
+      break;
+    case ParamType::PublicKey: {
+      const auto& key = value->as<ValuePublicKey>().value;
+      record(key ? td::buffer_to_hex(key.value().as_slice()) : "");
+      break;
+    }
+  }
+}
+
+auto record_values(const std::vector<ValueRef>& values) -> std::vector<std::string> {
+  std::vector<std::string> events;
+  for (const auto& value : values) {
+    record_value(value, events);
+  }
+  return events;
+}
+
+auto big_int(td::Slice str) -> td::BigInt256 {
+  auto value = td::string_to_int256(str);
+  CHECK(value.not_null());
+  return *value;
+}
+
+auto random_address() -> block::StdAddress {
+  td::Bits256 addr;
+  td::Random::secure_bytes(addr.as_slice());
+  return block::StdAddress{td::Random::fast(0, 1) ? ton::basechainId : ton::masterchainId, addr};
+}
+
+auto random_bytes(size_t size) -> std::vector<uint8_t> {
+  std::vector<uint8_t> result(size);
+  td::Random::secure_bytes(result.data(), result.size());
+  return result;
+}
+
+constexpr uint32_t EXPLICIT_ID = 0x1234abcd;
+
+auto make_abi() -> ContractAbi {
+  ContractAbi abi;
+  abi.header = make_named_params(std::make_pair("pubkey", ParamPublicKey{}), std::make_pair("time", ParamTime{}),
+                                 std::make_pair("expire", ParamExpire{}));
+
+  // integers at and around the 64 bit boundary, where the compiled decoder switches to big integers
+  abi.functions["ints"] = FunctionAbi{
+      "ints",
+      make_params(ParamUint{8}, ParamUint{64}, ParamUint{65}, ParamUint{256}, ParamInt{7}, ParamInt{64}, ParamInt{65},
+                  ParamInt{256}, ParamGram{}, ParamBool{}),
+      {},
+      std::nullopt};
+  abi.functions["arrays"] = FunctionAbi{
+      "arrays",
+      make_params(ParamArray{ParamUint{32}}, ParamFixedArray{ParamRef{ParamInt{128}}, 3},
+                  ParamArray{ParamTuple{ParamAddress{}, ParamBool{}, ParamUint{16}}}, ParamArray{ParamBytes{}}),
+      {},
+      std::nullopt};
+  abi.functions["maps"] = FunctionAbi{
+      "maps",
+      {ParamRef{ParamMap{ParamRef{ParamUint{32}}, ParamRef{ParamUint{128}}}},
+       ParamRef{ParamMap{ParamRef{ParamInt{128}}, ParamRef{ParamBool{}}}},
+       ParamRef{ParamMap{ParamRef{ParamInt{16}}, ParamRef{ParamTuple{ParamUint{8}, ParamAddress{}}}}},
+       ParamRef{ParamMap{ParamRef{ParamAddress{}}, ParamRef{ParamUint{64}}}}},
+      {},
+      std::nullopt};
+  // bytes longer than a cell are stored as a chain of cells
+  abi.functions["bytes"] = FunctionAbi{
+      "bytes", make_params(ParamBytes{}, ParamFixedBytes{32}, ParamCell{}, ParamBytes{}, ParamUint{256}), {},
+      EXPLICIT_ID};
+  return abi;
+}
+
+auto make_inputs(const ContractAbi& abi, const std::string& name) -> InputValues {
+  const auto& params = abi.functions.at(name).inputs;
+  InputValues values;
+  if (name == "ints") {
+    values = {ValueRef{ValueInt{params[0], td::BigInt256{255}}},
+              ValueRef{ValueInt{params[1], big_int("18446744073709551615")}},
+              ValueRef{ValueInt{params[2], big_int("36893488147419103231")}},
+              ValueRef{ValueInt{params[3], big_int("0x" + std::string(64, 'f'))}},
+              ValueRef{ValueInt{params[4], td::BigInt256{-64}}},
+              ValueRef{ValueInt{params[5], big_int("-9223372036854775808")}},
+              ValueRef{ValueInt{params[6], big_int("-18446744073709551616")}},
+              ValueRef{ValueInt{params[7], big_int("-123456789012345678901234567890123456789012345678901234567890")}},
+              ValueRef{ValueGram{params[8], big_int("1000000000000")}},
+              ValueRef{ValueBool{params[9], true}}};
+  } else if (name == "arrays") {
+    const auto& array = params[0]->as<ParamArray>().param;
+    const auto& fixed_array = params[1]->as<ParamFixedArray>().param;
+    const auto& tuple = params[2]->as<ParamArray>().param;
+    const auto& bytes = params[3]->as<ParamArray>().param;
+    std::vector<ValueRef> ids, ints, tuples, chunks;
+    for (int i = 0; i < 40; i++) {
+      ids.push_back(ValueRef{ValueInt{array, td::BigInt256{td::Random::fast(0, 1 << 30)}}});
+    }
+    for (int i = 0; i < 3; i++) {
+      ints.push_back(ValueRef{ValueInt{fixed_array, td::BigInt256{td::Random::fast(-(1 << 30), 1 << 30)}}});
+    }
+    for (int i = 0; i < 5; i++) {
+      auto& items = tuple->as<ParamTuple>().items;
+      tuples.push_back(ValueRef{ValueTuple{
+          tuple,
+          {ValueRef{ValueAddress{items[0], random_address()}}, ValueRef{ValueBool{items[1], i % 2 == 0}},
+           ValueRef{ValueInt{items[2], td::BigInt256{i * 1000}}}}}});
+    }
+    for (size_t size : {1, 127, 128, 300}) {
+      chunks.push_back(ValueRef{ValueBytes{bytes, random_bytes(size)}});
+    }
+    values = {ValueRef{ValueArray{params[0], std::move(ids)}}, ValueRef{ValueFixedArray{params[1], std::move(ints)}},
+              ValueRef{ValueArray{params[2], std::move(tuples)}}, ValueRef{ValueArray{params[3], std::move(chunks)}}};
+  } else if (name == "maps") {
+    std::vector<std::vector<std::pair<ValueRef, ValueRef>>> entries(params.size());
+    for (size_t i = 0; i < params.size(); i++) {
+      const auto& map = params[i]->as<ParamMap>();
+      for (int j = 0; j < 10; j++) {
+        ValueRef key, value;
+        switch (i) {
+          case 0:
+            key = ValueRef{ValueInt{map.key, td::BigInt256{j * 7919}}};
+            value = ValueRef{ValueInt{map.value, big_int(PSLICE() << "1000000000000000000000000000000" << j)}};
+            break;
+          case 1:
+            key = ValueRef{ValueInt{map.key, big_int(PSLICE() << (j % 2 ? "-" : "") << "1000000000000000000000" << j)}};
+            value = ValueRef{ValueBool{map.value, j % 3 == 0}};
+            break;
+          case 2: {
+            auto& items = map.value->as<ParamTuple>().items;
+            key = ValueRef{ValueInt{map.key, td::BigInt256{(j - 5) * 1000}}};
+            value = ValueRef{ValueTuple{
+                map.value, {ValueRef{ValueInt{items[0], td::BigInt256{j}}}, ValueRef{ValueAddress{items[1], random_address()}}}}};
+            break;
+          }
+          default:
+            key = ValueRef{ValueAddress{map.key, random_address()}};
+            value = ValueRef{ValueInt{map.value, td::BigInt256{j}}};
+            break;
+        }
+        entries[i].emplace_back(std::move(key), std::move(value));
+      }
+      // both decoders return the entries in the order of their keys in the dictionary
+      auto key_bits = [](const ValueRef& key) {
+        return vm::load_cell_slice(key->serialize().move_as_ok()[0]).as_bitslice().to_binary();
+      };
+      std::sort(entries[i].begin(), entries[i].end(),
+                [&](const auto& a, const auto& b) { return key_bits(a.first) < key_bits(b.first); });
+      values.push_back(ValueRef{ValueMap{params[i], std::move(entries[i])}});
+    }
+  } else if (name == "bytes") {
+    vm::CellBuilder cb;
+    cb.store_long(td::Random::fast_uint32(), 32);
+    values = {ValueRef{ValueBytes{params[0], random_bytes(1000)}}, ValueRef{ValueBytes{params[1], random_bytes(32)}},
+              ValueRef{ValueCell{params[2], cb.finalize()}}, ValueRef{ValueBytes{params[3], random_bytes(127)}},
+              ValueRef{ValueInt{params[4], td::BigInt256{42}}}};
+  }
+  return values;
+}
+}  // namespace
+
+TEST(CompiledAbi, decode_input_matches_function) {
+  auto abi = make_abi();
+  auto r_compiled = CompiledAbi::compile(abi);
+  ASSERT_TRUE(r_compiled.is_ok());
+  auto compiled = r_compiled.move_as_ok();
+  auto private_key = td::Ed25519::generate_private_key().move_as_ok();
+
+  for (const auto& it : abi.functions) {
+    auto function = abi.create_function(it.first).move_as_ok();
+    auto compiled_function = compiled.get_function(it.first);
+    ASSERT_TRUE(compiled_function != nullptr);
+    ASSERT_EQ(function.input_id(), compiled_function->input_id);
+    ASSERT_EQ(function.output_id(), compiled_function->output_id);
+    if (it.first == "bytes") {
+      ASSERT_EQ(EXPLICIT_ID, compiled_function->input_id);
+      ASSERT_EQ(EXPLICIT_ID, compiled_function->output_id);
+    }
+
+    auto inputs = make_inputs(abi, it.first);
+    auto expected_inputs = record_values(inputs);
+    // internal messages have no header, external ones are sent signed or unsigned
+    for (int mode = 0; mode < 3; mode++) {
+      const bool internal = mode == 0;
+      td::optional<td::Ed25519::PrivateKey> key;
+      if (mode == 2) {
+        key = td::Ed25519::PrivateKey(private_key.as_octet_string());
+      }
+      auto r_message = function.encode_input({}, inputs, internal, key, {});
+      ASSERT_TRUE(r_message.is_ok());
+      auto message = r_message.move_as_ok();
+
+      auto r_values = function.decode_input(vm::load_cell_slice_ref(message), internal);
+      ASSERT_TRUE(r_values.is_ok());
+      auto expected = record_values(r_values.ok().first);
+      ASSERT_EQ(internal ? 0u : 3u, r_values.ok().first.size());
+      if (key) {
+        ASSERT_EQ(td::buffer_to_hex(private_key.get_public_key().move_as_ok().as_octet_string()),
+                  expected[0].substr(expected[0].find(' ') + 1));
+      }
+      auto decoded_inputs = record_values(r_values.ok().second);
+      ASSERT_EQ(expected_inputs, decoded_inputs);
+      expected.insert(expected.end(), decoded_inputs.begin(), decoded_inputs.end());
+
+      RecordingVisitor visitor;
+      auto r_function = compiled.decode_input(vm::load_cell_slice(message), internal, visitor);
+      ASSERT_TRUE(r_function.is_ok());
+      ASSERT_TRUE(r_function.ok() == compiled_function);
+      ASSERT_EQ(expected, visitor.events);
+    }
+  }
+}
+
+TEST(CompiledAbi, cache_evicts_least_recently_used) {
+  auto make_json = [](size_t i) {
+    return PSTRING() << R"({"ABI version": 2, "header": [], "functions": [{"name": "f)" << i
+                     << R"(", "inputs": [], "outputs": []}]})";
+  };
+  const auto max_cached = CompiledAbi::MAX_CACHED_ABIS;
+  auto hot = CompiledAbi::get(make_json(0)).move_as_ok();
+  auto cold = CompiledAbi::get(make_json(1)).move_as_ok();
+  for (size_t i = 2; i < max_cached + 2; i++) {
+    CompiledAbi::get(make_json(i)).ensure();
+    ASSERT_TRUE(CompiledAbi::get(make_json(0)).move_as_ok() == hot);
+  }
+  ASSERT_TRUE(CompiledAbi::get(make_json(0)).move_as_ok() == hot);
+  ASSERT_TRUE(CompiledAbi::get(make_json(1)).move_as_ok() != cold);
+}
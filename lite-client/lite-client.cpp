@@ -923,6 +923,10 @@ bool TestNode::show_help(std::string command) {
          "status\tShow connection and local database status\n"
          "getaccount <addr> [<block-id-ext>]\tLoads the most recent state of specified account; <addr> is in "
          "[<workchain>:]<hex-or-base64-addr> format\n"
+         "getaccounts <addr>...\tLoads the most recent states of several accounts of the same workchain, fetching all "
+         "accounts of one shard with a single query, and shows their balances\n"
+         "getaccountsfrom <block-id-ext> <addr>...\tLoads the states of several accounts of the same workchain with "
+         "respect to <block-id-ext> and shows their balances\n"
          "saveaccount[code|data] <filename> <addr> [<block-id-ext>]\tSaves into specified file the most recent state "
          "(StateInit) or just the code or data of specified account; <addr> is in "
          "[<workchain>:]<hex-or-base64-addr> format\n"
@@ -1014,6 +1018,9 @@ bool TestNode::do_parse_line() {
            (seekeoln()
                 ? get_account_state(workchain, addr, mc_last_id_, addr_ext)
                 : parse_block_id_ext(blkid) && seekeoln() && get_account_state(workchain, addr, blkid, addr_ext));
+  } else if (word == "getaccounts" || word == "getaccountsfrom") {
+    blkid = mc_last_id_;
+    return (word == "getaccounts" || parse_block_id_ext(blkid)) && parse_get_account_states(blkid);
   } else if (word == "saveaccount" || word == "saveaccountcode" || word == "saveaccountdata") {
     std::string filename;
     int mode = ((word.c_str()[11] >> 1) & 3);
@@ -1246,6 +1253,116 @@ bool TestNode::get_account_state(ton::WorkchainId workchain, ton::StdSmcAddress
       });
 }
 
+bool TestNode::parse_get_account_states(ton::BlockIdExt ref_blkid) {
+  ton::WorkchainId workchain = ton::workchainInvalid;
+  std::vector<ton::StdSmcAddress> addrs;
+  while (!seekeoln()) {
+    ton::WorkchainId wc;
+    ton::StdSmcAddress addr;
+    if (!parse_account_addr(wc, addr)) {
+      return false;
+    }
+    if (workchain != ton::workchainInvalid && wc != workchain) {
+      return set_error("all accounts must belong to the same workchain");
+    }
+    workchain = wc;
+    addrs.push_back(addr);
+  }
+  if (addrs.empty()) {
+    return set_error("at least one account address expected");
+  }
+  return get_account_states(workchain, std::move(addrs), ref_blkid);
+}
+
+bool TestNode::get_account_states(ton::WorkchainId workchain, std::vector<ton::StdSmcAddress> addrs,
+                                  ton::BlockIdExt ref_blkid) {
+  if (!ref_blkid.is_valid()) {
+    return set_error("must obtain last block information before making other queries");
+  }
+  if (!(ready_ && !client_.empty())) {
+    return set_error("server connection not ready");
+  }
+  const size_t max_accounts_per_query = 1024;  // liteservers do not accept more
+  if (addrs.size() > max_accounts_per_query) {
+    std::vector<ton::StdSmcAddress> tail(addrs.begin() + max_accounts_per_query, addrs.end());
+    addrs.resize(max_accounts_per_query);
+    if (!get_account_states(workchain, std::move(tail), ref_blkid)) {
+      return false;
+    }
+  }
+  auto b = ton::serialize_tl_object(
+      ton::create_tl_object<ton::lite_api::liteServer_getAccountStates>(ton::create_tl_lite_block_id(ref_blkid),
+                                                                         workchain, std::vector<td::Bits256>(addrs)),
+      true);
+  LOG(INFO) << "requesting states of " << addrs.size() << " accounts of workchain " << workchain
+            << " with respect to " << ref_blkid.to_str();
+  return envelope_send_query(
+      std::move(b),
+      [Self = actor_id(this), workchain, addrs = std::move(addrs), ref_blkid](td::Result<td::BufferSlice> R) mutable {
+        if (R.is_error()) {
+          return;
+        }
+        auto F = ton::fetch_tl_object<ton::lite_api::liteServer_accountStates>(R.move_as_ok(), true);
+        if (F.is_error()) {
+          LOG(ERROR) << "cannot parse answer to liteServer.getAccountStates";
+        } else {
+          auto f = F.move_as_ok();
+          td::actor::send_closure_later(Self, &TestNode::got_account_states, ref_blkid, ton::create_block_id(f->id_),
+                                        ton::create_block_id(f->shardblk_), std::move(f->shard_proof_),
+                                        std::move(f->proof_), std::move(f->states_), workchain, std::move(addrs));
+        }
+      });
+}
+
+void TestNode::got_account_states(ton::BlockIdExt ref_blk, ton::BlockIdExt blk, ton::BlockIdExt shard_blk,
+                                  td::BufferSlice shard_proof, td::BufferSlice proof,
+                                  std::vector<td::BufferSlice> states, ton::WorkchainId workchain,
+                                  std::vector<ton::StdSmcAddress> addrs) {
+  LOG(INFO) << "got " << states.size() << " account states with respect to blocks " << blk.to_str()
+            << (shard_blk == blk ? "" : std::string{" and "} + shard_blk.to_str());
+  block::AccountStates account_states;
+  account_states.blk = blk;
+  account_states.shard_blk = shard_blk;
+  account_states.shard_proof = std::move(shard_proof);
+  account_states.proof = std::move(proof);
+  account_states.states = std::move(states);
+  auto r_infos = account_states.validate(ref_blk, workchain, addrs);
+  if (r_infos.is_error()) {
+    LOG(ERROR) << r_infos.error().message();
+    return;
+  }
+  auto infos = r_infos.move_as_ok();
+  auto out = td::TerminalIO::out();
+  std::vector<ton::StdSmcAddress> rest;
+  auto it = infos.begin();
+  for (const auto& addr : addrs) {
+    if (!ton::shard_contains(shard_blk.shard_full(), ton::extract_addr_prefix(workchain, addr))) {
+      rest.push_back(addr);
+      continue;
+    }
+    const auto& info = *it++;
+    out << workchain << ":" << addr.to_hex() << " : ";
+    if (info.root.is_null()) {
+      out << "account state is empty" << std::endl;
+      continue;
+    }
+    block::gen::Account::Record_account acc;
+    block::gen::AccountStorage::Record store;
+    block::CurrencyCollection balance;
+    if (tlb::unpack_cell(info.root, acc) && tlb::csr_unpack(acc.storage, store) && balance.unpack(store.balance)) {
+      out << "balance " << balance.to_str();
+    } else {
+      out << "cannot unpack account state";
+    }
+    out << ", last transaction lt = " << info.last_trans_lt << " hash = " << info.last_trans_hash.to_hex()
+        << std::endl;
+  }
+  if (!rest.empty()) {
+    // the remaining accounts belong to other shards
+    get_account_states(workchain, std::move(rest), ref_blk);
+  }
+}
+
 td::int64 TestNode::compute_method_id(std::string method) {
   td::int64 method_id;
   if (!convert_int64(method, method_id)) {
@@ -198,6 +198,11 @@ class TestNode : public td::actor::Actor {
   void got_account_state(ton::BlockIdExt ref_blk, ton::BlockIdExt blk, ton::BlockIdExt shard_blk,
                          td::BufferSlice shard_proof, td::BufferSlice proof, td::BufferSlice state,
                          ton::WorkchainId workchain, ton::StdSmcAddress addr, std::string filename, int mode);
+  bool parse_get_account_states(ton::BlockIdExt ref_blkid);
+  bool get_account_states(ton::WorkchainId workchain, std::vector<ton::StdSmcAddress> addrs, ton::BlockIdExt ref_blkid);
+  void got_account_states(ton::BlockIdExt ref_blk, ton::BlockIdExt blk, ton::BlockIdExt shard_blk,
+                          td::BufferSlice shard_proof, td::BufferSlice proof, std::vector<td::BufferSlice> states,
+                          ton::WorkchainId workchain, std::vector<ton::StdSmcAddress> addrs);
   bool parse_run_method(ton::WorkchainId workchain, ton::StdSmcAddress addr, ton::BlockIdExt ref_blkid, int addr_ext,
                         std::string method_name, bool ext_mode);
   bool after_parse_run_method(ton::WorkchainId workchain, ton::StdSmcAddress addr, ton::BlockIdExt ref_blkid,
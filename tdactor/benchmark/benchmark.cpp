@@ -1637,6 +1637,220 @@ class YieldMany : public td::Benchmark {
   bool use_io_{false};
 };
 
+// burns cpu for roughly the same time on each call
+static td::uint32 do_cpu_work(int n) {
+  static const std::string data(1 << 12, 'a');
+  td::uint32 res = 0;
+  for (int i = 0; i < n; i++) {
+    res += td::crc32c(data);
+  }
+  return res;
+}
+
+// All tasks are created on the first scheduler, and each scheduler has one cpu thread.
+// Without work stealing all the work is done by a single thread.
+class SkewedSpawn : public td::Benchmark {
+ public:
+  SkewedSpawn(bool work_stealing) : work_stealing_(work_stealing) {
+  }
+  std::string get_description() const {
+    return PSTRING() << "Skewed spawn work_stealing(" << work_stealing_ << ")";
+  }
+
+  void run(int n) {
+    unsigned tasks_per_cpu = 4;
+    unsigned cpu_n = td::thread::hardware_concurrency();
+    class Task : public td::actor::Actor {
+     public:
+      explicit Task(int n, Sem *sem) : n_(n), sem_(sem) {
+      }
+      void loop() override {
+        sink_ += do_cpu_work(10);
+        if (n_ == 0) {
+          sem_->post();
+          stop();
+        } else {
+          n_--;
+          yield();
+        }
+      };
+
+     private:
+      int n_;
+      Sem *sem_;
+      td::uint32 sink_{0};
+    };
+    td::actor::Scheduler scheduler{std::vector<td::actor::Scheduler::NodeInfo>(cpu_n, 1)};
+    if (work_stealing_) {
+      scheduler.enable_work_stealing();
+    }
+    auto sch = td::thread([&] { scheduler.run(); });
+    unsigned tasks = tasks_per_cpu * cpu_n;
+    Sem sem;
+    scheduler.run_in_context_external([&] {
+      for (int i = 0; i < n; i++) {
+        for (unsigned j = 0; j < tasks; j++) {
+          auto options = td::actor::ActorOptions().with_name("Task").on_scheduler(td::actor::SchedulerId{0});
+          td::actor::create_actor<Task>(options, 10, &sem).release();
+        }
+        sem.wait(tasks);
+      }
+    });
+
+    scheduler.run_in_context_external([&] { td::actor::SchedulerContext::get()->stop(); });
+    sch.join();
+  }
+
+ private:
+  bool work_stealing_{false};
+};
+
+// An actor sends small closures to another actor in rounds, one by one or in batches
+class SendClosureMany : public td::Benchmark {
+ public:
+  explicit SendClosureMany(size_t batch_size) : batch_size_(batch_size) {
+  }
+  std::string get_description() const {
+    return PSTRING() << "Send closure batch_size(" << batch_size_ << ")";
+  }
+
+  void run(int n) {
+    constexpr int round_size = 1024;
+    class Receiver : public td::actor::Actor {
+     public:
+      Receiver(td::actor::ActorId<> sender, int n, Sem *sem) : sender_(sender), n_(n), sem_(sem) {
+      }
+      void on_query(int x) {
+        sum_ += x;
+        received_++;
+        if (received_ == n_) {
+          sem_->post();
+          stop();
+        } else if (received_ % round_size == 0) {
+          td::actor::send_signals(sender_, td::actor::ActorSignals::wakeup());
+        }
+      }
+
+     private:
+      td::actor::ActorId<> sender_;
+      int n_;
+      Sem *sem_;
+      int received_{0};
+      td::int64 sum_{0};
+    };
+    class Sender : public td::actor::Actor {
+     public:
+      Sender(int n, Sem *sem, size_t batch_size) : n_(n), sem_(sem), batch_size_(batch_size) {
+      }
+      void start_up() override {
+        receiver_ = td::actor::create_actor<Receiver>("Receiver", actor_id(this), n_, sem_).release();
+        loop();
+      }
+      void loop() override {
+        int end = td::min(sent_ + round_size, n_);
+        if (batch_size_ <= 1) {
+          for (; sent_ < end; sent_++) {
+            td::actor::send_closure(receiver_, &Receiver::on_query, sent_);
+          }
+        } else {
+          td::actor::ClosureBatch<Receiver> batch;
+          for (; sent_ < end; sent_++) {
+            batch.add(&Receiver::on_query, sent_);
+            if (batch.size() == batch_size_) {
+              td::actor::send_closure_batch(receiver_, std::move(batch));
+            }
+          }
+          td::actor::send_closure_batch(receiver_, std::move(batch));
+        }
+        if (sent_ == n_) {
+          stop();
+        }
+      }
+
+     private:
+      td::actor::ActorId<Receiver> receiver_;
+      int n_;
+      Sem *sem_;
+      size_t batch_size_;
+      int sent_{0};
+    };
+    td::actor::Scheduler scheduler{{2}};
+    auto sch = td::thread([&] { scheduler.run(); });
+    Sem sem;
+    scheduler.run_in_context_external(
+        [&] { td::actor::create_actor<Sender>("Sender", n, &sem, batch_size_).release(); });
+    sem.wait();
+
+    scheduler.run_in_context_external([&] { td::actor::SchedulerContext::get()->stop(); });
+    sch.join();
+  }
+
+ private:
+  size_t batch_size_;
+};
+
+// A busy actor sends a query and keeps working. The query is queued to the same cpu worker,
+// so without work stealing it waits until the busy actor finishes, even though other workers are idle.
+class BusyWorker : public td::Benchmark {
+ public:
+  BusyWorker(bool work_stealing) : work_stealing_(work_stealing) {
+  }
+  std::string get_description() const {
+    return PSTRING() << "Busy worker work_stealing(" << work_stealing_ << ")";
+  }
+
+  void run(int n) {
+    class Helper : public td::actor::Actor {
+     public:
+      explicit Helper(Sem *sem) : sem_(sem) {
+      }
+      void query() {
+        sink_ += do_cpu_work(100);
+        sem_->post();
+      }
+
+     private:
+      Sem *sem_;
+      td::uint32 sink_{0};
+    };
+    class Task : public td::actor::Actor {
+     public:
+      Task(td::actor::ActorId<Helper> helper, Sem *sem) : helper_(std::move(helper)), sem_(sem) {
+      }
+      void query() {
+        send_closure_later(helper_, &Helper::query);
+        sink_ += do_cpu_work(100);
+        sem_->post();
+      }
+
+     private:
+      td::actor::ActorId<Helper> helper_;
+      Sem *sem_;
+      td::uint32 sink_{0};
+    };
+    td::actor::Scheduler scheduler{{td::thread::hardware_concurrency()}};
+    if (work_stealing_) {
+      scheduler.enable_work_stealing();
+    }
+    auto sch = td::thread([&] { scheduler.run(); });
+    Sem sem;
+    scheduler.run_in_context_external([&] {
+      auto helper = td::actor::create_actor<Helper>("Helper", &sem);
+      auto task = td::actor::create_actor<Task>("Task", helper.get(), &sem);
+      for (int i = 0; i < n; i++) {
+        send_closure(task, &Task::query);
+        sem.wait(2);
+      }
+    });
+
+    scheduler.run_in_context_external([&] { td::actor::SchedulerContext::get()->stop(); });
+    sch.join();
+  }
+
+ private:
+  bool work_stealing_{false};
+};
+
 int main(int argc, char **argv) {
   if (argc > 1) {
     if (argv[1][0] == 'a') {
@@ -1652,6 +1866,12 @@ int main(int argc, char **argv) {
     }
     return 0;
   }
+  bench(SendClosureMany(1));
+  bench(SendClosureMany(64));
+  bench(SkewedSpawn(false));
+  bench(SkewedSpawn(true));
+  bench(BusyWorker(false));
+  bench(BusyWorker(true));
   bench(YieldMany(false));
   bench(YieldMany(true));
   bench(SpawnMany(false));
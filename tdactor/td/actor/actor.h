@@ -163,6 +163,39 @@ bool send_closure_later_bool(ActorIdT &&actor_id, FunctionT function, ArgsT &&..
   return true;
 }
 
+// Closures for one actor, which are put into its mailbox at once and run in order, as if sent with send_closure_later
+template <class ActorT>
+class ClosureBatch {
+ public:
+  template <class FunctionT, class... ArgsT, class FunctionClassT = member_function_class_t<FunctionT>>
+  void add(FunctionT function, ArgsT &&... args) {
+    static_assert(std::is_base_of<FunctionClassT, ActorT>::value, "unsafe send_closure");
+    batch_.add(detail::ActorMessageCreator::lambda(
+        [closure = create_delayed_closure(function, std::forward<ArgsT>(args)...)]() mutable {
+          closure.run(&detail::current_actor<FunctionClassT>());
+        }));
+  }
+  size_t size() const {
+    return batch_.size();
+  }
+  bool empty() const {
+    return batch_.empty();
+  }
+
+ private:
+  template <class ActorIdT, class ClosureActorT>
+  friend void send_closure_batch(ActorIdT &&actor_id, ClosureBatch<ClosureActorT> batch);
+
+  core::ActorMessageBatch batch_;
+};
+
+template <class ActorIdT, class ActorT>
+void send_closure_batch(ActorIdT &&actor_id, ClosureBatch<ActorT> batch) {
+  static_assert(std::is_base_of<ActorT, typename std::decay_t<ActorIdT>::ActorT>::value, "unsafe send_closure_batch");
+  ActorIdT id = std::forward<ActorIdT>(actor_id);
+  detail::send_message_batch(id.as_actor_ref(), std::move(batch.batch_));
+}
+
 template <class ActorIdT, class... ArgsT>
 void send_lambda(ActorIdT &&actor_id, ArgsT &&... args) {
   ActorIdT id = std::forward<ActorIdT>(actor_id);
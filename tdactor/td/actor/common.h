@@ -64,6 +64,8 @@ using core::Actor;
 using core::SchedulerContext;
 using core::SchedulerId;
 using core::set_debug;
+using core::need_actor_stats;
+using core::set_actor_stats;
 
 struct Debug {
  public:
@@ -90,6 +92,13 @@ struct Debug {
     });
   }
 
+  // per actor name counters, collected if set_actor_stats(true) was called
+  void dump_actor_stats() {
+    for (auto &stat : core::ActorTypeStat::get_snapshots()) {
+      LOG(ERROR) << stat;
+    }
+  }
+
  private:
   std::shared_ptr<core::SchedulerGroupInfo> group_info_;
 };
@@ -145,6 +154,14 @@ class Scheduler {
     return Debug{group_info_};
   }
 
+  // Lets idle cpu workers run actors of other schedulers and actors waiting behind a busy worker.
+  // Actors created with ActorOptions().with_affinity() are run only by workers of their own scheduler.
+  // Must be called before start.
+  void enable_work_stealing() {
+    CHECK(!is_started_);
+    group_info_->work_stealing = true;
+  }
+
   bool run() {
     start();
     while (schedulers_[0]->run(10)) {
@@ -233,8 +250,6 @@ class ActorMessageCreator {
   static auto hangup_shared() {
     return core::ActorMessage(std::make_unique<core::ActorMessageHangupShared>());
   }
-
-  // Use faster allocation?
 };
 struct ActorRef {
   ActorRef(core::ActorInfo &actor_info, uint64 link_token = core::EmptyLinkToken)
@@ -285,6 +300,21 @@ inline void send_message_later(ActorRef actor_ref, core::ActorMessage message) {
   send_message_later(actor_ref.actor_info, std::move(message));
 }
 
+inline void send_message_batch(ActorRef actor_ref, core::ActorMessageBatch batch) {
+  auto scheduler_context_ptr = core::SchedulerContext::get();
+  if (scheduler_context_ptr == nullptr) {
+    //LOG(ERROR) << "send to actor is silently ignored";
+    return;
+  }
+  if (actor_ref.link_token != core::EmptyLinkToken) {
+    batch.set_link_token(actor_ref.link_token);
+  }
+  auto &scheduler_context = *scheduler_context_ptr;
+  core::ActorExecutor executor(actor_ref.actor_info, scheduler_context,
+                               core::ActorExecutor::Options().with_has_poll(scheduler_context.has_poll()));
+  executor.send(std::move(batch));
+}
+
 template <class ExecuteF, class ToMessageF>
 void send_immediate(ActorRef actor_ref, ExecuteF &&execute, ToMessageF &&to_message) {
   auto scheduler_context_ptr = core::SchedulerContext::get();
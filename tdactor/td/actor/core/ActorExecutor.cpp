@@ -18,22 +18,32 @@
 */
 #include "td/actor/core/ActorExecutor.h"
 
+#include "td/utils/port/thread_local.h"
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/Time.h"
 
 namespace td {
 namespace actor {
 namespace core {
+namespace {
+// the innermost executor measuring execution time in this thread
+TD_THREAD_LOCAL ActorExecutor *measuring_executor;
+}  // namespace
+
 void ActorExecutor::send_immediate(ActorMessage message) {
   CHECK(can_send_immediate());
   if (is_closed()) {
     return;
   }
   if (message.is_big()) {
-    actor_info_.mailbox().reader().delay(std::move(message));
+    push_to_mailbox(std::move(message), true);
     pending_signals_.add_signal(ActorSignals::Message);
     actor_execute_context_.set_pause();
     return;
   }
+  if (stat_) {
+    stat_->on_message();
+  }
   actor_execute_context_.set_link_token(message.get_link_token());
   message.run();
 }
@@ -59,8 +69,23 @@ void ActorExecutor::send(ActorMessage message) {
     return send_immediate(std::move(message));
   }
   //LOG(ERROR) << "AE::send delayed";
-  actor_info_.mailbox().push(std::move(message));
+  push_to_mailbox(std::move(message), false);
+  pending_signals_.add_signal(ActorSignals::Message);
+}
+
+void ActorExecutor::send(ActorMessageBatch batch) {
+  if (is_closed() || batch.empty()) {
+    return;
+  }
+  // the whole batch is delivered like a message sent with send_message_later
+  if (batch.stamped_size_ != 0) {
+    actor_info_.inc_mailbox_size(batch.stamped_size_);
+  }
+  actor_info_.mailbox().push(batch.list_);
   pending_signals_.add_signal(ActorSignals::Message);
+  if (can_send_immediate()) {
+    actor_execute_context_.set_pause();
+  }
 }
 
 void ActorExecutor::send(ActorSignals signals) {
@@ -112,6 +137,10 @@ void ActorExecutor::start() noexcept {
     return;
   }
 
+  if (need_actor_stats()) {
+    start_stat();
+  }
+
   actor_execute_context_.set_actor(&actor_info_.actor());
 
   while (flush_one_signal(signals)) {
@@ -128,6 +157,9 @@ void ActorExecutor::start() noexcept {
 
 void ActorExecutor::finish() noexcept {
   //LOG(ERROR) << "FINISH " << actor_info_.get_name() << " " << tag("own_lock", actor_locker_.own_lock());
+  if (stat_) {
+    finish_stat();
+  }
   if (!actor_locker_.own_lock()) {
     if (!pending_signals_.empty() && actor_locker_.add_signals(pending_signals_)) {
       flags_ = actor_locker_.flags();
@@ -244,11 +276,55 @@ bool ActorExecutor::flush_one_message() {
     return false;
   }
 
+  on_message(message);
   actor_execute_context_.set_link_token(message.get_link_token());
   message.run();
   return true;
 }
 
+void ActorExecutor::start_stat() {
+  stat_ = actor_info_.get_stat();
+  outer_executor_ = measuring_executor;
+  measuring_executor = this;
+  started_at_ = Time::now();
+}
+
+void ActorExecutor::finish_stat() {
+  auto execution_time = Time::now() - started_at_;
+  stat_->on_execution(execution_time - nested_execution_time_);
+  stat_ = nullptr;
+  measuring_executor = outer_executor_;
+  if (outer_executor_) {
+    outer_executor_->nested_execution_time_ += execution_time;
+  }
+}
+
+void ActorExecutor::push_to_mailbox(ActorMessage message, bool delay) {
+  if (need_actor_stats()) {
+    message.set_enqueued_at(Time::now());
+    actor_info_.inc_mailbox_size();
+  }
+  if (delay) {
+    actor_info_.mailbox().reader().delay(std::move(message));
+  } else {
+    actor_info_.mailbox().push(std::move(message));
+  }
+}
+
+void ActorExecutor::on_message(const ActorMessage &message) {
+  auto enqueued_at = message.get_enqueued_at();
+  if (enqueued_at != 0) {
+    // the message is counted in mailbox size even if actor stats were disabled since
+    auto mailbox_size = actor_info_.dec_mailbox_size();
+    if (stat_) {
+      stat_->on_queued_message(Time::now() - enqueued_at, mailbox_size);
+    }
+  }
+  if (stat_) {
+    stat_->on_message();
+  }
+}
+
 void ActorExecutor::flush_context_flags() {
   if (actor_execute_context_.get_stop()) {
     if (actor_info_.get_alarm_timestamp()) {
@@ -24,6 +24,7 @@
 #include "td/actor/core/ActorMessage.h"
 #include "td/actor/core/ActorSignals.h"
 #include "td/actor/core/ActorState.h"
+#include "td/actor/core/ActorTypeStat.h"
 #include "td/actor/core/SchedulerContext.h"
 
 #include "td/utils/format.h"
@@ -46,10 +47,16 @@ class ActorExecutor {
       this->signals = signals;
       return *this;
     }
+    // execute actor on behalf of another scheduler, e.g. after stealing it from its queue
+    Options &with_scheduler_id(SchedulerId new_scheduler_id) {
+      this->scheduler_id = new_scheduler_id;
+      return *this;
+    }
 
     bool from_queue{false};
     bool has_poll{false};
     ActorSignals signals;
+    SchedulerId scheduler_id;
   };
 
   ActorExecutor(ActorInfo &actor_info, SchedulerDispatcher &dispatcher, Options options)
@@ -82,6 +89,9 @@ class ActorExecutor {
     if (is_closed()) {
       return;
     }
+    if (stat_) {
+      stat_->on_message();
+    }
     actor_execute_context_.set_link_token(link_token);
     f();
   }
@@ -89,6 +99,7 @@ class ActorExecutor {
   void send_immediate(ActorMessage message);
   void send_immediate(ActorSignals signals);
   void send(ActorMessage message);
+  void send(ActorMessageBatch batch);
   void send(ActorSignals signals);
 
  private:
@@ -98,7 +109,9 @@ class ActorExecutor {
   ActorLocker actor_locker_{&actor_info_.state(), ActorLocker::Options()
                                                       .with_can_execute_paused(options_.from_queue)
                                                       .with_is_shared(!options_.has_poll)
-                                                      .with_scheduler_id(dispatcher_.get_scheduler_id())};
+                                                      .with_scheduler_id(options_.scheduler_id.is_valid()
+                                                                             ? options_.scheduler_id
+                                                                             : dispatcher_.get_scheduler_id())};
 
   ActorExecuteContext actor_execute_context_{nullptr, actor_info_.get_alarm_timestamp()};
   ActorExecuteContext::Guard guard{&actor_execute_context_};
@@ -108,6 +121,17 @@ class ActorExecutor {
 
   const char *old_log_tag_;
 
+  // actor stats, used only if stat_ != nullptr
+  ActorTypeStat *stat_{nullptr};
+  double started_at_{0};
+  double nested_execution_time_{0};
+  ActorExecutor *outer_executor_{nullptr};
+
+  void start_stat();
+  void finish_stat();
+  void push_to_mailbox(ActorMessage message, bool delay);
+  void on_message(const ActorMessage &message);
+
   ActorState::Flags &flags() {
     return flags_;
   }
@@ -20,6 +20,7 @@
 
 #include "td/actor/core/ActorState.h"
 #include "td/actor/core/ActorMailbox.h"
+#include "td/actor/core/ActorTypeStat.h"
 
 #include "td/utils/Heap.h"
 #include "td/utils/List.h"
@@ -71,6 +72,21 @@ class ActorInfo : private HeapNode, private ListNode {
     return name_;
   }
 
+  // may be called only by the thread executing the actor
+  ActorTypeStat *get_stat() {
+    if (stat_ == nullptr) {
+      stat_ = ActorTypeStat::get(name_);
+    }
+    return stat_;
+  }
+  // number of messages in the mailbox, which were put there while actor stats were enabled
+  void inc_mailbox_size(uint32 count = 1) {
+    mailbox_size_.fetch_add(count, std::memory_order_relaxed);
+  }
+  uint32 dec_mailbox_size() {
+    return mailbox_size_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
   HeapNode *as_heap_node() {
     return this;
   }
@@ -101,6 +117,8 @@ class ActorInfo : private HeapNode, private ListNode {
   ActorMailbox mailbox_;
   std::string name_;
   std::atomic<double> alarm_timestamp_at_{0};
+  ActorTypeStat *stat_{nullptr};
+  std::atomic<uint32> mailbox_size_{0};
 
   ActorInfoPtr pin_;
 };
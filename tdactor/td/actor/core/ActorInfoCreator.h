@@ -45,12 +45,18 @@ class ActorInfoCreator {
       is_shared = !has_poll;
       return *this;
     }
+    // forbids workers of other schedulers to steal the actor
+    Options &with_affinity(bool new_has_affinity = true) {
+      has_affinity = new_has_affinity;
+      return *this;
+    }
 
    private:
     friend class ActorInfoCreator;
     Slice name;
     SchedulerId scheduler_id;
     bool is_shared{true};
+    bool has_affinity{false};
     bool in_queue{true};
     //TODO: rename
   };
@@ -62,6 +68,7 @@ class ActorInfoCreator {
     if (allow_shared_) {
       flags.set_shared(args.is_shared);
     }
+    flags.set_affinity(args.has_affinity);
     flags.set_in_queue(args.in_queue);
     flags.set_signals(ActorSignals::one(ActorSignals::StartUp));
 
@@ -37,6 +37,9 @@ class ActorMailbox {
   void push(ActorMessage message) {
     queue_.push(std::move(message));
   }
+  void push(td::MpscLinkQueue<ActorMessage>::List &list) {
+    queue_.push(list);
+  }
   void push_unsafe(ActorMessage message) {
     queue_.push_unsafe(std::move(message));
   }
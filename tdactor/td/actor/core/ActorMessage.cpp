@@ -0,0 +1,178 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/actor/core/ActorMessage.h"
+
+#include "td/utils/port/thread_local.h"
+
+#include <array>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace td {
+namespace actor {
+namespace core {
+namespace {
+constexpr size_t SIZE_STEP = 16;
+constexpr size_t MAX_POOLED_SIZE = 256;
+constexpr size_t SIZE_CLASS_COUNT = MAX_POOLED_SIZE / SIZE_STEP;
+// number of free blocks moved between a thread cache and the depot at once
+constexpr size_t BATCH_SIZE = 64;
+constexpr size_t MAX_DEPOT_BATCHES = 64;
+
+size_t get_size_class(size_t size) {
+  return size == 0 ? 0 : (size - 1) / SIZE_STEP;
+}
+
+size_t get_class_size(size_t size_class) {
+  return (size_class + 1) * SIZE_STEP;
+}
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+struct FreeList {
+  FreeBlock *head{nullptr};
+  size_t size{0};
+
+  void push(void *ptr) {
+    auto block = static_cast<FreeBlock *>(ptr);
+    block->next = head;
+    head = block;
+    size++;
+  }
+  void *pop() {
+    auto block = head;
+    head = block->next;
+    size--;
+    return block;
+  }
+  void free_all() {
+    while (size != 0) {
+      ::operator delete(pop());
+    }
+  }
+};
+
+class MessageDepot {
+ public:
+  bool put(size_t size_class, FreeList &batch) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto &batches = batches_[size_class];
+    if (batches.size() >= MAX_DEPOT_BATCHES) {
+      return false;
+    }
+    batches.push_back(batch);
+    batch = FreeList();
+    return true;
+  }
+  bool take(size_t size_class, FreeList &to) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto &batches = batches_[size_class];
+    if (batches.empty()) {
+      return false;
+    }
+    to = batches.back();
+    batches.pop_back();
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::array<std::vector<FreeList>, SIZE_CLASS_COUNT> batches_;
+};
+
+MessageDepot &get_depot() {
+  // never destroyed, messages may be freed by other threads during exit
+  static auto *depot = new MessageDepot();
+  return *depot;
+}
+
+class MessageCache {
+ public:
+  MessageCache() = default;
+  MessageCache(const MessageCache &) = delete;
+  MessageCache &operator=(const MessageCache &) = delete;
+  ~MessageCache() {
+    for (size_t size_class = 0; size_class < SIZE_CLASS_COUNT; size_class++) {
+      auto &list = lists_[size_class];
+      while (list.size >= BATCH_SIZE) {
+        move_batch_to_depot(size_class);
+      }
+      list.free_all();
+    }
+  }
+
+  void *alloc(size_t size_class) {
+    auto &list = lists_[size_class];
+    if (list.size == 0 && !get_depot().take(size_class, list)) {
+      return ::operator new(get_class_size(size_class));
+    }
+    return list.pop();
+  }
+
+  void free(void *ptr, size_t size_class) {
+    auto &list = lists_[size_class];
+    list.push(ptr);
+    if (list.size >= 2 * BATCH_SIZE) {
+      move_batch_to_depot(size_class);
+    }
+  }
+
+ private:
+  std::array<FreeList, SIZE_CLASS_COUNT> lists_;
+
+  void move_batch_to_depot(size_t size_class) {
+    auto &list = lists_[size_class];
+    FreeList batch;
+    for (size_t i = 0; i < BATCH_SIZE; i++) {
+      batch.push(list.pop());
+    }
+    if (!get_depot().put(size_class, batch)) {
+      batch.free_all();
+    }
+  }
+};
+
+TD_THREAD_LOCAL MessageCache *message_cache;
+}  // namespace
+
+void *ActorMessageImpl::operator new(size_t size) {
+  if (size > MAX_POOLED_SIZE) {
+    return ::operator new(size);
+  }
+  init_thread_local<MessageCache>(message_cache);
+  return message_cache->alloc(get_size_class(size));
+}
+
+void ActorMessageImpl::operator delete(void *ptr, size_t size) {
+  if (ptr == nullptr) {
+    return;
+  }
+  if (size > MAX_POOLED_SIZE || message_cache == nullptr) {
+    // pooled blocks are allocated by ::operator new too, so they can be freed directly
+    ::operator delete(ptr);
+    return;
+  }
+  message_cache->free(ptr, get_size_class(size));
+}
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -19,8 +19,10 @@
 #pragma once
 
 #include "td/actor/core/ActorExecuteContext.h"
+#include "td/actor/core/ActorTypeStat.h"
 
 #include "td/utils/MpscLinkQueue.h"
+#include "td/utils/Time.h"
 
 namespace td {
 namespace actor {
@@ -36,6 +38,11 @@ class ActorMessageImpl : private MpscLinkQueueImpl::Node {
   virtual ~ActorMessageImpl() = default;
   virtual void run() = 0;
 
+  // Messages are small and short-lived, so they are taken from per-thread free lists.
+  // A message is usually freed by another thread, so free lists are rebalanced through a global depot
+  static void *operator new(size_t size);
+  static void operator delete(void *ptr, size_t size);
+
  private:
   friend class ActorMessage;
 
@@ -50,6 +57,8 @@ class ActorMessageImpl : private MpscLinkQueueImpl::Node {
 
   uint64 link_token_{EmptyLinkToken};
   bool is_big_{false};
+  // set only if actor stats are enabled
+  double enqueued_at_{0};
 };
 
 class ActorMessage {
@@ -78,6 +87,12 @@ class ActorMessage {
   void set_big() {
     impl_->is_big_ = true;
   }
+  double get_enqueued_at() const {
+    return impl_->enqueued_at_;
+  }
+  void set_enqueued_at(double enqueued_at) {
+    impl_->enqueued_at_ = enqueued_at;
+  }
 
  private:
   std::unique_ptr<ActorMessageImpl> impl_;
@@ -92,6 +107,46 @@ class ActorMessage {
     return impl_.release()->to_mpsc_link_queue_node();
   }
 };
+
+// Messages for one actor, which are put into its mailbox with a single atomic operation
+class ActorMessageBatch {
+ public:
+  ActorMessageBatch() = default;
+  ActorMessageBatch(ActorMessageBatch &&other) : list_(std::move(other.list_)), stamped_size_(other.stamped_size_) {
+    other.stamped_size_ = 0;
+  }
+  ActorMessageBatch &operator=(ActorMessageBatch &&other) {
+    if (this != &other) {
+      list_ = std::move(other.list_);
+      stamped_size_ = other.stamped_size_;
+      other.stamped_size_ = 0;
+    }
+    return *this;
+  }
+
+  void add(ActorMessage message) {
+    if (need_actor_stats()) {
+      message.set_enqueued_at(Time::now());
+      stamped_size_++;
+    }
+    list_.push_back(std::move(message));
+  }
+  void set_link_token(uint64 link_token) {
+    list_.for_each([link_token](ActorMessage &message) { message.set_link_token(link_token); });
+  }
+  size_t size() const {
+    return list_.size();
+  }
+  bool empty() const {
+    return list_.empty();
+  }
+
+ private:
+  friend class ActorExecutor;
+
+  MpscLinkQueue<ActorMessage>::List list_;
+  uint32 stamped_size_{0};
+};
 }  // namespace core
 }  // namespace actor
 }  // namespace td
@@ -54,6 +54,13 @@ class ActorState {
       set_flag(SharedFlag, shared);
     }
 
+    bool has_affinity() const {
+      return check_flag(AffinityFlag);
+    }
+    void set_affinity(bool affinity) {
+      set_flag(AffinityFlag, affinity);
+    }
+
     bool is_locked() const {
       return check_flag(LockFlag);
     }
@@ -99,8 +106,9 @@ class ActorState {
     }
     friend StringBuilder &operator<<(StringBuilder &sb, Flags flags) {
       sb << "ActorFlags{" << flags.get_scheduler_id().value() << ", " << (flags.is_shared() ? "cpu " : "io ")
-         << (flags.is_migrate() ? "migrate " : "") << (flags.is_closed() ? "closed " : "")
-         << (flags.is_in_queue() ? "in_queue " : "") << flags.get_signals() << "}";
+         << (flags.has_affinity() ? "affinity " : "") << (flags.is_migrate() ? "migrate " : "")
+         << (flags.is_closed() ? "closed " : "") << (flags.is_in_queue() ? "in_queue " : "") << flags.get_signals()
+         << "}";
 
       return sb;
     }
@@ -133,6 +141,10 @@ class ActorState {
   enum : uint32 {
     SchedulerMask = 255,
 
+    // Actor must be executed only by workers of its own scheduler, even if work stealing is enabled
+    // This flag may NOT change during the lifetime of an actor
+    AffinityFlag = 1 << 8,
+
     // Actors can be shared or not.
     // If actor is shared, than any thread may try to lock it
     // If actor is not shared, than it is owned by its scheduler, and only
@@ -0,0 +1,156 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/actor/core/ActorTypeStat.h"
+
+#include "td/utils/format.h"
+#include "td/utils/misc.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace td {
+namespace actor {
+namespace core {
+namespace {
+std::atomic<bool> actor_stats;
+
+uint64 to_ns(double seconds) {
+  return seconds > 0 ? static_cast<uint64>(seconds * 1e9) : 0;
+}
+
+double from_ns(uint64 ns) {
+  return static_cast<double>(ns) * 1e-9;
+}
+
+void update_max(std::atomic<uint64> &max, uint64 value) {
+  auto old_value = max.load(std::memory_order_relaxed);
+  while (old_value < value && !max.compare_exchange_weak(old_value, value, std::memory_order_relaxed)) {
+  }
+}
+
+// Names often contain ids, e.g. "downloadstatereq(-1,8000000000000000,123)".
+// Only the leading word is used, so that such actors share counters.
+Slice get_type_name(Slice name) {
+  size_t i = 0;
+  while (i < name.size() && (is_alnum(name[i]) || name[i] == '_' || name[i] == '.')) {
+    i++;
+  }
+  if (i == 0) {
+    i = name.size();
+  }
+  return name.substr(0, td::min(i, static_cast<size_t>(64)));
+}
+
+struct Registry {
+  std::mutex mutex;
+  std::map<std::string, std::unique_ptr<ActorTypeStat>, std::less<>> stats;
+};
+
+Registry &get_registry() {
+  // never destroyed, because actors may still be running during static destruction
+  static auto *registry = new Registry();
+  return *registry;
+}
+}  // namespace
+
+void set_actor_stats(bool flag) {
+  actor_stats = flag;
+}
+
+bool need_actor_stats() {
+  return actor_stats.load(std::memory_order_relaxed);
+}
+
+void ActorTypeStat::on_execution(double execution_time) {
+  auto ns = to_ns(execution_time);
+  executions_.fetch_add(1, std::memory_order_relaxed);
+  execution_time_ns_.fetch_add(ns, std::memory_order_relaxed);
+  update_max(max_execution_time_ns_, ns);
+}
+
+void ActorTypeStat::on_message() {
+  messages_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ActorTypeStat::on_queued_message(double delay, uint64 mailbox_size) {
+  auto ns = to_ns(delay);
+  queued_messages_.fetch_add(1, std::memory_order_relaxed);
+  delay_ns_.fetch_add(ns, std::memory_order_relaxed);
+  update_max(max_delay_ns_, ns);
+  mailbox_size_sum_.fetch_add(mailbox_size, std::memory_order_relaxed);
+  update_max(max_mailbox_size_, mailbox_size);
+}
+
+ActorTypeStat::Snapshot ActorTypeStat::get_snapshot() const {
+  Snapshot res;
+  res.name = name_;
+  res.executions = executions_.load(std::memory_order_relaxed);
+  res.messages = messages_.load(std::memory_order_relaxed);
+  res.execution_time = from_ns(execution_time_ns_.load(std::memory_order_relaxed));
+  res.max_execution_time = from_ns(max_execution_time_ns_.load(std::memory_order_relaxed));
+  res.queued_messages = queued_messages_.load(std::memory_order_relaxed);
+  res.max_delay = from_ns(max_delay_ns_.load(std::memory_order_relaxed));
+  res.max_mailbox_size = max_mailbox_size_.load(std::memory_order_relaxed);
+  if (res.queued_messages != 0) {
+    res.mean_delay = from_ns(delay_ns_.load(std::memory_order_relaxed)) / static_cast<double>(res.queued_messages);
+    res.mean_mailbox_size = static_cast<double>(mailbox_size_sum_.load(std::memory_order_relaxed)) /
+                            static_cast<double>(res.queued_messages);
+  }
+  return res;
+}
+
+StringBuilder &operator<<(StringBuilder &sb, const ActorTypeStat::Snapshot &snapshot) {
+  return sb << snapshot.name << " executions:" << snapshot.executions << " messages:" << snapshot.messages
+            << " time:" << format::as_time(snapshot.execution_time)
+            << " max_time:" << format::as_time(snapshot.max_execution_time)
+            << " queued:" << snapshot.queued_messages << " mean_delay:" << format::as_time(snapshot.mean_delay)
+            << " max_delay:" << format::as_time(snapshot.max_delay) << " mean_mailbox:" << snapshot.mean_mailbox_size
+            << " max_mailbox:" << snapshot.max_mailbox_size;
+}
+
+ActorTypeStat *ActorTypeStat::get(Slice name) {
+  auto type_name = get_type_name(name);
+  auto &registry = get_registry();
+  std::lock_guard<std::mutex> guard(registry.mutex);
+  auto it = registry.stats.find(type_name);
+  if (it == registry.stats.end()) {
+    auto stat = std::unique_ptr<ActorTypeStat>(new ActorTypeStat(type_name.str()));
+    it = registry.stats.emplace(type_name.str(), std::move(stat)).first;
+  }
+  return it->second.get();
+}
+
+std::vector<ActorTypeStat::Snapshot> ActorTypeStat::get_snapshots() {
+  std::vector<Snapshot> res;
+  {
+    auto &registry = get_registry();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    for (auto &it : registry.stats) {
+      res.push_back(it.second->get_snapshot());
+    }
+  }
+  std::sort(res.begin(), res.end(),
+            [](const Snapshot &a, const Snapshot &b) { return a.execution_time > b.execution_time; });
+  return res;
+}
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -0,0 +1,84 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/StringBuilder.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace td {
+namespace actor {
+namespace core {
+void set_actor_stats(bool flag);
+bool need_actor_stats();
+
+// Counters of all actors with the same name. Updated only while actor stats are enabled.
+class ActorTypeStat {
+ public:
+  struct Snapshot {
+    std::string name;
+    uint64 executions{0};
+    uint64 messages{0};
+    // time spent by worker threads executing the actors, nested executions excluded
+    double execution_time{0};
+    double max_execution_time{0};
+    // delay between putting a message into a mailbox and running it
+    uint64 queued_messages{0};
+    double mean_delay{0};
+    double max_delay{0};
+    // mailbox size (including the message) when a queued message is run
+    double mean_mailbox_size{0};
+    uint64 max_mailbox_size{0};
+
+    friend StringBuilder &operator<<(StringBuilder &sb, const Snapshot &snapshot);
+  };
+
+  void on_execution(double execution_time);
+  void on_message();
+  void on_queued_message(double delay, uint64 mailbox_size);
+
+  Snapshot get_snapshot() const;
+
+  // returns counters for the name, they are never destroyed
+  static ActorTypeStat *get(Slice name);
+  // sorted by execution time
+  static std::vector<Snapshot> get_snapshots();
+
+ private:
+  std::string name_;
+  std::atomic<uint64> executions_{0};
+  std::atomic<uint64> messages_{0};
+  std::atomic<uint64> execution_time_ns_{0};
+  std::atomic<uint64> max_execution_time_ns_{0};
+  std::atomic<uint64> queued_messages_{0};
+  std::atomic<uint64> delay_ns_{0};
+  std::atomic<uint64> max_delay_ns_{0};
+  std::atomic<uint64> mailbox_size_sum_{0};
+  std::atomic<uint64> max_mailbox_size_{0};
+
+  explicit ActorTypeStat(std::string name) : name_(std::move(name)) {
+  }
+};
+}  // namespace core
+}  // namespace actor
+}  // namespace td
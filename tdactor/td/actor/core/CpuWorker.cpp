@@ -41,7 +41,12 @@ void CpuWorker::run() {
         return;
       }
       auto lock = debug.start(message->get_name());
-      ActorExecutor executor(*message, dispatcher, ActorExecutor::Options().with_from_queue());
+      auto options = ActorExecutor::Options().with_from_queue();
+      if (scheduler_group_) {
+        // the actor may belong to another scheduler
+        options.with_scheduler_id(message->state().get_flags_unsafe().get_scheduler_id());
+      }
+      ActorExecutor executor(*message, dispatcher, options);
     } else {
       waiter_.wait(slot);
     }
@@ -59,7 +64,7 @@ bool CpuWorker::try_pop_local(SchedulerMessage &message) {
 
 bool CpuWorker::try_pop_global(SchedulerMessage &message, size_t thread_id) {
   SchedulerMessage::Raw *raw_message;
-  if (queue_.try_pop(raw_message, thread_id)) {
+  if ((affinity_queue_ && affinity_queue_->try_pop(raw_message, thread_id)) || queue_.try_pop(raw_message, thread_id)) {
     message = SchedulerMessage(SchedulerMessage::acquire_t{}, raw_message);
     return true;
   }
@@ -87,6 +92,36 @@ bool CpuWorker::try_pop(SchedulerMessage &message, size_t thread_id) {
     }
   }
 
+  if (scheduler_group_ && try_steal_from_group(message, thread_id)) {
+    return true;
+  }
+
+  return false;
+}
+
+bool CpuWorker::try_steal_from_group(SchedulerMessage &message, size_t thread_id) {
+  auto &schedulers = scheduler_group_->schedulers;
+  // idle workers start from different schedulers to not fight for the same queue
+  auto offset = id_ + steal_cnt_++;
+  for (size_t i = 0; i < schedulers.size(); i++) {
+    auto &info = schedulers[(i + offset) % schedulers.size()];
+    if (!info.cpu_queue || info.cpu_local_queue.data() == local_queues_.data()) {
+      continue;
+    }
+    // Actors with affinity are never put into these queues.
+    // A stop message is fine too: every cpu worker of the group exits after exactly one of them.
+    SchedulerMessage::Raw *raw_message;
+    if (info.cpu_queue->try_pop(raw_message, thread_id)) {
+      message = SchedulerMessage(SchedulerMessage::acquire_t{}, raw_message);
+      return true;
+    }
+    for (auto &local_queue : info.cpu_local_queue) {
+      if (local_queues_[id_].steal(raw_message, local_queue)) {
+        message = SchedulerMessage(SchedulerMessage::acquire_t{}, raw_message);
+        return true;
+      }
+    }
+  }
   return false;
 }
 
@@ -29,12 +29,24 @@ namespace actor {
 namespace core {
 template <class T>
 struct LocalQueue;
+struct SchedulerGroupInfo;
 class CpuWorker {
  public:
   CpuWorker(MpmcQueue<SchedulerMessage::Raw *> &queue, MpmcWaiter &waiter, size_t id,
             MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues)
       : queue_(queue), waiter_(waiter), id_(id), local_queues_(local_queues) {
   }
+  // steals actors without affinity from other schedulers of the group, when there is nothing to do
+  CpuWorker(MpmcQueue<SchedulerMessage::Raw *> &queue, MpmcWaiter &waiter, size_t id,
+            MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues,
+            MpmcQueue<SchedulerMessage::Raw *> &affinity_queue, SchedulerGroupInfo &scheduler_group)
+      : queue_(queue)
+      , waiter_(waiter)
+      , id_(id)
+      , local_queues_(local_queues)
+      , affinity_queue_(&affinity_queue)
+      , scheduler_group_(&scheduler_group) {
+  }
   void run();
 
  private:
@@ -42,12 +54,16 @@ class CpuWorker {
   MpmcWaiter &waiter_;
   size_t id_;
   MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues_;
+  MpmcQueue<SchedulerMessage::Raw *> *affinity_queue_{nullptr};
+  SchedulerGroupInfo *scheduler_group_{nullptr};
   size_t cnt_{0};
+  size_t steal_cnt_{0};
 
   bool try_pop(SchedulerMessage &message, size_t thread_id);
 
   bool try_pop_local(SchedulerMessage &message);
   bool try_pop_global(SchedulerMessage &message, size_t thread_id);
+  bool try_steal_from_group(SchedulerMessage &message, size_t thread_id);
 };
 }  // namespace core
 }  // namespace actor
@@ -45,6 +45,7 @@ Scheduler::Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, S
     info_->cpu_threads_count = cpu_threads_count;
     info_->cpu_queue = std::make_unique<MpmcQueue<SchedulerMessage::Raw *>>(1024, max_thread_count());
     info_->cpu_queue_waiter = std::make_unique<MpmcWaiter>();
+    info_->cpu_affinity_queue = std::make_unique<MpmcQueue<SchedulerMessage::Raw *>>(1024, max_thread_count());
 
     info_->cpu_local_queue = std::vector<LocalQueue<SchedulerMessage::Raw *>>(cpu_threads_count);
   }
@@ -79,7 +80,14 @@ void Scheduler::start() {
   for (size_t i = 0; i < cpu_threads_.size(); i++) {
     cpu_threads_[i] = td::thread([this, i] {
       this->run_in_context_impl(*this->info_->cpu_workers[i], [this, i] {
-        CpuWorker(*info_->cpu_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queue).run();
+        auto &group = *scheduler_group_info_;
+        if (group.work_stealing) {
+          CpuWorker(*info_->cpu_queue, group.get_cpu_queue_waiter(*info_), i, info_->cpu_local_queue,
+                    *info_->cpu_affinity_queue, group)
+              .run();
+        } else {
+          CpuWorker(*info_->cpu_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queue).run();
+        }
       });
     });
     cpu_threads_[i].set_name(PSLICE() << "#" << info_->id.value() << ":cpu#" << i);
@@ -157,23 +165,33 @@ void Scheduler::ContextImpl::add_to_queue(ActorInfoPtr actor_info_ptr, Scheduler
     scheduler_id = get_scheduler_id();
   }
   //LOG(ERROR) << "Add to queue: " << actor_info_ptr->get_name() << " " << scheduler_id.value();
-  auto &info = scheduler_group()->schedulers.at(scheduler_id.value());
+  auto &group = *scheduler_group();
+  auto &info = group.schedulers.at(scheduler_id.value());
   if (need_poll || !info.cpu_queue) {
     info.io_queue->writer_put(std::move(actor_info_ptr));
   } else {
+    auto &waiter = group.get_cpu_queue_waiter(info);
+    if (group.work_stealing && actor_info_ptr->state().get_flags_unsafe().has_affinity()) {
+      info.cpu_affinity_queue->push(actor_info_ptr.release(), get_thread_id());
+      waiter.notify();
+      return;
+    }
     if (scheduler_id == get_scheduler_id() && cpu_worker_id_.is_valid()) {
       // may push local
       CHECK(actor_info_ptr);
       auto raw = actor_info_ptr.release();
-      auto should_notify = info.cpu_local_queue[cpu_worker_id_.value()].push(
-          raw, [&](auto value) { info.cpu_queue->push(value, get_thread_id()); });
-      if (should_notify) {
-        info.cpu_queue_waiter->notify();
+      auto &local_queue = info.cpu_local_queue[cpu_worker_id_.value()];
+      auto overflow_f = [&](auto value) { info.cpu_queue->push(value, get_thread_id()); };
+      if (group.work_stealing) {
+        local_queue.push_stealable(raw, overflow_f);
+        waiter.notify();
+      } else if (local_queue.push(raw, overflow_f)) {
+        waiter.notify();
       }
       return;
     }
     info.cpu_queue->push(actor_info_ptr.release(), get_thread_id());
-    info.cpu_queue_waiter->notify();
+    waiter.notify();
   }
 }
 
@@ -206,7 +224,8 @@ void Scheduler::ContextImpl::set_alarm_timestamp(const ActorInfoPtr &actor_info_
   // 2. Update timeout only when it has increased
   // 3. Use signal-like logic to combile multiple timeout updates into one
   if (!has_heap()) {
-    add_to_queue(actor_info_ptr, {}, true);
+    // the actor may be executed by a worker of another scheduler, so use its own one
+    add_to_queue(actor_info_ptr, actor_info_ptr->state().get_flags_unsafe().get_scheduler_id(), true);
     return;
   }
   // we are in PollWorker
@@ -246,7 +265,7 @@ void Scheduler::ContextImpl::stop() {
     scheduler_info.io_queue->writer_put({});
     for (size_t i = 0; i < scheduler_info.cpu_threads_count; i++) {
       scheduler_info.cpu_queue->push({}, get_thread_id());
-      scheduler_info.cpu_queue_waiter->notify();
+      group.get_cpu_queue_waiter(scheduler_info).notify();
     }
   }
 }
@@ -303,8 +322,11 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
           queues_are_empty = false;
         }
       }
-      if (scheduler_info.cpu_queue) {
-        auto &cpu_queue = *scheduler_info.cpu_queue;
+      for (auto *queue : {scheduler_info.cpu_queue.get(), scheduler_info.cpu_affinity_queue.get()}) {
+        if (!queue) {
+          continue;
+        }
+        auto &cpu_queue = *queue;
         while (true) {
           SchedulerMessage::Raw *raw_message;
           if (!cpu_queue.try_pop(raw_message, get_thread_id())) {
@@ -326,6 +348,7 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
   for (auto &scheduler_info : group_info.schedulers) {
     scheduler_info.io_queue.reset();
     scheduler_info.cpu_queue.reset();
+    scheduler_info.cpu_affinity_queue.reset();
 
     // Do not destroy worker infos. run_in_context will crash if they are empty
     scheduler_info.io_worker->actor_info_creator.clear();
@@ -138,6 +138,14 @@ struct LocalQueue {
     }
     return false;
   }
+  // unlike push, doesn't keep the value in next_, which can't be stolen
+  template <class F>
+  void push_stealable(T value, F &&overflow_f) {
+    if (next_) {
+      queue_.local_push(next_.unwrap(), overflow_f);
+    }
+    queue_.local_push(value, overflow_f);
+  }
   bool try_pop(T &message) {
     if (!next_) {
       return queue_.local_pop(message);
@@ -164,6 +172,9 @@ struct SchedulerInfo {
   std::vector<LocalQueue<SchedulerMessage::Raw *>> cpu_local_queue;
   //std::vector<td::StealingQueue<SchedulerMessage>> cpu_stealing_queue;
 
+  // actors with affinity if work stealing is enabled, only workers of this scheduler read from it
+  std::unique_ptr<MpmcQueue<SchedulerMessage::Raw *>> cpu_affinity_queue;
+
   // only scheduler itself may read from io_queue_
   std::unique_ptr<MpscPollableQueue<SchedulerMessage>> io_queue;
   size_t cpu_threads_count{0};
@@ -177,6 +188,16 @@ struct SchedulerGroupInfo {
   }
   std::atomic<bool> is_stop_requested{false};
 
+  // Idle cpu workers execute actors of other schedulers of the group.
+  // Must not be changed after the schedulers are started.
+  bool work_stealing{false};
+  // all cpu workers of the group wait here if work stealing is enabled
+  MpmcWaiter cpu_queue_waiter;
+
+  MpmcWaiter &get_cpu_queue_waiter(SchedulerInfo &info) {
+    return work_stealing ? cpu_queue_waiter : *info.cpu_queue_waiter;
+  }
+
   int active_scheduler_count{0};
   std::mutex active_scheduler_count_mutex;
   std::condition_variable active_scheduler_count_condition_variable;
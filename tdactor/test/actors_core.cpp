@@ -22,6 +22,7 @@
 
 #include "td/utils/format.h"
 #include "td/utils/logging.h"
+#include "td/utils/port/sleep.h"
 #include "td/utils/port/thread.h"
 #include "td/utils/Random.h"
 #include "td/utils/Slice.h"
@@ -852,6 +853,136 @@ TEST(Actor2, SchedulerTwo) {
   });
   scheduler.run();
 }
+TEST(Actor2, SchedulerWorkStealing) {
+  // scheduler 0 has a single worker, which is kept busy until the other scheduler steals something
+  Scheduler scheduler({1, 2, 0});
+  scheduler.enable_work_stealing();
+  std::atomic<int> stolen{0};
+  scheduler.run_in_context([&stolen] {
+    class Worker : public Actor {
+     public:
+      Worker(int n, std::shared_ptr<td::Destructor> watcher, std::atomic<int> *stolen)
+          : n_(n), watcher_(std::move(watcher)), stolen_(stolen) {
+      }
+      void loop() override {
+        auto scheduler_id = SchedulerContext::get()->get_scheduler_id();
+        if (get_actor_info_ptr()->state().get_flags_unsafe().has_affinity()) {
+          CHECK(scheduler_id == SchedulerId{0});
+        } else if (!(scheduler_id == SchedulerId{0})) {
+          (*stolen_)++;
+        } else {
+          auto deadline = td::Timestamp::in(10);
+          while (stolen_->load() == 0) {
+            CHECK(!deadline.is_in_past());
+            td::usleep_for(100);
+          }
+        }
+        if (n_-- == 0) {
+          stop();
+        } else {
+          yield();
+        }
+      }
+
+     private:
+      int n_;
+      std::shared_ptr<td::Destructor> watcher_;
+      std::atomic<int> *stolen_;
+    };
+    auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+    for (int i = 0; i < 100; i++) {
+      auto options = ActorOptions().with_name("Worker").on_scheduler(SchedulerId{0}).with_affinity(i % 2 == 0);
+      create_actor<Worker>(options, 100, watcher, &stolen).release();
+    }
+  });
+  scheduler.run();
+  LOG(INFO) << "Stolen executions: " << stolen.load();
+  CHECK(stolen.load() > 0);
+}
+TEST(Actor2, actor_stats) {
+  set_actor_stats(true);
+  Scheduler scheduler({1});
+  scheduler.run_in_context([] {
+    class B : public Actor {
+     public:
+      void query(int i) {
+        if (i == 99) {
+          SchedulerContext::get()->stop();
+        }
+      }
+    };
+    class A : public Actor {
+      void start_up() override {
+        auto b = create_actor<B>("StatsTestB(1)").release();
+        for (int i = 0; i < 100; i++) {
+          send_closure_later(b, &B::query, i);
+        }
+      }
+    };
+    create_actor<A>("StatsTestA").release();
+  });
+  scheduler.run();
+  set_actor_stats(false);
+
+  bool found = false;
+  for (auto &stat : core::ActorTypeStat::get_snapshots()) {
+    if (stat.name == "StatsTestB") {
+      found = true;
+      ASSERT_EQ(100u, stat.messages);
+      ASSERT_EQ(100u, stat.queued_messages);
+      ASSERT_TRUE(stat.executions > 0);
+      ASSERT_TRUE(stat.max_mailbox_size >= 1 && stat.max_mailbox_size <= 100);
+      ASSERT_TRUE(stat.mean_mailbox_size >= 1);
+    }
+  }
+  ASSERT_TRUE(found);
+}
+TEST(Actor2, send_closure_batch) {
+  Scheduler scheduler({1});
+  scheduler.run_in_context([] {
+    class B : public Actor {
+     public:
+      void query(int i) {
+        CHECK(i == next_);
+        next_++;
+        if (i == 99) {
+          SchedulerContext::get()->stop();
+        }
+      }
+      void unused(std::shared_ptr<int> ptr) {
+        UNREACHABLE();
+      }
+
+     private:
+      int next_{0};
+    };
+    class A : public Actor {
+      void start_up() override {
+        auto b = create_actor<B>("B").release();
+        send_closure_later(b, &B::query, 0);
+        ClosureBatch<B> batch;
+        for (int i = 1; i < 99; i++) {
+          batch.add(&B::query, i);
+          if (batch.size() == 10) {
+            send_closure_batch(b, std::move(batch));
+            CHECK(batch.empty());
+          }
+        }
+        send_closure_batch(b, std::move(batch));
+        send_closure_later(b, &B::query, 99);
+
+        auto ptr = std::make_shared<int>(0);
+        ClosureBatch<B> unsent_batch;
+        unsent_batch.add(&B::unused, ptr);
+        CHECK(ptr.use_count() == 2);
+        unsent_batch = {};
+        CHECK(ptr.use_count() == 1);
+      }
+    };
+    create_actor<A>("A").release();
+  });
+  scheduler.run();
+}
 TEST(Actor2, ActorIdDynamicCast) {
   Scheduler scheduler({0});
   scheduler.run_in_context([] {
@@ -19,6 +19,10 @@
 #pragma once
 #include "td/utils/Status.h"
 #include "td/utils/logging.h"
+#include "td/utils/Span.h"
+
+#include <functional>
+
 namespace td {
 class KeyValueReader {
  public:
@@ -27,6 +31,42 @@ class KeyValueReader {
 
   virtual Result<GetStatus> get(Slice key, std::string &value) = 0;
   virtual Result<size_t> count(Slice prefix) = 0;
+
+  // Looks up several keys at once. values is resized to keys.size(); (*values)[i] is meaningful only if
+  // the i-th returned status is GetStatus::Ok.
+  virtual Result<std::vector<GetStatus>> get_multi(Span<Slice> keys, std::vector<std::string> *values) {
+    values->resize(keys.size());
+    std::vector<GetStatus> res;
+    res.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      TRY_RESULT(status, get(keys[i], (*values)[i]));
+      res.push_back(status);
+    }
+    return std::move(res);
+  }
+
+  // Calls f(key, value) for all keys in [begin, end) in increasing order; an empty end means no upper bound.
+  // Stops and returns the error if f returns one.
+  virtual Status for_each_in_range(Slice begin, Slice end, std::function<Status(Slice, Slice)> f) {
+    return Status::Error("for_each_in_range is not supported");
+  }
+
+  // Calls f(key, value) for all keys with the given prefix in increasing order
+  Status for_each(Slice prefix, std::function<Status(Slice, Slice)> f) {
+    return for_each_in_range(prefix, prefix_end(prefix), std::move(f));
+  }
+
+  // Returns the smallest key greater than all keys with the given prefix, or an empty string if there is none
+  static std::string prefix_end(Slice prefix) {
+    std::string res = prefix.str();
+    while (!res.empty() && static_cast<unsigned char>(res.back()) == 0xff) {
+      res.pop_back();
+    }
+    if (!res.empty()) {
+      res.back() = static_cast<char>(static_cast<unsigned char>(res.back()) + 1);
+    }
+    return res;
+  }
 };
 
 class PrefixedKeyValueReader : public KeyValueReader {
@@ -40,6 +80,20 @@ class PrefixedKeyValueReader : public KeyValueReader {
   Result<size_t> count(Slice prefix) override {
     return reader_->count(PSLICE() << prefix_ << prefix);
   }
+  Result<std::vector<GetStatus>> get_multi(Span<Slice> keys, std::vector<std::string> *values) override {
+    std::vector<std::string> prefixed_keys_str;
+    prefixed_keys_str.reserve(keys.size());
+    for (auto &key : keys) {
+      prefixed_keys_str.push_back(PSTRING() << prefix_ << key);
+    }
+    std::vector<Slice> prefixed_keys(prefixed_keys_str.begin(), prefixed_keys_str.end());
+    return reader_->get_multi(prefixed_keys, values);
+  }
+  Status for_each_in_range(Slice begin, Slice end, std::function<Status(Slice, Slice)> f) override {
+    return reader_->for_each_in_range(PSLICE() << prefix_ << begin,
+                                      end.empty() ? prefix_end(prefix_) : PSTRING() << prefix_ << end,
+                                      [&](Slice key, Slice value) { return f(key.substr(prefix_.size()), value); });
+  }
 
  private:
   std::shared_ptr<KeyValueReader> reader_;
@@ -83,6 +137,20 @@ class PrefixedKeyValue : public KeyValue {
   Result<size_t> count(Slice prefix) override {
     return kv_->count(PSLICE() << prefix_ << prefix);
   }
+  Result<std::vector<GetStatus>> get_multi(Span<Slice> keys, std::vector<std::string> *values) override {
+    std::vector<std::string> prefixed_keys_str;
+    prefixed_keys_str.reserve(keys.size());
+    for (auto &key : keys) {
+      prefixed_keys_str.push_back(PSTRING() << prefix_ << key);
+    }
+    std::vector<Slice> prefixed_keys(prefixed_keys_str.begin(), prefixed_keys_str.end());
+    return kv_->get_multi(prefixed_keys, values);
+  }
+  Status for_each_in_range(Slice begin, Slice end, std::function<Status(Slice, Slice)> f) override {
+    return kv_->for_each_in_range(PSLICE() << prefix_ << begin,
+                                  end.empty() ? prefix_end(prefix_) : PSTRING() << prefix_ << end,
+                                  [&](Slice key, Slice value) { return f(key.substr(prefix_.size()), value); });
+  }
   Status set(Slice key, Slice value) override {
     return kv_->set(PSLICE() << prefix_ << key, value);
   }
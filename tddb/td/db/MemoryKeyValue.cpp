@@ -52,6 +52,16 @@ Result<size_t> MemoryKeyValue::count(Slice prefix) {
   return res;
 }
 
+Status MemoryKeyValue::for_each_in_range(Slice begin, Slice end, std::function<Status(Slice, Slice)> f) {
+  for (auto it = map_.lower_bound(begin); it != map_.end(); it++) {
+    if (!end.empty() && !(Slice(it->first) < end)) {
+      break;
+    }
+    TRY_STATUS(f(it->first, it->second));
+  }
+  return Status::OK();
+}
+
 std::unique_ptr<KeyValueReader> MemoryKeyValue::snapshot() {
   auto res = std::make_unique<MemoryKeyValue>();
   res->map_ = map_;
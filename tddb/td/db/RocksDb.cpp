@@ -19,12 +19,18 @@
 #include "td/db/RocksDb.h"
 
 #include "rocksdb/db.h"
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/rate_limiter.h"
+#include "rocksdb/slice_transform.h"
 #include "rocksdb/table.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/write_batch.h"
 #include "rocksdb/utilities/optimistic_transaction_db.h"
 #include "rocksdb/utilities/transaction.h"
 
+#include <map>
+#include <mutex>
+
 namespace td {
 namespace {
 static Status from_rocksdb(rocksdb::Status status) {
@@ -39,6 +45,53 @@ static Slice from_rocksdb(rocksdb::Slice slice) {
 static rocksdb::Slice to_rocksdb(Slice slice) {
   return rocksdb::Slice(slice.data(), slice.size());
 }
+static rocksdb::CompressionType to_rocksdb(RocksDbOptions::Compression compression) {
+  switch (compression) {
+    case RocksDbOptions::Compression::None:
+      return rocksdb::kNoCompression;
+    case RocksDbOptions::Compression::Snappy:
+      return rocksdb::kSnappyCompression;
+    case RocksDbOptions::Compression::Lz4:
+      return rocksdb::kLZ4Compression;
+    case RocksDbOptions::Compression::Zstd:
+      return rocksdb::kZSTD;
+  }
+  UNREACHABLE();
+}
+static std::shared_ptr<rocksdb::Cache> get_block_cache(const RocksDbOptions &db_options) {
+  if (db_options.shared_cache_name.empty()) {
+    return rocksdb::NewLRUCache(db_options.block_cache_size);
+  }
+  static std::mutex mutex;
+  static std::map<std::string, std::shared_ptr<rocksdb::Cache>> caches;
+  std::lock_guard<std::mutex> guard(mutex);
+  auto &cache = caches[db_options.shared_cache_name];
+  if (!cache) {
+    cache = rocksdb::NewLRUCache(db_options.block_cache_size);
+  }
+  return cache;
+}
+
+static std::shared_ptr<rocksdb::RateLimiter> get_rate_limiter(const RocksDbOptions &db_options) {
+  if (db_options.rate_limit_bytes_per_sec == 0) {
+    return nullptr;
+  }
+  auto create = [&] {
+    return std::shared_ptr<rocksdb::RateLimiter>(
+        rocksdb::NewGenericRateLimiter(static_cast<int64_t>(db_options.rate_limit_bytes_per_sec)));
+  };
+  if (db_options.shared_cache_name.empty()) {
+    return create();
+  }
+  static std::mutex mutex;
+  static std::map<std::string, std::shared_ptr<rocksdb::RateLimiter>> rate_limiters;
+  std::lock_guard<std::mutex> guard(mutex);
+  auto &rate_limiter = rate_limiters[db_options.shared_cache_name];
+  if (!rate_limiter) {
+    rate_limiter = create();
+  }
+  return rate_limiter;
+}
 }  // namespace
 
 Status RocksDb::destroy(Slice path) {
@@ -59,17 +112,30 @@ RocksDb RocksDb::clone() const {
   return RocksDb{db_, statistics_};
 }
 
-Result<RocksDb> RocksDb::open(std::string path) {
+Result<RocksDb> RocksDb::open(std::string path, RocksDbOptions db_options) {
   rocksdb::OptimisticTransactionDB *db;
   auto statistics = rocksdb::CreateDBStatistics();
   {
     rocksdb::Options options;
 
-    static auto cache = rocksdb::NewLRUCache(1 << 30);
-
     rocksdb::BlockBasedTableOptions table_options;
-    table_options.block_cache = cache;
+    table_options.block_cache = get_block_cache(db_options);
+    table_options.block_size = db_options.block_size;
+    if (db_options.bloom_bits_per_key > 0) {
+      table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(db_options.bloom_bits_per_key, false));
+    }
+    table_options.whole_key_filtering = db_options.whole_key_filtering;
     options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    if (db_options.prefix_length > 0) {
+      options.prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(db_options.prefix_length));
+    }
+    options.compression = to_rocksdb(db_options.compression);
+    options.compaction_style = db_options.compaction_style == RocksDbOptions::CompactionStyle::Universal
+                                   ? rocksdb::kCompactionStyleUniversal
+                                   : rocksdb::kCompactionStyleLevel;
+    options.rate_limiter = get_rate_limiter(db_options);
+    options.use_direct_reads = db_options.use_direct_io;
+    options.use_direct_io_for_flush_and_compaction = db_options.use_direct_io;
 
     options.manual_wal_flush = true;
     options.create_if_missing = true;
@@ -129,6 +195,36 @@ Result<RocksDb::GetStatus> RocksDb::get(Slice key, std::string &value) {
   return from_rocksdb(status);
 }
 
+Result<std::vector<RocksDb::GetStatus>> RocksDb::get_multi(Span<Slice> keys, std::vector<std::string> *values) {
+  std::vector<rocksdb::Slice> rocksdb_keys;
+  rocksdb_keys.reserve(keys.size());
+  for (auto &key : keys) {
+    rocksdb_keys.push_back(to_rocksdb(key));
+  }
+  std::vector<rocksdb::Status> statuses;
+  if (snapshot_) {
+    rocksdb::ReadOptions options;
+    options.snapshot = snapshot_.get();
+    statuses = db_->MultiGet(options, rocksdb_keys, values);
+  } else if (transaction_) {
+    statuses = transaction_->MultiGet({}, rocksdb_keys, values);
+  } else {
+    statuses = db_->MultiGet({}, rocksdb_keys, values);
+  }
+  std::vector<GetStatus> res;
+  res.reserve(statuses.size());
+  for (auto &status : statuses) {
+    if (status.ok()) {
+      res.push_back(GetStatus::Ok);
+    } else if (status.code() == rocksdb::Status::kNotFound) {
+      res.push_back(GetStatus::NotFound);
+    } else {
+      return from_rocksdb(status);
+    }
+  }
+  return std::move(res);
+}
+
 Status RocksDb::set(Slice key, Slice value) {
   if (write_batch_) {
     return from_rocksdb(write_batch_->Put(to_rocksdb(key), to_rocksdb(value)));
@@ -152,6 +248,8 @@ Status RocksDb::erase(Slice key) {
 Result<size_t> RocksDb::count(Slice prefix) {
   rocksdb::ReadOptions options;
   options.snapshot = snapshot_.get();
+  // the prefix may be shorter than the one of the prefix extractor
+  options.total_order_seek = true;
   std::unique_ptr<rocksdb::Iterator> iterator;
   if (snapshot_ || !transaction_) {
     iterator.reset(db_->NewIterator(options));
@@ -172,6 +270,32 @@ Result<size_t> RocksDb::count(Slice prefix) {
   return res;
 }
 
+Status RocksDb::for_each_in_range(Slice begin, Slice end, std::function<Status(Slice, Slice)> f) {
+  rocksdb::ReadOptions options;
+  options.snapshot = snapshot_.get();
+  options.total_order_seek = true;
+  rocksdb::Slice upper_bound = to_rocksdb(end);
+  if (!end.empty()) {
+    options.iterate_upper_bound = &upper_bound;
+  }
+  std::unique_ptr<rocksdb::Iterator> iterator;
+  if (snapshot_ || !transaction_) {
+    iterator.reset(db_->NewIterator(options));
+  } else {
+    iterator.reset(transaction_->GetIterator(options));
+  }
+
+  for (iterator->Seek(to_rocksdb(begin)); iterator->Valid(); iterator->Next()) {
+    auto key = from_rocksdb(iterator->key());
+    // transaction iterators may ignore iterate_upper_bound for uncommitted writes
+    if (!end.empty() && !(key < end)) {
+      break;
+    }
+    TRY_STATUS(f(key, from_rocksdb(iterator->value())));
+  }
+  return from_rocksdb(iterator->status());
+}
+
 Status RocksDb::begin_write_batch() {
   CHECK(!transaction_);
   write_batch_ = std::make_unique<rocksdb::WriteBatch>();
@@ -23,6 +23,7 @@
 #endif
 
 #include "td/db/KeyValue.h"
+#include "td/db/RocksDbOptions.h"
 #include "td/utils/Status.h"
 
 namespace rocksdb {
@@ -38,12 +39,14 @@ class RocksDb : public KeyValue {
  public:
   static Status destroy(Slice path);
   RocksDb clone() const;
-  static Result<RocksDb> open(std::string path);
+  static Result<RocksDb> open(std::string path, RocksDbOptions db_options = {});
 
   Result<GetStatus> get(Slice key, std::string &value) override;
   Status set(Slice key, Slice value) override;
   Status erase(Slice key) override;
   Result<size_t> count(Slice prefix) override;
+  Result<std::vector<GetStatus>> get_multi(Span<Slice> keys, std::vector<std::string> *values) override;
+  Status for_each_in_range(Slice begin, Slice end, std::function<Status(Slice, Slice)> f) override;
 
   Status begin_write_batch() override;
   Status commit_write_batch() override;
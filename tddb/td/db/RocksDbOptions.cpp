@@ -0,0 +1,141 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/db/RocksDbOptions.h"
+
+#include "td/utils/misc.h"
+
+namespace td {
+namespace {
+Result<uint64> parse_size(Slice str) {
+  uint64 multiplier = 1;
+  if (!str.empty()) {
+    switch (str.back()) {
+      case 'K':
+      case 'k':
+        multiplier = 1 << 10;
+        break;
+      case 'M':
+      case 'm':
+        multiplier = 1 << 20;
+        break;
+      case 'G':
+      case 'g':
+        multiplier = 1 << 30;
+        break;
+    }
+    if (multiplier != 1) {
+      str.remove_suffix(1);
+    }
+  }
+  TRY_RESULT(value, to_integer_safe<uint64>(str));
+  if (value > std::numeric_limits<uint64>::max() / multiplier) {
+    return Status::Error("Size is too big");
+  }
+  return value * multiplier;
+}
+
+Result<bool> parse_bool(Slice str) {
+  if (str == "1" || str == "true") {
+    return true;
+  }
+  if (str == "0" || str == "false") {
+    return false;
+  }
+  return Status::Error("Expected true or false");
+}
+}  // namespace
+
+Status RocksDbOptions::apply(Slice options) {
+  for (auto option : full_split(options, ',')) {
+    if (option.empty()) {
+      continue;
+    }
+    auto key_value = split(option, '=');
+    auto key = key_value.first;
+    auto value = key_value.second;
+    auto status = [&]() -> Status {
+      if (key == "block_cache_size") {
+        TRY_RESULT_ASSIGN(block_cache_size, parse_size(value));
+      } else if (key == "shared_cache_name") {
+        shared_cache_name = value.str();
+      } else if (key == "block_size") {
+        TRY_RESULT_ASSIGN(block_size, parse_size(value));
+      } else if (key == "bloom_bits_per_key") {
+        TRY_RESULT_ASSIGN(bloom_bits_per_key, to_integer_safe<int32>(value));
+        if (bloom_bits_per_key < 0) {
+          return Status::Error("Expected non-negative value");
+        }
+      } else if (key == "whole_key_filtering") {
+        TRY_RESULT_ASSIGN(whole_key_filtering, parse_bool(value));
+      } else if (key == "prefix_length") {
+        TRY_RESULT_ASSIGN(prefix_length, to_integer_safe<size_t>(value));
+      } else if (key == "compression") {
+        if (value == "none") {
+          compression = Compression::None;
+        } else if (value == "snappy") {
+          compression = Compression::Snappy;
+        } else if (value == "lz4") {
+          compression = Compression::Lz4;
+        } else if (value == "zstd") {
+          compression = Compression::Zstd;
+        } else {
+          return Status::Error("Expected none, snappy, lz4 or zstd");
+        }
+      } else if (key == "compaction_style") {
+        if (value == "level") {
+          compaction_style = CompactionStyle::Level;
+        } else if (value == "universal") {
+          compaction_style = CompactionStyle::Universal;
+        } else {
+          return Status::Error("Expected level or universal");
+        }
+      } else if (key == "rate_limit") {
+        TRY_RESULT_ASSIGN(rate_limit_bytes_per_sec, parse_size(value));
+      } else if (key == "direct_io") {
+        TRY_RESULT_ASSIGN(use_direct_io, parse_bool(value));
+      } else {
+        return Status::Error("Unknown option");
+      }
+      return Status::OK();
+    }();
+    if (status.is_error()) {
+      return status.move_as_error_prefix(PSLICE() << "Invalid RocksDb option \"" << option << "\":");
+    }
+  }
+  return Status::OK();
+}
+
+RocksDbOptions RocksDbOptions::cell_db() {
+  RocksDbOptions options;
+  options.block_size = 16 << 10;
+  options.bloom_bits_per_key = 10;
+  options.compression = Compression::None;
+  return options;
+}
+
+RocksDbOptions RocksDbOptions::archive_index() {
+  RocksDbOptions options;
+  options.block_cache_size = 64 << 20;
+  options.shared_cache_name = "archive";
+  options.bloom_bits_per_key = 10;
+  options.prefix_length = 4;
+  return options;
+}
+
+}  // namespace td
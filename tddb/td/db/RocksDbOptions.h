@@ -0,0 +1,61 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// Options of a RocksDb database which are set when it is opened
+struct RocksDbOptions {
+  enum class Compression : int32 { None, Snappy, Lz4, Zstd };
+  enum class CompactionStyle : int32 { Level, Universal };
+
+  // Databases opened with the same non-empty shared_cache_name share one block cache, whose size is taken from
+  // the first of them, and one rate limiter, whose rate is taken from the first of them with a non-zero limit.
+  // A database with an empty shared_cache_name gets its own cache and rate limiter.
+  uint64 block_cache_size = 1 << 30;
+  std::string shared_cache_name = "default";
+  uint64 block_size = 4 << 10;
+  // 0 disables bloom filters
+  int32 bloom_bits_per_key = 0;
+  bool whole_key_filtering = true;
+  // if positive, bloom filters are also built for the first prefix_length bytes of the keys
+  size_t prefix_length = 0;
+  Compression compression = Compression::Snappy;
+  CompactionStyle compaction_style = CompactionStyle::Level;
+  // 0 means no limit for flushes and compactions of this database
+  uint64 rate_limit_bytes_per_sec = 0;
+  bool use_direct_io = false;
+
+  // Applies a comma-separated list of key=value pairs, e.g. "block_cache_size=4G,bloom_bits_per_key=10".
+  // Sizes may have K, M or G suffix.
+  Status apply(Slice options);
+
+  // Profiles for the databases of the validator. Default options are used by small databases (ADNL, DHT, etc.).
+
+  // Point lookups of random 32-byte keys of incompressible data
+  static RocksDbOptions cell_db();
+  // Many small databases of the archive slices; the keys start with a TL constructor id
+  static RocksDbOptions archive_index();
+};
+
+}  // namespace td
@@ -41,6 +41,9 @@ class BlobViewImpl {
     return td::Status::OK();
   }
   virtual td::uint64 size() = 0;
+  virtual std::shared_ptr<const void> get_view_owner() {
+    return nullptr;
+  }
 
  private:
   virtual td::Result<td::Slice> view_impl(td::MutableSlice slice, td::uint64 offset) = 0;
@@ -92,6 +95,11 @@ td::uint64 BlobView::size() {
   return impl_->size();
 }
 
+std::shared_ptr<const void> BlobView::get_view_owner() {
+  CHECK(impl_);
+  return impl_->get_view_owner();
+}
+
 td::Result<td::Slice> BlobViewImpl::view(td::MutableSlice slice, td::uint64 offset) {
   if (offset > size() || slice.size() > size() - offset) {
     return td::Status::Error(PSLICE() << "BlobView: invalid range requested " << td::tag("slice offset", offset)
@@ -280,21 +288,26 @@ td::Result<BlobView> FileNoCacheBlobView::create(td::CSlice file_path, td::uint6
 
 class FileMemoryMappingBlobViewImpl : public BlobViewImpl {
  public:
-  FileMemoryMappingBlobViewImpl(td::MemoryMapping mapping) : mapping_(std::move(mapping)) {
+  FileMemoryMappingBlobViewImpl(td::MemoryMapping mapping)
+      : mapping_(std::make_shared<td::MemoryMapping>(std::move(mapping))) {
   }
   td::Result<td::Slice> view_impl(td::MutableSlice slice, td::uint64 offset) override {
     // optimize anyway
-    return mapping_.as_slice().substr(offset, slice.size());
+    return mapping_->as_slice().substr(offset, slice.size());
   }
   td::uint64 size() override {
-    return mapping_.as_slice().size();
+    return mapping_->as_slice().size();
+  }
+  std::shared_ptr<const void> get_view_owner() override {
+    return mapping_;
   }
 
  private:
-  td::MemoryMapping mapping_;
+  std::shared_ptr<td::MemoryMapping> mapping_;
 };
 
-td::Result<BlobView> FileMemoryMappingBlobView::create(td::CSlice file_path, td::uint64 file_size) {
+td::Result<BlobView> FileMemoryMappingBlobView::create(td::CSlice file_path, td::uint64 file_size,
+                                                       td::MemoryMapping::Advice advice) {
   TRY_RESULT(fd, td::FileFd::open(file_path, td::FileFd::Flags::Read));
   TRY_RESULT(stat, fd.stat());
   if (file_size == 0) {
@@ -304,6 +317,9 @@ td::Result<BlobView> FileMemoryMappingBlobView::create(td::CSlice file_path, td:
   }
 
   TRY_RESULT(mapping, td::MemoryMapping::create_from_file(fd));
+  if (advice != td::MemoryMapping::Advice::Normal) {
+    TRY_STATUS(mapping.advise(advice));
+  }
 
   return BlobView(std::make_unique<FileMemoryMappingBlobViewImpl>(std::move(mapping)));
 }
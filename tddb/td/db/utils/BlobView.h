@@ -18,6 +18,9 @@
 */
 #pragma once
 #include "td/utils/buffer.h"
+#include "td/utils/port/MemoryMapping.h"
+
+#include <memory>
 
 namespace td {
 class BlobViewImpl;
@@ -34,6 +37,9 @@ class BlobView {
   td::Result<size_t> view_copy(td::MutableSlice slice, td::uint64 offset);
   td::Result<size_t> write(td::Slice data, td::uint64 offset);
   td::uint64 size();
+  // Returns an object keeping alive the memory returned by view, if views of the blob are zero-copy and immutable.
+  // Returns nullptr otherwise.
+  std::shared_ptr<const void> get_view_owner();
 
   explicit operator bool() const {
     return bool(impl_);
@@ -57,7 +63,8 @@ class FileNoCacheBlobView {
 };
 class FileMemoryMappingBlobView {
  public:
-  static td::Result<BlobView> create(td::CSlice file_path, td::uint64 file_size = 0);
+  static td::Result<BlobView> create(td::CSlice file_path, td::uint64 file_size = 0,
+                                     td::MemoryMapping::Advice advice = td::MemoryMapping::Advice::Normal);
 };
 
 // For testing purposes
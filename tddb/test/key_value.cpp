@@ -20,11 +20,13 @@
 
 #include "td/db/KeyValueAsync.h"
 #include "td/db/KeyValue.h"
+#include "td/db/MemoryKeyValue.h"
 #include "td/db/RocksDb.h"
 
 #include "td/utils/benchmark.h"
 #include "td/utils/buffer.h"
 #include "td/utils/optional.h"
+#include "td/utils/Random.h"
 #include "td/utils/UInt.h"
 
 TEST(KeyValue, simple) {
@@ -65,6 +67,120 @@ TEST(KeyValue, simple) {
   ensure_value(as_slice(x), as_slice(x));
 };
 
+TEST(KeyValue, get_multi_and_for_each) {
+  td::Slice db_name = "testdb";
+  td::RocksDb::destroy(db_name).ignore();
+
+  auto run_test = [](std::shared_ptr<td::KeyValue> kv) {
+    for (std::string key : {"a1", "a2", "b1", "b\xff", "c"}) {
+      kv->set(key, PSLICE() << "value of " << key).ensure();
+    }
+    auto collect = [](td::KeyValueReader &reader, td::Slice prefix) {
+      std::vector<std::string> keys;
+      reader
+          .for_each(prefix,
+                    [&](td::Slice key, td::Slice value) {
+                      auto expected_value = PSTRING() << "value of " << key;
+                      CHECK(value == expected_value);
+                      keys.push_back(key.str());
+                      return td::Status::OK();
+                    })
+          .ensure();
+      return keys;
+    };
+    ASSERT_TRUE(std::vector<std::string>({"a1", "a2"}) == collect(*kv, "a"));
+    ASSERT_TRUE(std::vector<std::string>({"b1", "b\xff"}) == collect(*kv, "b"));
+    ASSERT_EQ(5u, collect(*kv, "").size());
+    ASSERT_TRUE(collect(*kv, "d").empty());
+
+    std::vector<std::string> keys;
+    kv->for_each_in_range("a2", "c",
+                          [&](td::Slice key, td::Slice value) {
+                            keys.push_back(key.str());
+                            return td::Status::OK();
+                          })
+        .ensure();
+    ASSERT_TRUE(std::vector<std::string>({"a2", "b1", "b\xff"}) == keys);
+    size_t calls = 0;
+    auto status = kv->for_each("", [&](td::Slice key, td::Slice value) {
+      calls++;
+      return td::Status::Error("stop");
+    });
+    ASSERT_TRUE(status.is_error());
+    ASSERT_EQ(1u, calls);
+
+    auto check_get_multi = [](td::KeyValueReader &reader) {
+      std::vector<td::Slice> keys{"a1", "x", "c", "a1"};
+      std::vector<std::string> values;
+      auto statuses = reader.get_multi(keys, &values).move_as_ok();
+      ASSERT_EQ(4u, statuses.size());
+      ASSERT_EQ(4u, values.size());
+      ASSERT_TRUE(statuses[0] == td::KeyValue::GetStatus::Ok);
+      ASSERT_TRUE(statuses[1] == td::KeyValue::GetStatus::NotFound);
+      ASSERT_TRUE(statuses[2] == td::KeyValue::GetStatus::Ok);
+      ASSERT_TRUE(statuses[3] == td::KeyValue::GetStatus::Ok);
+      ASSERT_EQ("value of a1", values[0]);
+      ASSERT_EQ("value of c", values[2]);
+      ASSERT_EQ("value of a1", values[3]);
+    };
+    check_get_multi(*kv);
+
+    auto snapshot = kv->snapshot();
+    kv->set("a3", "value of a3").ensure();
+    kv->erase("c").ensure();
+    check_get_multi(*snapshot);
+    ASSERT_TRUE(std::vector<std::string>({"a1", "a2"}) == collect(*snapshot, "a"));
+    ASSERT_TRUE(std::vector<std::string>({"a1", "a2", "a3"}) == collect(*kv, "a"));
+
+    td::PrefixedKeyValue prefixed(kv, "b");
+    std::vector<std::string> prefixed_keys;
+    prefixed
+        .for_each("",
+                  [&](td::Slice key, td::Slice value) {
+                    prefixed_keys.push_back(key.str());
+                    return td::Status::OK();
+                  })
+        .ensure();
+    ASSERT_TRUE(std::vector<std::string>({"1", "\xff"}) == prefixed_keys);
+    std::vector<td::Slice> prefixed_get{"1", "2"};
+    std::vector<std::string> values;
+    auto statuses = prefixed.get_multi(prefixed_get, &values).move_as_ok();
+    ASSERT_TRUE(statuses[0] == td::KeyValue::GetStatus::Ok);
+    ASSERT_TRUE(statuses[1] == td::KeyValue::GetStatus::NotFound);
+    ASSERT_EQ("value of b1", values[0]);
+  };
+
+  run_test(std::make_shared<td::MemoryKeyValue>());
+  run_test(std::make_shared<td::RocksDb>(td::RocksDb::open(db_name.str()).move_as_ok()));
+}
+
+TEST(KeyValue, rocksdb_options) {
+  auto options = td::RocksDbOptions::cell_db();
+  options.apply("block_cache_size=4G,bloom_bits_per_key=12,compression=zstd,direct_io=true,rate_limit=64M").ensure();
+  ASSERT_EQ(4ull << 30, options.block_cache_size);
+  ASSERT_EQ(12, options.bloom_bits_per_key);
+  ASSERT_TRUE(options.compression == td::RocksDbOptions::Compression::Zstd);
+  ASSERT_TRUE(options.use_direct_io);
+  ASSERT_EQ(64ull << 20, options.rate_limit_bytes_per_sec);
+  ASSERT_EQ("default", options.shared_cache_name);
+  ASSERT_TRUE(options.apply("compression=gzip").is_error());
+  ASSERT_TRUE(options.apply("unknown=1").is_error());
+  ASSERT_TRUE(options.apply("block_size=1X").is_error());
+
+  td::Slice db_name = "testdb";
+  td::RocksDb::destroy(db_name).ignore();
+  auto db_options = td::RocksDbOptions::archive_index();
+  db_options.shared_cache_name = "";
+  auto kv = td::RocksDb::open(db_name.str(), db_options).move_as_ok();
+  kv.set("ab", "1").ensure();
+  kv.set("abcde", "2").ensure();
+  kv.set("b", "3").ensure();
+  ASSERT_EQ(2u, kv.count("a").move_as_ok());
+  std::string value;
+  ASSERT_TRUE(kv.get("abcde", value).move_as_ok() == td::KeyValue::GetStatus::Ok);
+  ASSERT_EQ("2", value);
+}
+
 TEST(KeyValue, async_simple) {
   td::Slice db_name = "testdb";
   td::RocksDb::destroy(db_name).ignore();
@@ -171,6 +287,63 @@ TEST(KeyValue, Bench) {
   td::bench(KeyValueBenchmark());
 }
 
+class KeyValueGetMultiBenchmark : public td::Benchmark {
+ public:
+  explicit KeyValueGetMultiBenchmark(bool use_get_multi) : use_get_multi_(use_get_multi) {
+  }
+
+  std::string get_description() const override {
+    return PSTRING() << "kv lookup of " << BATCH_SIZE << " keys " << (use_get_multi_ ? "with get_multi" : "one by one");
+  }
+
+  void start_up() override {
+    td::RocksDb::destroy("ttt-multi").ignore();
+    db_ = td::RocksDb::open("ttt-multi").move_as_ok();
+    db_.value().begin_write_batch().ensure();
+    for (int i = 0; i < KEYS_N; i++) {
+      db_.value().set(key(i), std::string(100, static_cast<char>(i))).ensure();
+    }
+    db_.value().commit_write_batch().ensure();
+  }
+  void tear_down() override {
+    db_ = {};
+    td::RocksDb::destroy("ttt-multi").ignore();
+  }
+  void run(int n) override {
+    std::vector<std::string> keys_str(BATCH_SIZE);
+    std::vector<std::string> values;
+    for (int i = 0; i < n; i++) {
+      for (auto &key_str : keys_str) {
+        key_str = key(td::Random::fast(0, KEYS_N - 1));
+      }
+      if (use_get_multi_) {
+        std::vector<td::Slice> keys(keys_str.begin(), keys_str.end());
+        db_.value().get_multi(keys, &values).ensure();
+      } else {
+        values.resize(BATCH_SIZE);
+        for (int j = 0; j < BATCH_SIZE; j++) {
+          db_.value().get(keys_str[j], values[j]).ensure();
+        }
+      }
+    }
+  }
+
+ private:
+  static constexpr int KEYS_N = 100000;
+  static constexpr int BATCH_SIZE = 100;
+  bool use_get_multi_;
+  td::optional<td::RocksDb> db_;
+
+  static std::string key(int i) {
+    return PSTRING() << "key" << i;
+  }
+};
+
+TEST(KeyValue, BenchGetMulti) {
+  td::bench(KeyValueGetMultiBenchmark(false));
+  td::bench(KeyValueGetMultiBenchmark(true));
+}
+
 TEST(KeyValue, Stress) {
   return;
   td::Slice db_name = "testdb";
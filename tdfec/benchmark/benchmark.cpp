@@ -235,11 +235,96 @@ class FecBenchmark : public td::Benchmark {
 template <template <class T, size_t size> class O, size_t size = 256 * 8>
 void bench_simd() {
   bench(O<td::Simd_null, size>("baseline"));
-#if TD_SSSE3
-  bench(O<td::Simd_sse, size>("SSE"));
+#if TD_SSE3
+  if (td::Simd_sse::is_supported()) {
+    bench(O<td::Simd_sse, size>("SSE"));
+  }
 #endif
 #if TD_AVX2
-  bench(O<td::Simd_avx, size>("AVX"));
+  if (td::Simd_avx::is_supported()) {
+    bench(O<td::Simd_avx, size>("AVX"));
+  }
+#endif
+#if TD_AVX512
+  if (td::Simd_avx512::is_supported()) {
+    bench(O<td::Simd_avx512, size>("AVX-512"));
+  }
+#endif
+#if TD_GFNI
+  if (td::Simd_gfni::is_supported()) {
+    bench(O<td::Simd_gfni, size>("AVX-512 GFNI"));
+  }
+#endif
+}
+
+void run_raptorq_benchmark(size_t symbol_size, size_t symbols_count) {
+  constexpr size_t TARGET_TOTAL_BYTES = 64 * 1024 * 1024;
+  auto data_size = symbol_size * symbols_count;
+  td::BufferSlice data(data_size);
+  td::Random::Xorshift128plus rnd(123);
+  for (auto &c : data.as_slice()) {
+    c = static_cast<td::uint8>(rnd());
+  }
+  auto iterations = td::max<size_t>(TARGET_TOTAL_BYTES / data_size, 1);
+
+  // decoding starts from the repair symbols only, so that the whole system has to be solved
+  auto encoder = td::fec::RaptorQEncoder::create(data.clone(), symbol_size);
+  auto parameters = encoder->get_parameters();
+  std::vector<td::fec::Symbol> symbols;
+  for (td::uint32 id = td::narrow_cast<td::uint32>(symbols_count); symbols.size() < symbols_count + 10; id++) {
+    if (encoder->get_info().ready_symbol_count <= id) {
+      encoder->prepare_more_symbols();
+    }
+    symbols.push_back(encoder->gen_symbol(id));
+  }
+
+  auto mb_per_second = [&](double elapsed) {
+    return static_cast<double>(data_size) * static_cast<double>(iterations) / (1 << 20) / elapsed;
+  };
+  auto best_kernels = td::Simd::get_name();
+  std::vector<std::string> kernels_names;
+#if TD_FEC_SIMD_DISPATCH
+  for (auto kernels : td::Simd::get_supported_kernels()) {
+    kernels_names.push_back(kernels->name);
+  }
+#else
+  kernels_names.push_back(best_kernels);
+#endif
+  for (auto &name : kernels_names) {
+#if TD_FEC_SIMD_DISPATCH
+    CHECK(td::Simd::set_kernels(name));
+#endif
+    td::uint64 junk = 0;
+    double start = td::Time::now();
+    for (size_t i = 0; i < iterations; i++) {
+      auto encoder = td::fec::RaptorQEncoder::create(data.clone(), symbol_size);
+      encoder->prepare_more_symbols();
+      junk += encoder->gen_symbol(td::narrow_cast<td::uint32>(symbols_count)).data.as_slice()[0];
+    }
+    double encode_elapsed = td::Time::now() - start;
+
+    start = td::Time::now();
+    for (size_t i = 0; i < iterations; i++) {
+      auto decoder = td::fec::RaptorQDecoder::create(parameters);
+      for (auto &symbol : symbols) {
+        decoder->add_symbol({symbol.id, symbol.data.clone()});
+        if (decoder->may_try_decode()) {
+          auto res = decoder->try_decode(false);
+          if (res.is_ok()) {
+            junk += res.ok().data.as_slice()[0];
+            break;
+          }
+        }
+      }
+    }
+    double decode_elapsed = td::Time::now() - start;
+    td::do_not_optimize_away(junk);
+    fprintf(stderr, "RaptorQ %s, symbol size = %d, symbol count = %d: encode %.1lfMB/s, decode %.1lfMB/s\n",
+            name.c_str(), (int)symbol_size, (int)symbols_count, mb_per_second(encode_elapsed),
+            mb_per_second(decode_elapsed));
+  }
+#if TD_FEC_SIMD_DISPATCH
+  CHECK(td::Simd::set_kernels(best_kernels));
 #endif
 }
 
@@ -278,6 +363,8 @@ void run_encode_benchmark() {
 int main(void) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
   run_encode_benchmark();
+  run_raptorq_benchmark(768, 1000);
+  run_raptorq_benchmark(768, 10000);
   bench_simd<Simd_gf256_mul, 32>();
   bench_simd<Simd_gf256_add_mul, 32>();
   bench_simd<Simd_gf256_add, 32>();
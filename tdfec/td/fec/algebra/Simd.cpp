@@ -0,0 +1,118 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/fec/algebra/Simd.h"
+
+#if TD_FEC_SIMD_DISPATCH
+#include <cpuid.h>
+#endif
+
+namespace td {
+
+namespace {
+SimdCpuFeatures detect_simd_cpu_features() {
+  SimdCpuFeatures res;
+#if TD_FEC_SIMD_DISPATCH
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return res;
+  }
+  res.ssse3 = (ecx & bit_SSSE3) != 0;
+  if (!(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+    return res;
+  }
+  // the OS must save ymm (and zmm) registers on context switch
+  uint32 xcr0_lo, xcr0_hi;
+  __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  bool ymm_enabled = (xcr0_lo & 0x06) == 0x06;
+  bool zmm_enabled = (xcr0_lo & 0xe6) == 0xe6;
+  if (!ymm_enabled || __get_cpuid_max(0, nullptr) < 7) {
+    return res;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  res.avx2 = (ebx & bit_AVX2) != 0;
+  res.avx512 = res.avx2 && zmm_enabled && (ebx & (1u << 16)) != 0 /* AVX512F */ &&
+               (ebx & (1u << 30)) != 0 /* AVX512BW */ && (ebx & (1u << 31)) != 0 /* AVX512VL */;
+  res.gfni = res.avx512 && (ecx & (1u << 8)) != 0 /* GFNI */;
+#else
+#if TD_SSE3
+  res.ssse3 = true;
+#endif
+#if TD_AVX2
+  res.avx2 = true;
+#endif
+#if TD_AVX512
+  res.avx512 = true;
+#endif
+#if TD_GFNI
+  res.gfni = true;
+#endif
+#endif
+  return res;
+}
+}  // namespace
+
+const SimdCpuFeatures &get_simd_cpu_features() {
+  static const SimdCpuFeatures features = detect_simd_cpu_features();
+  return features;
+}
+
+#if TD_FEC_SIMD_DISPATCH
+namespace {
+template <class SimdT>
+constexpr SimdKernels make_simd_kernels(const char *name) {
+  return SimdKernels{name, &SimdT::is_supported, &SimdT::gf256_add, &SimdT::gf256_mul, &SimdT::gf256_add_mul,
+                     &SimdT::gf256_from_gf2};
+}
+
+constexpr SimdKernels simd_kernels[] = {
+    make_simd_kernels<Simd_null>("Without simd"), make_simd_kernels<Simd_sse>("With SSE"),
+    make_simd_kernels<Simd_avx>("With AVX"), make_simd_kernels<Simd_avx512>("With AVX-512"),
+    make_simd_kernels<Simd_gfni>("With AVX-512 GFNI")};
+}  // namespace
+
+std::atomic<const SimdKernels *> Simd::kernels_{nullptr};
+
+const SimdKernels *Simd::init_kernels() {
+  auto kernels = get_supported_kernels().back();
+  kernels_.store(kernels, std::memory_order_relaxed);
+  return kernels;
+}
+
+std::vector<const SimdKernels *> Simd::get_supported_kernels() {
+  std::vector<const SimdKernels *> res;
+  for (auto &kernels : simd_kernels) {
+    if (kernels.is_supported()) {
+      res.push_back(&kernels);
+    }
+  }
+  return res;
+}
+
+bool Simd::set_kernels(Slice name) {
+  for (auto kernels : get_supported_kernels()) {
+    if (name == CSlice(kernels->name)) {
+      kernels_.store(kernels, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+}  // namespace td
@@ -18,9 +18,24 @@
 */
 #pragma once
 #include "td/utils/misc.h"
+#include "td/utils/Slice.h"
 
 #include "td/fec/algebra/Octet.h"
 
+#include <atomic>
+#include <vector>
+
+// With GCC or Clang on x86-64 all kernels are compiled in, and the fastest one supported by the CPU
+// is selected at runtime. Otherwise the kernel is chosen at compile time.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TD_FEC_SIMD_DISPATCH 1
+#define TD_FEC_TARGET(x) __attribute__((target(x)))
+#define TD_SSE3 1
+#define TD_AVX2 1
+#define TD_AVX512 1
+#define TD_GFNI 1
+#else
+#define TD_FEC_TARGET(x)
 #if __SSSE3__
 #define TD_SSE3 1
 #endif
@@ -30,13 +45,31 @@
 #define TD_SSE3 1
 #endif
 
-#if TD_AVX2
-#include <immintrin.h> /* avx2 */
+#if __AVX512BW__ && __AVX512VL__
+#define TD_AVX512 1
+#endif
+
+#if TD_AVX512 && __GFNI__
+#define TD_GFNI 1
+#endif
+#endif
+
+#if TD_FEC_SIMD_DISPATCH || TD_AVX2
+#include <immintrin.h> /* avx2, avx512, gfni */
 #elif TD_SSE3
 #include <tmmintrin.h> /* ssse3 */
 #endif
 
 namespace td {
+
+struct SimdCpuFeatures {
+  bool ssse3{false};
+  bool avx2{false};
+  bool avx512{false};  // AVX-512 F, BW and VL
+  bool gfni{false};    // GFNI together with AVX-512
+};
+const SimdCpuFeatures &get_simd_cpu_features();
+
 class Simd_null {
  public:
   static constexpr size_t alignment() {
@@ -46,6 +79,9 @@ class Simd_null {
   static std::string get_name() {
     return "Without simd";
   }
+  static bool is_supported() {
+    return true;
+  }
   static bool is_aligned_pointer(const void *ptr) {
     return ::td::is_aligned_pointer<alignment()>(ptr);
   }
@@ -98,12 +134,15 @@ class Simd_sse : public Simd_null {
   static std::string get_name() {
     return "With SSE";
   }
+  static bool is_supported() {
+    return get_simd_cpu_features().ssse3;
+  }
 
   static bool is_aligned_pointer(const void *ptr) {
     return ::td::is_aligned_pointer<alignment()>(ptr);
   }
 
-  static void gf256_add(void *a, const void *b, size_t size) {
+  static TD_FEC_TARGET("ssse3") void gf256_add(void *a, const void *b, size_t size) {
     DCHECK(is_aligned_pointer(a));
     DCHECK(is_aligned_pointer(b));
     uint8 *ap = reinterpret_cast<uint8 *>(a);
@@ -116,7 +155,7 @@ class Simd_sse : public Simd_null {
       bp128++;
     }
   }
-  static void gf256_mul(void *a, uint8 u, size_t size) {
+  static TD_FEC_TARGET("ssse3") void gf256_mul(void *a, uint8 u, size_t size) {
     DCHECK(is_aligned_pointer(a));
     uint8 *ap = reinterpret_cast<uint8 *>(a);
 
@@ -137,7 +176,7 @@ class Simd_sse : public Simd_null {
       ap128++;
     }
   }
-  static void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+  static TD_FEC_TARGET("ssse3") void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
     DCHECK(is_aligned_pointer(a));
     DCHECK(is_aligned_pointer(b));
     uint8 *ap = reinterpret_cast<uint8 *>(a);
@@ -170,8 +209,11 @@ class Simd_avx : public Simd_sse {
   static std::string get_name() {
     return "With AVX";
   }
+  static bool is_supported() {
+    return get_simd_cpu_features().avx2;
+  }
 
-  static void gf256_add(void *a, const void *b, size_t size) {
+  static TD_FEC_TARGET("avx2") void gf256_add(void *a, const void *b, size_t size) {
     DCHECK(is_aligned_pointer(a));
     DCHECK(is_aligned_pointer(b));
     uint8 *ap = reinterpret_cast<uint8 *>(a);
@@ -185,7 +227,7 @@ class Simd_avx : public Simd_sse {
     }
   }
 
-  static __m256i get_mask(const uint32 mask) {
+  static TD_FEC_TARGET("avx2") __m256i get_mask(const uint32 mask) {
     // abcd -> abcd * 8
     __m256i vmask(_mm256_set1_epi32(mask));
 
@@ -199,7 +241,7 @@ class Simd_avx : public Simd_sse {
     return _mm256_and_si256(_mm256_cmpeq_epi8(vmask, _mm256_set1_epi64x(-1)), _mm256_set1_epi8(1));
   }
 
-  static void gf256_from_gf2(void *a, const void *b, size_t size) {
+  static TD_FEC_TARGET("avx2") void gf256_from_gf2(void *a, const void *b, size_t size) {
     DCHECK(is_aligned_pointer(a));
     DCHECK(size % 4 == 0);
     __m256i *ap256 = reinterpret_cast<__m256i *>(a);
@@ -210,7 +252,7 @@ class Simd_avx : public Simd_sse {
     }
   }
 
-  static __attribute__((noinline)) void gf256_mul(void *a, uint8 u, size_t size) {
+  static TD_FEC_TARGET("avx2") __attribute__((noinline)) void gf256_mul(void *a, uint8 u, size_t size) {
     const __m128i urow_hi_small = _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulHi[u]));
     const __m256i urow_hi = _mm256_broadcastsi128_si256(urow_hi_small);
     const __m128i urow_lo_small = _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulLo[u]));
@@ -231,7 +273,7 @@ class Simd_avx : public Simd_sse {
     }
   }
 
-  static __attribute__((noinline)) void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+  static TD_FEC_TARGET("avx2") __attribute__((noinline)) void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
     const __m128i urow_hi_small = _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulHi[u]));
     const __m256i urow_hi = _mm256_broadcastsi128_si256(urow_hi_small);
     const __m128i urow_lo_small = _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulLo[u]));
@@ -255,7 +297,200 @@ class Simd_avx : public Simd_sse {
 };
 #endif  // AVX2
 
-#if TD_AVX2
+#if TD_AVX512
+#define TD_FEC_TARGET_AVX512 TD_FEC_TARGET("avx2,avx512f,avx512bw,avx512vl")
+// Sizes are multiples of alignment() == 32, so the last half of a 64-byte block is handled by Simd_avx
+class Simd_avx512 : public Simd_avx {
+ public:
+  static std::string get_name() {
+    return "With AVX-512";
+  }
+  static bool is_supported() {
+    return get_simd_cpu_features().avx512;
+  }
+
+  static TD_FEC_TARGET_AVX512 void gf256_add(void *a, const void *b, size_t size) {
+    DCHECK(is_aligned_pointer(a));
+    DCHECK(is_aligned_pointer(b));
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    const uint8 *bp = reinterpret_cast<const uint8 *>(b);
+    size_t idx = 0;
+    for (; idx + 64 <= size; idx += 64) {
+      _mm512_storeu_si512(ap + idx, _mm512_xor_si512(_mm512_loadu_si512(ap + idx), _mm512_loadu_si512(bp + idx)));
+    }
+    if (idx < size) {
+      Simd_avx::gf256_add(ap + idx, bp + idx, size - idx);
+    }
+  }
+
+  static TD_FEC_TARGET_AVX512 __attribute__((noinline)) void gf256_mul(void *a, uint8 u, size_t size) {
+    DCHECK(is_aligned_pointer(a));
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    // the masked forms take an initialized source instead of _mm512_undefined_epi32(), which GCC reports
+    // as -Wmaybe-uninitialized; with a full mask they produce the same result
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i urow_hi = _mm512_mask_broadcast_i32x4(
+        zero, 0xffff, _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulHi[u])));
+    const __m512i urow_lo = _mm512_mask_broadcast_i32x4(
+        zero, 0xffff, _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulLo[u])));
+    const __m512i mask = _mm512_set1_epi8(0x0f);
+
+    size_t idx = 0;
+    for (; idx + 64 <= size; idx += 64) {
+      __m512i ax = _mm512_loadu_si512(ap + idx);
+      __m512i lo = _mm512_and_si512(ax, mask);
+      __m512i hi = _mm512_and_si512(_mm512_mask_srli_epi64(zero, 0xff, ax, 4), mask);
+      lo = _mm512_shuffle_epi8(urow_lo, lo);
+      hi = _mm512_shuffle_epi8(urow_hi, hi);
+      _mm512_storeu_si512(ap + idx, _mm512_xor_si512(lo, hi));
+    }
+    if (idx < size) {
+      Simd_avx::gf256_mul(ap + idx, u, size - idx);
+    }
+  }
+
+  static TD_FEC_TARGET_AVX512 __attribute__((noinline)) void gf256_add_mul(void *a, const void *b, uint8 u,
+                                                                             size_t size) {
+    DCHECK(is_aligned_pointer(a));
+    DCHECK(is_aligned_pointer(b));
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    const uint8 *bp = reinterpret_cast<const uint8 *>(b);
+    // the masked forms take an initialized source instead of _mm512_undefined_epi32(), which GCC reports
+    // as -Wmaybe-uninitialized; with a full mask they produce the same result
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i urow_hi = _mm512_mask_broadcast_i32x4(
+        zero, 0xffff, _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulHi[u])));
+    const __m512i urow_lo = _mm512_mask_broadcast_i32x4(
+        zero, 0xffff, _mm_load_si128(reinterpret_cast<const __m128i *>(Octet::OctMulLo[u])));
+    const __m512i mask = _mm512_set1_epi8(0x0f);
+
+    size_t idx = 0;
+    for (; idx + 64 <= size; idx += 64) {
+      __m512i bx = _mm512_loadu_si512(bp + idx);
+      __m512i lo = _mm512_and_si512(bx, mask);
+      __m512i hi = _mm512_and_si512(_mm512_mask_srli_epi64(zero, 0xff, bx, 4), mask);
+      lo = _mm512_shuffle_epi8(urow_lo, lo);
+      hi = _mm512_shuffle_epi8(urow_hi, hi);
+      _mm512_storeu_si512(ap + idx, _mm512_xor_si512(_mm512_loadu_si512(ap + idx), _mm512_xor_si512(lo, hi)));
+    }
+    if (idx < size) {
+      Simd_avx::gf256_add_mul(ap + idx, bp + idx, u, size - idx);
+    }
+  }
+};
+#endif  // AVX512
+
+#if TD_GFNI
+#define TD_FEC_TARGET_GFNI TD_FEC_TARGET("avx2,avx512f,avx512bw,avx512vl,gfni")
+// Multiplication by a constant is a linear map over GF(2), so it is done by one gf2p8affineqb
+// with a precomputed matrix instead of two table lookups
+class Simd_gfni : public Simd_avx512 {
+ public:
+  static std::string get_name() {
+    return "With AVX-512 GFNI";
+  }
+  static bool is_supported() {
+    return get_simd_cpu_features().gfni;
+  }
+
+  static TD_FEC_TARGET_GFNI __attribute__((noinline)) void gf256_mul(void *a, uint8 u, size_t size) {
+    DCHECK(is_aligned_pointer(a));
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    const __m512i matrix = _mm512_set1_epi64(static_cast<long long>(Octet::OctMulAffine[u]));
+
+    size_t idx = 0;
+    for (; idx + 64 <= size; idx += 64) {
+      _mm512_storeu_si512(ap + idx, _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(ap + idx), matrix, 0));
+    }
+    if (idx < size) {
+      const __m256i matrix256 = _mm256_set1_epi64x(static_cast<long long>(Octet::OctMulAffine[u]));
+      __m256i *ap256 = reinterpret_cast<__m256i *>(ap + idx);
+      _mm256_store_si256(ap256, _mm256_gf2p8affine_epi64_epi8(_mm256_load_si256(ap256), matrix256, 0));
+    }
+  }
+
+  static TD_FEC_TARGET_GFNI __attribute__((noinline)) void gf256_add_mul(void *a, const void *b, uint8 u,
+                                                                           size_t size) {
+    DCHECK(is_aligned_pointer(a));
+    DCHECK(is_aligned_pointer(b));
+    uint8 *ap = reinterpret_cast<uint8 *>(a);
+    const uint8 *bp = reinterpret_cast<const uint8 *>(b);
+    const __m512i matrix = _mm512_set1_epi64(static_cast<long long>(Octet::OctMulAffine[u]));
+
+    size_t idx = 0;
+    for (; idx + 64 <= size; idx += 64) {
+      __m512i prod = _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(bp + idx), matrix, 0);
+      _mm512_storeu_si512(ap + idx, _mm512_xor_si512(_mm512_loadu_si512(ap + idx), prod));
+    }
+    if (idx < size) {
+      const __m256i matrix256 = _mm256_set1_epi64x(static_cast<long long>(Octet::OctMulAffine[u]));
+      __m256i *ap256 = reinterpret_cast<__m256i *>(ap + idx);
+      __m256i prod = _mm256_gf2p8affine_epi64_epi8(_mm256_load_si256(reinterpret_cast<const __m256i *>(bp + idx)),
+                                                   matrix256, 0);
+      _mm256_store_si256(ap256, _mm256_xor_si256(_mm256_load_si256(ap256), prod));
+    }
+  }
+};
+#endif  // GFNI
+
+#if TD_FEC_SIMD_DISPATCH
+// Kernels of one of the Simd_* classes
+struct SimdKernels {
+  const char *name;
+  bool (*is_supported)();
+  void (*gf256_add)(void *a, const void *b, size_t size);
+  void (*gf256_mul)(void *a, uint8 u, size_t size);
+  void (*gf256_add_mul)(void *a, const void *b, uint8 u, size_t size);
+  void (*gf256_from_gf2)(void *a, const void *b, size_t size);
+};
+
+class Simd {
+ public:
+  static constexpr size_t alignment() {
+    return 32;
+  }
+
+  static std::string get_name() {
+    return get_kernels().name;
+  }
+  static bool is_aligned_pointer(const void *ptr) {
+    return ::td::is_aligned_pointer<alignment()>(ptr);
+  }
+
+  static void gf256_add(void *a, const void *b, size_t size) {
+    get_kernels().gf256_add(a, b, size);
+  }
+  static void gf256_mul(void *a, uint8 u, size_t size) {
+    get_kernels().gf256_mul(a, u, size);
+  }
+  static void gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+    get_kernels().gf256_add_mul(a, b, u, size);
+  }
+  static void gf256_from_gf2(void *a, const void *b, size_t size) {
+    get_kernels().gf256_from_gf2(a, b, size);
+  }
+
+  static const SimdKernels &get_kernels() {
+    auto kernels = kernels_.load(std::memory_order_relaxed);
+    if (unlikely(kernels == nullptr)) {
+      kernels = init_kernels();
+    }
+    return *kernels;
+  }
+  // kernels supported by the CPU, from the slowest to the fastest
+  static std::vector<const SimdKernels *> get_supported_kernels();
+  // returns false if kernels with such name are unknown or not supported by the CPU
+  static bool set_kernels(Slice name);
+
+ private:
+  static std::atomic<const SimdKernels *> kernels_;
+  static const SimdKernels *init_kernels();
+};
+#elif TD_GFNI
+using Simd = Simd_gfni;
+#elif TD_AVX512
+using Simd = Simd_avx512;
+#elif TD_AVX2
 using Simd = Simd_avx;
 #elif TD_SSE3
 using Simd = Simd_sse;
@@ -90,11 +90,26 @@ TEST(Fec, Simd) {
       }
     };
     run(td::Simd_null());
+#if TD_FEC_SIMD_DISPATCH
+    auto best_kernels = td::Simd::get_name();
+    for (auto kernels : td::Simd::get_supported_kernels()) {
+      CHECK(td::Simd::set_kernels(td::CSlice(kernels->name)));
+      run(td::Simd());
+    }
+    CHECK(td::Simd::set_kernels(best_kernels));
+#else
 #if TD_SSE3
     run(td::Simd_sse());
 #endif
 #if TD_AVX2
     run(td::Simd_avx());
+#endif
+#if TD_AVX512
+    run(td::Simd_avx512());
+#endif
+#if TD_GFNI
+    run(td::Simd_gfni());
+#endif
 #endif
     run(td::Simd());
   }
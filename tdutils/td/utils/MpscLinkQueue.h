@@ -28,6 +28,7 @@ class MpscLinkQueueImpl {
  public:
   class Node;
   class Reader;
+  class List;
 
   void push(Node *node) {
     node->next_ = head_.load(std::memory_order_relaxed);
@@ -40,6 +41,19 @@ class MpscLinkQueueImpl {
     head_.store(node, std::memory_order_relaxed);
   }
 
+  // pushes all nodes of the list with a single CAS, list becomes empty
+  void push(List &list) {
+    if (list.empty()) {
+      return;
+    }
+    list.tail_->next_ = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_strong(list.tail_->next_, list.head_, std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+    }
+    list.head_ = nullptr;
+    list.tail_ = nullptr;
+  }
+
   void pop_all(Reader &reader) {
     return reader.add(head_.exchange(nullptr, std::memory_order_acquire));
   }
@@ -53,6 +67,43 @@ class MpscLinkQueueImpl {
     Node *next_{nullptr};
   };
 
+  // Nodes prepared for push. Reader will return them in the order they were added
+  class List {
+   public:
+    void push_back(Node *node) {
+      node->next_ = head_;
+      if (!head_) {
+        tail_ = node;
+      }
+      head_ = node;
+    }
+    // returns nodes in reverse order, used to free nodes which were never pushed
+    Node *pop() {
+      auto old_head = head_;
+      if (head_) {
+        head_ = head_->next_;
+        if (!head_) {
+          tail_ = nullptr;
+        }
+      }
+      return old_head;
+    }
+    bool empty() const {
+      return head_ == nullptr;
+    }
+    template <class F>
+    void for_each(F &&f) {
+      for (auto it = head_; it != nullptr; it = it->next_) {
+        f(it);
+      }
+    }
+
+   private:
+    friend class MpscLinkQueueImpl;
+    Node *head_{nullptr};
+    Node *tail_{nullptr};
+  };
+
   class Reader {
    public:
     Node *read() {
@@ -117,6 +168,69 @@ class MpscLinkQueue {
   void push_unsafe(Node node) {
     impl_.push_unsafe(node.to_mpsc_link_queue_node());
   }
+
+  class List {
+   public:
+    List() = default;
+    List(const List &) = delete;
+    List &operator=(const List &) = delete;
+    List(List &&other) : impl_(other.impl_), size_(other.size_) {
+      other.impl_ = {};
+      other.size_ = 0;
+    }
+    List &operator=(List &&other) {
+      if (this != &other) {
+        clear();
+        impl_ = other.impl_;
+        size_ = other.size_;
+        other.impl_ = {};
+        other.size_ = 0;
+      }
+      return *this;
+    }
+    ~List() {
+      clear();
+    }
+
+    void push_back(Node node) {
+      impl_.push_back(node.to_mpsc_link_queue_node());
+      size_++;
+    }
+    size_t size() const {
+      return size_;
+    }
+    bool empty() const {
+      return size_ == 0;
+    }
+    // order is unspecified, the node must stay in the list
+    template <class F>
+    void for_each(F &&f) {
+      impl_.for_each([&f](MpscLinkQueueImpl::Node *node) {
+        auto value = Node::from_mpsc_link_queue_node(node);
+        f(value);
+        value.to_mpsc_link_queue_node();
+      });
+    }
+    void clear() {
+      while (auto node = impl_.pop()) {
+        Node::from_mpsc_link_queue_node(node);
+      }
+      size_ = 0;
+    }
+
+   private:
+    friend class MpscLinkQueue;
+
+    MpscLinkQueueImpl::List impl_;
+    size_t size_{0};
+  };
+
+  // all nodes of the list are pushed atomically
+  void push(List &list) {
+    impl_.push(list.impl_);
+    list.size_ = 0;
+  }
+
   class Reader {
    public:
     ~Reader() {
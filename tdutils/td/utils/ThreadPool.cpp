@@ -0,0 +1,123 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace td {
+
+struct ThreadPool::Job {
+  Job(size_t n, const std::function<void(size_t)> &f, size_t workers_n) : n(n), f(f), workers_left(workers_n) {
+  }
+
+  // returns the number of calls made
+  size_t run() {
+    size_t done = 0;
+    while (true) {
+      auto i = next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= n) {
+        break;
+      }
+      f(i);
+      done++;
+    }
+    return done;
+  }
+
+  size_t n;
+  const std::function<void(size_t)> &f;
+  std::atomic<size_t> next{0};
+  // guarded by the mutex of the pool
+  size_t workers_left;
+  size_t done{0};
+  std::condition_variable done_cond;
+};
+
+ThreadPool::ThreadPool(size_t threads_n) {
+  threads_.reserve(threads_n);
+  for (size_t i = 0; i < threads_n; i++) {
+    threads_.emplace_back([this] { run_worker(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closing_ = true;
+  }
+  cond_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::parallel_for(size_t n, size_t threads_n, const std::function<void(size_t)> &f) {
+  threads_n = std::min({threads_n, n, threads_.size() + 1});
+  if (threads_n <= 1) {
+    for (size_t i = 0; i < n; i++) {
+      f(i);
+    }
+    return;
+  }
+
+  auto job = std::make_shared<Job>(n, f, threads_n - 1);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(job);
+  }
+  cond_.notify_all();
+  auto done = job->run();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  finish_job(*job, done);
+  job->done_cond.wait(lock, [&] { return job->done == n; });
+}
+
+void ThreadPool::run_worker() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [&] { return closing_ || !jobs_.empty(); });
+    if (jobs_.empty()) {
+      return;
+    }
+    auto job = jobs_.front();
+    if (--job->workers_left == 0) {
+      jobs_.pop_front();
+    }
+    lock.unlock();
+    auto done = job->run();
+    lock.lock();
+    finish_job(*job, done);
+  }
+}
+
+void ThreadPool::finish_job(Job &job, size_t done) {
+  // all calls are taken when run() returns, so other workers have nothing to do here
+  auto it = std::find_if(jobs_.begin(), jobs_.end(), [&](const auto &other) { return other.get() == &job; });
+  if (it != jobs_.end()) {
+    jobs_.erase(it);
+  }
+  job.done += done;
+  if (job.done == job.n) {
+    job.done_cond.notify_all();
+  }
+}
+
+}  // namespace td
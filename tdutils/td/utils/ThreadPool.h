@@ -0,0 +1,64 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/port/thread.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace td {
+
+// Worker threads for data-parallel loops. The threads are started once and shared by all users of the pool:
+// parallel_for() may be called from several threads at once, and from inside another parallel_for().
+// Threads waiting for work or for other threads are blocked, not spinning.
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t threads_n);
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool();
+
+  // number of worker threads
+  size_t size() const {
+    return threads_.size();
+  }
+
+  // calls f(0), ..., f(n - 1) in the calling thread and in at most threads_n - 1 workers of the pool,
+  // returns when all the calls are finished
+  void parallel_for(size_t n, size_t threads_n, const std::function<void(size_t)> &f);
+
+ private:
+  struct Job;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::shared_ptr<Job>> jobs_;
+  bool closing_{false};
+  std::vector<td::thread> threads_;
+
+  void run_worker();
+  void finish_job(Job &job, size_t done);
+};
+
+}  // namespace td
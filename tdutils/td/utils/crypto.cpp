@@ -47,9 +47,17 @@
 #include "crc32c/crc32c.h"
 #endif
 
+#if TD_HAVE_OPENSSL && (TD_GCC || TD_CLANG) && defined(__x86_64__)
+#define TD_HAVE_SHA256_AVX2 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 #include <algorithm>
+#include <cstring>
 #include <mutex>
 #include <utility>
+#include <vector>
 
 namespace td {
 
@@ -401,6 +409,206 @@ string sha512(Slice data) {
   return result;
 }
 
+#if TD_HAVE_SHA256_AVX2
+namespace {
+const uint32 SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+const uint32 SHA256_H0[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                             0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+constexpr size_t SHA256_BATCH_LANES = 8;
+// longer messages are hashed one by one
+constexpr size_t SHA256_BATCH_MAX_BLOCKS = 16;
+
+bool sha256_batch_use_avx2() {
+  static const bool result = [] {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+      return false;
+    }
+    bool has_osxsave = (ecx & bit_OSXSAVE) != 0;
+    bool has_avx = (ecx & bit_AVX) != 0;
+    if (!has_osxsave || !has_avx) {
+      return false;
+    }
+    unsigned int xcr0_lo, xcr0_hi;
+    __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    if ((xcr0_lo & 6) != 6) {
+      return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+      return false;
+    }
+    return (ebx & (1u << 5)) != 0;
+  }();
+  return result;
+}
+
+#define TD_SHA256_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+// blocks[i] padded 64-byte blocks starting at data[i] are hashed into state[i]
+__attribute__((target("avx2"))) void sha256_x8_avx2(const uint8 *const data[SHA256_BATCH_LANES],
+                                                     const int32 blocks[SHA256_BATCH_LANES],
+                                                     uint32 state[SHA256_BATCH_LANES][8]) {
+  __m256i s[8];
+  for (int i = 0; i < 8; i++) {
+    s[i] = _mm256_set1_epi32(static_cast<int32>(SHA256_H0[i]));
+  }
+  const __m256i blocks_v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks));
+  int32 max_blocks = *std::max_element(blocks, blocks + SHA256_BATCH_LANES);
+
+  auto load_be32 = [](const uint8 *ptr) {
+    return static_cast<int32>((static_cast<uint32>(ptr[0]) << 24) | (static_cast<uint32>(ptr[1]) << 16) |
+                              (static_cast<uint32>(ptr[2]) << 8) | static_cast<uint32>(ptr[3]));
+  };
+
+  for (int32 block = 0; block < max_blocks; block++) {
+    const uint8 *ptr[SHA256_BATCH_LANES];
+    for (size_t lane = 0; lane < SHA256_BATCH_LANES; lane++) {
+      // finished lanes just hash their last block once more, the result is dropped below
+      ptr[lane] = data[lane] + 64 * std::max(std::min(block, blocks[lane] - 1), 0);
+    }
+    __m256i w[16];
+    for (int t = 0; t < 16; t++) {
+      w[t] = _mm256_set_epi32(load_be32(ptr[7] + 4 * t), load_be32(ptr[6] + 4 * t), load_be32(ptr[5] + 4 * t),
+                              load_be32(ptr[4] + 4 * t), load_be32(ptr[3] + 4 * t), load_be32(ptr[2] + 4 * t),
+                              load_be32(ptr[1] + 4 * t), load_be32(ptr[0] + 4 * t));
+    }
+
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int t = 0; t < 64; t++) {
+      if (t >= 16) {
+        __m256i w15 = w[(t - 15) & 15];
+        __m256i w2 = w[(t - 2) & 15];
+        __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(TD_SHA256_ROTR(w15, 7), TD_SHA256_ROTR(w15, 18)),
+                                      _mm256_srli_epi32(w15, 3));
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(TD_SHA256_ROTR(w2, 17), TD_SHA256_ROTR(w2, 19)),
+                                      _mm256_srli_epi32(w2, 10));
+        w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+      }
+      __m256i big_s1 =
+          _mm256_xor_si256(_mm256_xor_si256(TD_SHA256_ROTR(e, 6), TD_SHA256_ROTR(e, 11)), TD_SHA256_ROTR(e, 25));
+      __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+      __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, big_s1),
+                                    _mm256_add_epi32(_mm256_add_epi32(ch, w[t & 15]),
+                                                     _mm256_set1_epi32(static_cast<int32>(SHA256_K[t]))));
+      __m256i big_s0 =
+          _mm256_xor_si256(_mm256_xor_si256(TD_SHA256_ROTR(a, 2), TD_SHA256_ROTR(a, 13)), TD_SHA256_ROTR(a, 22));
+      __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+      __m256i t2 = _mm256_add_epi32(big_s0, maj);
+      h = g;
+      g = f;
+      f = e;
+      e = _mm256_add_epi32(d, t1);
+      d = c;
+      c = b;
+      b = a;
+      a = _mm256_add_epi32(t1, t2);
+    }
+
+    __m256i active = _mm256_cmpgt_epi32(blocks_v, _mm256_set1_epi32(block));
+    __m256i x[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; i++) {
+      s[i] = _mm256_blendv_epi8(s[i], _mm256_add_epi32(s[i], x[i]), active);
+    }
+  }
+
+  alignas(32) uint32 words[8][SHA256_BATCH_LANES];
+  for (int i = 0; i < 8; i++) {
+    _mm256_store_si256(reinterpret_cast<__m256i *>(words[i]), s[i]);
+  }
+  for (size_t lane = 0; lane < SHA256_BATCH_LANES; lane++) {
+    for (int i = 0; i < 8; i++) {
+      state[lane][i] = words[i][lane];
+    }
+  }
+}
+
+#undef TD_SHA256_ROTR
+
+size_t sha256_padded_blocks(size_t size) {
+  return (size + 9 + 63) / 64;
+}
+
+void sha256_batch_avx2(Span<Slice> data, Span<MutableSlice> output) {
+  // messages with the same number of blocks are hashed together
+  std::vector<size_t> order;
+  order.reserve(data.size());
+  for (size_t blocks = 1; blocks <= SHA256_BATCH_MAX_BLOCKS; blocks++) {
+    for (size_t i = 0; i < data.size(); i++) {
+      if (sha256_padded_blocks(data[i].size()) == blocks) {
+        order.push_back(i);
+      }
+    }
+  }
+  for (size_t i = 0; i < data.size(); i++) {
+    if (sha256_padded_blocks(data[i].size()) > SHA256_BATCH_MAX_BLOCKS) {
+      sha256(data[i], output[i]);
+    }
+  }
+
+  std::vector<uint8> buffer(SHA256_BATCH_LANES * SHA256_BATCH_MAX_BLOCKS * 64);
+  for (size_t group = 0; group < order.size(); group += SHA256_BATCH_LANES) {
+    size_t lanes = std::min(SHA256_BATCH_LANES, order.size() - group);
+    const uint8 *lane_data[SHA256_BATCH_LANES];
+    int32 lane_blocks[SHA256_BATCH_LANES];
+    for (size_t lane = 0; lane < SHA256_BATCH_LANES; lane++) {
+      auto *padded = buffer.data() + lane * SHA256_BATCH_MAX_BLOCKS * 64;
+      lane_data[lane] = padded;
+      if (lane >= lanes) {
+        lane_blocks[lane] = 0;
+        continue;
+      }
+      Slice message = data[order[group + lane]];
+      auto blocks = sha256_padded_blocks(message.size());
+      lane_blocks[lane] = static_cast<int32>(blocks);
+      std::memcpy(padded, message.data(), message.size());
+      std::memset(padded + message.size(), 0, blocks * 64 - message.size());
+      padded[message.size()] = 0x80;
+      uint64 bit_size = static_cast<uint64>(message.size()) * 8;
+      for (int i = 0; i < 8; i++) {
+        padded[blocks * 64 - 1 - i] = static_cast<uint8>(bit_size >> (8 * i));
+      }
+    }
+
+    uint32 state[SHA256_BATCH_LANES][8];
+    sha256_x8_avx2(lane_data, lane_blocks, state);
+
+    for (size_t lane = 0; lane < lanes; lane++) {
+      auto dest = output[order[group + lane]];
+      CHECK(dest.size() >= 32);
+      for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 4; j++) {
+          dest[4 * i + j] = static_cast<char>(state[lane][i] >> (24 - 8 * j));
+        }
+      }
+    }
+  }
+}
+}  // namespace
+#endif
+
+void sha256_batch(Span<Slice> data, Span<MutableSlice> output) {
+  CHECK(data.size() == output.size());
+#if TD_HAVE_SHA256_AVX2
+  if (data.size() >= SHA256_BATCH_LANES / 2 && sha256_batch_use_avx2()) {
+    sha256_batch_avx2(data, output);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < data.size(); i++) {
+    sha256(data[i], output[i]);
+  }
+}
+
 class Sha256State::Impl {
  public:
   SHA256_CTX ctx_;
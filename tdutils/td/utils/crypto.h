@@ -22,6 +22,7 @@
 #include "td/utils/common.h"
 #include "td/utils/Slice.h"
 #include "td/utils/SharedSlice.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 
 namespace td {
@@ -86,6 +87,11 @@ void sha512(Slice data, MutableSlice output);
 
 string sha256(Slice data) TD_WARN_UNUSED_RESULT;
 
+// computes sha256 of each data[i] into output[i]
+// short messages are hashed 8 at a time by a multi-lane AVX2 kernel if the CPU supports it,
+// otherwise this is the same as calling sha256 for each message
+void sha256_batch(Span<Slice> data, Span<MutableSlice> output);
+
 string sha512(Slice data) TD_WARN_UNUSED_RESULT;
 
 class Sha256State {
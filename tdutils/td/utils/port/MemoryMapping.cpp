@@ -37,6 +37,16 @@ namespace td {
 class MemoryMapping::Impl {
  public:
   Impl(MutableSlice data, int64 offset) : data_(data), offset_(offset) {
+  }
+  Impl(const Impl &other) = delete;
+  Impl &operator=(const Impl &other) = delete;
+  ~Impl() {
+#if !TD_WINDOWS
+    if (munmap(data_.data(), data_.size()) != 0) {
+      auto error = OS_ERROR("munmap call failed");
+      LOG(ERROR) << error;
+    }
+#endif
   }
   Slice as_slice() const {
     return data_.substr(narrow_cast<size_t>(offset_));
@@ -44,10 +54,57 @@ class MemoryMapping::Impl {
   MutableSlice as_mutable_slice() const {
     return {};
   }
+  Status advise(Advice advice, int64 offset, int64 size) const {
+#if TD_WINDOWS
+    return Status::OK();
+#else
+    auto slice = as_slice();
+    if (offset < 0 || static_cast<uint64>(offset) > slice.size()) {
+      return Status::Error(PSLICE() << "Can't advise memory mapping: invalid offset " << offset);
+    }
+    slice.remove_prefix(narrow_cast<size_t>(offset));
+    if (size >= 0) {
+      slice.truncate(narrow_cast<size_t>(size));
+    }
+    if (slice.empty()) {
+      return Status::OK();
+    }
+    // madvise needs a page-aligned address, the mapping itself is page-aligned
+    auto begin = static_cast<size_t>(slice.begin() - data_.begin());
+    auto fixed_begin = begin / page_size() * page_size();
+    int native_advice = MADV_NORMAL;
+    switch (advice) {
+      case Advice::Normal:
+        native_advice = MADV_NORMAL;
+        break;
+      case Advice::Random:
+        native_advice = MADV_RANDOM;
+        break;
+      case Advice::Sequential:
+        native_advice = MADV_SEQUENTIAL;
+        break;
+      case Advice::WillNeed:
+        native_advice = MADV_WILLNEED;
+        break;
+      case Advice::DontNeed:
+        native_advice = MADV_DONTNEED;
+        break;
+    }
+    if (madvise(data_.data() + fixed_begin, begin + slice.size() - fixed_begin, native_advice) != 0) {
+      return OS_ERROR("madvise call failed");
+    }
+    return Status::OK();
+#endif
+  }
 
  private:
   MutableSlice data_;
   int64 offset_;
+
+  static size_t page_size() {
+    static size_t res = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return res;
+  }
 };
 
 static Result<int64> get_page_size() {
@@ -87,7 +144,11 @@ Result<MemoryMapping> MemoryMapping::create_from_file(const FileFd &file_fd, con
   if (options.size < 0) {
     end = stat.size_;
   } else {
-    end = begin + stat.size_;
+    end = begin + options.size;
+  }
+  if (end > stat.size_) {
+    return Status::Error(PSLICE() << "Can't create memory mapping: range end " << end << " is beyond file size "
+                                  << stat.size_);
   }
 
   TRY_RESULT(page_size, get_page_size());
@@ -120,4 +181,8 @@ MutableSlice MemoryMapping::as_mutable_slice() {
   return impl_->as_mutable_slice();
 }
 
+Status MemoryMapping::advise(Advice advice, int64 offset, int64 size) const {
+  return impl_->advise(advice, offset, size);
+}
+
 }  // namespace td
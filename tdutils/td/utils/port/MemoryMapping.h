@@ -43,12 +43,18 @@ class MemoryMapping {
     }
   };
 
+  // expected access pattern of the mapped memory, passed to madvise
+  enum class Advice : int32 { Normal, Random, Sequential, WillNeed, DontNeed };
+
   static Result<MemoryMapping> create_anonymous(const Options &options = {});
   static Result<MemoryMapping> create_from_file(const FileFd &file, const Options &options = {});
 
   Slice as_slice() const;
   MutableSlice as_mutable_slice();  // returns empty slice if memory is read-only
 
+  // applies advice to the part of the mapping [offset, offset + size), or to the whole mapping if size < 0
+  Status advise(Advice advice, int64 offset = 0, int64 size = -1) const;
+
   MemoryMapping(const MemoryMapping &other) = delete;
   const MemoryMapping &operator=(const MemoryMapping &other) = delete;
   MemoryMapping(MemoryMapping &&other);
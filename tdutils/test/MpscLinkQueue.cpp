@@ -87,6 +87,38 @@ TEST(MpscLinkQueue, one_thread) {
   }
 }
 
+TEST(MpscLinkQueue, push_list) {
+  td::MpscLinkQueue<QueueNode> queue;
+  td::MpscLinkQueue<QueueNode>::Reader reader;
+
+  queue.push(create_node(1));
+  td::MpscLinkQueue<QueueNode>::List list;
+  queue.push(list);
+  list.push_back(create_node(2));
+  list.push_back(create_node(3));
+  list.push_back(create_node(4));
+  CHECK(list.size() == 3);
+  queue.push(list);
+  CHECK(list.empty());
+  queue.push(create_node(5));
+
+  {
+    td::MpscLinkQueue<QueueNode>::List unused;
+    unused.push_back(create_node(6));
+    unused.push_back(create_node(7));
+    auto moved = std::move(unused);
+    CHECK(unused.empty());
+    CHECK(moved.size() == 2);
+  }
+
+  queue.pop_all(reader);
+  std::vector<int> v;
+  while (auto node = reader.read()) {
+    v.push_back(node.value().value());
+  }
+  LOG_CHECK((v == std::vector<int>{1, 2, 3, 4, 5})) << td::format::as_array(v);
+}
+
 #if !TD_THREAD_UNSUPPORTED
 TEST(MpscLinkQueue, multi_thread) {
   td::MpscLinkQueue<QueueNode> queue;
@@ -0,0 +1,55 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/tests.h"
+#include "td/utils/ThreadPool.h"
+
+#include <atomic>
+
+#if !TD_THREAD_UNSUPPORTED
+TEST(ThreadPool, parallel_for) {
+  td::ThreadPool pool(3);
+  for (size_t threads_n : {1, 2, 4, 10}) {
+    std::vector<int> calls(10000);
+    pool.parallel_for(calls.size(), threads_n, [&](size_t i) { calls[i]++; });
+    for (auto x : calls) {
+      ASSERT_EQ(1, x);
+    }
+  }
+  pool.parallel_for(0, 4, [&](size_t i) { UNREACHABLE(); });
+}
+
+TEST(ThreadPool, concurrent_and_nested) {
+  td::ThreadPool pool(4);
+  std::atomic<size_t> sum{0};
+  std::vector<td::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&] {
+      for (int round = 0; round < 100; round++) {
+        pool.parallel_for(10, 3, [&](size_t i) {
+          pool.parallel_for(10, 3, [&](size_t j) { sum += i * 10 + j; });
+        });
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(4u * 100u * (99u * 100u / 2), sum.load());
+}
+#endif
@@ -21,6 +21,7 @@
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
 #include "td/utils/logging.h"
+#include "td/utils/Random.h"
 #include "td/utils/Slice.h"
 #include "td/utils/tests.h"
 #include "td/utils/UInt.h"
@@ -152,6 +153,24 @@ TEST(Crypto, sha256) {
   }
 }
 
+TEST(Crypto, sha256_batch) {
+  for (int sizes_limit : {64, 300, 2000}) {
+    for (int n : {1, 3, 8, 17, 100}) {
+      td::vector<td::string> messages(n);
+      for (auto &message : messages) {
+        message = td::rand_string('a', 'z', td::Random::fast(0, sizes_limit));
+      }
+      td::vector<td::Slice> data(messages.begin(), messages.end());
+      td::vector<td::string> results(n, td::string(32, '\0'));
+      td::vector<td::MutableSlice> output(results.begin(), results.end());
+      td::sha256_batch(data, output);
+      for (int i = 0; i < n; i++) {
+        ASSERT_EQ(td::sha256(messages[i]), results[i]);
+      }
+    }
+  }
+}
+
 TEST(Crypto, md5) {
   td::vector<td::Slice> answers{
       "1B2M2Y8AsgTpgAmY7PhCfg==", "xMpCOKC5I4INzFCab3WEmw==", "vwBninYbDRkgk+uA7GMiIQ==", "dwfWrk4CfHDuoqk1wilvIQ=="};
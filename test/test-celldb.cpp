@@ -0,0 +1,188 @@
+/*
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission
+    to link the code of portions of this program with the OpenSSL library.
+    You must obey the GNU General Public License in all respects for all
+    of the code used other than OpenSSL. If you modify file(s) with this
+    exception, you may extend this exception to your version of the file(s),
+    but you are not obligated to do so. If you do not wish to do so, delete this
+    exception statement from your version. If you delete this exception statement
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/actor/actor.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/signals.h"
+#include "td/utils/Random.h"
+#include "vm/cells/CellBuilder.h"
+#include "validator/db/celldb.hpp"
+
+#include <map>
+
+// Checks the CellDb reader pool: concurrent loads of one cell share a single read,
+// misses fall back to CellDbIn, and prepare_stats reports the counters
+class CellDbTester : public td::actor::Actor {
+ public:
+  CellDbTester(std::string db_root, td::uint32 read_threads, td::Promise<td::Unit> promise)
+      : db_root_(std::move(db_root)), read_threads_(read_threads), promise_(std::move(promise)) {
+  }
+
+  void start_up() override {
+    auto opts = ton::validator::ValidatorManagerOptions::create(ton::BlockIdExt{}, ton::BlockIdExt{});
+    opts.write().set_celldb_read_threads(read_threads_);
+    cell_db_ = td::actor::create_actor<ton::validator::CellDb>(
+        "celldb", td::actor::ActorId<ton::validator::RootDb>{}, PSTRING() << db_root_ << "/celldb" << read_threads_,
+        std::move(opts));
+    for (td::uint32 i = 0; i < 2; i++) {
+      vm::CellBuilder cb;
+      cb.store_long(td::Random::fast_uint32(), 32).store_long(i, 32);
+      cells_.push_back(cb.finalize());
+    }
+    store_next();
+  }
+
+ private:
+  std::string db_root_;
+  td::uint32 read_threads_;
+  td::Promise<td::Unit> promise_;
+
+  td::actor::ActorOwn<ton::validator::CellDb> cell_db_;
+  std::vector<td::Ref<vm::Cell>> cells_;
+  size_t stored_ = 0;
+  size_t pending_ = 0;
+  int round_ = 0;
+
+  void store_next() {
+    if (stored_ == cells_.size()) {
+      run_loads();
+      return;
+    }
+    ton::BlockIdExt block_id{ton::basechainId, ton::shardIdAll, static_cast<ton::BlockSeqno>(stored_ + 1),
+                             cells_[stored_]->get_hash().bits(), cells_[stored_]->get_hash().bits()};
+    td::actor::send_closure(cell_db_, &ton::validator::CellDb::store_cell, block_id, cells_[stored_],
+                            [SelfId = actor_id(this)](td::Result<td::Ref<vm::DataCell>> R) {
+                              R.ensure();
+                              td::actor::send_closure(SelfId, &CellDbTester::stored);
+                            });
+  }
+
+  void stored() {
+    stored_++;
+    store_next();
+  }
+
+  void load(ton::RootHash hash, td::Ref<vm::Cell> expected) {
+    pending_++;
+    td::actor::send_closure(cell_db_, &ton::validator::CellDb::load_cell, hash,
+                            [SelfId = actor_id(this), expected](td::Result<td::Ref<vm::DataCell>> R) {
+                              if (expected.is_null()) {
+                                CHECK(R.is_error());
+                              } else {
+                                CHECK(R.is_ok());
+                                CHECK(R.ok()->get_hash() == expected->get_hash());
+                              }
+                              td::actor::send_closure(SelfId, &CellDbTester::loaded);
+                            });
+  }
+
+  void run_loads() {
+    if (round_ == 0) {
+      // all requests are queued before CellDb runs, so the copies of the first one are deduplicated
+      for (int i = 0; i < 5; i++) {
+        load(cells_[0]->get_hash().bits(), cells_[0]);
+      }
+      load(cells_[1]->get_hash().bits(), cells_[1]);
+      ton::RootHash missing;
+      td::Random::secure_bytes(missing.as_slice());
+      load(missing, {});
+    } else {
+      // a finished read is not shared with later requests
+      load(cells_[0]->get_hash().bits(), cells_[0]);
+    }
+  }
+
+  void loaded() {
+    CHECK(pending_ > 0);
+    if (--pending_ > 0) {
+      return;
+    }
+    td::actor::send_closure(cell_db_, &ton::validator::CellDb::prepare_stats,
+                            [SelfId = actor_id(this)](td::Result<std::vector<std::pair<std::string, std::string>>> R) {
+                              R.ensure();
+                              td::actor::send_closure(SelfId, &CellDbTester::got_stats, R.move_as_ok());
+                            });
+  }
+
+  void got_stats(std::vector<std::pair<std::string, std::string>> vec) {
+    std::map<std::string, std::string> stats(vec.begin(), vec.end());
+    CHECK(stats["readers"] == td::to_string(read_threads_));
+    if (read_threads_ == 0) {
+      CHECK(stats.count("reads") == 0);
+    } else if (round_ == 0) {
+      CHECK(stats["reads"] == "3");
+      CHECK(stats["deduplicatedreads"] == "4");
+      CHECK(stats["failedreads"] == "1");
+      CHECK(stats["queuedepth"] == "0");
+    } else {
+      CHECK(stats["reads"] == "4");
+      CHECK(stats["deduplicatedreads"] == "4");
+      CHECK(stats["failedreads"] == "1");
+      CHECK(stats["queuedepth"] == "0");
+    }
+    LOG(INFO) << "read_threads=" << read_threads_ << " round " << round_ << " ok";
+    if (round_++ == 0) {
+      run_loads();
+      return;
+    }
+    promise_.set_value(td::Unit());
+    stop();
+  }
+};
+
+int main() {
+  SET_VERBOSITY_LEVEL(verbosity_INFO);
+  td::set_default_failure_signal_handler().ensure();
+
+  std::string db_root_ = "tmp-celldb";
+
+  // no cpu threads: all actors share one thread, which makes the order of messages deterministic
+  td::actor::Scheduler scheduler({0});
+  td::rmrf(db_root_).ignore();
+  td::mkdir(db_root_).ensure();
+
+  for (td::uint32 read_threads : {0, 1, 2}) {
+    bool done = false;
+    td::actor::ActorOwn<CellDbTester> tester;
+    scheduler.run_in_context([&] {
+      tester = td::actor::create_actor<CellDbTester>(
+          "tester", db_root_, read_threads, td::PromiseCreator::lambda([&](td::Result<td::Unit> R) {
+            R.ensure();
+            done = true;
+          }));
+    });
+    auto t = td::Timestamp::in(5.0);
+    while (!done && scheduler.run(0.1)) {
+      CHECK(!t.is_in_past());
+    }
+    scheduler.run_in_context([&] { tester.reset(); });
+    scheduler.run(0.1);
+  }
+
+  td::rmrf(db_root_).ensure();
+  return 0;
+}
@@ -0,0 +1,158 @@
+/*
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission
+    to link the code of portions of this program with the OpenSSL library.
+    You must obey the GNU General Public License in all respects for all
+    of the code used other than OpenSSL. If you modify file(s) with this
+    exception, you may extend this exception to your version of the file(s),
+    but you are not obligated to do so. If you do not wish to do so, delete this
+    exception statement from your version. If you delete this exception statement
+    from all source files in the program, then also delete it here.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "validator/impl/collator-impl.h"
+#include "block/block-parse.h"
+#include "vm/cells/UsageCell.h"
+#include "td/utils/port/signals.h"
+
+namespace ton {
+
+namespace validator {
+
+// Runs the transactions of a few inbound messages through the collator, once precomputed in a worker thread and once
+// created one by one, and checks that both give the same transactions and account states
+class CollatorTest {
+ public:
+  static constexpr ton::LogicalTime start_lt = 2000;
+
+  static ton::StdSmcAddress make_addr(unsigned char first_byte) {
+    ton::StdSmcAddress addr = ton::StdSmcAddress::zero();
+    addr.as_slice()[0] = first_byte;
+    return addr;
+  }
+
+  // uninitialized accounts, so that the transactions only credit the value of the messages
+  static Ref<vm::Cell> make_accounts(const std::vector<ton::StdSmcAddress>& addrs) {
+    vm::AugmentedDictionary dict{256, block::tlb::aug_ShardAccounts};
+    for (const auto& addr : addrs) {
+      vm::CellBuilder acc;
+      CHECK(acc.store_long_bool(1, 1)                                                 // account$1
+            && acc.store_long_bool(4, 3)                                              // addr_std$10 anycast:nothing
+            && acc.store_long_bool(ton::basechainId, 8) && acc.store_bits_bool(addr)  // workchain_id address
+            && acc.store_zeroes_bool(9) && acc.store_long_bool(0, 32)                 // used:StorageUsed last_paid
+            && acc.store_long_bool(0, 1)                                              // due_payment:nothing
+            && acc.store_long_bool(1001, 64)                                          // last_trans_lt (end)
+            && block::tlb::t_Grams.store_long(acc, 1000000000)                        // balance:grams
+            && acc.store_long_bool(0, 1)                                              // other:empty
+            && acc.store_long_bool(0, 2));                                            // account_uninit$00
+      vm::CellBuilder cb;
+      CHECK(cb.store_ref_bool(acc.finalize()) && cb.store_zeroes_bool(256) && cb.store_long_bool(1000, 64));
+      CHECK(dict.set_builder(addr, cb));
+    }
+    vm::CellBuilder cb;
+    CHECK(cb.append_cellslice_bool(dict.get_root()));
+    return cb.finalize();
+  }
+
+  static Ref<vm::Cell> make_msg(const ton::StdSmcAddress& dest, td::uint64 value, ton::LogicalTime created_lt) {
+    vm::CellBuilder cb;
+    // the sender is in another shard
+    CHECK(cb.store_long_bool(0, 1)                                                 // int_msg_info$0
+          && cb.store_long_bool(4, 3)                                              // ihr_disabled bounce bounced
+          && cb.store_long_bool(4, 3) && cb.store_long_bool(ton::basechainId, 8)  // src:addr_std$10 anycast:nothing
+          && cb.store_bits_bool(make_addr(0xff))                                   // address
+          && cb.store_long_bool(4, 3) && cb.store_long_bool(ton::basechainId, 8)  // dest:addr_std$10 anycast:nothing
+          && cb.store_bits_bool(dest)                                              // address
+          && block::tlb::t_Grams.store_long(cb, value) && cb.store_long_bool(0, 1)  // value:CurrencyCollection
+          && block::tlb::t_Grams.store_long(cb, 0)                                  // ihr_fee
+          && block::tlb::t_Grams.store_long(cb, 0)                                  // fwd_fee
+          && cb.store_long_bool(created_lt, 64) && cb.store_long_bool(1600000000, 32)  // created_lt created_at
+          && cb.store_long_bool(0, 1) && cb.store_long_bool(0, 1));                    // init:nothing body:(left$0 _)
+    return cb.finalize();
+  }
+
+  static std::unique_ptr<Collator> make_collator(Ref<vm::Cell> accounts, bool parallel) {
+    ShardIdFull shard{ton::basechainId, 0x4000000000000000ULL};  // accounts starting with bit 0
+    auto collator = std::make_unique<Collator>(shard, false, 0, BlockIdExt{}, std::vector<BlockIdExt>{},
+                                               Ref<ValidatorSet>{}, Ed25519_PublicKey{td::Bits256::zero()},
+                                               td::actor::ActorId<ValidatorManager>{}, td::Timestamp::in(10.0),
+                                               td::PromiseCreator::lambda([](td::Result<BlockCandidate>) {}));
+    auto& c = *collator;
+    // the thread pool of the collator depends on the number of cpus, a single worker thread is enough here
+    c.thread_pool_ = parallel ? std::make_shared<td::ThreadPool>(1) : nullptr;
+    c.threads_n_ = parallel ? 2 : 1;
+    c.now_ = 1600000010;
+    c.start_lt = c.max_lt = start_lt;
+    c.state_usage_tree_ = std::make_shared<vm::CellUsageTree>();
+    c.account_dict = std::make_unique<vm::AugmentedDictionary>(
+        vm::load_cell_slice_ref(vm::UsageCell::create(std::move(accounts), c.state_usage_tree_->root_ptr())), 256,
+        block::tlb::aug_ShardAccounts);
+    c.compute_phase_cfg_.gas_price = c.compute_phase_cfg_.gas_limit = c.compute_phase_cfg_.gas_credit = 1000;
+    c.compute_phase_cfg_.compute_threshold();
+    c.block_limits_ = std::make_unique<block::BlockLimits>();
+    c.block_limits_->bytes = c.block_limits_->gas = c.block_limits_->lt_delta = block::ParamLimits{1000, 2000, 3000};
+    c.block_limits_->start_lt = start_lt;
+    c.block_limits_->usage_tree = c.state_usage_tree_.get();
+    c.block_limit_status_ = std::make_unique<block::BlockLimitStatus>(*c.block_limits_);
+    return collator;
+  }
+
+  static std::vector<std::string> collate(Ref<vm::Cell> accounts, const std::vector<Ref<vm::Cell>>& msgs,
+                                          bool parallel) {
+    auto collator = make_collator(std::move(accounts), parallel);
+    auto& c = *collator;
+    CHECK(c.precompute_ordinary_transactions(msgs, start_lt, false) == parallel);
+    CHECK(c.precomputed_trans_.size() == (parallel ? msgs.size() : 0));
+    std::vector<std::string> res;
+    for (const auto& msg : msgs) {
+      // the precomputed transaction is committed, and freed together with the account state it has been created for
+      auto trans_root = c.create_ordinary_transaction(msg);
+      CHECK(trans_root.not_null());
+      res.push_back(trans_root->get_hash().to_hex());
+    }
+    CHECK(c.precomputed_trans_.empty());
+    for (auto& z : c.accounts) {
+      res.push_back(PSTRING() << z.first.to_hex() << " " << z.second->last_trans_end_lt_ << " "
+                              << z.second->total_state->get_hash().to_hex());
+    }
+    return res;
+  }
+
+  static void run() {
+    auto a = make_addr(0x12), b = make_addr(0x34);
+    auto accounts = make_accounts({a, b});
+    // two transactions of one account, which are precomputed one after another, and one of the other account
+    std::vector<Ref<vm::Cell>> msgs{make_msg(a, 1000, 1500), make_msg(b, 2000, 1501), make_msg(a, 3000, 1502)};
+    auto one_by_one = collate(accounts, msgs, false);
+    auto precomputed = collate(accounts, msgs, true);
+    CHECK(one_by_one.size() == msgs.size() + 2);
+    CHECK(one_by_one == precomputed);
+  }
+};
+
+}  // namespace validator
+
+}  // namespace ton
+
+int main() {
+  SET_VERBOSITY_LEVEL(verbosity_INFO);
+  td::set_default_failure_signal_handler().ensure();
+  ton::validator::CollatorTest::run();
+  LOG(INFO) << "ok";
+  return 0;
+}
@@ -45,6 +45,7 @@
 
 #include "validator/fabric.h"
 #include "validator/impl/collator.h"
+#include "validator/impl/validate-query.hpp"
 #include "crypto/vm/cp0.h"
 #include "crypto/block/block-db.h"
 
@@ -84,6 +85,8 @@ class TestNode : public td::actor::Actor {
   bool need_save_file_{false};
   bool tdescr_save_{false};
   std::string tdescr_pfx_;
+  td::uint32 collator_threads_{1};
+  td::uint32 validate_threads_{1};
   ton::BlockIdExt shard_top_block_id_;
 
   ton::ShardIdFull shard_{ton::masterchainId, ton::shardIdAll};
@@ -112,6 +115,12 @@ class TestNode : public td::actor::Actor {
   void set_collator_flags(int flags) {
     ton::collator_settings |= flags;
   }
+  void set_collator_threads(td::uint32 threads) {
+    collator_threads_ = threads;
+  }
+  void set_validate_threads(td::uint32 threads) {
+    validate_threads_ = threads;
+  }
   void start_up() override {
   }
   void alarm() override {
@@ -231,6 +240,8 @@ class TestNode : public td::actor::Actor {
         ton::BlockIdExt{ton::masterchainId, ton::shardIdAll, 0, zero_id_.root_hash, zero_id_.file_hash},
         ton::BlockIdExt{ton::masterchainId, ton::shardIdAll, 0, zero_id_.root_hash, zero_id_.file_hash});
     opts.write().set_initial_sync_disabled(true);
+    opts.write().set_collator_threads(collator_threads_);
+    opts.write().set_validate_threads(validate_threads_);
     validator_manager_ = ton::validator::ValidatorManagerDiskFactory::create(ton::PublicKeyHash::zero(), opts, shard_,
                                                                              shard_top_block_id_, db_root_);
     for (auto &msg : ext_msgs_) {
@@ -291,7 +302,7 @@ class TestNode : public td::actor::Actor {
                                td::Promise<td::BufferSlice> promise) override {
       }
       void download_persistent_state(ton::BlockIdExt block_id, ton::BlockIdExt masterchain_block_id,
-                                     td::uint32 priority, td::Timestamp timeout,
+                                     td::uint32 priority, std::string tmp_dir, td::Timestamp timeout,
                                      td::Promise<td::BufferSlice> promise) override {
       }
       void download_block_proof(ton::BlockIdExt block_id, td::uint32 priority, td::Timestamp timeout,
@@ -411,6 +422,29 @@ int main(int argc, char *argv[]) {
     td::actor::send_closure(x, &TestNode::set_collator_flags, 2);
     return td::Status::OK();
   });
+  p.add_option('t', "threads",
+               "execute transactions of different accounts in <threads> parallel threads, then collate the block "
+               "in a single thread as well and check that the result is the same",
+               [&](td::Slice arg) {
+                 TRY_RESULT(threads, td::to_integer_safe<td::uint32>(arg));
+                 if (threads < 1 || threads > 256) {
+                   return td::Status::Error("number of threads must be in range 1..256");
+                 }
+                 td::actor::send_closure(x, &TestNode::set_collator_threads, threads);
+                 return td::Status::OK();
+               });
+  p.add_option('V', "validate-threads",
+               "check transactions of different accounts in <threads> parallel threads when validating the new block, "
+               "then check them sequentially as well and report both timings",
+               [&](td::Slice arg) {
+                 TRY_RESULT(threads, td::to_integer_safe<td::uint32>(arg));
+                 if (threads < 1 || threads > 256) {
+                   return td::Status::Error("number of threads must be in range 1..256");
+                 }
+                 td::actor::send_closure(x, &TestNode::set_validate_threads, threads);
+                 ton::validate_settings |= 1;
+                 return td::Status::OK();
+               });
   p.add_option('s', "save-top-descr", "saves generated shard top block description into files with specified prefix",
                [&](td::Slice arg) {
                  td::actor::send_closure(x, &TestNode::set_top_descr_prefix, arg.str());
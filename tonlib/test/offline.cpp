@@ -28,18 +28,26 @@
 #include "tonlib/utils.h"
 #include "tonlib/TonlibClient.h"
 #include "tonlib/Client.h"
+#include "tonlib/ExtClientPool.h"
+#include "tonlib/VerifiedCache.h"
 
 #include "auto/tl/ton_api_json.h"
 #include "auto/tl/tonlib_api_json.h"
+#include "auto/tl/lite_api.h"
+#include "tl-utils/lite-utils.hpp"
 
 #include "td/utils/benchmark.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/optional.h"
 #include "td/utils/overloaded.h"
+#include "td/utils/port/FileFd.h"
 #include "td/utils/port/path.h"
 #include "td/utils/PathView.h"
+#include "td/utils/ScopeGuard.h"
 #include "td/utils/tests.h"
 
+#include <deque>
+
 // KeyManager
 #include "tonlib/keys/bip39.h"
 #include "tonlib/keys/DecryptedKey.h"
@@ -655,3 +663,147 @@ TEST(Tonlib, ConfigCache) {
                         make_object<tonlib_api::config>(testnet3, "testnet2", true, false)))
       .ensure_error();
 }
+
+TEST(Tonlib, ExtClientPool) {
+  class FakeLiteServer : public ton::adnl::AdnlExtClient {
+   public:
+    FakeLiteServer(double delay, int *queries_count) : delay_(delay), queries_count_(queries_count) {
+    }
+    void check_ready(td::Promise<td::Unit> promise) override {
+      promise.set_value(td::Unit());
+    }
+    void send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                    td::Promise<td::BufferSlice> promise) override {
+      ++*queries_count_;
+      auto at = td::Timestamp::in(delay_);
+      answers_.emplace_back(at, std::move(promise));
+      alarm_timestamp().relax(at);
+    }
+    void alarm() override {
+      while (!answers_.empty() && answers_.front().first.is_in_past()) {
+        answers_.front().second.set_value(ton::create_serialize_tl_object<ton::lite_api::liteServer_currentTime>(0));
+        answers_.pop_front();
+      }
+      if (!answers_.empty()) {
+        alarm_timestamp() = answers_.front().first;
+      }
+    }
+
+   private:
+    double delay_;
+    int *queries_count_;
+    std::deque<std::pair<td::Timestamp, td::Promise<td::BufferSlice>>> answers_;
+  };
+
+  int slow_queries = 0;
+  int fast_queries = 0;
+  int answers = 0;
+  constexpr int total_queries = 20;
+  td::actor::Scheduler scheduler({1});
+  std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> servers;
+  td::actor::ActorOwn<ton::adnl::AdnlExtClient> pool;
+  scheduler.run_in_context([&] {
+    servers.push_back(td::actor::create_actor<FakeLiteServer>("slow", 1000.0, &slow_queries));
+    servers.push_back(td::actor::create_actor<FakeLiteServer>("fast", 0.01, &fast_queries));
+    tonlib::ExtClientPool::Options options;
+    options.hedge_queries = true;
+    options.default_hedge_delay = 0.1;
+    pool = tonlib::ExtClientPool::create(std::move(servers), options);
+    auto query = ton::serialize_tl_object(
+        ton::create_tl_object<ton::lite_api::liteServer_query>(
+            ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_getTime>(), true)),
+        true);
+    for (int i = 0; i < total_queries; i++) {
+      td::actor::send_closure(pool, &ton::adnl::AdnlExtClient::send_query, "query", query.clone(),
+                              td::Timestamp::in(10.0), [&](td::Result<td::BufferSlice> R) {
+                                R.ensure();
+                                if (++answers == total_queries) {
+                                  pool.reset();
+                                  td::actor::SchedulerContext::get()->stop();
+                                }
+                              });
+    }
+  });
+  auto start = td::Time::now();
+  scheduler.run();
+  ASSERT_EQ(total_queries, answers);
+  // every query sent to the slow server first is answered by the fast one after the hedging delay
+  ASSERT_TRUE(td::Time::now() - start < 5);
+  ASSERT_EQ(total_queries, fast_queries);
+}
+
+TEST(Tonlib, VerifiedCache) {
+  std::string keystore_dir = "test-verified-cache";
+  td::rmrf(keystore_dir).ignore();
+  td::mkdir(keystore_dir).ensure();
+  SCOPE_EXIT {
+    td::rmrf(keystore_dir).ignore();
+  };
+  auto cache_dir = keystore_dir + TD_DIR_SLASH + "verified-cache";
+  ton::BlockIdExt mc_blk(ton::masterchainId, ton::shardIdAll, 100, td::Bits256::zero(), td::Bits256::zero());
+  ton::BlockIdExt shard_blk(ton::basechainId, ton::shardIdAll, 200, td::Bits256::zero(), td::Bits256::zero());
+  block::StdAddress addr(ton::basechainId, td::Bits256::zero());
+
+  block::AccountState::Info info;
+  info.true_root = vm::CellBuilder().store_long(123, 32).finalize();
+  info.root = info.true_root;
+  info.last_trans_lt = 1000;
+  info.gen_utime = 2000;
+
+  VerifiedCache::Options options;
+  options.persistent = true;
+  {
+    VerifiedCache cache(options, cache_dir);
+    cache.flush();
+    ASSERT_TRUE(!cache.has_shard_proof(mc_blk, shard_blk));
+    ASSERT_TRUE(!cache.get_account_state(mc_blk, addr));
+    cache.add_shard_proof(mc_blk, shard_blk);
+    cache.add_account_state(mc_blk, addr, info, 100);
+    cache.add_block_data(shard_blk, td::BufferSlice("block data"));
+    ASSERT_TRUE(cache.has_shard_proof(mc_blk, shard_blk));
+    ASSERT_TRUE(!cache.has_shard_proof(shard_blk, mc_blk));
+    ASSERT_EQ(1000u, cache.get_account_state(mc_blk, addr).unwrap().last_trans_lt);
+    ASSERT_EQ("block data", cache.get_block_data(shard_blk).unwrap().as_slice());
+  }
+  // the keystore is not touched
+  auto kv = KeyValue::create_dir(keystore_dir).move_as_ok();
+  kv->foreach_key([](td::Slice key) { LOG(FATAL) << "unexpected key " << key; });
+  {
+    // shard proofs and account states are loaded from the persistent store, block data is not persisted
+    VerifiedCache cache(options, cache_dir);
+    cache.flush();
+    ASSERT_TRUE(cache.has_shard_proof(mc_blk, shard_blk));
+    auto loaded = cache.get_account_state(mc_blk, addr).unwrap();
+    ASSERT_TRUE(info.true_root->get_hash() == loaded.true_root->get_hash());
+    ASSERT_EQ(info.last_trans_lt, loaded.last_trans_lt);
+    ASSERT_EQ(info.gen_utime, loaded.gen_utime);
+    ASSERT_TRUE(!cache.get_block_data(shard_blk));
+    ASSERT_EQ(2u, cache.get_stats().loaded);
+  }
+  {
+    // a partially written record is dropped
+    auto fd = td::FileFd::open(cache_dir + TD_DIR_SLASH + "cache", td::FileFd::Write | td::FileFd::Append).move_as_ok();
+    fd.write("garbage").ensure();
+    fd.close();
+    VerifiedCache cache(options, cache_dir);
+    cache.flush();
+    ASSERT_TRUE(cache.has_shard_proof(mc_blk, shard_blk));
+    ASSERT_TRUE(cache.get_account_state(mc_blk, addr));
+  }
+  {
+    VerifiedCache::Options small_options;
+    small_options.max_size = 1 << 12;
+    VerifiedCache cache(small_options, cache_dir);
+    ASSERT_TRUE(!cache.has_shard_proof(mc_blk, shard_blk));
+    for (td::uint32 seqno = 1; seqno <= 100; seqno++) {
+      ton::BlockIdExt blk(ton::basechainId, ton::shardIdAll, seqno, td::Bits256::zero(), td::Bits256::zero());
+      cache.add_block_data(blk, td::BufferSlice(std::string(100, 'a')));
+    }
+    ASSERT_TRUE(cache.get_stats().evictions > 0);
+    ASSERT_TRUE(cache.get_stats().size <= small_options.max_size);
+    ASSERT_TRUE(!cache.get_block_data(
+        ton::BlockIdExt(ton::basechainId, ton::shardIdAll, 1, td::Bits256::zero(), td::Bits256::zero())));
+    ASSERT_TRUE(!!cache.get_block_data(
+        ton::BlockIdExt(ton::basechainId, ton::shardIdAll, 100, td::Bits256::zero(), td::Bits256::zero())));
+  }
+}
@@ -105,6 +105,32 @@ td::Result<Config> Config::parse(std::string str) {
     res.lite_clients.push_back(std::move(client));
   }
 
+  auto r_pool = td::get_json_object_field(json.get_object(), "liteserver_pool", td::JsonValue::Type::Object, false);
+  if (r_pool.is_ok()) {
+    auto pool_obj = r_pool.move_as_ok();
+    auto &pool = pool_obj.get_object();
+    TRY_RESULT(pool_size, td::get_json_object_int_field(pool, "size", true, 1));
+    if (pool_size <= 0) {
+      return td::Status::Error("Invalid config (9)");
+    }
+    TRY_RESULT(hedge_queries, td::get_json_object_bool_field(pool, "hedge", true, false));
+    res.lite_client_pool.size = pool_size;
+    res.lite_client_pool.hedge_queries = hedge_queries;
+  }
+
+  auto r_cache = td::get_json_object_field(json.get_object(), "verified_cache", td::JsonValue::Type::Object, false);
+  if (r_cache.is_ok()) {
+    auto cache_obj = r_cache.move_as_ok();
+    auto &cache = cache_obj.get_object();
+    TRY_RESULT(max_size, td::get_json_object_long_field(cache, "max_size", true, res.verified_cache.max_size));
+    if (max_size < 0) {
+      return td::Status::Error("Invalid config (10)");
+    }
+    TRY_RESULT(persistent, td::get_json_object_bool_field(cache, "persistent", true, false));
+    res.verified_cache.max_size = max_size;
+    res.verified_cache.persistent = persistent;
+  }
+
   TRY_RESULT(validator_obj,
              td::get_json_object_field(json.get_object(), "validator", td::JsonValue::Type::Object, false));
   auto &validator = validator_obj.get_object();
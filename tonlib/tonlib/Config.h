@@ -27,10 +27,23 @@ struct Config {
     ton::adnl::AdnlNodeIdFull adnl_id;
     td::IPAddress address;
   };
+  // queries are routed through a pool of connections to several liteservers if size > 1
+  struct LiteClientPool {
+    td::int32 size{1};
+    bool hedge_queries{false};
+  };
+  // verified liteserver answers are cached in memory, and also in a subdirectory of the keystore directory
+  // if persistent is set
+  struct VerifiedCacheConfig {
+    td::int64 max_size{64 << 20};
+    bool persistent{false};
+  };
   ton::BlockIdExt zero_state_id;
   ton::BlockIdExt init_block_id;
   std::vector<ton::BlockIdExt> hardforks;
   std::vector<LiteClient> lite_clients;
+  LiteClientPool lite_client_pool;
+  VerifiedCacheConfig verified_cache;
   std::string name;
   static td::Result<Config> parse(std::string str);
 };
@@ -36,10 +36,12 @@ class LastBlock;
 class LastConfig;
 struct LastBlockState;
 struct LastConfigState;
+class VerifiedCache;
 struct ExtClientRef {
   td::actor::ActorId<ton::adnl::AdnlExtClient> andl_ext_client_;
   td::actor::ActorId<LastBlock> last_block_actor_;
   td::actor::ActorId<LastConfig> last_config_actor_;
+  std::shared_ptr<VerifiedCache> verified_cache_;
 };
 
 class ExtClient {
@@ -56,6 +58,10 @@ class ExtClient {
   ExtClientRef get_client() {
     return client_;
   }
+  // may be nullptr
+  VerifiedCache* get_verified_cache() {
+    return client_.verified_cache_.get();
+  }
   ~ExtClient();
 
   void with_last_block(td::Promise<LastBlockState> promise);
@@ -0,0 +1,304 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "ExtClientPool.h"
+#include "TonlibError.h"
+
+#include "auto/tl/lite_api.h"
+#include "tl-utils/lite-utils.hpp"
+
+#include "ton/ton-types.h"
+
+#include "td/utils/as.h"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+#include "td/utils/misc.h"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <set>
+
+namespace tonlib {
+
+class ExtClientPoolImpl : public ton::adnl::AdnlExtClient {
+ public:
+  ExtClientPoolImpl(std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> clients,
+                    ExtClientPool::Options options)
+      : options_(options) {
+    CHECK(!clients.empty());
+    servers_.resize(clients.size());
+    for (size_t i = 0; i < clients.size(); i++) {
+      servers_[i].client = std::move(clients[i]);
+    }
+  }
+
+  void check_ready(td::Promise<td::Unit> promise) override {
+    send_closure(servers_[choose_server(-1)].client, &ton::adnl::AdnlExtClient::check_ready, std::move(promise));
+  }
+
+  void send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                  td::Promise<td::BufferSlice> promise) override {
+    auto query_id = ++last_query_id_;
+    auto &query = queries_[query_id];
+    query.promise = std::move(promise);
+    query.timeout = timeout;
+    auto server_id = choose_server(-1);
+    if (options_.hedge_queries && servers_.size() > 1 && is_idempotent(data)) {
+      query.name = name;
+      query.data = data.clone();
+      query.first_server_id = server_id;
+      query.sent_at = td::Time::now();
+      query.hedge_at = td::Time::now() + hedge_delay(servers_[server_id]);
+      hedges_.emplace(query.hedge_at, query_id);
+      alarm_timestamp().relax(td::Timestamp::at(query.hedge_at));
+    }
+    send_to_server(query_id, server_id, std::move(name), std::move(data), timeout);
+  }
+
+ private:
+  static constexpr double LATENCY_EWMA_ALPHA = 0.2;
+  static constexpr double ERROR_EWMA_ALPHA = 0.1;
+  // a server behind the best known masterchain seqno is penalized as if it were this much slower per block
+  static constexpr double LAG_PENALTY_PER_BLOCK = 0.5;
+  static constexpr td::uint32 MAX_PENALIZED_LAG = 10;
+  // once in a while a random server is chosen to refresh its statistics
+  static constexpr td::uint32 EXPLORE_ONE_IN = 32;
+  static constexpr size_t MIN_LATENCY_SAMPLES_FOR_P95 = 8;
+
+  struct Server {
+    td::actor::ActorOwn<ton::adnl::AdnlExtClient> client;
+    double latency_ewma{-1};  // seconds, negative if unknown
+    double error_rate{0};
+    ton::BlockSeqno mc_seqno{0};
+    std::array<double, 32> latencies{};
+    size_t latencies_count{0};
+    td::uint32 in_flight{0};
+  };
+
+  struct Query {
+    td::Promise<td::BufferSlice> promise;
+    td::Timestamp timeout;
+    td::uint32 pending{0};
+    // kept only for queries that may be hedged
+    std::string name;
+    td::BufferSlice data;
+    size_t first_server_id{0};
+    double sent_at{0};
+    double hedge_at{0};  // 0 if the query is not going to be hedged
+  };
+
+  ExtClientPool::Options options_;
+  std::vector<Server> servers_;
+  ton::BlockSeqno max_mc_seqno_{0};
+  td::uint64 last_query_id_{0};
+  std::map<td::uint64, Query> queries_;
+  std::set<std::pair<double, td::uint64>> hedges_;
+
+  // liteServer.sendMessage is the only query that changes anything
+  static bool is_idempotent(td::Slice data) {
+    auto r_query = ton::fetch_tl_object<ton::lite_api::liteServer_query>(td::BufferSlice(data), true);
+    if (r_query.is_error()) {
+      return false;
+    }
+    auto inner = r_query.ok()->data_.as_slice();
+    if (inner.size() >= 4 && td::as<td::int32>(inner.data()) == ton::lite_api::liteServer_waitMasterchainSeqno::ID) {
+      inner.remove_prefix(12);
+    }
+    return inner.size() >= 4 && td::as<td::int32>(inner.data()) != ton::lite_api::liteServer_sendMessage::ID;
+  }
+
+  double score(const Server &server) const {
+    // servers without latency samples are tried first
+    double latency = std::max(server.latency_ewma, 0.0);
+    double res = latency * (1 + 10 * server.error_rate) + server.error_rate;
+    if (server.mc_seqno != 0 && server.mc_seqno < max_mc_seqno_) {
+      res += LAG_PENALTY_PER_BLOCK * std::min(max_mc_seqno_ - server.mc_seqno, MAX_PENALIZED_LAG);
+    }
+    return res;
+  }
+
+  size_t choose_server(td::int64 exclude_id) {
+    if (servers_.size() == 1) {
+      return 0;
+    }
+    if (td::Random::fast(0, EXPLORE_ONE_IN - 1) == 0) {
+      while (true) {
+        auto id = static_cast<size_t>(td::Random::fast(0, td::narrow_cast<int>(servers_.size()) - 1));
+        if (static_cast<td::int64>(id) != exclude_id) {
+          return id;
+        }
+      }
+    }
+    size_t best_id = 0;
+    double best_score = 0;
+    bool found = false;
+    for (size_t i = 0; i < servers_.size(); i++) {
+      if (static_cast<td::int64>(i) == exclude_id) {
+        continue;
+      }
+      auto cur_score = score(servers_[i]);
+      if (!found || cur_score < best_score) {
+        best_id = i;
+        best_score = cur_score;
+        found = true;
+      }
+    }
+    return best_id;
+  }
+
+  double hedge_delay(const Server &server) const {
+    auto n = std::min(server.latencies_count, server.latencies.size());
+    if (n < MIN_LATENCY_SAMPLES_FOR_P95) {
+      return std::max(options_.default_hedge_delay, options_.min_hedge_delay);
+    }
+    std::array<double, 32> sorted = server.latencies;
+    std::sort(sorted.begin(), sorted.begin() + n);
+    return std::max(sorted[std::min(n - 1, n * 95 / 100)], options_.min_hedge_delay);
+  }
+
+  void send_to_server(td::uint64 query_id, size_t server_id, std::string name, td::BufferSlice data,
+                      td::Timestamp timeout) {
+    queries_[query_id].pending++;
+    servers_[server_id].in_flight++;
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), query_id, server_id,
+                                         started_at = td::Time::now()](td::Result<td::BufferSlice> R) {
+      td::actor::send_closure(SelfId, &ExtClientPoolImpl::on_server_answer, query_id, server_id,
+                              td::Time::now() - started_at, std::move(R));
+    });
+    send_closure(servers_[server_id].client, &ton::adnl::AdnlExtClient::send_query, std::move(name), std::move(data),
+                 timeout, std::move(P));
+  }
+
+  void on_server_answer(td::uint64 query_id, size_t server_id, double latency, td::Result<td::BufferSlice> R) {
+    auto &server = servers_[server_id];
+    server.in_flight--;
+    bool ok = R.is_ok() && ton::fetch_tl_object<ton::lite_api::liteServer_error>(R.ok().clone(), true).is_error();
+    // a liteServer.error is a valid answer, e.g. to a query about an unknown block, so only transport errors
+    // and timeouts count against the server
+    server.error_rate += ERROR_EWMA_ALPHA * ((R.is_ok() ? 0.0 : 1.0) - server.error_rate);
+    if (R.is_ok()) {
+      update_latency(server, latency);
+      update_mc_seqno(server, R.ok().as_slice());
+    }
+
+    auto it = queries_.find(query_id);
+    if (it == queries_.end()) {
+      // the query was already answered by another server
+      return;
+    }
+    auto &query = it->second;
+    query.pending--;
+    if (!ok) {
+      if (query.pending > 0) {
+        // the first successful answer wins
+        return;
+      }
+      if (query.hedge_at != 0) {
+        // no need to wait for the hedging delay
+        hedges_.erase({query.hedge_at, query_id});
+        send_hedge(query_id);
+        return;
+      }
+    }
+    finish_query(it, std::move(R));
+  }
+
+  static void update_latency(Server &server, double latency) {
+    if (server.latency_ewma < 0) {
+      server.latency_ewma = latency;
+    } else {
+      server.latency_ewma += LATENCY_EWMA_ALPHA * (latency - server.latency_ewma);
+    }
+    server.latencies[server.latencies_count++ % server.latencies.size()] = latency;
+  }
+
+  void update_mc_seqno(Server &server, td::Slice answer) {
+    if (answer.size() < 4) {
+      return;
+    }
+    auto constructor_id = td::as<td::int32>(answer.data());
+    ton::BlockSeqno seqno = 0;
+    if (constructor_id == ton::lite_api::liteServer_masterchainInfo::ID) {
+      auto r_info = ton::fetch_tl_object<ton::lite_api::liteServer_masterchainInfo>(td::BufferSlice(answer), true);
+      if (r_info.is_error()) {
+        return;
+      }
+      seqno = r_info.ok()->last_->seqno_;
+    } else if (constructor_id == ton::lite_api::liteServer_masterchainInfoExt::ID) {
+      auto r_info = ton::fetch_tl_object<ton::lite_api::liteServer_masterchainInfoExt>(td::BufferSlice(answer), true);
+      if (r_info.is_error()) {
+        return;
+      }
+      seqno = r_info.ok()->last_->seqno_;
+    } else {
+      return;
+    }
+    server.mc_seqno = std::max(server.mc_seqno, seqno);
+    max_mc_seqno_ = std::max(max_mc_seqno_, seqno);
+  }
+
+  void send_hedge(td::uint64 query_id) {
+    auto it = queries_.find(query_id);
+    if (it == queries_.end()) {
+      return;
+    }
+    auto &query = it->second;
+    if (query.hedge_at != 0 && query.pending > 0) {
+      // the first server may never answer, so its latency is estimated by the time it has already taken
+      update_latency(servers_[query.first_server_id], td::Time::now() - query.sent_at);
+    }
+    query.hedge_at = 0;
+    auto server_id = choose_server(static_cast<td::int64>(query.first_server_id));
+    send_to_server(query_id, server_id, std::move(query.name), std::move(query.data), query.timeout);
+  }
+
+  void finish_query(std::map<td::uint64, Query>::iterator it, td::Result<td::BufferSlice> R) {
+    if (it->second.hedge_at != 0) {
+      hedges_.erase({it->second.hedge_at, it->first});
+    }
+    auto promise = std::move(it->second.promise);
+    queries_.erase(it);
+    promise.set_result(std::move(R));
+  }
+
+  void alarm() override {
+    auto now = td::Time::now();
+    while (!hedges_.empty() && hedges_.begin()->first <= now) {
+      auto query_id = hedges_.begin()->second;
+      hedges_.erase(hedges_.begin());
+      send_hedge(query_id);
+    }
+    if (!hedges_.empty()) {
+      alarm_timestamp() = td::Timestamp::at(hedges_.begin()->first);
+    }
+  }
+
+  void tear_down() override {
+    for (auto &it : queries_) {
+      it.second.promise.set_error(TonlibError::Cancelled());
+    }
+    queries_.clear();
+  }
+};
+
+td::actor::ActorOwn<ton::adnl::AdnlExtClient> ExtClientPool::create(
+    std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> clients, Options options) {
+  return td::actor::create_actor<ExtClientPoolImpl>("ExtClientPool", std::move(clients), options);
+}
+}  // namespace tonlib
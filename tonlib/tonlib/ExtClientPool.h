@@ -0,0 +1,41 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+#include "td/actor/actor.h"
+
+#include "adnl/adnl-ext-client.h"
+
+namespace tonlib {
+// Routes each query to the best of several liteservers, judging by their latency, error rate
+// and the last masterchain seqno seen in their answers
+class ExtClientPool {
+ public:
+  struct Options {
+    // idempotent queries are also sent to a second server if the first one doesn't answer in time
+    bool hedge_queries{false};
+    // the hedging delay is the 95th percentile of the latency of the first server, but no less than this
+    double min_hedge_delay{0.05};
+    // used until there are enough latency samples of the first server
+    double default_hedge_delay{1.0};
+  };
+  static td::actor::ActorOwn<ton::adnl::AdnlExtClient> create(
+      std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> clients, Options options);
+};
+
+}  // namespace tonlib
@@ -3,9 +3,12 @@
 #include "tonlib/LastBlock.h"
 #include "tonlib/LastConfig.h"
 #include "tonlib/LiteServerUtils.h"
+#include "tonlib/VerifiedCache.h"
 
 #include "ton/lite-tl.hpp"
 
+#include "common/checksum.h"
+
 #include "block/block.h"
 #include "block/block-parse.h"
 #include "block/block-auto.h"
@@ -217,6 +220,16 @@ void GetBlock::start_up_with_lookup() {
 }
 
 void GetBlock::proceed_with_block_id(const ton::BlockIdExt& block_id) {
+  if (auto cache = client_.get_verified_cache()) {
+    auto block_data = cache->get_block_data(block_id);
+    if (block_data) {
+      block_data_ = block_data.unwrap();
+      if (pending_queries_ == 0) {
+        finish_query();
+      }
+      return;
+    }
+  }
   auto block_data_handler =
       td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<lite_api_ptr<lite_api::liteServer_blockData>> R) {
         if (R.is_error()) {
@@ -238,6 +251,14 @@ void GetBlock::got_block_header(lite_api_ptr<lite_api::liteServer_blockHeader>&&
 }
 
 void GetBlock::got_block_data(lite_api_ptr<lite_api::liteServer_blockData>&& result) {
+  const auto& block_id = *block_id_;
+  if (td::sha256_bits256(result->data_) != block_id.file_hash) {
+    check(td::Status::Error(PSLICE() << "file hash mismatch for block " << block_id.to_str()));
+    return;
+  }
+  if (auto cache = client_.get_verified_cache()) {
+    cache->add_block_data(block_id, result->data_);
+  }
   block_data_ = std::move(result->data_);
   check_finished();
 }
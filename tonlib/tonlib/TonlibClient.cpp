@@ -20,6 +20,7 @@
 
 #include "tonlib/ExtClientLazy.h"
 #include "tonlib/ExtClientOutbound.h"
+#include "tonlib/ExtClientPool.h"
 #include "tonlib/LastBlock.h"
 #include "tonlib/LastConfig.h"
 #include "tonlib/Logging.h"
@@ -27,6 +28,7 @@
 #include "tonlib/keys/Mnemonic.h"
 #include "tonlib/keys/SimpleEncryption.h"
 #include "tonlib/TonlibError.h"
+#include "tonlib/VerifiedCache.h"
 #include "tonlib/AbiDto.h"
 #include "tonlib/LiteServerUtils.h"
 #include "tonlib/AccountState.h"
@@ -516,7 +518,12 @@ class RemoteRunSmcMethod : public td::actor::Actor {
   td::Result<int_api::RemoteRunSmcMethod::ReturnType> do_with_run_method_result(
       ton::tl_object_ptr<ton::lite_api::liteServer_runMethodResult> run_method_result) {
     auto account_state = create_account_state(run_method_result);
-    TRY_RESULT(info, account_state.validate(query_.block_id.value(), query_.address));
+    auto cache = client_.get_verified_cache();
+    bool skip_shard_proof = cache && cache->has_shard_proof(account_state.blk, account_state.shard_blk);
+    TRY_RESULT(info, account_state.validate(query_.block_id.value(), query_.address, skip_shard_proof));
+    if (cache) {
+      cache->add_shard_proof(account_state.blk, account_state.shard_blk);
+    }
     auto serialized_state = account_state.state.clone();
     int_api::RemoteRunSmcMethod::ReturnType res;
     res.block_id = query_.block_id.value();
@@ -598,6 +605,91 @@ class RemoteRunSmcMethod : public td::actor::Actor {
   }
 };
 
+td::Result<RawAccountState> to_raw_account_state(ton::BlockIdExt block_id, block::AccountState::Info info) {
+  RawAccountState res;
+  res.block_id = std::move(block_id);
+  res.info = std::move(info);
+  auto cell = res.info.root;
+  //std::ostringstream outp;
+  //block::gen::t_Account.print_ref(outp, cell);
+  //LOG(INFO) << outp.str();
+  if (cell.is_null()) {
+    return res;
+  }
+  block::gen::Account::Record_account account;
+  if (!tlb::unpack_cell(cell, account)) {
+    return td::Status::Error("Failed to unpack Account");
+  }
+  {
+    block::gen::StorageInfo::Record storage_info;
+    if (!tlb::csr_unpack(account.storage_stat, storage_info)) {
+      return td::Status::Error("Failed to unpack StorageInfo");
+    }
+    res.storage_last_paid = storage_info.last_paid;
+    td::RefInt256 due_payment;
+    if (storage_info.due_payment->prefetch_ulong(1) == 1) {
+      vm::CellSlice& cs2 = storage_info.due_payment.write();
+      cs2.advance(1);
+      due_payment = block::tlb::t_Grams.as_integer_skip(cs2);
+      if (due_payment.is_null() || !cs2.empty_ext()) {
+        return td::Status::Error("Failed to upack due_payment");
+      }
+    } else {
+      due_payment = td::RefInt256{true, 0};
+    }
+    block::gen::StorageUsed::Record storage_used;
+    if (!tlb::csr_unpack(storage_info.used, storage_used)) {
+      return td::Status::Error("Failed to unpack StorageInfo");
+    }
+    unsigned long long u = 0;
+    vm::CellStorageStat storage_stat;
+    u |= storage_stat.cells = block::tlb::t_VarUInteger_7.as_uint(*storage_used.cells);
+    u |= storage_stat.bits = block::tlb::t_VarUInteger_7.as_uint(*storage_used.bits);
+    u |= storage_stat.public_cells = block::tlb::t_VarUInteger_7.as_uint(*storage_used.public_cells);
+    //LOG(DEBUG) << "last_paid=" << res.storage_last_paid << "; cells=" << storage_stat.cells
+    //<< " bits=" << storage_stat.bits << " public_cells=" << storage_stat.public_cells;
+    if (u == std::numeric_limits<td::uint64>::max()) {
+      return td::Status::Error("Failed to unpack StorageStat");
+    }
+
+    res.storage_stat = storage_stat;
+  }
+
+  block::gen::AccountStorage::Record storage;
+  if (!tlb::csr_unpack(account.storage, storage)) {
+    return td::Status::Error("Failed to unpack AccountStorage");
+  }
+  TRY_RESULT(balance, to_balance(storage.balance));
+  res.balance = balance;
+  auto state_tag = block::gen::t_AccountState.get_tag(*storage.state);
+  if (state_tag < 0) {
+    return td::Status::Error("Failed to parse AccountState tag");
+  }
+  if (state_tag == block::gen::AccountState::account_frozen) {
+    block::gen::AccountState::Record_account_frozen state;
+    if (!tlb::csr_unpack(storage.state, state)) {
+      return td::Status::Error("Failed to parse AccountState");
+    }
+    res.frozen_hash = state.state_hash.as_slice().str();
+    return res;
+  }
+  if (state_tag != block::gen::AccountState::account_active) {
+    return res;
+  }
+  block::gen::AccountState::Record_account_active state;
+  if (!tlb::csr_unpack(storage.state, state)) {
+    return td::Status::Error("Failed to parse AccountState");
+  }
+  block::gen::StateInit::Record state_init;
+  res.state = vm::CellBuilder().append_cellslice(state.x).finalize();
+  if (!tlb::csr_unpack(state.x, state_init)) {
+    return td::Status::Error("Failed to parse StateInit");
+  }
+  state_init.code->prefetch_maybe_ref(res.code);
+  state_init.data->prefetch_maybe_ref(res.data);
+  return res;
+}
+
 class GetRawAccountState : public td::actor::Actor {
  public:
   GetRawAccountState(ExtClientRef ext_client_ref, block::StdAddress address, td::optional<ton::BlockIdExt> block_id,
@@ -623,114 +715,219 @@ class GetRawAccountState : public td::actor::Actor {
   td::Status do_with_account_state(
       td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_accountState>> r_raw_account_state) {
     TRY_RESULT(raw_account_state, std::move(r_raw_account_state));
-    TRY_RESULT_PREFIX(state, TRY_VM(do_with_account_state(std::move(raw_account_state))),
+    TRY_RESULT_PREFIX(info, TRY_VM(validate_account_state(std::move(raw_account_state))),
+                      TonlibError::ValidateAccountState());
+    return do_with_account_info(std::move(info));
+  }
+
+  td::Result<block::AccountState::Info> validate_account_state(
+      ton::tl_object_ptr<ton::lite_api::liteServer_accountState> raw_account_state) {
+    auto account_state = create_account_state(std::move(raw_account_state));
+    auto cache = client_.get_verified_cache();
+    bool skip_shard_proof = cache && cache->has_shard_proof(account_state.blk, account_state.shard_blk);
+    TRY_RESULT(info, account_state.validate(block_id_.value(), address_, skip_shard_proof));
+    if (cache) {
+      cache->add_shard_proof(account_state.blk, account_state.shard_blk);
+      if (block_id_.value().is_valid_full()) {
+        cache->add_account_state(block_id_.value(), address_, info, account_state.state.size());
+      }
+    }
+    return std::move(info);
+  }
+
+  td::Status do_with_account_info(block::AccountState::Info info) {
+    TRY_RESULT_PREFIX(state, TRY_VM(to_raw_account_state(block_id_.value(), std::move(info))),
                       TonlibError::ValidateAccountState());
     promise_.set_value(std::move(state));
     stop();
     return td::Status::OK();
   }
 
-  td::Result<RawAccountState> do_with_account_state(
-      ton::tl_object_ptr<ton::lite_api::liteServer_accountState> raw_account_state) {
-    auto account_state = create_account_state(std::move(raw_account_state));
-    TRY_RESULT(info, account_state.validate(block_id_.value(), address_));
-    auto serialized_state = account_state.state.clone();
-    RawAccountState res;
-    res.block_id = block_id_.value();
-    res.info = std::move(info);
-    auto cell = res.info.root;
-    //std::ostringstream outp;
-    //block::gen::t_Account.print_ref(outp, cell);
-    //LOG(INFO) << outp.str();
-    if (cell.is_null()) {
-      return res;
+  void with_last_block(td::Result<LastBlockState> r_last_block) {
+    check(do_with_last_block(std::move(r_last_block)));
+  }
+
+  void with_block_id() {
+    auto cache = client_.get_verified_cache();
+    if (cache && block_id_.value().is_valid_full()) {
+      auto info = cache->get_account_state(block_id_.value(), address_);
+      if (info) {
+        check(do_with_account_info(info.unwrap()));
+        return;
+      }
     }
-    block::gen::Account::Record_account account;
-    if (!tlb::unpack_cell(cell, account)) {
-      return td::Status::Error("Failed to unpack Account");
+    client_.send_query(
+        ton::lite_api::liteServer_getAccountState(
+            ton::create_tl_lite_block_id(block_id_.value()),
+            ton::create_tl_object<ton::lite_api::liteServer_accountId>(address_.workchain, address_.addr)),
+        [self = this](auto r_state) { self->with_account_state(std::move(r_state)); }, block_id_.value().id.seqno);
+  }
+
+  td::Status do_with_last_block(td::Result<LastBlockState> r_last_block) {
+    TRY_RESULT(last_block, std::move(r_last_block));
+    block_id_ = std::move(last_block.last_block_id);
+    with_block_id();
+    return td::Status::OK();
+  }
+
+  void start_up() override {
+    if (block_id_) {
+      with_block_id();
+    } else {
+      client_.with_last_block(
+          [self = this](td::Result<LastBlockState> r_last_block) { self->with_last_block(std::move(r_last_block)); });
     }
-    {
-      block::gen::StorageInfo::Record storage_info;
-      if (!tlb::csr_unpack(account.storage_stat, storage_info)) {
-        return td::Status::Error("Failed to unpack StorageInfo");
-      }
-      res.storage_last_paid = storage_info.last_paid;
-      td::RefInt256 due_payment;
-      if (storage_info.due_payment->prefetch_ulong(1) == 1) {
-        vm::CellSlice& cs2 = storage_info.due_payment.write();
-        cs2.advance(1);
-        due_payment = block::tlb::t_Grams.as_integer_skip(cs2);
-        if (due_payment.is_null() || !cs2.empty_ext()) {
-          return td::Status::Error("Failed to upack due_payment");
+  }
+
+  void check(td::Status status) {
+    if (status.is_error()) {
+      promise_.set_error(std::move(status));
+      stop();
+    }
+  }
+  void hangup() override {
+    check(TonlibError::Cancelled());
+  }
+};
+
+// Accounts of one shard are requested with a single liteServer.getAccountStates query;
+// the answer covers the shard of the first requested account, so the rest are requested again
+class GetRawAccountStates : public td::actor::Actor {
+ public:
+  GetRawAccountStates(ExtClientRef ext_client_ref, std::vector<block::StdAddress> addresses,
+                      td::optional<ton::BlockIdExt> block_id, td::actor::ActorShared<> parent,
+                      td::Promise<std::vector<RawAccountState>>&& promise)
+      : addresses_(std::move(addresses))
+      , block_id_(std::move(block_id))
+      , promise_(std::move(promise))
+      , parent_(std::move(parent)) {
+    client_.set_client(ext_client_ref);
+  }
+
+ private:
+  static constexpr size_t MAX_ACCOUNTS_PER_QUERY = 1024;
+
+  std::vector<block::StdAddress> addresses_;
+  td::optional<ton::BlockIdExt> block_id_;
+  td::Promise<std::vector<RawAccountState>> promise_;
+  td::actor::ActorShared<> parent_;
+  ExtClient client_;
+  std::vector<td::optional<RawAccountState>> states_;
+  size_t pending_queries_{0};
+
+  void with_block_id() {
+    check(do_with_block_id());
+  }
+
+  td::Status do_with_block_id() {
+    states_.resize(addresses_.size());
+    auto cache = client_.get_verified_cache();
+    std::map<ton::WorkchainId, std::vector<size_t>> to_query;
+    for (size_t i = 0; i < addresses_.size(); i++) {
+      if (cache && block_id_.value().is_valid_full()) {
+        auto info = cache->get_account_state(block_id_.value(), addresses_[i]);
+        if (info) {
+          TRY_RESULT_PREFIX(state, TRY_VM(to_raw_account_state(block_id_.value(), info.unwrap())),
+                            TonlibError::ValidateAccountState());
+          states_[i] = std::move(state);
+          continue;
         }
-      } else {
-        due_payment = td::RefInt256{true, 0};
       }
-      block::gen::StorageUsed::Record storage_used;
-      if (!tlb::csr_unpack(storage_info.used, storage_used)) {
-        return td::Status::Error("Failed to unpack StorageInfo");
-      }
-      unsigned long long u = 0;
-      vm::CellStorageStat storage_stat;
-      u |= storage_stat.cells = block::tlb::t_VarUInteger_7.as_uint(*storage_used.cells);
-      u |= storage_stat.bits = block::tlb::t_VarUInteger_7.as_uint(*storage_used.bits);
-      u |= storage_stat.public_cells = block::tlb::t_VarUInteger_7.as_uint(*storage_used.public_cells);
-      //LOG(DEBUG) << "last_paid=" << res.storage_last_paid << "; cells=" << storage_stat.cells
-      //<< " bits=" << storage_stat.bits << " public_cells=" << storage_stat.public_cells;
-      if (u == std::numeric_limits<td::uint64>::max()) {
-        return td::Status::Error("Failed to unpack StorageStat");
-      }
-
-      res.storage_stat = storage_stat;
+      to_query[addresses_[i].workchain].push_back(i);
     }
+    for (auto& it : to_query) {
+      send_query(it.first, std::move(it.second));
+    }
+    try_finish();
+    return td::Status::OK();
+  }
 
-    block::gen::AccountStorage::Record storage;
-    if (!tlb::csr_unpack(account.storage, storage)) {
-      return td::Status::Error("Failed to unpack AccountStorage");
+  void send_query(ton::WorkchainId workchain, std::vector<size_t> indices) {
+    if (indices.size() > MAX_ACCOUNTS_PER_QUERY) {
+      send_query(workchain, std::vector<size_t>(indices.begin() + MAX_ACCOUNTS_PER_QUERY, indices.end()));
+      indices.resize(MAX_ACCOUNTS_PER_QUERY);
     }
-    TRY_RESULT(balance, to_balance(storage.balance));
-    res.balance = balance;
-    auto state_tag = block::gen::t_AccountState.get_tag(*storage.state);
-    if (state_tag < 0) {
-      return td::Status::Error("Failed to parse AccountState tag");
+    std::vector<td::Bits256> accounts;
+    for (auto i : indices) {
+      accounts.push_back(addresses_[i].addr);
+    }
+    pending_queries_++;
+    client_.send_query(
+        ton::lite_api::liteServer_getAccountStates(ton::create_tl_lite_block_id(block_id_.value()), workchain,
+                                                   std::move(accounts)),
+        [self = this, workchain, indices = std::move(indices)](auto r_states) mutable {
+          self->with_account_states(workchain, std::move(indices), std::move(r_states));
+        },
+        block_id_.value().id.seqno);
+  }
+
+  void with_account_states(ton::WorkchainId workchain, std::vector<size_t> indices,
+                           td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_accountStates>> r_states) {
+    pending_queries_--;
+    check(do_with_account_states(workchain, std::move(indices), std::move(r_states)));
+  }
+
+  td::Status do_with_account_states(ton::WorkchainId workchain, std::vector<size_t> indices,
+                                    td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_accountStates>> r_states) {
+    TRY_RESULT(raw_states, std::move(r_states));
+    block::AccountStates account_states;
+    account_states.blk = ton::create_block_id(raw_states->id_);
+    account_states.shard_blk = ton::create_block_id(raw_states->shardblk_);
+    account_states.shard_proof = std::move(raw_states->shard_proof_);
+    account_states.proof = std::move(raw_states->proof_);
+    account_states.states = std::move(raw_states->states_);
+
+    std::vector<ton::StdSmcAddress> addrs;
+    for (auto i : indices) {
+      addrs.push_back(addresses_[i].addr);
+    }
+    auto cache = client_.get_verified_cache();
+    bool skip_shard_proof = cache && cache->has_shard_proof(account_states.blk, account_states.shard_blk);
+    TRY_RESULT_PREFIX(infos, TRY_VM(account_states.validate(block_id_.value(), workchain, addrs, skip_shard_proof)),
+                      TonlibError::ValidateAccountState());
+    if (cache) {
+      cache->add_shard_proof(account_states.blk, account_states.shard_blk);
     }
-    if (state_tag == block::gen::AccountState::account_frozen) {
-      block::gen::AccountState::Record_account_frozen state;
-      if (!tlb::csr_unpack(storage.state, state)) {
-        return td::Status::Error("Failed to parse AccountState");
+
+    std::vector<size_t> rest;
+    size_t j = 0;
+    for (auto i : indices) {
+      if (!ton::shard_contains(account_states.shard_blk.shard_full(),
+                               ton::extract_addr_prefix(workchain, addresses_[i].addr))) {
+        rest.push_back(i);
+        continue;
       }
-      res.frozen_hash = state.state_hash.as_slice().str();
-      return res;
+      if (cache && block_id_.value().is_valid_full()) {
+        cache->add_account_state(block_id_.value(), addresses_[i], infos[j], account_states.states[j].size());
+      }
+      TRY_RESULT_PREFIX(state, TRY_VM(to_raw_account_state(block_id_.value(), std::move(infos[j]))),
+                        TonlibError::ValidateAccountState());
+      states_[i] = std::move(state);
+      j++;
     }
-    if (state_tag != block::gen::AccountState::account_active) {
-      return res;
+    if (!rest.empty()) {
+      send_query(workchain, std::move(rest));
     }
-    block::gen::AccountState::Record_account_active state;
-    if (!tlb::csr_unpack(storage.state, state)) {
-      return td::Status::Error("Failed to parse AccountState");
+    try_finish();
+    return td::Status::OK();
+  }
+
+  void try_finish() {
+    if (pending_queries_ != 0) {
+      return;
     }
-    block::gen::StateInit::Record state_init;
-    res.state = vm::CellBuilder().append_cellslice(state.x).finalize();
-    if (!tlb::csr_unpack(state.x, state_init)) {
-      return td::Status::Error("Failed to parse StateInit");
+    std::vector<RawAccountState> res;
+    for (auto& state : states_) {
+      res.push_back(state.unwrap());
     }
-    state_init.code->prefetch_maybe_ref(res.code);
-    state_init.data->prefetch_maybe_ref(res.data);
-    return res;
+    promise_.set_value(std::move(res));
+    stop();
   }
 
   void with_last_block(td::Result<LastBlockState> r_last_block) {
     check(do_with_last_block(std::move(r_last_block)));
   }
 
-  void with_block_id() {
-    client_.send_query(
-        ton::lite_api::liteServer_getAccountState(
-            ton::create_tl_lite_block_id(block_id_.value()),
-            ton::create_tl_object<ton::lite_api::liteServer_accountId>(address_.workchain, address_.addr)),
-        [self = this](auto r_state) { self->with_account_state(std::move(r_state)); }, block_id_.value().id.seqno);
-  }
-
   td::Status do_with_last_block(td::Result<LastBlockState> r_last_block) {
     TRY_RESULT(last_block, std::move(r_last_block));
     block_id_ = std::move(last_block.last_block_id);
@@ -777,6 +974,7 @@ ExtClientRef TonlibClient::get_client_ref() {
   ref.andl_ext_client_ = raw_client_.get();
   ref.last_block_actor_ = raw_last_block_.get();
   ref.last_config_actor_ = raw_last_config_.get();
+  ref.verified_cache_ = verified_cache_;
 
   return ref;
 }
@@ -810,8 +1008,6 @@ void TonlibClient::init_ext_client() {
   } else {
     auto lite_clients_size = config_.lite_clients.size();
     CHECK(lite_clients_size != 0);
-    auto lite_client_id = td::Random::fast(0, td::narrow_cast<int>(lite_clients_size) - 1);
-    auto& lite_client = config_.lite_clients[lite_client_id];
     class Callback : public ExtClientLazy::Callback {
      public:
       explicit Callback(td::actor::ActorShared<> parent) : parent_(std::move(parent)) {
@@ -821,12 +1017,40 @@ void TonlibClient::init_ext_client() {
       td::actor::ActorShared<> parent_;
     };
     ext_client_outbound_ = {};
-    ref_cnt_++;
-    raw_client_ = ExtClientLazy::create(lite_client.adnl_id, lite_client.address,
-                                        td::make_unique<Callback>(td::actor::actor_shared()));
+
+    auto pool_size = std::min(static_cast<size_t>(config_.lite_client_pool.size), lite_clients_size);
+    std::vector<size_t> lite_client_ids(lite_clients_size);
+    for (size_t i = 0; i < lite_clients_size; i++) {
+      lite_client_ids[i] = i;
+    }
+    td::Random::Fast rnd;
+    td::random_shuffle(td::as_mutable_span(lite_client_ids), rnd);
+    lite_client_ids.resize(pool_size);
+
+    std::vector<td::actor::ActorOwn<ton::adnl::AdnlExtClient>> clients;
+    for (auto lite_client_id : lite_client_ids) {
+      auto& lite_client = config_.lite_clients[lite_client_id];
+      ref_cnt_++;
+      clients.push_back(ExtClientLazy::create(lite_client.adnl_id, lite_client.address,
+                                              td::make_unique<Callback>(td::actor::actor_shared())));
+    }
+    if (clients.size() == 1) {
+      raw_client_ = std::move(clients[0]);
+    } else {
+      ExtClientPool::Options options;
+      options.hedge_queries = config_.lite_client_pool.hedge_queries;
+      raw_client_ = ExtClientPool::create(std::move(clients), options);
+    }
   }
 }
 
+void TonlibClient::init_verified_cache() {
+  VerifiedCache::Options options;
+  options.max_size = td::narrow_cast<size_t>(config_.verified_cache.max_size);
+  options.persistent = config_.verified_cache.persistent;
+  verified_cache_ = std::make_shared<VerifiedCache>(options, verified_cache_dir_);
+}
+
 void TonlibClient::update_last_block_state(LastBlockState state, td::uint32 config_generation) {
   if (config_generation != config_generation_) {
     return;
@@ -1301,7 +1525,11 @@ td::Status TonlibClient::do_request(const tonlib_api::init& request,
   auto r_kv = downcast_call2<td::Result<td::unique_ptr<KeyValue>>>(
       *request.options_->keystore_type_,
       td::overloaded(
-          [](tonlib_api::keyStoreTypeDirectory& directory) { return KeyValue::create_dir(directory.directory_); },
+          [&](tonlib_api::keyStoreTypeDirectory& directory) {
+            // a subdirectory is not visible to the KeyValue of the keystore
+            verified_cache_dir_ = directory.directory_ + TD_DIR_SLASH + "verified-cache";
+            return KeyValue::create_dir(directory.directory_);
+          },
           [](tonlib_api::keyStoreTypeInMemory& inmemory) { return KeyValue::create_inmemory(); }));
   TRY_RESULT(kv, std::move(r_kv));
   kv_ = std::shared_ptr<KeyValue>(kv.release());
@@ -1480,6 +1708,7 @@ void TonlibClient::set_config(FullConfig full_config) {
   last_state_key_ = full_config.last_state_key;
 
   use_callbacks_for_network_ = full_config.use_callbacks_for_network;
+  init_verified_cache();
   init_ext_client();
   init_last_block(std::move(full_config.last_state));
   init_last_config();
@@ -1772,6 +2001,36 @@ td::Status TonlibClient::do_request(tonlib_api::raw_getAccountState& request,
   return td::Status::OK();
 }
 
+td::Status TonlibClient::do_request(tonlib_api::raw_getAccountStates& request,
+                                    td::Promise<object_ptr<tonlib_api::raw_fullAccountStates>>&& promise) {
+  if (request.account_addresses_.empty()) {
+    return TonlibError::EmptyField("account_addresses");
+  }
+  std::vector<block::StdAddress> addresses;
+  for (auto& account_address : request.account_addresses_) {
+    if (!account_address) {
+      return TonlibError::EmptyField("account_addresses");
+    }
+    TRY_RESULT(address, get_account_address(account_address->account_address_));
+    addresses.push_back(std::move(address));
+  }
+  auto actor_id = actor_id_++;
+  actors_[actor_id] = td::actor::create_actor<GetRawAccountStates>(
+      "GetAccountStates", client_.get_client(), addresses, query_context_.block_id.copy(),
+      actor_shared(this, actor_id),
+      promise.wrap([addresses, wallet_id = wallet_id_](std::vector<RawAccountState>&& raw_states)
+                       -> td::Result<object_ptr<tonlib_api::raw_fullAccountStates>> {
+        std::vector<object_ptr<tonlib_api::raw_fullAccountState>> states;
+        for (size_t i = 0; i < raw_states.size(); i++) {
+          TRY_RESULT(state,
+                     AccountState(addresses[i], std::move(raw_states[i]), wallet_id).to_raw_fullAccountState());
+          states.push_back(std::move(state));
+        }
+        return tonlib_api::make_object<tonlib_api::raw_fullAccountStates>(std::move(states));
+      }));
+  return td::Status::OK();
+}
+
 td::Status TonlibClient::do_request(tonlib_api::raw_getTransactions& request,
                                     td::Promise<object_ptr<tonlib_api::raw_transactions>>&& promise) {
   if (!request.account_address_) {
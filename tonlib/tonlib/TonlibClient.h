@@ -112,6 +112,8 @@ class TonlibClient : public td::actor::Actor {
   td::actor::ActorId<ExtClientOutbound> ext_client_outbound_;
   td::actor::ActorOwn<LastBlock> raw_last_block_;
   td::actor::ActorOwn<LastConfig> raw_last_config_;
+  std::shared_ptr<VerifiedCache> verified_cache_;
+  std::string verified_cache_dir_;  // empty if the keystore is in memory
   ExtClient client_;
 
   td::CancellationTokenSource source_;
@@ -121,6 +123,7 @@ class TonlibClient : public td::actor::Actor {
 
   ExtClientRef get_client_ref();
   void init_ext_client();
+  void init_verified_cache();
   void init_last_block(LastBlockState state);
   void init_last_config();
 
@@ -297,6 +300,8 @@ class TonlibClient : public td::actor::Actor {
 
   td::Status do_request(tonlib_api::raw_getAccountState& request,
                         td::Promise<object_ptr<tonlib_api::raw_fullAccountState>>&& promise);
+  td::Status do_request(tonlib_api::raw_getAccountStates& request,
+                        td::Promise<object_ptr<tonlib_api::raw_fullAccountStates>>&& promise);
   td::Status do_request(tonlib_api::raw_getTransactions& request,
                         td::Promise<object_ptr<tonlib_api::raw_transactions>>&& promise);
 
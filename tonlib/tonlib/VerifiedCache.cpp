@@ -0,0 +1,458 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "VerifiedCache.h"
+
+#include "tonlib/LastBlock.h"
+
+#include "vm/boc.h"
+#include "vm/cells/MerkleProof.h"
+
+#include "td/utils/as.h"
+#include "td/utils/crypto.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/path.h"
+#include "td/utils/tl_helpers.h"
+
+namespace tonlib {
+
+namespace {
+struct PersistedAccountState {
+  std::string true_root;  // serialized bag of cells, empty if there is no state
+  bool is_virtualized{false};
+  ton::LogicalTime last_trans_lt{0};
+  ton::Bits256 last_trans_hash;
+  ton::LogicalTime gen_lt{0};
+  td::uint32 gen_utime{0};
+
+  template <class StorerT>
+  void store(StorerT &storer) const {
+    using td::store;
+    using tonlib::store;
+    store(true_root, storer);
+    store(is_virtualized, storer);
+    store(last_trans_lt, storer);
+    store(last_trans_hash, storer);
+    store(gen_lt, storer);
+    store(gen_utime, storer);
+  }
+
+  template <class ParserT>
+  void parse(ParserT &parser) {
+    using td::parse;
+    using tonlib::parse;
+    parse(true_root, parser);
+    parse(is_virtualized, parser);
+    parse(last_trans_lt, parser);
+    parse(last_trans_hash, parser);
+    parse(gen_lt, parser);
+    parse(gen_utime, parser);
+  }
+};
+
+std::string shard_proof_key(const ton::BlockIdExt &mc_blk, const ton::BlockIdExt &shard_blk) {
+  return PSTRING() << "shard " << mc_blk.to_str() << " " << shard_blk.to_str();
+}
+
+std::string account_state_key(const ton::BlockIdExt &mc_blk, const block::StdAddress &addr) {
+  return PSTRING() << "account " << mc_blk.to_str() << " " << addr.workchain << ":" << addr.addr.to_hex();
+}
+
+std::string block_data_key(const ton::BlockIdExt &blk) {
+  return PSTRING() << "block " << blk.to_str();
+}
+
+// a record of the persistent store is crc64 of the rest of it, the sizes of the key and the value, the key, the value
+constexpr size_t record_header_size = 16;
+constexpr size_t max_record_size = 64 << 20;
+
+td::Status parse_record(td::Slice record, td::Slice &key, td::Slice &value) {
+  if (record.size() < record_header_size) {
+    return td::Status::Error("too short");
+  }
+  auto key_size = td::as<td::uint32>(record.data() + 8);
+  auto value_size = td::as<td::uint32>(record.data() + 12);
+  if (record.size() != record_header_size + key_size + value_size) {
+    return td::Status::Error("wrong size");
+  }
+  if (td::as<td::uint64>(record.data()) != td::crc64(record.substr(8))) {
+    return td::Status::Error("crc64 mismatch");
+  }
+  key = record.substr(record_header_size, key_size);
+  value = record.substr(record_header_size + key_size);
+  return td::Status::OK();
+}
+
+td::Status pread_all(const td::FileFd &file, td::MutableSlice data, td::int64 offset) {
+  while (!data.empty()) {
+    TRY_RESULT(size, file.pread(data, offset));
+    if (size == 0) {
+      return td::Status::Error("unexpected end of file");
+    }
+    data.remove_prefix(size);
+    offset += size;
+  }
+  return td::Status::OK();
+}
+
+td::Status pwrite_all(td::FileFd &file, td::Slice data, td::int64 offset) {
+  while (!data.empty()) {
+    TRY_RESULT(size, file.pwrite(data, offset));
+    data.remove_prefix(size);
+    offset += size;
+  }
+  return td::Status::OK();
+}
+}  // namespace
+
+VerifiedCache::VerifiedCache(Options options, std::string directory) : options_(options) {
+  if (options_.persistent && !directory.empty()) {
+    directory_ = std::move(directory);
+    writer_ = td::thread([this] { run_writer(); });
+  }
+}
+
+VerifiedCache::~VerifiedCache() {
+  if (directory_.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    closed_ = true;
+  }
+  writer_cv_.notify_all();
+  writer_.join();
+}
+
+bool VerifiedCache::has_shard_proof(const ton::BlockIdExt &mc_blk, const ton::BlockIdExt &shard_blk) {
+  auto key = shard_proof_key(mc_blk, shard_blk);
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (find(key)) {
+    return true;
+  }
+  if (load(key).is_error()) {
+    stats_.misses++;
+    return false;
+  }
+  stats_.loaded++;
+  insert(std::move(key), 0);
+  return true;
+}
+
+void VerifiedCache::add_shard_proof(const ton::BlockIdExt &mc_blk, const ton::BlockIdExt &shard_blk) {
+  auto key = shard_proof_key(mc_blk, shard_blk);
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (entries_.count(key) != 0) {
+    return;
+  }
+  save(key, "");
+  insert(std::move(key), 0);
+}
+
+td::optional<block::AccountState::Info> VerifiedCache::get_account_state(const ton::BlockIdExt &mc_blk,
+                                                                         const block::StdAddress &addr) {
+  auto key = account_state_key(mc_blk, addr);
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (auto entry = find(key)) {
+    return entry->account_state;
+  }
+  size_t size = 0;
+  auto r_info = [&]() -> td::Result<block::AccountState::Info> {
+    TRY_RESULT(value, load(key));
+    size = value.size();
+    PersistedAccountState state;
+    TRY_STATUS(td::unserialize(state, value));
+    block::AccountState::Info res;
+    if (!state.true_root.empty()) {
+      TRY_RESULT(true_root, vm::std_boc_deserialize(state.true_root));
+      res.true_root = std::move(true_root);
+      res.root = state.is_virtualized ? vm::MerkleProof::virtualize(res.true_root, 1) : res.true_root;
+      if (res.root.is_null()) {
+        return td::Status::Error("invalid account state proof");
+      }
+    }
+    res.last_trans_lt = state.last_trans_lt;
+    res.last_trans_hash = state.last_trans_hash;
+    res.gen_lt = state.gen_lt;
+    res.gen_utime = state.gen_utime;
+    return res;
+  }();
+  if (r_info.is_error()) {
+    stats_.misses++;
+    return {};
+  }
+  stats_.loaded++;
+  auto entry = insert(std::move(key), size);
+  entry->account_state = r_info.move_as_ok();
+  return entry->account_state;
+}
+
+void VerifiedCache::add_account_state(const ton::BlockIdExt &mc_blk, const block::StdAddress &addr,
+                                      const block::AccountState::Info &info, size_t serialized_size) {
+  auto key = account_state_key(mc_blk, addr);
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (entries_.count(key) != 0) {
+    return;
+  }
+  if (!directory_.empty()) {
+    PersistedAccountState state;
+    if (info.true_root.not_null()) {
+      auto r_boc = vm::std_boc_serialize(info.true_root);
+      if (r_boc.is_ok()) {
+        state.true_root = r_boc.ok().as_slice().str();
+        state.is_virtualized = info.root.get() != info.true_root.get();
+      }
+    }
+    if (info.true_root.is_null() || !state.true_root.empty()) {
+      state.last_trans_lt = info.last_trans_lt;
+      state.last_trans_hash = info.last_trans_hash;
+      state.gen_lt = info.gen_lt;
+      state.gen_utime = info.gen_utime;
+      save(key, td::serialize(state));
+    }
+  }
+  auto entry = insert(std::move(key), serialized_size);
+  entry->account_state = info;
+}
+
+td::optional<td::BufferSlice> VerifiedCache::get_block_data(const ton::BlockIdExt &blk) {
+  auto key = block_data_key(blk);
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (auto entry = find(key)) {
+    return entry->data.clone();
+  }
+  stats_.misses++;
+  return {};
+}
+
+void VerifiedCache::add_block_data(const ton::BlockIdExt &blk, const td::BufferSlice &data) {
+  auto key = block_data_key(blk);
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (entries_.count(key) != 0) {
+    return;
+  }
+  auto entry = insert(std::move(key), data.size());
+  entry->data = data.clone();
+}
+
+VerifiedCache::Stats VerifiedCache::get_stats() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto res = stats_;
+  res.size = size_;
+  return res;
+}
+
+void VerifiedCache::flush() {
+  if (directory_.empty()) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  flushed_cv_.wait(lock, [&] { return writer_ready_ && pending_.empty() && !writing_; });
+}
+
+VerifiedCache::Entry *VerifiedCache::find(td::Slice key) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  stats_.hits++;
+  auto entry = it->second.get();
+  entry->remove();
+  lru_.put(entry);
+  return entry;
+}
+
+VerifiedCache::Entry *VerifiedCache::insert(std::string key, size_t size) {
+  auto entry = std::make_unique<Entry>();
+  entry->key = key;
+  entry->size = size + key.size() + entry_overhead;
+  size_ += entry->size;
+  auto res = entry.get();
+  lru_.put(res);
+  entries_[std::move(key)] = std::move(entry);
+  // the new entry is kept even if it alone is larger than the limit
+  while (size_ > options_.max_size && lru_.prev != res) {
+    stats_.evictions++;
+    erase(Entry::from_list_node(lru_.prev));
+  }
+  return res;
+}
+
+void VerifiedCache::erase(Entry *entry) {
+  entry->remove();
+  size_ -= entry->size;
+  auto it = entries_.find(entry->key);
+  CHECK(it != entries_.end());
+  entries_.erase(it);
+}
+
+// the records are read under mutex_, but they are small and read only on a miss of the memory cache
+td::Result<std::string> VerifiedCache::load(td::Slice key) {
+  auto it = persisted_.find(key);
+  if (it == persisted_.end()) {
+    return td::Status::Error("not found");
+  }
+  std::string record(it->second.size, '\0');
+  TRY_STATUS(pread_all(file_, record, it->second.offset));
+  td::Slice record_key, value;
+  TRY_STATUS(parse_record(record, record_key, value));
+  if (record_key != key) {
+    return td::Status::Error("key mismatch");
+  }
+  return value.str();
+}
+
+void VerifiedCache::save(std::string key, std::string value) {
+  if (directory_.empty()) {
+    return;
+  }
+  pending_.emplace_back(std::move(key), std::move(value));
+  writer_cv_.notify_one();
+}
+
+std::string VerifiedCache::serialize_record(td::Slice key, td::Slice value) {
+  std::string record(record_header_size + key.size() + value.size(), '\0');
+  td::MutableSlice data(record);
+  td::as<td::uint32>(data.data() + 8) = td::narrow_cast<td::uint32>(key.size());
+  td::as<td::uint32>(data.data() + 12) = td::narrow_cast<td::uint32>(value.size());
+  data.substr(record_header_size).copy_from(key);
+  data.substr(record_header_size + key.size()).copy_from(value);
+  td::as<td::uint64>(data.data()) = td::crc64(data.substr(8));
+  return record;
+}
+
+std::string VerifiedCache::store_path() const {
+  return directory_ + TD_DIR_SLASH + "cache";
+}
+
+// indexes the valid records of the store and cuts off a partially written or corrupted tail
+td::Status VerifiedCache::open_store(td::int64 &end_offset, size_t &records) {
+  td::mkdir(directory_).ignore();
+  auto path = store_path();
+  TRY_RESULT(file, td::FileFd::open(path, td::FileFd::Read | td::FileFd::Write | td::FileFd::Create));
+  // a cache replaced after a change of the config may still be writing its last batch
+  TRY_STATUS(file.lock(td::FileFd::LockFlags::Write, path, 100));
+  TRY_RESULT(file_size, file.get_size());
+  std::map<std::string, Record, std::less<>> index;
+  end_offset = 0;
+  records = 0;
+  std::string header(record_header_size, '\0');
+  std::string record;
+  while (end_offset + static_cast<td::int64>(record_header_size) <= file_size) {
+    if (pread_all(file, header, end_offset).is_error()) {
+      break;
+    }
+    size_t size = record_header_size + td::as<td::uint32>(header.data() + 8) + td::as<td::uint32>(header.data() + 12);
+    if (size > max_record_size || end_offset + static_cast<td::int64>(size) > file_size) {
+      break;
+    }
+    record.resize(size);
+    td::Slice key, value;
+    if (pread_all(file, record, end_offset).is_error() || parse_record(record, key, value).is_error()) {
+      break;
+    }
+    index[key.str()] = Record{end_offset, size};
+    end_offset += size;
+    records++;
+  }
+  if (end_offset != file_size) {
+    LOG(WARNING) << "Dropping " << file_size - end_offset << " bytes of damaged records from verified cache";
+    TRY_STATUS(file.seek(end_offset));
+    TRY_STATUS(file.truncate_to_current_position(end_offset));
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  file_ = std::move(file);
+  persisted_ = std::move(index);
+  return td::Status::OK();
+}
+
+void VerifiedCache::run_writer() {
+  td::int64 end_offset = 0;
+  size_t records = 0;
+  auto status = open_store(end_offset, records);
+  if (status.is_error()) {
+    LOG(WARNING) << "Failed to open verified cache in " << directory_ << ": " << status;
+  }
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    writer_ready_ = true;
+  }
+  flushed_cv_.notify_all();
+
+  auto write_batch = [&](std::vector<std::pair<std::string, std::string>> &batch) -> td::Status {
+    if (records + batch.size() > max_persisted_records) {
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        persisted_.clear();
+      }
+      end_offset = 0;
+      records = 0;
+      TRY_STATUS(file_.seek(0));
+      TRY_STATUS(file_.truncate_to_current_position(0));
+    }
+    // the batch is written with a single call, and becomes visible to load() only once it is written
+    std::string data;
+    std::vector<std::pair<std::string, Record>> added;
+    for (auto &entry : batch) {
+      auto record = serialize_record(entry.first, entry.second);
+      Record location{end_offset + static_cast<td::int64>(data.size()), record.size()};
+      added.emplace_back(std::move(entry.first), location);
+      data += record;
+    }
+    TRY_STATUS(pwrite_all(file_, data, end_offset));
+    end_offset += static_cast<td::int64>(data.size());
+    records += added.size();
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (auto &entry : added) {
+      persisted_[std::move(entry.first)] = entry.second;
+    }
+    return td::Status::OK();
+  };
+
+  while (true) {
+    std::vector<std::pair<std::string, std::string>> batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      writer_cv_.wait(lock, [&] { return closed_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        break;
+      }
+      batch.swap(pending_);
+      writing_ = true;
+    }
+    // the batch is dropped if the store couldn't be opened
+    if (!file_.empty()) {
+      auto S = write_batch(batch);
+      if (S.is_error()) {
+        LOG(WARNING) << "Failed to write verified cache in " << directory_ << ": " << S;
+      }
+    }
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      writing_ = false;
+    }
+    flushed_cv_.notify_all();
+  }
+  if (!file_.empty()) {
+    file_.lock(td::FileFd::LockFlags::Unlock, store_path(), 1).ignore();
+    file_.close();
+  }
+}
+
+}  // namespace tonlib
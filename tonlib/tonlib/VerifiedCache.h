@@ -0,0 +1,137 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "block/block.h"
+#include "block/check-proof.h"
+#include "ton/ton-types.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/List.h"
+#include "td/utils/optional.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/thread.h"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+namespace tonlib {
+
+// Bounded LRU cache of liteserver answers that were already verified against a trusted block id.
+// Everything cached is determined by the block id, so entries never become outdated.
+// Shard block proofs and account states may also be persisted to a single append-only file, so that they are not
+// downloaded and verified again after a restart; block data is kept in memory only, as verifying it is just a hash
+// check. The file is loaded and written by a background thread, so persisted entries become visible shortly after
+// the construction and the writes don't block the callers.
+class VerifiedCache {
+ public:
+  struct Options {
+    size_t max_size{64 << 20};
+    bool persistent{false};
+  };
+  struct Stats {
+    td::uint64 hits{0};
+    td::uint64 misses{0};
+    td::uint64 evictions{0};
+    td::uint64 loaded{0};  // entries loaded from the persistent store
+    size_t size{0};
+  };
+
+  // the persistent store is kept in directory, which is used only if options.persistent is set
+  VerifiedCache(Options options, std::string directory);
+  VerifiedCache(const VerifiedCache &) = delete;
+  VerifiedCache &operator=(const VerifiedCache &) = delete;
+  // waits for the pending writes
+  ~VerifiedCache();
+
+  // shard_blk was proven to be the shard block of mc_blk
+  bool has_shard_proof(const ton::BlockIdExt &mc_blk, const ton::BlockIdExt &shard_blk);
+  void add_shard_proof(const ton::BlockIdExt &mc_blk, const ton::BlockIdExt &shard_blk);
+
+  // state of addr at mc_blk, returned by block::AccountState::validate()
+  td::optional<block::AccountState::Info> get_account_state(const ton::BlockIdExt &mc_blk,
+                                                            const block::StdAddress &addr);
+  void add_account_state(const ton::BlockIdExt &mc_blk, const block::StdAddress &addr,
+                         const block::AccountState::Info &info, size_t serialized_size);
+
+  // data of blk, checked against its file hash
+  td::optional<td::BufferSlice> get_block_data(const ton::BlockIdExt &blk);
+  void add_block_data(const ton::BlockIdExt &blk, const td::BufferSlice &data);
+
+  Stats get_stats();
+  // waits until the persistent store is loaded and all entries added so far are written
+  void flush();
+
+ private:
+  struct Entry : public td::ListNode {
+    std::string key;
+    block::AccountState::Info account_state;
+    td::BufferSlice data;
+    size_t size{0};
+
+    static Entry *from_list_node(td::ListNode *node) {
+      return static_cast<Entry *>(node);
+    }
+  };
+
+  // location of a record of the persistent store
+  struct Record {
+    td::int64 offset;
+    size_t size;
+  };
+
+  static constexpr size_t entry_overhead = sizeof(Entry) + 64;
+  // the persistent store is emptied once it has this many records
+  static constexpr size_t max_persisted_records = 1 << 16;
+
+  Options options_;
+  std::string directory_;
+
+  std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Entry>, std::less<>> entries_;
+  td::ListNode lru_;
+  size_t size_{0};
+  Stats stats_;
+
+  // the persistent store; file_ is opened by the writer thread before persisted_ becomes non-empty
+  td::FileFd file_;
+  std::map<std::string, Record, std::less<>> persisted_;
+  std::vector<std::pair<std::string, std::string>> pending_;  // records to be written
+  bool writing_{false};
+  bool writer_ready_{false};  // the store is loaded or couldn't be opened
+  bool closed_{false};
+  std::condition_variable writer_cv_;
+  std::condition_variable flushed_cv_;
+  td::thread writer_;
+
+  Entry *find(td::Slice key);
+  Entry *insert(std::string key, size_t size);
+  void erase(Entry *entry);
+
+  td::Result<std::string> load(td::Slice key);
+  void save(std::string key, std::string value);
+
+  void run_writer();
+  std::string store_path() const;
+  td::Status open_store(td::int64 &end_offset, size_t &records);
+  static std::string serialize_record(td::Slice key, td::Slice value);
+};
+
+}  // namespace tonlib
@@ -34,6 +34,8 @@
 #include "common/errorlog.h"
 
 #include "crypto/vm/cp0.h"
+#include "crypto/vm/dict.h"
+#include "crypto/vm/opctable.h"
 #include "crypto/fift/utils.h"
 
 #include "td/utils/filesystem.h"
@@ -1327,6 +1329,33 @@ td::Status ValidatorEngine::load_global_config() {
   if (truncate_seqno_ > 0) {
     validator_options_.write().truncate_db(truncate_seqno_);
   }
+  if (celldb_cache_size_ > 0) {
+    validator_options_.write().set_celldb_cache_size(celldb_cache_size_);
+  }
+  if (celldb_commit_threads_ > 0) {
+    validator_options_.write().set_celldb_commit_threads(celldb_commit_threads_);
+  }
+  if (celldb_read_threads_ > 0) {
+    validator_options_.write().set_celldb_read_threads(celldb_read_threads_);
+  }
+  if (celldb_prefetch_threads_ > 0) {
+    validator_options_.write().set_celldb_prefetch_threads(celldb_prefetch_threads_);
+  }
+  if (state_deserialize_threads_ > 0) {
+    validator_options_.write().set_state_deserialize_threads(state_deserialize_threads_);
+  }
+  if (collator_threads_ > 0) {
+    validator_options_.write().set_collator_threads(collator_threads_);
+  }
+  if (validate_threads_ > 0) {
+    validator_options_.write().set_validate_threads(validate_threads_);
+  }
+  if (celldb_rocksdb_options_) {
+    validator_options_.write().set_celldb_rocksdb_options(celldb_rocksdb_options_.value());
+  }
+  if (archive_rocksdb_options_) {
+    validator_options_.write().set_archive_rocksdb_options(archive_rocksdb_options_.value());
+  }
 
   std::vector<ton::BlockIdExt> h;
   for (auto &x : conf.validator_->hardforks_) {
@@ -3059,6 +3088,12 @@ void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getStats
           for (auto &s : r) {
             vec.push_back(ton::create_tl_object<ton::ton_api::engine_validator_oneStat>(s.first, s.second));
           }
+          if (td::actor::need_actor_stats()) {
+            for (auto &stat : td::actor::core::ActorTypeStat::get_snapshots()) {
+              vec.push_back(ton::create_tl_object<ton::ton_api::engine_validator_oneStat>(
+                  PSTRING() << "actor." << stat.name, PSTRING() << stat));
+            }
+          }
           promise.set_value(ton::create_serialize_tl_object<ton::ton_api::engine_validator_stats>(std::move(vec)));
         }
       });
@@ -3432,11 +3467,116 @@ int main(int argc, char *argv[]) {
                  acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_truncate_seqno, v); });
                  return td::Status::OK();
                });
+  p.add_option('M', "celldb-cache-size", "size of in-memory cache of celldb cells (in bytes) default=0 (disabled)",
+               [&](td::Slice fname) {
+                 TRY_RESULT(v, td::to_integer_safe<td::uint64>(fname));
+                 acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_cache_size, v); });
+                 return td::Status::OK();
+               });
+  p.add_option('P', "celldb-commit-threads",
+               "number of threads used to look up and serialize cells when a state is stored to celldb default=0 "
+               "(store in celldb thread)",
+               [&](td::Slice fname) {
+                 TRY_RESULT(v, td::to_integer_safe<td::uint32>(fname));
+                 acts.push_back(
+                     [&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_commit_threads, v); });
+                 return td::Status::OK();
+               });
+  p.add_option('r', "celldb-read-threads",
+               "number of actors loading cells from the latest celldb snapshot in parallel default=0 (load in "
+               "celldb actor)",
+               [&](td::Slice fname) {
+                 TRY_RESULT(v, td::to_integer_safe<td::uint32>(fname));
+                 acts.push_back([&x, v]() {
+                   td::actor::send_closure(x, &ValidatorEngine::set_celldb_read_threads, v);
+                 });
+                 return td::Status::OK();
+               });
+  p.add_option('p', "celldb-prefetch-threads",
+               "number of threads loading descendants of cells read during bulk traversals into the celldb cache "
+               "in advance default=0 (disabled, requires --celldb-cache-size)",
+               [&](td::Slice fname) {
+                 TRY_RESULT(v, td::to_integer_safe<td::uint32>(fname));
+                 acts.push_back([&x, v]() {
+                   td::actor::send_closure(x, &ValidatorEngine::set_celldb_prefetch_threads, v);
+                 });
+                 return td::Status::OK();
+               });
+  p.add_option('Z', "state-deserialize-threads",
+               "number of threads deserializing large shard states (at most the number of cpu cores) default=1",
+               [&](td::Slice fname) {
+                 TRY_RESULT(v, td::to_integer_safe<td::uint32>(fname));
+                 acts.push_back([&x, v]() {
+                   td::actor::send_closure(x, &ValidatorEngine::set_state_deserialize_threads, v);
+                 });
+                 return td::Status::OK();
+               });
+  p.add_option('N', "collator-threads",
+               "number of threads executing transactions of different accounts when collating shardchain blocks "
+               "(at most the number of cpu cores) default=1",
+               [&](td::Slice fname) {
+                 TRY_RESULT(v, td::to_integer_safe<td::uint32>(fname));
+                 acts.push_back([&x, v]() {
+                   td::actor::send_closure(x, &ValidatorEngine::set_collator_threads, v);
+                 });
+                 return td::Status::OK();
+               });
+  p.add_option('V', "validate-threads",
+               "number of threads checking transactions of different accounts when validating shardchain blocks, "
+               "taken from the collator thread pool (at most the number of cpu cores) default=1",
+               [&](td::Slice fname) {
+                 TRY_RESULT(v, td::to_integer_safe<td::uint32>(fname));
+                 acts.push_back([&x, v]() {
+                   td::actor::send_closure(x, &ValidatorEngine::set_validate_threads, v);
+                 });
+                 return td::Status::OK();
+               });
+  p.add_option('F', "frozen-dicts",
+               "serve lookups in the configuration, shard configuration and public libraries dictionaries from "
+               "read-only in-memory indexes built on first use",
+               [&]() {
+                 vm::FrozenDictionary::enable(true);
+                 return td::Status::OK();
+               });
+  p.add_option('O', "tvm-decode-cache",
+               "remember the opcode table lookups of executed code cells, shared by the collator, the validator and "
+               "runSmcMethod of the liteserver",
+               [&]() {
+                 vm::OpcodeTable::enable_decode_cache(true);
+                 return td::Status::OK();
+               });
+  p.add_option('R', "celldb-rocksdb-options",
+               "comma-separated RocksDB options of celldb, e.g. block_cache_size=4G,bloom_bits_per_key=10 (options: "
+               "block_cache_size, shared_cache_name, block_size, bloom_bits_per_key, whole_key_filtering, "
+               "prefix_length, compression, compaction_style, rate_limit, direct_io)",
+               [&](td::Slice fname) {
+                 auto v = td::RocksDbOptions::cell_db();
+                 TRY_STATUS(v.apply(fname));
+                 acts.push_back(
+                     [&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_rocksdb_options, v); });
+                 return td::Status::OK();
+               });
+  p.add_option('a', "archive-rocksdb-options",
+               "comma-separated RocksDB options of archive indexes, same as in --celldb-rocksdb-options",
+               [&](td::Slice fname) {
+                 auto v = td::RocksDbOptions::archive_index();
+                 TRY_STATUS(v.apply(fname));
+                 acts.push_back(
+                     [&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_archive_rocksdb_options, v); });
+                 return td::Status::OK();
+               });
   p.add_option('U', "unsafe-catchain-restore", "use SLOW and DANGEROUS catchain recover method", [&](td::Slice id) {
     TRY_RESULT(seq, td::to_integer_safe<ton::CatchainSeqno>(id));
     acts.push_back([&x, seq]() { td::actor::send_closure(x, &ValidatorEngine::add_unsafe_catchain, seq); });
     return td::Status::OK();
   });
+  p.add_option('x', "actor-stats",
+               "collect per actor name counters of messages, execution time, queueing delay and mailbox size; "
+               "they are dumped with scheduler status and returned by getstats",
+               [&]() {
+                 td::actor::set_actor_stats(true);
+                 return td::Status::OK();
+               });
   td::uint32 threads = 7;
   p.add_option('t', "threads", PSTRING() << "number of threads (default=" << threads << ")", [&](td::Slice fname) {
     td::int32 v;
@@ -3480,6 +3620,9 @@ int main(int argc, char *argv[]) {
     if (need_scheduler_status_flag.exchange(false)) {
       LOG(ERROR) << "DUMPING SCHEDULER STATISTICS";
       scheduler.get_debug().dump();
+      if (td::actor::need_actor_stats()) {
+        scheduler.get_debug().dump_actor_stats();
+      }
     }
     if (rotate_logs_flags.exchange(false)) {
       if (td::log_interface) {
@@ -37,6 +37,7 @@
 #include "adnl/adnl-ext-client.h"
 
 #include "td/actor/MultiPromise.h"
+#include "td/utils/optional.h"
 
 #include "auto/tl/ton_api_json.h"
 #include "auto/tl/ton_api.hpp"
@@ -199,6 +200,15 @@ class ValidatorEngine : public td::actor::Actor {
   bool started_keyring_ = false;
   bool started_ = false;
   ton::BlockSeqno truncate_seqno_{0};
+  td::uint64 celldb_cache_size_{0};
+  td::uint32 celldb_commit_threads_{0};
+  td::uint32 celldb_read_threads_{0};
+  td::uint32 celldb_prefetch_threads_{0};
+  td::uint32 state_deserialize_threads_{0};
+  td::uint32 collator_threads_{0};
+  td::uint32 validate_threads_{0};
+  td::optional<td::RocksDbOptions> celldb_rocksdb_options_;
+  td::optional<td::RocksDbOptions> archive_rocksdb_options_;
 
   std::set<ton::CatchainSeqno> unsafe_catchains_;
 
@@ -234,6 +244,33 @@ class ValidatorEngine : public td::actor::Actor {
   void set_truncate_seqno(ton::BlockSeqno seqno) {
     truncate_seqno_ = seqno;
   }
+  void set_celldb_cache_size(td::uint64 value) {
+    celldb_cache_size_ = value;
+  }
+  void set_celldb_commit_threads(td::uint32 value) {
+    celldb_commit_threads_ = value;
+  }
+  void set_celldb_read_threads(td::uint32 value) {
+    celldb_read_threads_ = value;
+  }
+  void set_celldb_prefetch_threads(td::uint32 value) {
+    celldb_prefetch_threads_ = value;
+  }
+  void set_state_deserialize_threads(td::uint32 value) {
+    state_deserialize_threads_ = value;
+  }
+  void set_collator_threads(td::uint32 value) {
+    collator_threads_ = value;
+  }
+  void set_validate_threads(td::uint32 value) {
+    validate_threads_ = value;
+  }
+  void set_celldb_rocksdb_options(td::RocksDbOptions value) {
+    celldb_rocksdb_options_ = std::move(value);
+  }
+  void set_archive_rocksdb_options(td::RocksDbOptions value) {
+    archive_rocksdb_options_ = std::move(value);
+  }
   void add_ip(td::IPAddress addr) {
     addrs_.push_back(addr);
   }
@@ -55,7 +55,8 @@ std::string PackageId::name() const {
   }
 }
 
-ArchiveManager::ArchiveManager(td::actor::ActorId<RootDb> root, std::string db_root) : db_root_(db_root) {
+ArchiveManager::ArchiveManager(td::actor::ActorId<RootDb> root, std::string db_root, td::RocksDbOptions db_options)
+    : db_root_(db_root), db_options_(std::move(db_options)) {
 }
 
 void ArchiveManager::add_handle(BlockHandle handle, td::Promise<td::Unit> promise) {
@@ -357,6 +358,31 @@ void ArchiveManager::add_persistent_state(BlockIdExt block_id, BlockIdExt master
       .release();
 }
 
+void ArchiveManager::add_persistent_state_gen(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                              std::function<td::Status(td::FileFd&)> write_state,
+                                              td::Promise<td::Unit> promise) {
+  auto id = FileReference{fileref::PersistentState{block_id, masterchain_block_id}};
+  auto hash = id.hash();
+  if (perm_states_.find(hash) != perm_states_.end()) {
+    promise.set_value(td::Unit());
+    return;
+  }
+
+  auto path = db_root_ + "/archive/states/" + id.filename_short();
+  auto P = td::PromiseCreator::lambda(
+      [SelfId = actor_id(this), id = id.shortref(), promise = std::move(promise)](td::Result<std::string> R) mutable {
+        if (R.is_error()) {
+          promise.set_error(R.move_as_error());
+        } else {
+          td::actor::send_closure(SelfId, &ArchiveManager::written_perm_state, id);
+          promise.set_value(td::Unit());
+        }
+      });
+  td::actor::create_actor<db::WriteFile>("writefile", db_root_ + "/archive/tmp/", path, std::move(write_state),
+                                         std::move(P))
+      .release();
+}
+
 void ArchiveManager::get_zero_state(BlockIdExt block_id, td::Promise<td::BufferSlice> promise) {
   auto id = FileReference{fileref::ZeroState{block_id}};
   auto hash = id.hash();
@@ -369,6 +395,19 @@ void ArchiveManager::get_zero_state(BlockIdExt block_id, td::Promise<td::BufferS
   td::actor::create_actor<db::ReadFile>("readfile", path, 0, -1, 0, std::move(promise)).release();
 }
 
+void ArchiveManager::get_zero_state_view(BlockIdExt block_id, td::Promise<td::BlobView> promise) {
+  auto id = FileReference{fileref::ZeroState{block_id}};
+  auto hash = id.hash();
+  if (perm_states_.find(hash) == perm_states_.end()) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "zerostate not in db"));
+    return;
+  }
+
+  // state files are never modified after they are written, so they can be mapped instead of read
+  auto path = db_root_ + "/archive/states/" + id.filename_short();
+  promise.set_result(td::FileMemoryMappingBlobView::create(path, 0, td::MemoryMapping::Advice::Random));
+}
+
 void ArchiveManager::check_zero_state(BlockIdExt block_id, td::Promise<bool> promise) {
   auto id = FileReference{fileref::ZeroState{block_id}};
   auto hash = id.hash();
@@ -566,7 +605,7 @@ void ArchiveManager::load_package(PackageId id) {
     }
   }
 
-  desc.file = td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false, db_root_);
+  desc.file = td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false, db_root_, db_options_);
 
   get_file_map(id).emplace(id, std::move(desc));
 }
@@ -599,7 +638,7 @@ ArchiveManager::FileDescription *ArchiveManager::add_file_desc(ShardIdFull shard
   FileDescription desc{id, false};
   td::mkdir(db_root_ + id.path()).ensure();
   std::string prefix = PSTRING() << db_root_ << id.path() << id.name();
-  desc.file = td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false, db_root_);
+  desc.file = td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false, db_root_, db_options_);
   if (!id.temp) {
     update_desc(desc, shard, seqno, ts, lt);
   }
@@ -837,7 +876,7 @@ void ArchiveManager::start_up() {
   td::mkdir(db_root_ + "/archive/states/").ensure();
   td::mkdir(db_root_ + "/files/").ensure();
   td::mkdir(db_root_ + "/files/packages/").ensure();
-  index_ = std::make_shared<td::RocksDb>(td::RocksDb::open(db_root_ + "/files/globalindex").move_as_ok());
+  index_ = std::make_shared<td::RocksDb>(td::RocksDb::open(db_root_ + "/files/globalindex", db_options_).move_as_ok());
   std::string value;
   auto v = index_->get(create_serialize_tl_object<ton_api::db_files_index_key>().as_slice(), value);
   v.ensure();
@@ -19,6 +19,8 @@
 #pragma once
 
 #include "archive-slice.hpp"
+#include "td/db/RocksDbOptions.h"
+#include "td/db/utils/BlobView.h"
 
 namespace ton {
 
@@ -28,7 +30,7 @@ class RootDb;
 
 class ArchiveManager : public td::actor::Actor {
  public:
-  ArchiveManager(td::actor::ActorId<RootDb> root, std::string db_root);
+  ArchiveManager(td::actor::ActorId<RootDb> root, std::string db_root, td::RocksDbOptions db_options);
 
   void add_handle(BlockHandle handle, td::Promise<td::Unit> promise);
   void update_handle(BlockHandle handle, td::Promise<td::Unit> promise);
@@ -45,7 +47,10 @@ class ArchiveManager : public td::actor::Actor {
   void add_zero_state(BlockIdExt block_id, td::BufferSlice data, td::Promise<td::Unit> promise);
   void add_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::BufferSlice data,
                             td::Promise<td::Unit> promise);
+  void add_persistent_state_gen(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                std::function<td::Status(td::FileFd&)> write_state, td::Promise<td::Unit> promise);
   void get_zero_state(BlockIdExt block_id, td::Promise<td::BufferSlice> promise);
+  void get_zero_state_view(BlockIdExt block_id, td::Promise<td::BlobView> promise);
   void get_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::Promise<td::BufferSlice> promise);
   void get_persistent_state_slice(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::int64 offset,
                                   td::int64 max_size, td::Promise<td::BufferSlice> promise);
@@ -143,6 +148,7 @@ class ArchiveManager : public td::actor::Actor {
   void got_gc_masterchain_handle(ConstBlockHandle handle, FileHash hash);
 
   std::string db_root_;
+  td::RocksDbOptions db_options_;
 
   std::shared_ptr<td::KeyValue> index_;
 
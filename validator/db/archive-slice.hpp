@@ -21,6 +21,7 @@
 #include "validator/interfaces/db.h"
 #include "package.hpp"
 #include "fileref.hpp"
+#include "td/db/RocksDbOptions.h"
 
 namespace ton {
 
@@ -73,7 +74,8 @@ class PackageWriter : public td::actor::Actor {
 
 class ArchiveSlice : public td::actor::Actor {
  public:
-  ArchiveSlice(td::uint32 archive_id, bool key_blocks_only, bool temp, bool finalized, std::string db_root);
+  ArchiveSlice(td::uint32 archive_id, bool key_blocks_only, bool temp, bool finalized, std::string db_root,
+               td::RocksDbOptions db_options);
 
   void get_archive_id(BlockSeqno masterchain_seqno, td::Promise<td::uint64> promise);
 
@@ -128,6 +130,7 @@ class ArchiveSlice : public td::actor::Actor {
   td::uint32 slice_size_{100};
 
   std::string db_root_;
+  td::RocksDbOptions db_options_;
   std::shared_ptr<td::KeyValue> kv_;
 
   struct PackageInfo {
@@ -28,15 +28,56 @@ namespace ton {
 
 namespace validator {
 
-CellDbIn::CellDbIn(td::actor::ActorId<RootDb> root_db, td::actor::ActorId<CellDb> parent, std::string path)
-    : root_db_(root_db), parent_(parent), path_(std::move(path)) {
+namespace {
+// upper bounds of the buckets of CellDb histograms; the last bucket is unbounded
+constexpr double read_latency_buckets[] = {0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0};
+constexpr size_t queue_depth_buckets[] = {1, 2, 4, 8, 16, 32, 64, 128, 256};
+
+template <class T, size_t N, size_t M>
+void add_to_histogram(std::array<td::uint64, M> &hist, const T (&buckets)[N], T value) {
+  static_assert(N + 1 == M, "wrong number of buckets");
+  size_t i = 0;
+  while (i < N && value > buckets[i]) {
+    i++;
+  }
+  hist[i]++;
+}
+
+template <class T, size_t N, size_t M>
+std::string histogram_to_string(const std::array<td::uint64, M> &hist, const T (&buckets)[N]) {
+  td::StringBuilder sb;
+  for (size_t i = 0; i < M; i++) {
+    if (i > 0) {
+      sb << " ";
+    }
+    if (i < N) {
+      sb << "<=" << buckets[i];
+    } else {
+      sb << ">" << buckets[N - 1];
+    }
+    sb << ":" << hist[i];
+  }
+  return sb.as_cslice().str();
+}
+}  // namespace
+
+CellDbIn::CellDbIn(td::actor::ActorId<RootDb> root_db, td::actor::ActorId<CellDb> parent, std::string path,
+                   td::Ref<ValidatorManagerOptions> opts, std::shared_ptr<vm::CellCache> cell_cache,
+                   std::shared_ptr<vm::CellPrefetcher> cell_prefetcher)
+    : root_db_(root_db)
+    , parent_(parent)
+    , path_(std::move(path))
+    , opts_(std::move(opts))
+    , cell_cache_(std::move(cell_cache))
+    , cell_prefetcher_(std::move(cell_prefetcher)) {
 }
 
 void CellDbIn::start_up() {
-  cell_db_ = std::make_shared<td::RocksDb>(td::RocksDb::open(path_).move_as_ok());
+  cell_db_ = std::make_shared<td::RocksDb>(td::RocksDb::open(path_, opts_->celldb_rocksdb_options()).move_as_ok());
 
   boc_ = vm::DynamicBagOfCellsDb::create();
-  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot())).ensure();
+  boc_->set_commit_threads(opts_->celldb_commit_threads());
+  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), cell_cache_, cell_prefetcher_)).ensure();
   td::actor::send_closure(parent_, &CellDb::update_snapshot, cell_db_->snapshot());
 
   alarm_timestamp() = td::Timestamp::in(10.0);
@@ -88,7 +129,7 @@ void CellDbIn::store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promi
 
   boc_->inc(cell);
   boc_->prepare_commit().ensure();
-  vm::CellStorer stor{*cell_db_.get()};
+  vm::CellStorer stor{*cell_db_.get(), cell_cache_};
   cell_db_->begin_write_batch().ensure();
   boc_->commit(stor).ensure();
   set_block(empty, std::move(E));
@@ -96,7 +137,7 @@ void CellDbIn::store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promi
   set_block(key_hash, std::move(D));
   cell_db_->commit_write_batch().ensure();
 
-  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot())).ensure();
+  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), cell_cache_, cell_prefetcher_)).ensure();
   td::actor::send_closure(parent_, &CellDb::update_snapshot, cell_db_->snapshot());
 
   promise.set_result(boc_->load_cell(cell->get_hash().as_slice()));
@@ -180,7 +221,7 @@ void CellDbIn::gc_cont2(BlockHandle handle) {
 
   boc_->dec(cell);
   boc_->prepare_commit().ensure();
-  vm::CellStorer stor{*cell_db_.get()};
+  vm::CellStorer stor{*cell_db_.get(), cell_cache_};
   cell_db_->begin_write_batch().ensure();
   boc_->commit(stor).ensure();
   cell_db_->erase(get_key(last_gc_)).ensure();
@@ -189,7 +230,7 @@ void CellDbIn::gc_cont2(BlockHandle handle) {
   cell_db_->commit_write_batch().ensure();
   alarm_timestamp() = td::Timestamp::now();
 
-  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot())).ensure();
+  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), cell_cache_, cell_prefetcher_)).ensure();
   td::actor::send_closure(parent_, &CellDb::update_snapshot, cell_db_->snapshot());
 
   DCHECK(get_block(last_gc_).is_error());
@@ -250,23 +291,114 @@ void CellDbIn::set_block(KeyHash key_hash, DbEntry e) {
 void CellDb::load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise) {
   if (!started_) {
     td::actor::send_closure(cell_db_, &CellDbIn::load_cell, hash, std::move(promise));
-  } else {
+  } else if (readers_.empty()) {
     auto R = boc_->load_cell(hash.as_slice());
     if (R.is_error()) {
       td::actor::send_closure(cell_db_, &CellDbIn::load_cell, hash, std::move(promise));
     } else {
       promise.set_result(R.move_as_ok());
     }
+  } else {
+    auto &pending = pending_loads_[hash];
+    pending.promises.push_back(std::move(promise));
+    if (pending.promises.size() > 1) {
+      deduplicated_reads_++;
+      return;
+    }
+    pending.started_at = td::Time::now();
+    reads_++;
+    add_to_histogram(queue_depth_hist_, queue_depth_buckets, pending_loads_.size());
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), hash](td::Result<td::Ref<vm::DataCell>> R) {
+      td::actor::send_closure(SelfId, &CellDb::loaded_cell, hash, std::move(R));
+    });
+    td::actor::send_closure(readers_[next_reader_], &CellDbReader::load_cell, hash, std::move(P));
+    next_reader_ = (next_reader_ + 1) % readers_.size();
+  }
+}
+
+void CellDb::loaded_cell(RootHash hash, td::Result<td::Ref<vm::DataCell>> R) {
+  auto it = pending_loads_.find(hash);
+  CHECK(it != pending_loads_.end());
+  auto pending = std::move(it->second);
+  pending_loads_.erase(it);
+  add_to_histogram(read_latency_hist_, read_latency_buckets, td::Time::now() - pending.started_at);
+  if (R.is_error()) {
+    // the cell may have been stored after the snapshot was taken
+    failed_reads_++;
+    for (auto &promise : pending.promises) {
+      td::actor::send_closure(cell_db_, &CellDbIn::load_cell, hash, std::move(promise));
+    }
+    return;
+  }
+  auto cell = R.move_as_ok();
+  for (auto &promise : pending.promises) {
+    promise.set_value(td::Ref<vm::DataCell>(cell));
   }
 }
 
+void CellDb::update_snapshot(std::unique_ptr<td::KeyValueReader> snapshot) {
+  started_ = true;
+  if (readers_.empty()) {
+    boc_->set_loader(std::make_unique<vm::CellLoader>(std::move(snapshot), cell_cache_, cell_prefetcher_)).ensure();
+    return;
+  }
+  std::shared_ptr<td::KeyValueReader> shared_snapshot = std::move(snapshot);
+  for (auto &reader : readers_) {
+    td::actor::send_closure(reader, &CellDbReader::update_snapshot, shared_snapshot);
+  }
+}
+
+void CellDb::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  std::vector<std::pair<std::string, std::string>> vec;
+  vec.emplace_back("readers", td::to_string(readers_.size()));
+  if (!readers_.empty()) {
+    vec.emplace_back("reads", td::to_string(reads_));
+    vec.emplace_back("deduplicatedreads", td::to_string(deduplicated_reads_));
+    vec.emplace_back("failedreads", td::to_string(failed_reads_));
+    vec.emplace_back("queuedepth", td::to_string(pending_loads_.size()));
+    vec.emplace_back("queuedepthhist", histogram_to_string(queue_depth_hist_, queue_depth_buckets));
+    vec.emplace_back("readlatencyhist", histogram_to_string(read_latency_hist_, read_latency_buckets));
+  }
+  if (cell_prefetcher_) {
+    // hit rate of prefetching is prefetchhits / prefetched
+    auto stats = cell_prefetcher_->get_stats();
+    auto cache_stats = cell_cache_->get_stats();
+    vec.emplace_back("prefetchrequests", td::to_string(stats.requests));
+    vec.emplace_back("prefetchdropped", td::to_string(stats.dropped));
+    vec.emplace_back("prefetchcached", td::to_string(stats.cached));
+    vec.emplace_back("prefetched", td::to_string(cache_stats.prefetched));
+    vec.emplace_back("prefetchhits", td::to_string(cache_stats.prefetch_hits));
+  }
+  promise.set_value(std::move(vec));
+}
+
 void CellDb::store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise) {
   td::actor::send_closure(cell_db_, &CellDbIn::store_cell, block_id, std::move(cell), std::move(promise));
 }
 
 void CellDb::start_up() {
+  cell_cache_ = vm::CellCache::create(td::narrow_cast<size_t>(opts_->celldb_cache_size()));
+  cell_prefetcher_ = vm::CellPrefetcher::create(cell_cache_, opts_->celldb_prefetch_threads());
   boc_ = vm::DynamicBagOfCellsDb::create();
-  cell_db_ = td::actor::create_actor<CellDbIn>("celldbin", root_db_, actor_id(this), path_);
+  for (td::uint32 i = 0; i < opts_->celldb_read_threads(); i++) {
+    readers_.push_back(
+        td::actor::create_actor<CellDbReader>(PSTRING() << "celldbreader" << i, cell_cache_, cell_prefetcher_));
+  }
+  cell_db_ = td::actor::create_actor<CellDbIn>("celldbin", root_db_, actor_id(this), path_, opts_, cell_cache_,
+                                               cell_prefetcher_);
+}
+
+void CellDbReader::start_up() {
+  boc_ = vm::DynamicBagOfCellsDb::create();
+}
+
+void CellDbReader::update_snapshot(std::shared_ptr<td::KeyValueReader> snapshot) {
+  boc_->set_loader(std::make_unique<vm::CellLoader>(std::move(snapshot), cell_cache_, cell_prefetcher_)).ensure();
+}
+
+void CellDbReader::load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise) {
+  td::PerfWarningTimer timer{"celldbreader.loadcell", 0.1};
+  promise.set_result(boc_->load_cell(hash.as_slice()));
 }
 
 CellDbIn::DbEntry::DbEntry(tl_object_ptr<ton_api::db_celldb_value> entry)
@@ -21,11 +21,17 @@
 #include "td/actor/actor.h"
 #include "crypto/vm/db/DynamicBagOfCellsDb.h"
 #include "crypto/vm/db/CellStorage.h"
+#include "crypto/vm/db/CellCache.h"
+#include "crypto/vm/db/CellPrefetcher.h"
 #include "td/db/KeyValue.h"
 #include "ton/ton-types.h"
 #include "interfaces/block-handle.h"
+#include "validator/validator.h"
 #include "auto/tl/ton_api.h"
 
+#include <array>
+#include <map>
+
 namespace ton {
 
 namespace validator {
@@ -41,7 +47,9 @@ class CellDbIn : public td::actor::Actor {
   void load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise);
   void store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise);
 
-  CellDbIn(td::actor::ActorId<RootDb> root_db, td::actor::ActorId<CellDb> parent, std::string path);
+  CellDbIn(td::actor::ActorId<RootDb> root_db, td::actor::ActorId<CellDb> parent, std::string path,
+           td::Ref<ValidatorManagerOptions> opts, std::shared_ptr<vm::CellCache> cell_cache,
+           std::shared_ptr<vm::CellPrefetcher> cell_prefetcher);
 
   void start_up() override;
   void alarm() override;
@@ -81,23 +89,43 @@ class CellDbIn : public td::actor::Actor {
   td::actor::ActorId<CellDb> parent_;
 
   std::string path_;
+  td::Ref<ValidatorManagerOptions> opts_;
 
   std::unique_ptr<vm::DynamicBagOfCellsDb> boc_;
   std::shared_ptr<vm::KeyValue> cell_db_;
+  std::shared_ptr<vm::CellCache> cell_cache_;
+  std::shared_ptr<vm::CellPrefetcher> cell_prefetcher_;
 
   KeyHash last_gc_;
 };
 
+// Loads cells from the latest snapshot of celldb; several readers run in parallel
+class CellDbReader : public td::actor::Actor {
+ public:
+  CellDbReader(std::shared_ptr<vm::CellCache> cell_cache, std::shared_ptr<vm::CellPrefetcher> cell_prefetcher)
+      : cell_cache_(std::move(cell_cache)), cell_prefetcher_(std::move(cell_prefetcher)) {
+  }
+
+  void update_snapshot(std::shared_ptr<td::KeyValueReader> snapshot);
+  void load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise);
+
+  void start_up() override;
+
+ private:
+  std::shared_ptr<vm::CellCache> cell_cache_;
+  std::shared_ptr<vm::CellPrefetcher> cell_prefetcher_;
+  std::unique_ptr<vm::DynamicBagOfCellsDb> boc_;
+};
+
 class CellDb : public td::actor::Actor {
  public:
   void load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise);
   void store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise);
-  void update_snapshot(std::unique_ptr<td::KeyValueReader> snapshot) {
-    started_ = true;
-    boc_->set_loader(std::make_unique<vm::CellLoader>(std::move(snapshot))).ensure();
-  }
+  void update_snapshot(std::unique_ptr<td::KeyValueReader> snapshot);
+  void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise);
 
-  CellDb(td::actor::ActorId<RootDb> root_db, std::string path) : root_db_(root_db), path_(path) {
+  CellDb(td::actor::ActorId<RootDb> root_db, std::string path, td::Ref<ValidatorManagerOptions> opts)
+      : root_db_(root_db), path_(path), opts_(std::move(opts)) {
   }
 
   void start_up() override;
@@ -105,11 +133,35 @@ class CellDb : public td::actor::Actor {
  private:
   td::actor::ActorId<RootDb> root_db_;
   std::string path_;
+  td::Ref<ValidatorManagerOptions> opts_;
 
   td::actor::ActorOwn<CellDbIn> cell_db_;
+  // shared with CellDbIn and readers
+  std::shared_ptr<vm::CellCache> cell_cache_;
+  // null unless opts_->celldb_prefetch_threads() > 0 and the cache is enabled
+  std::shared_ptr<vm::CellPrefetcher> cell_prefetcher_;
 
   std::unique_ptr<vm::DynamicBagOfCellsDb> boc_;
   bool started_ = false;
+
+  // used if opts_->celldb_read_threads() > 0 instead of boc_
+  std::vector<td::actor::ActorOwn<CellDbReader>> readers_;
+  size_t next_reader_ = 0;
+  // concurrent loads of the same cell share one read
+  struct PendingLoad {
+    std::vector<td::Promise<td::Ref<vm::DataCell>>> promises;
+    double started_at;
+  };
+  std::map<RootHash, PendingLoad> pending_loads_;
+
+  void loaded_cell(RootHash hash, td::Result<td::Ref<vm::DataCell>> R);
+
+  // see bucket bounds in celldb.cpp
+  std::array<td::uint64, 11> read_latency_hist_{};
+  std::array<td::uint64, 10> queue_depth_hist_{};
+  td::uint64 reads_{0};
+  td::uint64 deduplicated_reads_{0};
+  td::uint64 failed_reads_{0};
 };
 
 }  // namespace validator
@@ -22,9 +22,12 @@
 #include "td/utils/filesystem.h"
 #include "td/actor/actor.h"
 #include "td/utils/buffer.h"
+#include "td/utils/port/FileFd.h"
 
 #include "common/errorcode.h"
 
+#include <functional>
+
 namespace ton {
 
 namespace validator {
@@ -52,12 +55,23 @@ class WriteFile : public td::actor::Actor {
     auto res = R.move_as_ok();
     auto file = std::move(res.first);
     auto old_name = res.second;
-    td::uint64 offset = 0;
-    while (data_.size() > 0) {
-      auto R = file.pwrite(data_.as_slice(), offset);
-      auto s = R.move_as_ok();
-      offset += s;
-      data_.confirm_read(s);
+    if (write_data_) {
+      auto S = write_data_(file);
+      if (S.is_error()) {
+        file.close();
+        td::unlink(old_name).ignore();
+        promise_.set_error(std::move(S));
+        stop();
+        return;
+      }
+    } else {
+      td::uint64 offset = 0;
+      while (data_.size() > 0) {
+        auto R = file.pwrite(data_.as_slice(), offset);
+        auto s = R.move_as_ok();
+        offset += s;
+        data_.confirm_read(s);
+      }
     }
     file.sync().ensure();
     if (new_name_.length() > 0) {
@@ -71,11 +85,17 @@ class WriteFile : public td::actor::Actor {
   WriteFile(std::string tmp_dir, std::string new_name, td::BufferSlice data, td::Promise<std::string> promise)
       : tmp_dir_(tmp_dir), new_name_(new_name), data_(std::move(data)), promise_(std::move(promise)) {
   }
+  // the file is produced by write_data, which may stream it without keeping the whole content in memory
+  WriteFile(std::string tmp_dir, std::string new_name, std::function<td::Status(td::FileFd&)> write_data,
+            td::Promise<std::string> promise)
+      : tmp_dir_(tmp_dir), new_name_(new_name), write_data_(std::move(write_data)), promise_(std::move(promise)) {
+  }
 
  private:
   const std::string tmp_dir_;
   std::string new_name_;
   td::BufferSlice data_;
+  std::function<td::Status(td::FileFd&)> write_data_;
   td::Promise<std::string> promise_;
 };
 
@@ -47,7 +47,8 @@ class FullNodeShard : public td::actor::Actor {
   virtual void download_zero_state(BlockIdExt id, td::uint32 priority, td::Timestamp timeout,
                                    td::Promise<td::BufferSlice> promise) = 0;
   virtual void download_persistent_state(BlockIdExt id, BlockIdExt masterchain_block_id, td::uint32 priority,
-                                         td::Timestamp timeout, td::Promise<td::BufferSlice> promise) = 0;
+                                         std::string tmp_dir, td::Timestamp timeout,
+                                         td::Promise<td::BufferSlice> promise) = 0;
 
   virtual void download_block_proof(BlockIdExt block_id, td::uint32 priority, td::Timestamp timeout,
                                     td::Promise<td::BufferSlice> promise) = 0;
@@ -30,6 +30,7 @@
 #include "block/output-queue-merger.h"
 #include "vm/cells/MerkleProof.h"
 #include "vm/cells/MerkleUpdate.h"
+#include "td/utils/ThreadPool.h"
 #include <map>
 #include <queue>
 
@@ -39,6 +40,7 @@ namespace validator {
 using td::Ref;
 
 class Collator final : public td::actor::Actor {
+  friend class CollatorTest;
   static constexpr int supported_version() {
     return 5;
   }
@@ -84,6 +86,7 @@ class Collator final : public td::actor::Actor {
   static constexpr int max_ext_msg_size = 65535;   // 64k
   static constexpr int max_blk_sign_size = 65535;  // 64k
   static constexpr bool shard_splitting_enabled = true;
+  static constexpr unsigned precompute_window = 256;  // inbound queue entries precomputed at once
 
  public:
   Collator(ShardIdFull shard, bool is_hardfork, td::uint32 min_ts, BlockIdExt min_masterchain_block_id,
@@ -124,6 +127,7 @@ class Collator final : public td::actor::Actor {
   std::map<BlockSeqno, Ref<MasterchainStateQ>> aux_mc_states_;
   std::vector<block::McShardDescr> neighbors_;
   std::unique_ptr<block::OutputQueueMerger> nb_out_msgs_;
+  std::unique_ptr<block::OutputQueueMerger> nb_out_msgs_lookahead_;
   std::vector<ton::StdSmcAddress> special_smcs;
   std::vector<std::pair<ton::StdSmcAddress, int>> ticktock_smcs;
   Ref<vm::Cell> prev_block_root;
@@ -186,12 +190,23 @@ class Collator final : public td::actor::Actor {
   Ref<vm::Cell> shard_account_blocks_;  // ShardAccountBlocks
   std::vector<Ref<vm::Cell>> collated_roots_;
   std::unique_ptr<ton::BlockCandidate> block_candidate;
+  struct PrecomputedTransaction {
+    Ref<vm::Cell> msg_root;
+    ton::LogicalTime trans_min_lt;
+    std::unique_ptr<block::Account> account;  // state of the account the transaction has been created for
+    td::Result<std::unique_ptr<block::Transaction>> result;
+    std::unique_ptr<vm::CellUsageTree::LoadJournal> loads;  // cells of the previous state loaded meanwhile
+  };
+  std::map<ton::Bits256, PrecomputedTransaction> precomputed_trans_;  // by message hash
+  std::shared_ptr<td::ThreadPool> thread_pool_;                       // null = no parallel transactions
+  td::uint32 threads_n_ = 1;                                          // including the collator's own thread
 
   td::PerfWarningTimer perf_timer_{"collate", 0.1};
   //
   block::Account* lookup_account(td::ConstBitPtr addr) const;
   std::unique_ptr<block::Account> make_account_from(td::ConstBitPtr addr, Ref<vm::CellSlice> account,
                                                     Ref<vm::CellSlice> extra, bool force_create = false);
+  td::Result<std::unique_ptr<block::Account>> load_account(td::ConstBitPtr addr, bool force_create = false);
   td::Result<block::Account*> make_account(td::ConstBitPtr addr, bool force_create = false);
   td::actor::ActorId<Collator> get_self() {
     return actor_id(this);
@@ -233,6 +248,17 @@ class Collator final : public td::actor::Actor {
   bool create_ticktock_transactions(int mask);
   bool create_ticktock_transaction(const ton::StdSmcAddress& smc_addr, ton::LogicalTime req_start_lt, int mask);
   Ref<vm::Cell> create_ordinary_transaction(Ref<vm::Cell> msg_root);
+  static td::Result<std::unique_ptr<block::Transaction>> impl_create_ordinary_transaction(
+      Ref<vm::Cell> msg_root, block::Account* acc, ton::UnixTime utime, ton::LogicalTime lt,
+      ton::LogicalTime trans_min_lt, const block::StoragePhaseConfig* storage_phase_cfg,
+      const block::ComputePhaseConfig* compute_phase_cfg, const block::ActionPhaseConfig* action_phase_cfg,
+      bool external);
+  bool precompute_ordinary_transactions(const std::vector<Ref<vm::Cell>>& msgs, ton::LogicalTime trans_min_lt,
+                                        bool external);
+  unsigned precompute_inbound_internal_messages();
+  bool adopt_precomputed_transaction(PrecomputedTransaction& rec, const ton::StdSmcAddress& addr,
+                                     ton::LogicalTime trans_min_lt, block::Account*& acc,
+                                     td::Result<std::unique_ptr<block::Transaction>>& res);
   bool check_cur_validator_set();
   bool unpack_last_mc_state();
   bool unpack_last_state();
@@ -17,9 +17,11 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "collator-impl.h"
+#include "collator.h"
 #include "vm/boc.h"
 #include "td/db/utils/BlobView.h"
 #include "vm/db/StaticBagOfCellsDb.h"
+#include "vm/db/CellPrefetcher.h"
 #include "block/mc-config.h"
 #include "block/block.h"
 #include "block/block-parse.h"
@@ -35,6 +37,9 @@
 #include "top-shard-descr.hpp"
 #include <ctime>
 #include "td/utils/Random.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/ThreadPool.h"
+#include <mutex>
 
 namespace ton {
 
@@ -44,6 +49,40 @@ namespace validator {
 using td::Ref;
 using namespace std::literals::string_literals;
 
+namespace {
+// shared by collators and block validation, large enough for the bigger of the two thread counts
+std::mutex transaction_pool_mutex;
+std::shared_ptr<td::ThreadPool> transaction_pool_instance;
+td::uint32 collator_threads_n = 1;
+td::uint32 validate_threads_n = 1;
+
+void set_transaction_threads(td::uint32& dest, td::uint32 threads_n) {
+  threads_n = std::min(threads_n, std::max(td::thread::hardware_concurrency(), 1u));
+  std::lock_guard<std::mutex> guard(transaction_pool_mutex);
+  dest = std::max(threads_n, 1u);
+  auto pool_threads_n = std::max(collator_threads_n, validate_threads_n);
+  if (pool_threads_n <= 1) {
+    transaction_pool_instance = nullptr;
+  } else if (!transaction_pool_instance || transaction_pool_instance->size() + 1 != pool_threads_n) {
+    transaction_pool_instance = std::make_shared<td::ThreadPool>(pool_threads_n - 1);
+  }
+}
+}  // namespace
+
+void set_collator_threads(td::uint32 threads_n) {
+  set_transaction_threads(collator_threads_n, threads_n);
+}
+
+void set_validate_threads(td::uint32 threads_n) {
+  set_transaction_threads(validate_threads_n, threads_n);
+}
+
+std::shared_ptr<td::ThreadPool> get_transaction_pool(bool validate, td::uint32& threads_n) {
+  std::lock_guard<std::mutex> guard(transaction_pool_mutex);
+  threads_n = validate ? validate_threads_n : collator_threads_n;
+  return threads_n > 1 ? transaction_pool_instance : nullptr;
+}
+
 #define DBG(__n) dbg(__n)&&
 #define DSTART int __dcnt = 0;
 #define DEB DBG(++__dcnt)
@@ -68,6 +107,7 @@ Collator::Collator(ShardIdFull shard, bool is_hardfork, UnixTime min_ts, BlockId
     , manager(manager)
     , timeout(timeout)
     , main_promise(std::move(promise)) {
+  thread_pool_ = get_transaction_pool(false, threads_n_);
 }
 
 void Collator::start_up() {
@@ -1725,6 +1765,11 @@ bool Collator::do_collate() {
   CHECK(!nb_out_msgs_);
   LOG(DEBUG) << "creating OutputQueueMerger";
   nb_out_msgs_ = std::make_unique<block::OutputQueueMerger>(shard_, neighbors_);
+  if (thread_pool_ && !is_masterchain()) {
+    vm::CellUsageTree::LoadJournal loads{state_usage_tree_};
+    vm::CellUsageTree::LoadJournal::Guard guard{&loads};
+    nb_out_msgs_lookahead_ = std::make_unique<block::OutputQueueMerger>(shard_, neighbors_);
+  }
   // 1.4. compute created / minted / recovered
   if (!init_value_create()) {
     return fatal_error("cannot compute the value to be created / minted / recovered");
@@ -1841,6 +1886,8 @@ bool Collator::dequeue_message(Ref<vm::Cell> msg_envelope, ton::LogicalTime deli
 
 bool Collator::out_msg_queue_cleanup() {
   LOG(INFO) << "cleaning outbound queue from messages already imported by neighbors";
+  // the whole outbound queue is scanned
+  vm::CellPrefetcher::Scope prefetch_scope;
   if (verbosity >= 2) {
     auto rt = out_msg_queue_->get_root();
     std::cerr << "old out_msg_queue is ";
@@ -1937,11 +1984,7 @@ block::Account* Collator::lookup_account(td::ConstBitPtr addr) const {
   return found != accounts.end() ? found->second.get() : nullptr;
 }
 
-td::Result<block::Account*> Collator::make_account(td::ConstBitPtr addr, bool force_create) {
-  auto found = lookup_account(addr);
-  if (found) {
-    return found;
-  }
+td::Result<std::unique_ptr<block::Account>> Collator::load_account(td::ConstBitPtr addr, bool force_create) {
   auto dict_entry = account_dict->lookup_extra(addr, 256);
   if (dict_entry.first.is_null()) {
     if (!force_create) {
@@ -1956,6 +1999,18 @@ td::Result<block::Account*> Collator::make_account(td::ConstBitPtr addr, bool fo
     return td::Status::Error(PSTRING() << "account " << addr.to_hex(256) << " does not really belong to current shard "
                                        << shard_.to_str());
   }
+  return std::move(new_acc);
+}
+
+td::Result<block::Account*> Collator::make_account(td::ConstBitPtr addr, bool force_create) {
+  auto found = lookup_account(addr);
+  if (found) {
+    return found;
+  }
+  TRY_RESULT(new_acc, load_account(addr, force_create));
+  if (!new_acc) {
+    return nullptr;
+  }
   auto ins = accounts.emplace(addr, std::move(new_acc));
   if (!ins.second) {
     return td::Status::Error(PSTRING() << "cannot insert newly-extracted account " << addr.to_hex(256)
@@ -2211,94 +2266,255 @@ Ref<vm::Cell> Collator::create_ordinary_transaction(Ref<vm::Cell> msg_root) {
     return {};
   }
   LOG(DEBUG) << "inbound message to our smart contract " << addr.to_hex();
-  auto acc_res = make_account(addr.cbits(), true);
-  if (acc_res.is_error()) {
-    fatal_error(acc_res.move_as_error());
-    return {};
-  }
-  block::Account* acc = acc_res.move_as_ok();
-  assert(acc);
-  if (acc->last_trans_end_lt_ >= start_lt && acc->transactions.empty()) {
-    fatal_error(PSTRING() << "last transaction time in the state of account " << workchain() << ":" << addr.to_hex()
-                          << " is too large");
-    return {};
-  }
   auto trans_min_lt = start_lt;
   if (external) {
     // transactions processing external messages must have lt larger than all processed internal messages
     trans_min_lt = std::max(trans_min_lt, last_proc_int_msg_.first);
   }
+  block::Account* acc = nullptr;
+  td::Result<std::unique_ptr<block::Transaction>> res;
+  bool precomputed = false;
+  // a precomputed transaction refers to the account state it has been created for, which must outlive it
+  std::unique_ptr<block::Account> precomputed_account;
+  if (!precomputed_trans_.empty()) {
+    auto it = precomputed_trans_.find(msg_root->get_hash().bits());
+    if (it != precomputed_trans_.end()) {
+      precomputed = adopt_precomputed_transaction(it->second, addr, trans_min_lt, acc, res);
+      precomputed_account = std::move(it->second.account);
+      precomputed_trans_.erase(it);
+    }
+  }
+  if (!precomputed) {
+    auto acc_res = make_account(addr.cbits(), true);
+    if (acc_res.is_error()) {
+      fatal_error(acc_res.move_as_error());
+      return {};
+    }
+    acc = acc_res.move_as_ok();
+    assert(acc);
+    res = impl_create_ordinary_transaction(msg_root, acc, now_, start_lt, trans_min_lt, &storage_phase_cfg_,
+                                           &compute_phase_cfg_, &action_phase_cfg_, external);
+  }
+  if (res.is_error()) {
+    auto error = res.move_as_error();
+    if (error.code() == -701) {
+      // inbound external message was not accepted
+      LOG(DEBUG) << error.message();
+    } else {
+      fatal_error(std::move(error));
+    }
+    return {};
+  }
+  std::unique_ptr<block::Transaction> trans = res.move_as_ok();
+  if (!trans->update_limits(*block_limit_status_)) {
+    fatal_error("cannot update block limit status to include the new transaction");
+    return {};
+  }
+  auto trans_root = precomputed ? trans->commit_to(*acc) : trans->commit(*acc);
+  if (trans_root.is_null()) {
+    fatal_error("cannot commit new transaction for smart contract "s + addr.to_hex());
+    return {};
+  }
+  register_new_msgs(*trans);
+  update_max_lt(acc->last_trans_end_lt_);
+  return trans_root;
+}
+
+// creates, but does not commit, an ordinary transaction processing msg_root for account acc
+// does not modify collator state, so it may be used in a worker thread
+// returns an error with code -701 if an inbound external message has not been accepted by the account
+td::Result<std::unique_ptr<block::Transaction>> Collator::impl_create_ordinary_transaction(
+    Ref<vm::Cell> msg_root, block::Account* acc, ton::UnixTime utime, ton::LogicalTime lt,
+    ton::LogicalTime trans_min_lt, const block::StoragePhaseConfig* storage_phase_cfg,
+    const block::ComputePhaseConfig* compute_phase_cfg, const block::ActionPhaseConfig* action_phase_cfg,
+    bool external) {
+  if (acc->last_trans_end_lt_ >= lt && acc->transactions.empty()) {
+    return td::Status::Error(-669, PSTRING() << "last transaction time in the state of account " << acc->workchain
+                                             << ":" << acc->addr.to_hex() << " is too large");
+  }
   std::unique_ptr<block::Transaction> trans =
-      std::make_unique<block::Transaction>(*acc, block::Transaction::tr_ord, trans_min_lt + 1, now_, msg_root);
+      std::make_unique<block::Transaction>(*acc, block::Transaction::tr_ord, trans_min_lt + 1, utime, msg_root);
   bool ihr_delivered = false;  // FIXME
-  if (!trans->unpack_input_msg(ihr_delivered, &action_phase_cfg_)) {
+  if (!trans->unpack_input_msg(ihr_delivered, action_phase_cfg)) {
     if (external) {
       // inbound external message was not accepted
-      LOG(DEBUG) << "inbound external message rejected by account " << addr.to_hex()
-                 << " before smart-contract execution";
-      return {};
+      return td::Status::Error(-701, "inbound external message rejected by account "s + acc->addr.to_hex() +
+                                         " before smart-contract execution");
     }
-    fatal_error("cannot unpack input message for a new transaction");
-    return {};
+    return td::Status::Error(-669, "cannot unpack input message for a new transaction");
   }
   if (trans->bounce_enabled) {
-    if (!trans->prepare_storage_phase(storage_phase_cfg_, true)) {
-      fatal_error("cannot create storage phase of a new transaction for smart contract "s + addr.to_hex());
-      return {};
+    if (!trans->prepare_storage_phase(*storage_phase_cfg, true)) {
+      return td::Status::Error(
+          -669, "cannot create storage phase of a new transaction for smart contract "s + acc->addr.to_hex());
     }
     if (!external && !trans->prepare_credit_phase()) {
-      fatal_error("cannot create credit phase of a new transaction for smart contract "s + addr.to_hex());
-      return {};
+      return td::Status::Error(
+          -669, "cannot create credit phase of a new transaction for smart contract "s + acc->addr.to_hex());
     }
   } else {
     if (!external && !trans->prepare_credit_phase()) {
-      fatal_error("cannot create credit phase of a new transaction for smart contract "s + addr.to_hex());
-      return {};
+      return td::Status::Error(
+          -669, "cannot create credit phase of a new transaction for smart contract "s + acc->addr.to_hex());
     }
-    if (!trans->prepare_storage_phase(storage_phase_cfg_, true, true)) {
-      fatal_error("cannot create storage phase of a new transaction for smart contract "s + addr.to_hex());
-      return {};
+    if (!trans->prepare_storage_phase(*storage_phase_cfg, true, true)) {
+      return td::Status::Error(
+          -669, "cannot create storage phase of a new transaction for smart contract "s + acc->addr.to_hex());
     }
   }
-  if (!trans->prepare_compute_phase(compute_phase_cfg_)) {
-    fatal_error("cannot create compute phase of a new transaction for smart contract "s + addr.to_hex());
-    return {};
+  if (!trans->prepare_compute_phase(*compute_phase_cfg)) {
+    return td::Status::Error(
+        -669, "cannot create compute phase of a new transaction for smart contract "s + acc->addr.to_hex());
   }
   if (!trans->compute_phase->accepted) {
     if (external) {
       // inbound external message was not accepted
-      LOG(DEBUG) << "inbound external message rejected by transaction " << addr.to_hex();
-      return {};
+      return td::Status::Error(-701, "inbound external message rejected by transaction "s + acc->addr.to_hex());
     } else if (trans->compute_phase->skip_reason == block::ComputePhase::sk_none) {
-      fatal_error("new ordinary transaction for smart contract "s + addr.to_hex() +
-                  " has not been accepted by the smart contract (?)");
-      return {};
+      return td::Status::Error(-669, "new ordinary transaction for smart contract "s + acc->addr.to_hex() +
+                                         " has not been accepted by the smart contract (?)");
     }
   }
-  if (trans->compute_phase->success && !trans->prepare_action_phase(action_phase_cfg_)) {
-    fatal_error("cannot create action phase of a new transaction for smart contract "s + addr.to_hex());
-    return {};
+  if (trans->compute_phase->success && !trans->prepare_action_phase(*action_phase_cfg)) {
+    return td::Status::Error(
+        -669, "cannot create action phase of a new transaction for smart contract "s + acc->addr.to_hex());
   }
-  if (trans->bounce_enabled && !trans->compute_phase->success && !trans->prepare_bounce_phase(action_phase_cfg_)) {
-    fatal_error("cannot create bounce phase of a new transaction for smart contract "s + addr.to_hex());
-    return {};
+  if (trans->bounce_enabled && !trans->compute_phase->success && !trans->prepare_bounce_phase(*action_phase_cfg)) {
+    return td::Status::Error(
+        -669, "cannot create bounce phase of a new transaction for smart contract "s + acc->addr.to_hex());
   }
   if (!trans->serialize()) {
-    fatal_error("cannot serialize new transaction for smart contract "s + addr.to_hex());
-    return {};
+    return td::Status::Error(-669,
+                             "cannot serialize new transaction for smart contract "s + acc->addr.to_hex());
   }
-  if (!trans->update_limits(*block_limit_status_)) {
-    fatal_error("cannot update block limit status to include the new transaction");
-    return {};
+  return std::move(trans);
+}
+
+// executes the ordinary transactions for a list of inbound messages ahead of time, running the transactions of
+// different accounts in parallel threads; the results are picked up by create_ordinary_transaction() when
+// the messages are processed (in their original order), so that the collated block does not depend on
+// whether this has been done
+bool Collator::precompute_ordinary_transactions(const std::vector<Ref<vm::Cell>>& msgs,
+                                                ton::LogicalTime trans_min_lt, bool external) {
+  precomputed_trans_.clear();
+  // transactions in the masterchain may change the public libraries and the configuration seen by later ones
+  if (!thread_pool_ || is_masterchain() || msgs.size() <= 1) {
+    return false;
   }
-  auto trans_root = trans->commit(*acc);
-  if (trans_root.is_null()) {
-    fatal_error("cannot commit new transaction for smart contract "s + addr.to_hex());
-    return {};
+  std::map<ton::StdSmcAddress, std::vector<PrecomputedTransaction*>> chains;
+  for (const auto& msg_root : msgs) {
+    ton::StdSmcAddress addr;
+    auto cs = vm::load_cell_slice(msg_root);
+    Ref<vm::CellSlice> dest;
+    if (external) {
+      block::gen::CommonMsgInfo::Record_ext_in_msg_info info;
+      if (!tlb::unpack(cs, info)) {
+        continue;
+      }
+      dest = std::move(info.dest);
+    } else {
+      block::gen::CommonMsgInfo::Record_int_msg_info info;
+      if (!tlb::unpack(cs, info)) {
+        continue;
+      }
+      dest = std::move(info.dest);
+    }
+    ton::WorkchainId wc;
+    if (!is_our_address(dest) || !block::tlb::t_MsgAddressInt.extract_std_address(dest, wc, addr) ||
+        wc != workchain()) {
+      continue;
+    }
+    auto ins = precomputed_trans_.emplace(msg_root->get_hash().bits(), PrecomputedTransaction{});
+    if (!ins.second) {
+      // the same message twice, keep things simple
+      precomputed_trans_.clear();
+      return false;
+    }
+    auto& rec = ins.first->second;
+    rec.msg_root = msg_root;
+    rec.trans_min_lt = trans_min_lt;
+    rec.loads = std::make_unique<vm::CellUsageTree::LoadJournal>(state_usage_tree_);
+    auto& chain = chains[addr];
+    if (chain.empty()) {
+      // the initial state of the account; the cells loaded to extract it are accounted for in its first transaction
+      auto acc = lookup_account(addr.cbits());
+      if (acc) {
+        rec.account = std::make_unique<block::Account>(*acc);
+      } else {
+        vm::CellUsageTree::LoadJournal::Guard guard{rec.loads.get()};
+        auto acc_res = load_account(addr.cbits(), true);
+        if (acc_res.is_ok()) {
+          rec.account = acc_res.move_as_ok();
+        }
+      }
+      if (!rec.account) {
+        precomputed_trans_.erase(ins.first);
+        chains.erase(addr);
+        continue;
+      }
+    }
+    chain.push_back(&rec);
+  }
+  std::vector<std::vector<PrecomputedTransaction*>*> work;
+  for (auto& z : chains) {
+    work.push_back(&z.second);
+  }
+  auto run_chain = [this, external](std::vector<PrecomputedTransaction*>& chain) {
+    std::unique_ptr<block::Account> acc;
+    for (auto rec : chain) {
+      vm::CellUsageTree::LoadJournal::Guard guard{rec->loads.get()};
+      if (acc) {
+        rec->account = std::move(acc);
+      }
+      rec->result = impl_create_ordinary_transaction(rec->msg_root, rec->account.get(), now_, start_lt,
+                                                     rec->trans_min_lt, &storage_phase_cfg_, &compute_phase_cfg_,
+                                                     &action_phase_cfg_, external);
+      if (rec->result.is_error() && rec->result.error().code() != -701) {
+        // let the collator report the error when it gets to this message
+        break;
+      }
+      acc = std::make_unique<block::Account>(*rec->account);
+      if (rec->result.is_ok()) {
+        rec->result.ok()->commit_to(*acc);
+      }
+    }
+  };
+  auto threads_n = std::min<size_t>(threads_n_, work.size());
+  state_usage_tree_->set_concurrent(true);
+  thread_pool_->parallel_for(work.size(), threads_n, [&](size_t i) { run_chain(*work[i]); });
+  state_usage_tree_->set_concurrent(false);
+  LOG(DEBUG) << "precomputed " << precomputed_trans_.size() << " transactions for " << work.size()
+             << " accounts using " << threads_n << " threads";
+  return true;
+}
+
+// checks that a precomputed transaction has been created for the current state of the account, and if so,
+// accounts for the cells it has loaded; otherwise the transaction has to be created anew
+bool Collator::adopt_precomputed_transaction(PrecomputedTransaction& rec, const ton::StdSmcAddress& addr,
+                                             ton::LogicalTime trans_min_lt, block::Account*& acc,
+                                             td::Result<std::unique_ptr<block::Transaction>>& res) {
+  if (!rec.account || rec.trans_min_lt != trans_min_lt || rec.account->addr != addr) {
+    return false;
   }
-  register_new_msgs(*trans);
-  update_max_lt(acc->last_trans_end_lt_);
-  return trans_root;
+  auto cur = lookup_account(addr.cbits());
+  const auto& orig = *rec.account;
+  if (cur && !(cur->status == orig.status && cur->last_trans_lt_ == orig.last_trans_lt_ &&
+               cur->last_trans_end_lt_ == orig.last_trans_end_lt_ && cur->last_trans_hash_ == orig.last_trans_hash_ &&
+               cur->transactions.size() == orig.transactions.size())) {
+    LOG(DEBUG) << "state of account " << addr.to_hex() << " differs from the one used by a precomputed transaction";
+    return false;
+  }
+  if (!cur) {
+    if (!orig.transactions.empty()) {
+      return false;
+    }
+    auto ins = accounts.emplace(addr, std::make_unique<block::Account>(orig));
+    cur = ins.first->second.get();
+  }
+  rec.loads->apply();
+  acc = cur;
+  res = std::move(rec.result);
+  return true;
 }
 
 void Collator::update_max_lt(ton::LogicalTime lt) {
@@ -2709,13 +2925,42 @@ bool Collator::process_inbound_message(Ref<vm::CellSlice> enq_msg, ton::LogicalT
   return true;
 }
 
+// looks ahead into the inbound message queues and precomputes the transactions for the next messages to be
+// imported; returns the number of queue entries looked at
+unsigned Collator::precompute_inbound_internal_messages() {
+  std::vector<Ref<vm::Cell>> msgs;
+  unsigned entries = 0;
+  {
+    // the cells loaded here are accounted for when the messages are actually processed
+    vm::CellUsageTree::LoadJournal loads{state_usage_tree_};
+    vm::CellUsageTree::LoadJournal::Guard guard{&loads};
+    while (entries < precompute_window && !nb_out_msgs_lookahead_->is_eof()) {
+      auto kv = nb_out_msgs_lookahead_->extract_cur();
+      nb_out_msgs_lookahead_->next();
+      ++entries;
+      block::tlb::MsgEnvelope::Record_std env;
+      if (kv && kv->msg.not_null() && kv->msg->size_ext() == 0x10040 &&
+          tlb::unpack_cell(kv->msg->prefetch_ref(), env)) {
+        msgs.push_back(std::move(env.msg));
+      }
+    }
+  }
+  // messages to other shards and already processed messages are skipped by the collator
+  precompute_ordinary_transactions(msgs, start_lt, false);
+  return entries;
+}
+
 bool Collator::process_inbound_internal_messages() {
+  unsigned lookahead = 0;  // queue entries looked at by nb_out_msgs_lookahead_, but not processed yet
   while (!block_full_ && !nb_out_msgs_->is_eof()) {
     block_full_ = !block_limit_status_->fits(block::ParamLimits::cl_normal);
     if (block_full_) {
       LOG(INFO) << "BLOCK FULL, stop processing inbound internal messages";
       break;
     }
+    if (nb_out_msgs_lookahead_ && !lookahead) {
+      lookahead = precompute_inbound_internal_messages();
+    }
     auto kv = nb_out_msgs_->extract_cur();
     CHECK(kv && kv->msg.not_null());
     LOG(DEBUG) << "processing inbound message with (lt,hash)=(" << kv->lt << "," << kv->key.to_hex()
@@ -2730,10 +2975,15 @@ bool Collator::process_inbound_internal_messages() {
                   << " msg=";
         block::gen::t_EnqueuedMsg.print(std::cerr, *(kv->msg));
       }
+      precomputed_trans_.clear();
       return fatal_error("error processing inbound internal message");
     }
     nb_out_msgs_->next();
+    if (lookahead) {
+      --lookahead;
+    }
   }
+  precomputed_trans_.clear();
   inbound_queues_empty_ = nb_out_msgs_->is_eof();
   return true;
 }
@@ -2744,6 +2994,14 @@ bool Collator::process_inbound_external_messages() {
     return true;
   }
   bool full = !block_limit_status_->fits(block::ParamLimits::cl_soft);
+  if (!full && thread_pool_) {
+    std::vector<Ref<vm::Cell>> msgs;
+    msgs.reserve(ext_msg_list_.size());
+    for (auto& ext_msg_pair : ext_msg_list_) {
+      msgs.push_back(ext_msg_pair.first);
+    }
+    precompute_ordinary_transactions(msgs, std::max(start_lt, last_proc_int_msg_.first), true);
+  }
   for (auto& ext_msg_pair : ext_msg_list_) {
     if (full) {
       LOG(INFO) << "BLOCK FULL, stop processing external messages";
@@ -2754,6 +3012,7 @@ bool Collator::process_inbound_external_messages() {
     int r = process_external_message(std::move(ext_msg));
     if (r < 0) {
       bad_ext_msgs_.emplace_back(ext_msg_pair.second);
+      precomputed_trans_.clear();
       return false;
     }
     if (!r) {
@@ -2769,6 +3028,7 @@ bool Collator::process_inbound_external_messages() {
       break;
     }
   }
+  precomputed_trans_.clear();
   return true;
 }
 
@@ -22,12 +22,19 @@
 #include "validator/validator.h"
 #include "block/block-db.h"
 #include "vm/cells.h"
+#include "td/utils/ThreadPool.h"
 
 namespace ton {
 using td::Ref;
 
 extern int collator_settings;  // +1 = force want_split, +2 = force want_merge
 
+namespace validator {
+// the pool executing transactions of different accounts in parallel, shared by collators and ValidateQuery;
+// null if the given kind of query must run in one thread; threads_n = number of threads it may use, its own included
+std::shared_ptr<td::ThreadPool> get_transaction_pool(bool validate, td::uint32& threads_n);
+}  // namespace validator
+
 class Collator : public td::actor::Actor {
  protected:
   Collator() = default;
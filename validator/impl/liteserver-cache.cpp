@@ -0,0 +1,98 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "liteserver-cache.hpp"
+
+namespace ton {
+
+namespace validator {
+
+void LiteServerCacheImpl::lookup_smc_code(vm::CellHash code_hash, td::Promise<SmcCodeLookup> promise) {
+  auto it = smc_code_.find(code_hash);
+  if (it == smc_code_.end()) {
+    smc_code_misses_++;
+    promise.set_value(SmcCodeLookup{});
+    return;
+  }
+  smc_code_hits_++;
+  auto entry = it->second.get();
+  entry->remove();
+  smc_code_lru_.put(entry);
+  SmcCodeLookup res;
+  res.code = entry->code;
+  res.too_large = entry->code.is_null();
+  promise.set_value(std::move(res));
+}
+
+void LiteServerCacheImpl::update_smc_code(td::Ref<vm::Cell> code, td::uint64 size) {
+  if (code.is_null()) {
+    return;
+  }
+  auto hash = code->get_hash();
+  if (size > max_smc_code_size_) {
+    add_too_large_smc_code(hash);
+    return;
+  }
+  add_smc_code(hash, std::move(code), size);
+}
+
+void LiteServerCacheImpl::add_too_large_smc_code(vm::CellHash code_hash) {
+  add_smc_code(code_hash, td::Ref<vm::Cell>{}, sizeof(SmcCode));
+}
+
+void LiteServerCacheImpl::add_smc_code(vm::CellHash hash, td::Ref<vm::Cell> code, td::uint64 size) {
+  auto &entry = smc_code_[hash];
+  if (entry) {
+    return;
+  }
+  if (code.is_null()) {
+    smc_code_too_large_++;
+  }
+  entry = std::make_unique<SmcCode>();
+  entry->hash = hash;
+  entry->code = std::move(code);
+  entry->size = size;
+  smc_code_lru_.put(entry.get());
+  smc_code_size_ += size;
+
+  while (smc_code_size_ > max_smc_code_size_) {
+    auto oldest = SmcCode::from_list_node(smc_code_lru_.get());
+    smc_code_size_ -= oldest->size;
+    smc_code_evictions_++;
+    if (oldest->code.is_null()) {
+      smc_code_too_large_--;
+    }
+    smc_code_.erase(oldest->hash);
+  }
+}
+
+void LiteServerCacheImpl::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  std::vector<std::pair<std::string, std::string>> vec;
+  vec.emplace_back("smccode.entries", td::to_string(smc_code_.size()));
+  vec.emplace_back("smccode.toolarge", td::to_string(smc_code_too_large_));
+  vec.emplace_back("smccode.size", td::to_string(smc_code_size_));
+  vec.emplace_back("smccode.maxsize", td::to_string(max_smc_code_size_));
+  vec.emplace_back("smccode.hits", td::to_string(smc_code_hits_));
+  vec.emplace_back("smccode.misses", td::to_string(smc_code_misses_));
+  vec.emplace_back("smccode.evictions", td::to_string(smc_code_evictions_));
+  promise.set_value(std::move(vec));
+}
+
+}  // namespace validator
+
+}  // namespace ton
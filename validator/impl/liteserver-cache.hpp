@@ -0,0 +1,70 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "interfaces/liteserver.h"
+
+#include "td/utils/List.h"
+
+#include <unordered_map>
+
+namespace ton {
+
+namespace validator {
+
+class LiteServerCacheImpl : public LiteServerCache {
+ public:
+  enum : td::uint64 { default_max_smc_code_size = 64 << 20 };
+  explicit LiteServerCacheImpl(td::uint64 max_smc_code_size = default_max_smc_code_size)
+      : max_smc_code_size_(max_smc_code_size) {
+  }
+
+  void lookup_smc_code(vm::CellHash code_hash, td::Promise<SmcCodeLookup> promise) override;
+  void update_smc_code(td::Ref<vm::Cell> code, td::uint64 size) override;
+  void add_too_large_smc_code(vm::CellHash code_hash) override;
+
+  void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) override;
+
+ private:
+  struct SmcCode : public td::ListNode {
+    vm::CellHash hash;
+    td::Ref<vm::Cell> code;  // null for code too large to be cached
+    td::uint64 size;
+
+    static SmcCode *from_list_node(td::ListNode *node) {
+      return static_cast<SmcCode *>(node);
+    }
+  };
+
+  void add_smc_code(vm::CellHash hash, td::Ref<vm::Cell> code, td::uint64 size);
+
+  std::unordered_map<vm::CellHash, std::unique_ptr<SmcCode>> smc_code_;
+  td::ListNode smc_code_lru_;
+  td::uint64 smc_code_size_{0};
+  td::uint64 max_smc_code_size_;
+
+  td::uint64 smc_code_hits_{0};
+  td::uint64 smc_code_misses_{0};
+  td::uint64 smc_code_evictions_{0};
+  td::uint64 smc_code_too_large_{0};
+};
+
+}  // namespace validator
+
+}  // namespace ton
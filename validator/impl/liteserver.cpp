@@ -21,6 +21,7 @@
 #include "td/utils/common.h"
 #include "td/utils/crypto.h"
 #include "td/utils/overloaded.h"
+#include "td/utils/HashMap.h"
 #include "auto/tl/lite_api.h"
 #include "auto/tl/lite_api.hpp"
 #include "adnl/utils.hpp"
@@ -54,13 +55,15 @@ td::int32 get_tl_tag(td::Slice slice) {
 }
 
 void LiteQuery::run_query(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                          td::Promise<td::BufferSlice> promise) {
-  td::actor::create_actor<LiteQuery>("litequery", std::move(data), std::move(manager), std::move(promise)).release();
+                          td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise) {
+  td::actor::create_actor<LiteQuery>("litequery", std::move(data), std::move(manager), std::move(cache),
+                                     std::move(promise))
+      .release();
 }
 
 LiteQuery::LiteQuery(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                     td::Promise<td::BufferSlice> promise)
-    : query_(std::move(data)), manager_(std::move(manager)), promise_(std::move(promise)) {
+                     td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise)
+    : query_(std::move(data)), manager_(std::move(manager)), cache_(std::move(cache)), promise_(std::move(promise)) {
   timeout_ = td::Timestamp::in(default_timeout_msec * 0.001);
 }
 
@@ -135,6 +138,10 @@ void LiteQuery::start_up() {
             this->perform_getAccountState(ton::create_block_id(q.id_), static_cast<WorkchainId>(q.account_->workchain_),
                                           q.account_->id_, 0);
           },
+          [&](lite_api::liteServer_getAccountStates& q) {
+            this->perform_getAccountStates(ton::create_block_id(q.id_), static_cast<WorkchainId>(q.workchain_),
+                                           std::move(q.accounts_));
+          },
           [&](lite_api::liteServer_getOneTransaction& q) {
             this->perform_getOneTransaction(ton::create_block_id(q.id_),
                                             static_cast<WorkchainId>(q.account_->workchain_), q.account_->id_,
@@ -906,8 +913,8 @@ bool LiteQuery::request_zero_state(BlockIdExt blkid) {
   blk_id_ = blkid;
   ++pending_;
   td::actor::send_closure_later(
-      manager_, &ValidatorManager::get_zero_state, blkid,
-      [Self = actor_id(this), blkid](td::Result<td::BufferSlice> res) {
+      manager_, &ValidatorManager::get_zero_state_view, blkid,
+      [Self = actor_id(this), blkid](td::Result<td::BlobView> res) {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query,
                                   res.move_as_error_prefix("cannot load zerostate of "s + blkid.to_str() + " : "));
@@ -964,6 +971,19 @@ void LiteQuery::perform_getAccountState(BlockIdExt blkid, WorkchainId workchain,
   }
 }
 
+void LiteQuery::perform_getAccountStates(BlockIdExt blkid, WorkchainId workchain, std::vector<StdSmcAddress> addrs) {
+  LOG(INFO) << "started a getAccountStates(" << blkid.to_str() << ", " << workchain << ", <list of " << addrs.size()
+            << " accounts>) liteserver query";
+  if (addrs.empty() || addrs.size() > max_account_states) {
+    fatal_error(PSTRING() << "a getAccountStates() query must request between 1 and " << max_account_states
+                          << " accounts");
+    return;
+  }
+  // the shard is chosen by the first account; the client asks again for the accounts of other shards
+  acc_addrs_ = std::move(addrs);
+  perform_getAccountState(blkid, workchain, acc_addrs_[0], 0x20000);
+}
+
 void LiteQuery::continue_getAccountState_0(Ref<ton::validator::MasterchainState> mc_state, BlockIdExt blkid) {
   LOG(INFO) << "obtained last masterchain block = " << blkid.to_str();
   base_blk_id_ = blkid;
@@ -1093,10 +1113,10 @@ void LiteQuery::got_block_proof_link(BlockIdExt blkid, Ref<ProofLink> proof_link
   dec_pending();
 }
 
-void LiteQuery::got_zero_state(BlockIdExt blkid, td::BufferSlice zerostate) {
+void LiteQuery::got_zero_state(BlockIdExt blkid, td::BlobView zerostate) {
   LOG(INFO) << "obtained data for getZeroState(" << blkid.to_str() << ") needed by a liteserver query";
-  CHECK(!zerostate.empty());
-  buffer_ = std::move(zerostate);
+  CHECK(zerostate);
+  zero_state_ = std::move(zerostate);
   CHECK(blkid == blk_id_);
   dec_pending();
 }
@@ -1257,6 +1277,13 @@ void LiteQuery::continue_getAccountState() {
     // no shard with requested address found
     LOG(INFO) << "getAccountState(" << acc_workchain_ << ":" << acc_addr_.to_hex()
               << ") query completed (unknown workchain/shard)";
+    if (mode_ & 0x20000) {
+      auto b = ton::create_serialize_tl_object<ton::lite_api::liteServer_accountStates>(
+          ton::create_tl_lite_block_id(base_blk_id_), ton::create_tl_lite_block_id(blkid), proof.move_as_ok(),
+          td::BufferSlice{}, std::vector<td::BufferSlice>{});
+      finish_query(std::move(b));
+      return;
+    }
     auto b = ton::create_serialize_tl_object<ton::lite_api::liteServer_accountState>(
         ton::create_tl_lite_block_id(base_blk_id_), ton::create_tl_lite_block_id(blkid), proof.move_as_ok(),
         td::BufferSlice{}, td::BufferSlice{});
@@ -1269,6 +1296,10 @@ void LiteQuery::continue_getAccountState() {
 }
 
 void LiteQuery::finish_getAccountState(td::BufferSlice shard_proof) {
+  if (mode_ & 0x20000) {
+    finish_getAccountStates(std::move(shard_proof));
+    return;
+  }
   LOG(INFO) << "completing getAccountState() query";
   Ref<vm::Cell> proof1;
   if (!make_state_root_proof(proof1)) {
@@ -1313,6 +1344,33 @@ void LiteQuery::finish_getAccountState(td::BufferSlice shard_proof) {
   finish_query(std::move(b));
 }
 
+void LiteQuery::finish_getAccountStates(td::BufferSlice shard_proof) {
+  LOG(INFO) << "completing getAccountStates() query";
+  Ref<vm::Cell> proof1;
+  if (!make_state_root_proof(proof1)) {
+    return;
+  }
+  Ref<vm::Cell> proof2;
+  std::vector<td::BufferSlice> states;
+  auto S = block::make_account_states_proof(state_->root_cell(), blk_id_.shard_full(), acc_workchain_, acc_addrs_,
+                                            proof2, states);
+  if (S.is_error()) {
+    fatal_error(std::move(S));
+    return;
+  }
+  auto proof = vm::std_boc_serialize_multi({std::move(proof1), std::move(proof2)});
+  if (proof.is_error()) {
+    fatal_error(proof.move_as_error());
+    return;
+  }
+  LOG(INFO) << "getAccountStates(" << acc_workchain_ << ", <list of " << acc_addrs_.size()
+            << " accounts>) query completed with " << states.size() << " account states from " << blk_id_.to_str();
+  auto b = ton::create_serialize_tl_object<ton::lite_api::liteServer_accountStates>(
+      ton::create_tl_lite_block_id(base_blk_id_), ton::create_tl_lite_block_id(blk_id_), std::move(shard_proof),
+      proof.move_as_ok(), std::move(states));
+  finish_query(std::move(b));
+}
+
 // same as in lite-client/lite-client-common.cpp
 static td::Ref<vm::Tuple> prepare_vm_c7(ton::UnixTime now, ton::LogicalTime lt, td::Ref<vm::CellSlice> my_addr,
                                         const block::CurrencyCollection& balance) {
@@ -1368,12 +1426,93 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
   }
   auto code = state_init.code->prefetch_ref();
   auto data = state_init.data->prefetch_ref();
+  auto c7 = prepare_vm_c7(gen_utime, gen_lt, td::make_ref<vm::CellSlice>(acc.addr->clone()), balance);
+  if (!(mode & 2) && code.not_null() && !cache_.empty()) {
+    // no proof of the account state is requested, so the code may be taken from LiteServerCache
+    auto code_hash = code->get_hash();
+    auto P = td::PromiseCreator::lambda(
+        [SelfId = actor_id(this), shard_proof = std::move(shard_proof), state_proof = std::move(state_proof),
+         code = std::move(code), data = std::move(data),
+         c7 = std::move(c7)](td::Result<LiteServerCache::SmcCodeLookup> R) mutable {
+          LiteServerCache::SmcCodeLookup cached_code;
+          if (R.is_ok()) {
+            cached_code = R.move_as_ok();
+          }
+          td::actor::send_closure(SelfId, &LiteQuery::continue_runSmcMethod, std::move(shard_proof),
+                                  std::move(state_proof), std::move(code), std::move(data), std::move(c7),
+                                  std::move(cached_code));
+        });
+    td::actor::send_closure(cache_, &LiteServerCache::lookup_smc_code, code_hash, std::move(P));
+    return;
+  }
+  run_smc_method(std::move(shard_proof), std::move(state_proof), std::move(code), std::move(data), std::move(c7),
+                 mode & 2 ? &pb : nullptr);
+}
+
+// copies smart contract code into cells that do not refer to the state it was loaded from
+static td::Result<Ref<vm::Cell>> copy_smc_code(Ref<vm::Cell> cell, td::HashMap<vm::CellHash, Ref<vm::Cell>>& copied,
+                                               td::uint64& size, bool& too_large) {
+  auto hash = cell->get_hash();
+  auto it = copied.find(hash);
+  if (it != copied.end()) {
+    return it->second;
+  }
+  if (copied.size() >= LiteQuery::max_cached_code_cells) {
+    too_large = true;
+    return td::Status::Error("smart contract code is too large to be cached");
+  }
+  TRY_RESULT(loaded_cell, cell->load_cell());
+  auto& data_cell = loaded_cell.data_cell;
+  vm::CellBuilder cb;
+  cb.store_bits(data_cell->get_data(), data_cell->get_bits());
+  for (unsigned i = 0; i < data_cell->size_refs(); i++) {
+    TRY_RESULT(child, copy_smc_code(data_cell->get_ref(i), copied, size, too_large));
+    cb.store_ref(std::move(child));
+  }
+  Ref<vm::Cell> res = cb.finalize_novm(data_cell->is_special());
+  if (res->get_hash() != hash) {
+    return td::Status::Error("hash mismatch while copying smart contract code");
+  }
+  size += sizeof(vm::DataCell) + (data_cell->get_bits() + 7) / 8 + data_cell->size_refs() * sizeof(Ref<vm::Cell>);
+  copied.emplace(hash, res);
+  return res;
+}
+
+void LiteQuery::continue_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice state_proof, Ref<vm::Cell> code,
+                                      Ref<vm::Cell> data, Ref<vm::Tuple> c7,
+                                      LiteServerCache::SmcCodeLookup cached_code) {
+  // only the cells are cached here; instructions are decoded again on every run, unless the engine has been started
+  // with --tvm-decode-cache
+  if (cached_code.code.not_null()) {
+    LOG(DEBUG) << "using cached code " << cached_code.code->get_hash().to_hex();
+    code = std::move(cached_code.code);
+  } else if (!cached_code.too_large) {
+    td::HashMap<vm::CellHash, Ref<vm::Cell>> copied;
+    td::uint64 size = 0;
+    bool too_large = false;
+    auto R = copy_smc_code(code, copied, size, too_large);
+    if (R.is_ok()) {
+      code = R.move_as_ok();
+      td::actor::send_closure(cache_, &LiteServerCache::update_smc_code, code, size);
+    } else {
+      LOG(DEBUG) << "cannot cache code " << code->get_hash().to_hex() << " : " << R.move_as_error();
+      if (too_large) {
+        td::actor::send_closure(cache_, &LiteServerCache::add_too_large_smc_code, code->get_hash());
+      }
+    }
+  }
+  run_smc_method(std::move(shard_proof), std::move(state_proof), std::move(code), std::move(data), std::move(c7),
+                 nullptr);
+}
+
+void LiteQuery::run_smc_method(td::BufferSlice shard_proof, td::BufferSlice state_proof, Ref<vm::Cell> code,
+                               Ref<vm::Cell> data, Ref<vm::Tuple> c7, vm::MerkleProofBuilder* pb) {
+  int mode = mode_ & 0xffff;
   long long gas_limit = client_method_gas_limit;
   LOG(DEBUG) << "creating VM with gas limit " << gas_limit;
   // **** INIT VM ****
   vm::GasLimits gas{gas_limit};
   vm::VmState vm{std::move(code), std::move(stack_), gas, 1, std::move(data), vm::VmLog::Null()};
-  auto c7 = prepare_vm_c7(gen_utime, gen_lt, td::make_ref<vm::CellSlice>(acc.addr->clone()), balance);
   vm.set_c7(c7);  // tuple with SmartContractInfo
   // vm.incr_stack_trace(1);    // enable stack dump after each step
   LOG(INFO) << "starting VM to run GET-method of smart contract " << acc_workchain_ << ":" << acc_addr_.to_hex();
@@ -1418,7 +1557,7 @@ void LiteQuery::finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice
   }
   auto b = ton::create_serialize_tl_object<ton::lite_api::liteServer_runMethodResult>(
       mode, ton::create_tl_lite_block_id(base_blk_id_), ton::create_tl_lite_block_id(blk_id_), std::move(shard_proof),
-      std::move(state_proof), mode & 2 ? pb.extract_proof_boc().move_as_ok() : td::BufferSlice(), std::move(c7_info),
+      std::move(state_proof), pb ? pb->extract_proof_boc().move_as_ok() : td::BufferSlice(), std::move(c7_info),
       td::BufferSlice(), exit_code, std::move(result));
   finish_query(std::move(b));
 }
@@ -2194,7 +2333,7 @@ bool LiteQuery::construct_proof_link_forward(ton::BlockIdExt cur, ton::BlockIdEx
 
 bool LiteQuery::construct_proof_link_forward_cont(ton::BlockIdExt cur, ton::BlockIdExt next) {
   LOG(INFO) << "continue constructing a forward proof link from " << cur.to_str() << " to " << next.to_str();
-  CHECK(cur.seqno() ? proof_link_.not_null() && proof_link_->block_id() == cur : !buffer_.empty());
+  CHECK(cur.seqno() ? proof_link_.not_null() && proof_link_->block_id() == cur : bool(zero_state_));
   CHECK(mc_proof_.not_null() && mc_proof_->block_id() == next);
   try {
     Ref<vm::Cell> cur_root, next_root;
@@ -2208,10 +2347,10 @@ bool LiteQuery::construct_proof_link_forward_cont(ton::BlockIdExt cur, ton::Bloc
       virt1 = vres1.move_as_ok();
       cur_root = virt1.root;
     } else {
-      // for zero state, lazily deserialize buffer_ instead
+      // for zero state, lazily deserialize the memory-mapped state file instead
       vm::StaticBagOfCellsDbLazy::Options options;
       options.check_crc32c = true;
-      auto res = vm::StaticBagOfCellsDbLazy::create(td::BufferSliceBlobView::create(std::move(buffer_)), options);
+      auto res = vm::StaticBagOfCellsDbLazy::create(std::move(zero_state_), options);
       if (res.is_error()) {
         return fatal_error(res.move_as_error());
       }
@@ -23,6 +23,8 @@
 #include "interfaces/block-handle.h"
 #include "interfaces/validator-manager.h"
 #include "interfaces/shard.h"
+#include "interfaces/liteserver.h"
+#include "vm/cells/MerkleProof.h"
 #include "block.hpp"
 #include "shard.hpp"
 #include "proof.hpp"
@@ -35,12 +37,14 @@ using td::Ref;
 class LiteQuery : public td::actor::Actor {
   td::BufferSlice query_;
   td::actor::ActorId<ton::validator::ValidatorManager> manager_;
+  td::actor::ActorId<LiteServerCache> cache_;
   td::Timestamp timeout_;
   td::Promise<td::BufferSlice> promise_;
   int pending_{0};
   int mode_{0};
   WorkchainId acc_workchain_;
   StdSmcAddress acc_addr_;
+  std::vector<StdSmcAddress> acc_addrs_;
   td::int64 acc_sync_utime_;
   LogicalTime trans_lt_;
   Bits256 trans_hash_;
@@ -51,7 +55,7 @@ class LiteQuery : public td::actor::Actor {
   Ref<BlockQ> mc_block_, block_;
   Ref<ProofQ> mc_proof_, mc_proof_alt_;
   Ref<ProofLinkQ> proof_link_;
-  td::BufferSlice buffer_;
+  td::BlobView zero_state_;
   std::function<void()> continuation_;
   bool cont_set_{false};
   td::BufferSlice shard_proof_;
@@ -66,16 +70,18 @@ class LiteQuery : public td::actor::Actor {
   enum {
     default_timeout_msec = 4500,      // 4.5 seconds
     max_transaction_count = 16,       // fetch at most 16 transactions in one query
-    client_method_gas_limit = 300000  // gas limit for liteServer.runSmcMethod
+    client_method_gas_limit = 300000,  // gas limit for liteServer.runSmcMethod
+    max_cached_code_cells = 4096,      // larger smart contract code is not kept in LiteServerCache
+    max_account_states = 1024          // at most 1024 accounts in one liteServer.getAccountStates query
   };
   enum {
     ls_version = 0x101,
-    ls_capabilities = 7
-  };  // version 1.1; +1 = build block proof chains, +2 = masterchainInfoExt, +4 = runSmcMethod
+    ls_capabilities = 15
+  };  // version 1.1; +1 = build block proof chains, +2 = masterchainInfoExt, +4 = runSmcMethod, +8 = getAccountStates
   LiteQuery(td::BufferSlice data, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-            td::Promise<td::BufferSlice> promise);
+            td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise);
   static void run_query(td::BufferSlice data, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-                        td::Promise<td::BufferSlice> promise);
+                        td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise);
 
  private:
   bool fatal_error(td::Status error);
@@ -110,10 +116,16 @@ class LiteQuery : public td::actor::Actor {
   void continue_getAccountState_0(Ref<MasterchainState> mc_state, BlockIdExt blkid);
   void continue_getAccountState();
   void finish_getAccountState(td::BufferSlice shard_proof);
+  void perform_getAccountStates(BlockIdExt blkid, WorkchainId workchain, std::vector<StdSmcAddress> addrs);
+  void finish_getAccountStates(td::BufferSlice shard_proof);
   void perform_runSmcMethod(BlockIdExt blkid, WorkchainId workchain, StdSmcAddress addr, int mode, td::int64 method_id,
                             td::BufferSlice params);
   void finish_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice state_proof, Ref<vm::Cell> acc_root,
                            UnixTime gen_utime, LogicalTime gen_lt);
+  void continue_runSmcMethod(td::BufferSlice shard_proof, td::BufferSlice state_proof, Ref<vm::Cell> code,
+                             Ref<vm::Cell> data, Ref<vm::Tuple> c7, LiteServerCache::SmcCodeLookup cached_code);
+  void run_smc_method(td::BufferSlice shard_proof, td::BufferSlice state_proof, Ref<vm::Cell> code,
+                      Ref<vm::Cell> data, Ref<vm::Tuple> c7, vm::MerkleProofBuilder* pb);
   void perform_getOneTransaction(BlockIdExt blkid, WorkchainId workchain, StdSmcAddress addr, LogicalTime lt);
   void continue_getOneTransaction();
   void perform_getTransactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash, unsigned count);
@@ -164,7 +176,7 @@ class LiteQuery : public td::actor::Actor {
   void got_mc_block_data(BlockIdExt blkid, Ref<BlockData> data);
   void got_mc_block_proof(BlockIdExt blkid, int mode, Ref<Proof> proof);
   void got_block_proof_link(BlockIdExt blkid, Ref<ProofLink> proof_link);
-  void got_zero_state(BlockIdExt blkid, td::BufferSlice zerostate);
+  void got_zero_state(BlockIdExt blkid, td::BlobView zerostate);
   void dec_pending() {
     if (!--pending_) {
       check_pending();
@@ -20,6 +20,7 @@
 #include "message-queue.hpp"
 #include "validator-set.hpp"
 #include "vm/boc.h"
+#include "td/utils/port/thread.h"
 #include "td/db/utils/BlobView.h"
 #include "vm/db/StaticBagOfCellsDb.h"
 #include "vm/cellslice.h"
@@ -77,6 +78,30 @@ td::Result<Ref<ShardStateQ>> ShardStateQ::fetch(const BlockIdExt& _id, td::Buffe
   }
 }
 
+namespace {
+std::mutex deserialize_pool_mutex;
+std::shared_ptr<td::ThreadPool> deserialize_pool_instance;
+}  // namespace
+
+void set_state_deserialize_threads(td::uint32 threads_n) {
+  threads_n = std::min(threads_n, std::max(td::thread::hardware_concurrency(), 1u));
+  std::lock_guard<std::mutex> guard(deserialize_pool_mutex);
+  if (threads_n <= 1) {
+    deserialize_pool_instance = nullptr;
+  } else if (!deserialize_pool_instance || deserialize_pool_instance->size() + 1 != threads_n) {
+    deserialize_pool_instance = std::make_shared<td::ThreadPool>(threads_n - 1);
+  }
+}
+
+std::shared_ptr<td::ThreadPool> ShardStateQ::deserialize_pool(std::size_t data_size) {
+  // small states are deserialized faster by a single thread
+  if (data_size < (1 << 20)) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> guard(deserialize_pool_mutex);
+  return deserialize_pool_instance;
+}
+
 td::Status ShardStateQ::init() {
   if (root.is_null()) {
     if (data.empty()) {
@@ -102,7 +127,8 @@ td::Status ShardStateQ::init() {
     bocs_.clear();
     bocs_.push_back(std::move(boc));
 #else
-    auto res3 = vm::std_boc_deserialize(data.as_slice());
+    auto pool = deserialize_pool(data.size());
+    auto res3 = vm::std_boc_deserialize(data.as_slice(), false, pool.get());
 #endif
     if (res3.is_error()) {
       return res3.move_as_error();
@@ -136,7 +162,8 @@ td::Status ShardStateQ::validate_deep() const {
     return td::Status::Error(-668,
                              "cannot validate serialized shard state because no serialized shard state is present");
   }
-  auto res = vm::std_boc_deserialize(data.as_slice());
+  auto pool = deserialize_pool(data.size());
+  auto res = vm::std_boc_deserialize(data.as_slice(), false, pool.get());
   if (res.is_error()) {
     return res.move_as_error();
   }
@@ -21,6 +21,7 @@
 #include "vm/db/StaticBagOfCellsDb.h"
 #include "block/mc-config.h"
 #include "config.hpp"
+#include "td/utils/ThreadPool.h"
 
 namespace ton {
 
@@ -46,6 +47,7 @@ class ShardStateQ : virtual public ShardState {
   friend class Ref<ShardStateQ>;
   ShardStateQ(const ShardStateQ& other);
   ShardStateQ(ShardStateQ&& other) = default;
+  static std::shared_ptr<td::ThreadPool> deserialize_pool(std::size_t data_size);
 
  public:
   td::Status init();
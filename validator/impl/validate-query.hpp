@@ -25,12 +25,15 @@
 #include "block/transaction.h"
 #include "shard.hpp"
 #include "signature-set.hpp"
+#include "td/utils/ThreadPool.h"
 #include <vector>
 #include <string>
 #include <map>
 
 namespace ton {
 
+extern int validate_settings;  // +1 = after a parallel check of transactions, check them sequentially too and compare
+
 namespace validator {
 using td::Ref;
 
@@ -228,6 +231,38 @@ class ValidateQuery : public td::actor::Actor {
 
   std::vector<std::tuple<Bits256, Bits256, bool>> lib_publishers_, lib_publishers2_;
 
+  // the transactions of each account are checked independently, possibly in parallel threads;
+  // everything a check produces is kept here and merged in the order of account addresses
+  struct AccountTransactionsCheck {
+    StdSmcAddress addr;
+    Ref<vm::CellSlice> acc_blk_root;
+    std::vector<std::tuple<Bits256, LogicalTime, LogicalTime>> msg_proc_lt;
+    std::vector<std::tuple<Bits256, Bits256, bool>> lib_publishers;
+    bool failed{false};
+    bool fatal{false};
+    int error_code{0};
+    std::string error;  // only the first error is kept, as only the first one is reported by ValidateQuery
+
+    AccountTransactionsCheck(const StdSmcAddress& addr, Ref<vm::CellSlice> acc_blk_root)
+        : addr(addr), acc_blk_root(std::move(acc_blk_root)) {
+    }
+    bool reject_query(std::string err_msg) {
+      return set_error(false, 0, std::move(err_msg));
+    }
+    bool fatal_error(std::string err_msg, int err_code = -666) {
+      return set_error(true, err_code, std::move(err_msg));
+    }
+    bool set_error(bool is_fatal, int err_code, std::string err_msg) {
+      if (!failed) {
+        failed = true;
+        fatal = is_fatal;
+        error_code = err_code;
+        error = std::move(err_msg);
+      }
+      return false;
+    }
+  };
+
   td::PerfWarningTimer perf_timer_{"validateblock", 0.1};
 
   static constexpr td::uint32 priority() {
@@ -343,12 +378,16 @@ class ValidateQuery : public td::actor::Actor {
   bool check_delivered_dequeued();
   std::unique_ptr<block::Account> make_account_from(td::ConstBitPtr addr, Ref<vm::CellSlice> account,
                                                     Ref<vm::CellSlice> extra);
-  std::unique_ptr<block::Account> unpack_account(td::ConstBitPtr addr);
-  bool check_one_transaction(block::Account& account, LogicalTime lt, Ref<vm::Cell> trans_root, bool is_first,
-                             bool is_last);
-  bool check_account_transactions(const StdSmcAddress& acc_addr, Ref<vm::CellSlice> acc_tr);
+  std::unique_ptr<block::Account> unpack_account(AccountTransactionsCheck& chk, td::ConstBitPtr addr);
+  bool check_one_transaction(AccountTransactionsCheck& chk, block::Account& account, LogicalTime lt,
+                             Ref<vm::Cell> trans_root, bool is_first, bool is_last);
+  bool check_account_transactions(AccountTransactionsCheck& chk);
+  void run_account_transactions_check(AccountTransactionsCheck& chk);
+  bool run_account_transactions_checks(std::vector<AccountTransactionsCheck>& checks, td::ThreadPool* pool,
+                                       td::uint32 threads);
   bool check_transactions();
-  bool scan_account_libraries(Ref<vm::Cell> orig_libs, Ref<vm::Cell> final_libs, const td::Bits256& addr);
+  bool scan_account_libraries(AccountTransactionsCheck& chk, Ref<vm::Cell> orig_libs, Ref<vm::Cell> final_libs,
+                              const td::Bits256& addr);
   bool check_all_ticktock_processed();
   bool check_message_processing_order();
   bool check_special_message(Ref<vm::Cell> in_msg_root, const block::CurrencyCollection& amount,
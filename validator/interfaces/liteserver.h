@@ -19,6 +19,7 @@
 #pragma once
 
 #include "td/actor/actor.h"
+#include "vm/cells.h"
 
 namespace ton {
 
@@ -27,6 +28,18 @@ namespace validator {
 class LiteServerCache : public td::actor::Actor {
  public:
   virtual ~LiteServerCache() = default;
+
+  // code of smart contracts used by runSmcMethod, copied into memory and keyed by code hash;
+  // code too large to be copied is remembered as well, so that it is not measured again on every call
+  struct SmcCodeLookup {
+    td::Ref<vm::Cell> code;  // null if there is no such code in the cache
+    bool too_large{false};
+  };
+  virtual void lookup_smc_code(vm::CellHash code_hash, td::Promise<SmcCodeLookup> promise) = 0;
+  virtual void update_smc_code(td::Ref<vm::Cell> code, td::uint64 size) = 0;
+  virtual void add_too_large_smc_code(vm::CellHash code_hash) = 0;
+
+  virtual void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) = 0;
 };
 
 }  // namespace validator
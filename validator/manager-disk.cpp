@@ -27,6 +27,9 @@
 #include "manager.h"
 #include "ton/ton-io.hpp"
 #include "td/utils/overloaded.h"
+#include "vm/boc.h"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
 
 namespace ton {
 
@@ -109,29 +112,86 @@ void ValidatorManagerImpl::sync_complete(td::Promise<td::Unit> promise) {
   auto val_set = last_masterchain_state_->get_validator_set(shard_id);
   //LOG(DEBUG) << "after get_validator_set: addr=" << (const void*)val_set.get();
 
-  auto P = td::PromiseCreator::lambda(
-      [SelfId = actor_id(this), last = last_masterchain_block_id_, val_set, prev](td::Result<BlockCandidate> R) {
-        if (R.is_ok()) {
-          auto v = R.move_as_ok();
-          LOG(ERROR) << "created block " << v.id;
-          td::actor::send_closure(SelfId, &ValidatorManagerImpl::validate_fake, std::move(v), std::move(prev), last,
-                                  val_set);
-        } else {
-          LOG(ERROR) << "failed to create block: " << R.move_as_error();
-          std::exit(2);
-        }
-      });
-
-  LOG(ERROR) << "running collate query";
   if (local_id_.is_zero()) {
     //td::as<td::uint32>(created_by_.data() + 32 - 4) = ((unsigned)std::time(nullptr) >> 8);
   }
-  Ed25519_PublicKey created_by{td::Bits256::zero()};
-  td::as<td::uint32>(created_by.as_bits256().data() + 32 - 4) = ((unsigned)std::time(nullptr) >> 8);
-  run_collate_query(shard_id, 0, last_masterchain_block_id_, prev, created_by, val_set, actor_id(this),
+  td::as<td::uint32>(fake_created_by_.as_bits256().data() + 32 - 4) = ((unsigned)std::time(nullptr) >> 8);
+  collate_fake(std::move(prev), std::move(val_set), 0);
+}
+
+void ValidatorManagerImpl::collate_fake(std::vector<BlockIdExt> prev, td::Ref<ValidatorSet> val_set, int attempt) {
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), last = last_masterchain_block_id_, val_set, prev,
+                                       attempt](td::Result<BlockCandidate> R) {
+    if (R.is_ok()) {
+      auto v = R.move_as_ok();
+      LOG(ERROR) << "created block " << v.id;
+      td::actor::send_closure(SelfId, &ValidatorManagerImpl::check_fake, std::move(v), std::move(prev), last, val_set,
+                              attempt);
+    } else {
+      LOG(ERROR) << "failed to create block: " << R.move_as_error();
+      std::exit(2);
+    }
+  });
+
+  LOG(ERROR) << "running collate query";
+  run_collate_query(shard_to_generate_, 0, last_masterchain_block_id_, std::move(prev), fake_created_by_,
+                    std::move(val_set), actor_id(this), td::Timestamp::in(10.0), std::move(P));
+}
+
+// collates the block once more in a single thread and checks that the result is the same
+void ValidatorManagerImpl::check_fake(BlockCandidate candidate, std::vector<BlockIdExt> prev, BlockIdExt last,
+                                      td::Ref<ValidatorSet> val_set, int attempt) {
+  if (opts_->collator_threads() <= 1 || candidate.id.is_masterchain()) {
+    validate_fake(std::move(candidate), std::move(prev), last, std::move(val_set));
+    return;
+  }
+  set_collator_threads(1);
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), c = candidate.clone(), prev, last, val_set,
+                                       attempt](td::Result<BlockCandidate> R) mutable {
+    if (R.is_ok()) {
+      td::actor::send_closure(SelfId, &ValidatorManagerImpl::compare_fake, std::move(c), R.move_as_ok(),
+                              std::move(prev), last, std::move(val_set), attempt);
+    } else {
+      LOG(ERROR) << "failed to create block in a single thread: " << R.move_as_error();
+      std::exit(2);
+    }
+  });
+  LOG(ERROR) << "running single-threaded collate query";
+  run_collate_query(shard_to_generate_, 0, last, prev, fake_created_by_, val_set, actor_id(this),
                     td::Timestamp::in(10.0), std::move(P));
 }
 
+void ValidatorManagerImpl::compare_fake(BlockCandidate candidate, BlockCandidate check, std::vector<BlockIdExt> prev,
+                                        BlockIdExt last, td::Ref<ValidatorSet> val_set, int attempt) {
+  set_collator_threads(opts_->collator_threads());
+  if (candidate.id == check.id && candidate.data.as_slice() == check.data.as_slice() &&
+      candidate.collated_data.as_slice() == check.collated_data.as_slice()) {
+    LOG(ERROR) << "block collated using " << opts_->collator_threads()
+               << " threads is identical to the one collated in a single thread";
+    validate_fake(std::move(candidate), std::move(prev), last, std::move(val_set));
+    return;
+  }
+  auto gen_utime = [](const BlockCandidate& c) -> UnixTime {
+    auto root = vm::std_boc_deserialize(c.data.as_slice());
+    block::gen::Block::Record blk;
+    block::gen::BlockInfo::Record info;
+    if (root.is_error() || !tlb::unpack_cell(root.move_as_ok(), blk) || !tlb::unpack_cell(blk.info, info)) {
+      return 0;
+    }
+    return info.gen_utime;
+  };
+  auto utime = gen_utime(candidate);
+  if (utime != gen_utime(check) && attempt < 5) {
+    // the clock has ticked between the two collations
+    LOG(WARNING) << "unix time of the block collated in a single thread differs, collating both blocks again";
+    collate_fake(std::move(prev), std::move(val_set), attempt + 1);
+    return;
+  }
+  LOG(ERROR) << "block collated using " << opts_->collator_threads()
+             << " threads differs from the one collated in a single thread";
+  std::exit(2);
+}
+
 void ValidatorManagerImpl::validate_fake(BlockCandidate candidate, std::vector<BlockIdExt> prev, BlockIdExt last,
                                          td::Ref<ValidatorSet> val_set) {
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), c = candidate.clone(), prev, last,
@@ -200,6 +260,10 @@ void ValidatorManagerImpl::get_zero_state(BlockIdExt block_id, td::Promise<td::B
   td::actor::send_closure(db_, &Db::get_zero_state_file, block_id, std::move(promise));
 }
 
+void ValidatorManagerImpl::get_zero_state_view(BlockIdExt block_id, td::Promise<td::BlobView> promise) {
+  td::actor::send_closure(db_, &Db::get_zero_state_file_view, block_id, std::move(promise));
+}
+
 void ValidatorManagerImpl::check_persistent_state_exists(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                                                          td::Promise<bool> promise) {
   td::actor::send_closure(db_, &Db::check_persistent_state_file_exists, block_id, masterchain_block_id,
@@ -680,6 +744,13 @@ void ValidatorManagerImpl::store_persistent_state_file(BlockIdExt block_id, Bloc
                           std::move(promise));
 }
 
+void ValidatorManagerImpl::store_persistent_state_file_gen(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                                           std::function<td::Status(td::FileFd&)> write_state,
+                                                           td::Promise<td::Unit> promise) {
+  td::actor::send_closure(db_, &Db::store_persistent_state_file_gen, block_id, masterchain_block_id,
+                          std::move(write_state), std::move(promise));
+}
+
 void ValidatorManagerImpl::store_zero_state_file(BlockIdExt block_id, td::BufferSlice state,
                                                  td::Promise<td::Unit> promise) {
   td::actor::send_closure(db_, &Db::store_zero_state_file, block_id, std::move(state), std::move(promise));
@@ -882,7 +953,9 @@ void ValidatorManagerImpl::send_top_shard_block_description(td::Ref<ShardTopBloc
 }
 
 void ValidatorManagerImpl::start_up() {
-  db_ = create_db_actor(actor_id(this), db_root_);
+  set_collator_threads(opts_->collator_threads());
+  set_validate_threads(opts_->validate_threads());
+  db_ = create_db_actor(actor_id(this), db_root_, opts_);
 
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<ValidatorManagerInitResult> R) {
     R.ensure();
@@ -140,6 +140,9 @@ class ValidatorManagerImpl : public ValidatorManager {
                        td::Promise<td::Ref<ShardState>> promise) override;
   void store_persistent_state_file(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::BufferSlice state,
                                    td::Promise<td::Unit> promise) override;
+  void store_persistent_state_file_gen(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                       std::function<td::Status(td::FileFd&)> write_state,
+                                       td::Promise<td::Unit> promise) override;
   void store_zero_state_file(BlockIdExt block_id, td::BufferSlice state, td::Promise<td::Unit> promise) override;
   void wait_block_state(BlockHandle handle, td::uint32 priority, td::Timestamp timeout,
                         td::Promise<td::Ref<ShardState>> promise) override;
@@ -220,6 +223,7 @@ class ValidatorManagerImpl : public ValidatorManager {
 
   void send_get_block_request(BlockIdExt id, td::uint32 priority, td::Promise<ReceivedBlock> promise) override;
   void send_get_zero_state_request(BlockIdExt id, td::uint32 priority, td::Promise<td::BufferSlice> promise) override;
+  void get_zero_state_view(BlockIdExt block_id, td::Promise<td::BlobView> promise) override;
   void send_get_persistent_state_request(BlockIdExt id, BlockIdExt masterchain_block_id, td::uint32 priority,
                                          td::Promise<td::BufferSlice> promise) override;
   void send_get_block_proof_request(BlockIdExt block_id, td::uint32 priority,
@@ -281,6 +285,11 @@ class ValidatorManagerImpl : public ValidatorManager {
   void start_up() override;
   void started(ValidatorManagerInitResult result);
 
+  void collate_fake(std::vector<BlockIdExt> prev, td::Ref<ValidatorSet> val_set, int attempt);
+  void check_fake(BlockCandidate candidate, std::vector<BlockIdExt> prev, BlockIdExt last,
+                  td::Ref<ValidatorSet> val_set, int attempt);
+  void compare_fake(BlockCandidate candidate, BlockCandidate check, std::vector<BlockIdExt> prev, BlockIdExt last,
+                    td::Ref<ValidatorSet> val_set, int attempt);
   void write_fake(BlockCandidate candidate, std::vector<BlockIdExt> prev, BlockIdExt last,
                   td::Ref<ValidatorSet> val_set);
   void validate_fake(BlockCandidate candidate, std::vector<BlockIdExt> prev, BlockIdExt last,
@@ -371,6 +380,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   std::string db_root_;
   ShardIdFull shard_to_generate_;
   BlockIdExt block_to_generate_;
+  Ed25519_PublicKey fake_created_by_{td::Bits256::zero()};
 
   int pending_new_shard_block_descr_{0};
   std::vector<td::Promise<std::vector<td::Ref<ShardTopBlockDescription>>>> waiting_new_shard_block_descr_;
@@ -283,6 +283,10 @@ void ValidatorManagerImpl::get_zero_state(BlockIdExt block_id, td::Promise<td::B
   td::actor::send_closure(db_, &Db::get_zero_state_file, block_id, std::move(promise));
 }
 
+void ValidatorManagerImpl::get_zero_state_view(BlockIdExt block_id, td::Promise<td::BlobView> promise) {
+  td::actor::send_closure(db_, &Db::get_zero_state_file_view, block_id, std::move(promise));
+}
+
 void ValidatorManagerImpl::check_persistent_state_exists(BlockIdExt block_id, BlockIdExt masterchain_block_id,
                                                          td::Promise<bool> promise) {
   td::actor::send_closure(db_, &Db::check_persistent_state_file_exists, block_id, masterchain_block_id,
@@ -1032,6 +1036,13 @@ void ValidatorManagerImpl::store_persistent_state_file(BlockIdExt block_id, Bloc
                           std::move(promise));
 }
 
+void ValidatorManagerImpl::store_persistent_state_file_gen(BlockIdExt block_id, BlockIdExt masterchain_block_id,
+                                                           std::function<td::Status(td::FileFd&)> write_state,
+                                                           td::Promise<td::Unit> promise) {
+  td::actor::send_closure(db_, &Db::store_persistent_state_file_gen, block_id, masterchain_block_id,
+                          std::move(write_state), std::move(promise));
+}
+
 void ValidatorManagerImpl::store_zero_state_file(BlockIdExt block_id, td::BufferSlice state,
                                                  td::Promise<td::Unit> promise) {
   td::actor::send_closure(db_, &Db::store_zero_state_file, block_id, std::move(state), std::move(promise));
@@ -1328,8 +1339,8 @@ void ValidatorManagerImpl::send_get_zero_state_request(BlockIdExt id, td::uint32
 void ValidatorManagerImpl::send_get_persistent_state_request(BlockIdExt id, BlockIdExt masterchain_block_id,
                                                              td::uint32 priority,
                                                              td::Promise<td::BufferSlice> promise) {
-  callback_->download_persistent_state(id, masterchain_block_id, priority, td::Timestamp::in(3600.0),
-                                       std::move(promise));
+  callback_->download_persistent_state(id, masterchain_block_id, priority, db_root_ + "/tmp/",
+                                       td::Timestamp::in(3600.0), std::move(promise));
 }
 
 void ValidatorManagerImpl::send_get_block_proof_request(BlockIdExt block_id, td::uint32 priority,
@@ -1374,7 +1385,10 @@ void ValidatorManagerImpl::send_block_broadcast(BlockBroadcast broadcast) {
 }
 
 void ValidatorManagerImpl::start_up() {
-  db_ = create_db_actor(actor_id(this), db_root_);
+  set_state_deserialize_threads(opts_->state_deserialize_threads());
+  set_collator_threads(opts_->collator_threads());
+  set_validate_threads(opts_->validate_threads());
+  db_ = create_db_actor(actor_id(this), db_root_, opts_);
   lite_server_cache_ = create_liteserver_cache_actor(actor_id(this), db_root_);
   token_manager_ = td::actor::create_actor<TokenManager>("tokenmanager");
   td::mkdir(db_root_ + "/tmp/").ensure();
@@ -2409,6 +2423,10 @@ void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::
   merger.make_promise("").set_value(std::move(vec));
 
   td::actor::send_closure(db_, &Db::prepare_stats, merger.make_promise("db."));
+  if (!lite_server_cache_.empty()) {
+    td::actor::send_closure(lite_server_cache_, &LiteServerCache::prepare_stats,
+                            merger.make_promise("liteservercache."));
+  }
 }
 
 void ValidatorManagerImpl::truncate(BlockSeqno seqno, ConstBlockHandle handle, td::Promise<td::Unit> promise) {
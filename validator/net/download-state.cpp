@@ -19,24 +19,133 @@
 #include "download-state.hpp"
 #include "ton/ton-tl.hpp"
 #include "ton/ton-io.hpp"
+#include "td/utils/as.h"
+#include "td/utils/misc.h"
 #include "td/utils/overloaded.h"
+#include "td/utils/PathView.h"
+#include "td/utils/port/path.h"
+#include "td/utils/Time.h"
+#include "vm/boc.h"
 #include "full-node.h"
 
+#include <algorithm>
+
 namespace ton {
 
 namespace validator {
 
 namespace fullnode {
 
-DownloadState::DownloadState(BlockIdExt block_id, BlockIdExt masterchain_block_id, adnl::AdnlNodeIdShort local_id,
-                             overlay::OverlayIdShort overlay_id, adnl::AdnlNodeIdShort download_from,
-                             td::uint32 priority, td::Timestamp timeout,
+StatePartFile::StatePartFile(std::string tmp_dir, BlockIdExt block_id, BlockIdExt masterchain_block_id)
+    : tmp_dir_(std::move(tmp_dir))
+    , prefix_(PSTRING() << "state_" << masterchain_block_id.file_hash.to_hex() << "_")
+    , name_(PSTRING() << tmp_dir_ << prefix_ << block_id.file_hash.to_hex() << ".part") {
+}
+
+void StatePartFile::open(td::Promise<std::pair<td::uint64, td::BufferSlice>> promise) {
+  remove_stale_files();
+
+  TRY_RESULT_PROMISE_ASSIGN(promise, fd_,
+                            td::FileFd::open(name_, td::FileFd::Read | td::FileFd::Write | td::FileFd::Create));
+  TRY_RESULT_PROMISE(promise, size, fd_.get_size());
+  if (static_cast<td::uint64>(size) < header_size()) {
+    promise.set_value(std::make_pair(td::uint64{0}, td::BufferSlice{}));
+    return;
+  }
+
+  char header[header_size()];
+  TRY_RESULT_PROMISE(promise, read, fd_.pread(td::MutableSlice(header, header_size()), 0));
+  td::uint64 synced_size = td::as<td::uint64>(header);
+  if (read != header_size() || synced_size > static_cast<td::uint64>(size) - header_size()) {
+    promise.set_value(std::make_pair(td::uint64{0}, td::BufferSlice{}));
+    return;
+  }
+
+  td::BufferSlice data{td::narrow_cast<size_t>(std::min<td::uint64>(synced_size, 1 << 10))};
+  TRY_RESULT_PROMISE(promise, read_data, fd_.pread(data.as_slice(), header_size()));
+  if (read_data != data.size()) {
+    promise.set_value(std::make_pair(td::uint64{0}, td::BufferSlice{}));
+    return;
+  }
+  promise.set_value(std::make_pair(synced_size, std::move(data)));
+}
+
+void StatePartFile::remove_stale_files() {
+  // only the states of one masterchain block are downloaded at a time, parts of the others are never resumed
+  int cnt = 0;
+  auto S = td::WalkPath::run(tmp_dir_, [&](td::CSlice path, td::WalkPath::Type type) {
+    if (type == td::WalkPath::Type::EnterDir) {
+      if (cnt++ != 0) {
+        return td::WalkPath::Action::SkipDir;
+      }
+    } else if (type == td::WalkPath::Type::NotDir) {
+      auto name = td::PathView(path).file_name();
+      if (td::begins_with(name, "state_") && td::ends_with(name, ".part") && !td::begins_with(name, prefix_)) {
+        LOG(INFO) << "removing stale state part file " << path;
+        td::unlink(path).ignore();
+      }
+    }
+    return td::WalkPath::Action::Continue;
+  });
+  if (S.is_error()) {
+    LOG(WARNING) << "failed to list " << tmp_dir_ << ": " << S;
+  }
+}
+
+td::Status StatePartFile::write_synced_size(td::uint64 size) {
+  char header[header_size()];
+  td::as<td::uint64>(header) = size;
+  TRY_RESULT(written, fd_.pwrite(td::Slice(header, header_size()), 0));
+  if (written != header_size()) {
+    return td::Status::Error(ErrorCode::error, "short write");
+  }
+  return td::Status::OK();
+}
+
+void StatePartFile::reset(td::Promise<td::Unit> promise) {
+  TRY_STATUS_PROMISE(promise, write_synced_size(0));
+  TRY_STATUS_PROMISE(promise, fd_.sync());
+  promise.set_value(td::Unit());
+}
+
+void StatePartFile::write(td::uint64 offset, td::BufferSlice data, bool sync, td::Promise<td::Unit> promise) {
+  TRY_RESULT_PROMISE(promise, written, fd_.pwrite(data.as_slice(), header_size() + offset));
+  if (written != data.size()) {
+    promise.set_error(td::Status::Error(ErrorCode::error, "short write"));
+    return;
+  }
+  if (sync) {
+    // parts are written in order, so everything before the end of this one is on disk after the sync;
+    // the new synced size itself is synced with the next part
+    TRY_STATUS_PROMISE(promise, fd_.sync());
+    TRY_STATUS_PROMISE(promise, write_synced_size(offset + data.size()));
+  }
+  promise.set_value(td::Unit());
+}
+
+void StatePartFile::read(td::uint64 size, td::Promise<td::BufferSlice> promise) {
+  td::BufferSlice data{td::narrow_cast<size_t>(size)};
+  auto R = fd_.pread(data.as_slice(), header_size());
+  fd_.close();
+  td::unlink(name_).ignore();
+  TRY_RESULT_PROMISE(promise, read, std::move(R));
+  if (read != data.size()) {
+    promise.set_error(td::Status::Error(ErrorCode::error, "short read"));
+    return;
+  }
+  promise.set_value(std::move(data));
+}
+
+DownloadState::DownloadState(BlockIdExt block_id, BlockIdExt masterchain_block_id, std::string tmp_dir,
+                             adnl::AdnlNodeIdShort local_id, overlay::OverlayIdShort overlay_id,
+                             adnl::AdnlNodeIdShort download_from, td::uint32 priority, td::Timestamp timeout,
                              td::actor::ActorId<ValidatorManagerInterface> validator_manager,
                              td::actor::ActorId<rldp::Rldp> rldp, td::actor::ActorId<overlay::Overlays> overlays,
                              td::actor::ActorId<adnl::Adnl> adnl, td::actor::ActorId<adnl::AdnlExtClient> client,
                              td::Promise<td::BufferSlice> promise)
     : block_id_(block_id)
     , masterchain_block_id_(masterchain_block_id)
+    , tmp_dir_(std::move(tmp_dir))
     , local_id_(local_id)
     , overlay_id_(overlay_id)
     , download_from_(download_from)
@@ -53,13 +162,13 @@ DownloadState::DownloadState(BlockIdExt block_id, BlockIdExt masterchain_block_i
 void DownloadState::abort_query(td::Status reason) {
   if (promise_) {
     if (reason.code() == ErrorCode::notready || reason.code() == ErrorCode::timeout) {
-      VLOG(FULL_NODE_DEBUG) << "failed to download state " << block_id_ << "from " << download_from_ << ": " << reason;
+      VLOG(FULL_NODE_DEBUG) << "failed to download state " << block_id_ << ": " << reason;
     } else {
-      VLOG(FULL_NODE_NOTICE) << "failed to download state " << block_id_ << " from " << download_from_ << ": "
-                             << reason;
+      VLOG(FULL_NODE_NOTICE) << "failed to download state " << block_id_ << ": " << reason;
     }
     promise_.set_error(std::move(reason));
   }
+  // the part file is kept, so that the next attempt continues from the synced offset
   stop();
 }
 
@@ -91,8 +200,55 @@ void DownloadState::start_up() {
 
 void DownloadState::got_block_handle(BlockHandle handle) {
   handle_ = std::move(handle);
+  if (!masterchain_block_id_.is_valid()) {
+    get_nodes_to_download();
+    return;
+  }
+
+  part_file_ = td::actor::create_actor<StatePartFile>("statepartfile", tmp_dir_, block_id_, masterchain_block_id_);
+  auto P = td::PromiseCreator::lambda(
+      [SelfId = actor_id(this)](td::Result<std::pair<td::uint64, td::BufferSlice>> R) {
+        if (R.is_error()) {
+          td::actor::send_closure(SelfId, &DownloadState::abort_query,
+                                  R.move_as_error_prefix("failed to open part file: "));
+        } else {
+          auto res = R.move_as_ok();
+          td::actor::send_closure(SelfId, &DownloadState::got_part_file, res.first, std::move(res.second));
+        }
+      });
+  td::actor::send_closure(part_file_, &StatePartFile::open, std::move(P));
+}
+
+void DownloadState::got_part_file(td::uint64 size, td::BufferSlice header) {
+  if (size != 0) {
+    auto S = set_total_size(header.as_slice());
+    if (S.is_error() || size > total_size_) {
+      LOG(WARNING) << "dropping partially downloaded state " << block_id_ << ": " << S;
+      total_size_ = 0;
+      size = 0;
+      auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Unit> R) {
+        if (R.is_error()) {
+          td::actor::send_closure(SelfId, &DownloadState::abort_query,
+                                  R.move_as_error_prefix("failed to reset part file: "));
+        }
+      });
+      td::actor::send_closure(part_file_, &StatePartFile::reset, std::move(P));
+    } else {
+      VLOG(FULL_NODE_INFO) << "resuming download of state " << block_id_ << " from offset " << size << " of "
+                           << total_size_;
+    }
+  }
+  queued_size_ = written_size_ = synced_size_ = next_offset_ = size;
+  if (total_size_ != 0 && written_size_ == total_size_) {
+    finish_download();
+    return;
+  }
+  get_nodes_to_download();
+}
+
+void DownloadState::get_nodes_to_download() {
   if (!download_from_.is_zero() || !client_.empty()) {
-    got_node_to_download(download_from_);
+    got_nodes_to_download({download_from_});
   } else {
     auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<std::vector<adnl::AdnlNodeIdShort>> R) {
       if (R.is_error()) {
@@ -103,116 +259,181 @@ void DownloadState::got_block_handle(BlockHandle handle) {
           td::actor::send_closure(SelfId, &DownloadState::abort_query,
                                   td::Status::Error(ErrorCode::notready, "no nodes"));
         } else {
-          td::actor::send_closure(SelfId, &DownloadState::got_node_to_download, vec[0]);
+          td::actor::send_closure(SelfId, &DownloadState::got_nodes_to_download, std::move(vec));
         }
       }
     });
 
-    td::actor::send_closure(overlays_, &overlay::Overlays::get_overlay_random_peers, local_id_, overlay_id_, 1,
+    // zero states are small and downloaded with a single query, so one peer is enough
+    td::uint32 peers = masterchain_block_id_.is_valid() ? max_peers() : 1;
+    td::actor::send_closure(overlays_, &overlay::Overlays::get_overlay_random_peers, local_id_, overlay_id_, peers,
                             std::move(P));
   }
 }
 
-void DownloadState::got_node_to_download(adnl::AdnlNodeIdShort node) {
+void DownloadState::got_nodes_to_download(std::vector<adnl::AdnlNodeIdShort> nodes) {
+  for (auto &node : nodes) {
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), node](td::Result<td::BufferSlice> R) mutable {
+      if (R.is_error()) {
+        td::actor::send_closure(SelfId, &DownloadState::failed_block_state_description, node, R.move_as_error());
+      } else {
+        td::actor::send_closure(SelfId, &DownloadState::got_block_state_description, node, R.move_as_ok());
+      }
+    });
+
+    td::BufferSlice query;
+    if (masterchain_block_id_.is_valid()) {
+      query = create_serialize_tl_object<ton_api::tonNode_preparePersistentState>(
+          create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_));
+    } else {
+      query = create_serialize_tl_object<ton_api::tonNode_prepareZeroState>(create_tl_block_id(block_id_));
+    }
+
+    pending_descriptions_++;
+    if (client_.empty()) {
+      td::actor::send_closure(overlays_, &overlay::Overlays::send_query, node, local_id_, overlay_id_, "get_prepare",
+                              std::move(P), td::Timestamp::in(1.0), std::move(query));
+    } else {
+      td::actor::send_closure(client_, &adnl::AdnlExtClient::send_query, "get_prepare",
+                              create_serialize_tl_object_suffix<ton_api::tonNode_query>(std::move(query)),
+                              td::Timestamp::in(1.0), std::move(P));
+    }
+  }
+}
+
+void DownloadState::got_block_state_description(adnl::AdnlNodeIdShort node, td::BufferSlice data) {
+  auto F = fetch_tl_object<ton_api::tonNode_PreparedState>(std::move(data), true);
+  if (F.is_error()) {
+    failed_block_state_description(node, F.move_as_error());
+    return;
+  }
+
+  ton_api::downcast_call(*F.move_as_ok().get(),
+                         td::overloaded(
+                             [&](ton_api::tonNode_notFoundState &f) {
+                               failed_block_state_description(
+                                   node, td::Status::Error(ErrorCode::notready, "state not found"));
+                             },
+                             [&](ton_api::tonNode_preparedState &f) {
+                               pending_descriptions_--;
+                               if (!masterchain_block_id_.is_valid()) {
+                                 download_zero_state(node);
+                                 return;
+                               }
+                               peers_.push_back(Peer{node});
+                               download_parts();
+                             }));
+}
+
+void DownloadState::failed_block_state_description(adnl::AdnlNodeIdShort node, td::Status reason) {
+  VLOG(FULL_NODE_DEBUG) << "peer " << node << " can not provide state " << block_id_ << ": " << reason;
+  pending_descriptions_--;
+  if (peers_.empty() && pending_descriptions_ == 0 && !downloading_zero_state_) {
+    abort_query(std::move(reason));
+  }
+}
+
+void DownloadState::download_zero_state(adnl::AdnlNodeIdShort node) {
+  if (downloading_zero_state_) {
+    return;
+  }
+  downloading_zero_state_ = true;
   download_from_ = node;
 
-  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::BufferSlice> R) mutable {
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::BufferSlice> R) {
     if (R.is_error()) {
       td::actor::send_closure(SelfId, &DownloadState::abort_query, R.move_as_error());
     } else {
-      td::actor::send_closure(SelfId, &DownloadState::got_block_state_description, R.move_as_ok());
+      td::actor::send_closure(SelfId, &DownloadState::got_block_state, R.move_as_ok());
     }
   });
 
-  td::BufferSlice query;
-  if (masterchain_block_id_.is_valid()) {
-    query = create_serialize_tl_object<ton_api::tonNode_preparePersistentState>(
-        create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_));
-  } else {
-    query = create_serialize_tl_object<ton_api::tonNode_prepareZeroState>(create_tl_block_id(block_id_));
-  }
-
+  td::BufferSlice query = create_serialize_tl_object<ton_api::tonNode_downloadZeroState>(create_tl_block_id(block_id_));
   if (client_.empty()) {
-    td::actor::send_closure(overlays_, &overlay::Overlays::send_query, download_from_, local_id_, overlay_id_,
-                            "get_prepare", std::move(P), td::Timestamp::in(1.0), std::move(query));
+    td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, download_from_, local_id_, overlay_id_,
+                            "download state", std::move(P), td::Timestamp::in(3.0), std::move(query),
+                            FullNode::max_state_size(), rldp_);
   } else {
-    td::actor::send_closure(client_, &adnl::AdnlExtClient::send_query, "get_prepare",
+    td::actor::send_closure(client_, &adnl::AdnlExtClient::send_query, "download state",
                             create_serialize_tl_object_suffix<ton_api::tonNode_query>(std::move(query)),
-                            td::Timestamp::in(1.0), std::move(P));
+                            td::Timestamp::in(3.0), std::move(P));
   }
 }
 
-void DownloadState::got_block_state_description(td::BufferSlice data) {
-  auto F = fetch_tl_object<ton_api::tonNode_PreparedState>(std::move(data), true);
-  if (F.is_error()) {
-    abort_query(F.move_as_error());
-    return;
+td::Status DownloadState::set_total_size(td::Slice header) {
+  vm::BagOfCells::Info info;
+  if (info.parse_serialized_header(header) <= 0) {
+    return td::Status::Error(ErrorCode::protoviolation, "bad state: invalid bag of cells header");
   }
+  if (info.total_size == 0 || info.total_size > max_state_size()) {
+    return td::Status::Error(ErrorCode::protoviolation, PSTRING() << "bad state size " << info.total_size);
+  }
+  total_size_ = info.total_size;
+  return td::Status::OK();
+}
 
-  ton_api::downcast_call(
-      *F.move_as_ok().get(),
-      td::overloaded(
-          [&](ton_api::tonNode_notFoundState &f) {
-            abort_query(td::Status::Error(ErrorCode::notready, "state not found"));
-          },
-          [&, self = this](ton_api::tonNode_preparedState &f) {
-            if (masterchain_block_id_.is_valid()) {
-              got_block_state_part(td::BufferSlice{}, 0);
-              return;
-            }
-            auto P = td::PromiseCreator::lambda([SelfId = actor_id(self)](td::Result<td::BufferSlice> R) {
-              if (R.is_error()) {
-                td::actor::send_closure(SelfId, &DownloadState::abort_query, R.move_as_error());
-              } else {
-                td::actor::send_closure(SelfId, &DownloadState::got_block_state, R.move_as_ok());
-              }
-            });
-
-            td::BufferSlice query =
-                create_serialize_tl_object<ton_api::tonNode_downloadZeroState>(create_tl_block_id(block_id_));
-            if (client_.empty()) {
-              td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, download_from_, local_id_,
-                                      overlay_id_, "download state", std::move(P), td::Timestamp::in(3.0),
-                                      std::move(query), FullNode::max_state_size(), rldp_);
-            } else {
-              td::actor::send_closure(client_, &adnl::AdnlExtClient::send_query, "download state",
-                                      create_serialize_tl_object_suffix<ton_api::tonNode_query>(std::move(query)),
-                                      td::Timestamp::in(3.0), std::move(P));
-            }
-          }));
-}
-
-void DownloadState::got_block_state_part(td::BufferSlice data, td::uint32 requested_size) {
-  bool last_part = data.size() < requested_size;
-  sum_ += data.size();
-  parts_.push_back(std::move(data));
-
-  if (last_part) {
-    td::BufferSlice res{td::narrow_cast<std::size_t>(sum_)};
-    auto S = res.as_slice();
-    for (auto &p : parts_) {
-      S.copy_from(p.as_slice());
-      S.remove_prefix(p.size());
-    }
-    parts_.clear();
-    CHECK(!S.size());
-    got_block_state(std::move(res));
-    return;
+DownloadState::Peer *DownloadState::choose_peer(adnl::AdnlNodeIdShort exclude) {
+  // peers are tried at least once, then the fastest one is used, taking queries in flight into account;
+  // a part is not retried on the peer that failed it, unless no other peer is left
+  auto score = [](const Peer &peer) {
+    return peer.throughput < 0 ? 1e100 : peer.throughput / (1 + peer.in_flight);
+  };
+  Peer *best = nullptr;
+  for (auto &peer : peers_) {
+    if (peer.in_flight >= max_peer_queries() || (peer.id == exclude && peers_.size() > 1)) {
+      continue;
+    }
+    if (!best || score(peer) > score(*best)) {
+      best = &peer;
+    }
   }
+  return best;
+}
 
-  td::uint32 part_size = 1 << 18;
-  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), part_size](td::Result<td::BufferSlice> R) {
-    if (R.is_error()) {
-      td::actor::send_closure(SelfId, &DownloadState::abort_query, R.move_as_error());
+void DownloadState::download_parts() {
+  while (true) {
+    // the size of the state is known from the header in the first part, until then nothing else is requested
+    if (total_size_ == 0 && in_flight_ > 0) {
+      return;
+    }
+    bool retry = !retry_offsets_.empty();
+    if (!retry && total_size_ != 0 &&
+        (next_offset_ >= total_size_ ||
+         next_offset_ >= written_size_ + static_cast<td::uint64>(max_parts_ahead()) * part_size())) {
+      return;
+    }
+    auto peer = choose_peer(retry ? retry_offsets_.begin()->second : adnl::AdnlNodeIdShort::zero());
+    if (!peer) {
+      return;
+    }
+    if (retry) {
+      download_part(*peer, retry_offsets_.begin()->first);
+      retry_offsets_.erase(retry_offsets_.begin());
     } else {
-      td::actor::send_closure(SelfId, &DownloadState::got_block_state_part, R.move_as_ok(), part_size);
+      download_part(*peer, next_offset_);
+      next_offset_ += part_size();
     }
+  }
+}
+
+void DownloadState::download_part(Peer &peer, td::uint64 offset) {
+  td::uint32 size = part_size();
+  if (total_size_ != 0) {
+    size = static_cast<td::uint32>(std::min<td::uint64>(size, total_size_ - offset));
+  }
+  peer.in_flight++;
+  in_flight_++;
+
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), node = peer.id, offset, size,
+                                       started_at = td::Time::now()](td::Result<td::BufferSlice> R) {
+    td::actor::send_closure(SelfId, &DownloadState::got_block_state_part, node, offset, size, started_at,
+                            std::move(R));
   });
 
   td::BufferSlice query = create_serialize_tl_object<ton_api::tonNode_downloadPersistentStateSlice>(
-      create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_), sum_, part_size);
+      create_tl_block_id(block_id_), create_tl_block_id(masterchain_block_id_), offset, size);
   if (client_.empty()) {
-    td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, download_from_, local_id_, overlay_id_,
+    td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, peer.id, local_id_, overlay_id_,
                             "download state", std::move(P), td::Timestamp::in(10.0), std::move(query),
                             FullNode::max_state_size(), rldp_);
   } else {
@@ -222,6 +443,97 @@ void DownloadState::got_block_state_part(td::BufferSlice data, td::uint32 reques
   }
 }
 
+void DownloadState::got_block_state_part(adnl::AdnlNodeIdShort node, td::uint64 offset, td::uint32 requested_size,
+                                         double started_at, td::Result<td::BufferSlice> R) {
+  in_flight_--;
+  auto it = std::find_if(peers_.begin(), peers_.end(), [&](const Peer &peer) { return peer.id == node; });
+  if (it != peers_.end()) {
+    it->in_flight--;
+  }
+
+  if (R.is_ok() && total_size_ == 0) {
+    CHECK(offset == 0);
+    auto S = set_total_size(R.ok().as_slice());
+    if (S.is_error()) {
+      R = std::move(S);
+    }
+  }
+  if (R.is_ok() && R.ok().size() != std::min<td::uint64>(requested_size, total_size_ - offset)) {
+    R = td::Status::Error(ErrorCode::protoviolation, "bad state part size");
+  }
+
+  if (R.is_error()) {
+    VLOG(FULL_NODE_DEBUG) << "failed to download part " << offset << " of state " << block_id_ << " from " << node
+                          << ": " << R.error();
+    retry_offsets_[offset] = node;
+    if (it != peers_.end() && ++it->failures >= max_peer_failures()) {
+      peers_.erase(it);
+      if (peers_.empty() && pending_descriptions_ == 0) {
+        abort_query(R.move_as_error());
+        return;
+      }
+    }
+    download_parts();
+    return;
+  }
+
+  auto data = R.move_as_ok();
+  if (it != peers_.end()) {
+    double throughput = static_cast<double>(data.size()) / std::max(td::Time::now() - started_at, 1e-3);
+    it->throughput = it->throughput < 0 ? throughput : 0.8 * it->throughput + 0.2 * throughput;
+  }
+  parts_.emplace(offset, std::move(data));
+
+  write_parts();
+  download_parts();
+}
+
+void DownloadState::write_parts() {
+  while (!parts_.empty() && parts_.begin()->first == queued_size_) {
+    auto data = std::move(parts_.begin()->second);
+    parts_.erase(parts_.begin());
+    auto offset = queued_size_;
+    auto size = data.size();
+    queued_size_ += size;
+    // a synced prefix survives a restart, so it is not downloaded again
+    bool sync = queued_size_ >= synced_size_ + (1 << 26) || queued_size_ == total_size_;
+    if (sync) {
+      synced_size_ = queued_size_;
+    }
+
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), size](td::Result<td::Unit> R) {
+      if (R.is_error()) {
+        td::actor::send_closure(SelfId, &DownloadState::abort_query,
+                                R.move_as_error_prefix("failed to write part file: "));
+      } else {
+        td::actor::send_closure(SelfId, &DownloadState::written_part, size);
+      }
+    });
+    td::actor::send_closure(part_file_, &StatePartFile::write, offset, std::move(data), sync, std::move(P));
+  }
+}
+
+void DownloadState::written_part(td::uint64 size) {
+  written_size_ += size;
+  if (written_size_ == total_size_) {
+    finish_download();
+    return;
+  }
+  download_parts();
+}
+
+void DownloadState::finish_download() {
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::BufferSlice> R) {
+    if (R.is_error()) {
+      td::actor::send_closure(SelfId, &DownloadState::abort_query,
+                              R.move_as_error_prefix("failed to read part file: "));
+    } else {
+      td::actor::send_closure(SelfId, &DownloadState::got_block_state, R.move_as_ok());
+    }
+  });
+  td::actor::send_closure(part_file_, &StatePartFile::read, total_size_, std::move(P));
+}
+
 void DownloadState::got_block_state(td::BufferSlice data) {
   state_ = std::move(data);
   finish_query();
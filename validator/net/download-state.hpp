@@ -24,20 +24,54 @@
 #include "rldp/rldp.h"
 #include "adnl/adnl-ext-client.h"
 
+#include "td/utils/port/FileFd.h"
+
+#include <map>
+
 namespace ton {
 
 namespace validator {
 
 namespace fullnode {
 
+// The file a persistent state is downloaded to. It starts with the size of the prefix of the state that is synced to
+// disk, so that only this prefix is trusted when the download is resumed. The file is accessed by this actor only,
+// off the thread of DownloadState.
+class StatePartFile : public td::actor::Actor {
+ public:
+  StatePartFile(std::string tmp_dir, BlockIdExt block_id, BlockIdExt masterchain_block_id);
+
+  // returns the synced size and the beginning of the synced data, which holds the header of the bag of cells
+  void open(td::Promise<std::pair<td::uint64, td::BufferSlice>> promise);
+  void reset(td::Promise<td::Unit> promise);
+  void write(td::uint64 offset, td::BufferSlice data, bool sync, td::Promise<td::Unit> promise);
+  // reads the state and deletes the file
+  void read(td::uint64 size, td::Promise<td::BufferSlice> promise);
+
+  static constexpr td::uint64 header_size() {
+    return 8;
+  }
+
+ private:
+  std::string tmp_dir_;
+  std::string prefix_;
+  std::string name_;
+  td::FileFd fd_;
+
+  void remove_stale_files();
+  td::Status write_synced_size(td::uint64 size);
+};
+
+// Persistent states are downloaded in slices from several peers at once. Slices are written to a StatePartFile in
+// tmp_dir in order, so that an interrupted download is resumed from the last synced offset.
 class DownloadState : public td::actor::Actor {
  public:
-  DownloadState(BlockIdExt block_id, BlockIdExt masterchain_block_id, adnl::AdnlNodeIdShort local_id,
-                overlay::OverlayIdShort overlay_id, adnl::AdnlNodeIdShort download_from, td::uint32 priority,
-                td::Timestamp timeout, td::actor::ActorId<ValidatorManagerInterface> validator_manager,
-                td::actor::ActorId<rldp::Rldp> rldp, td::actor::ActorId<overlay::Overlays> overlays,
-                td::actor::ActorId<adnl::Adnl> adnl, td::actor::ActorId<adnl::AdnlExtClient> client,
-                td::Promise<td::BufferSlice> promise);
+  DownloadState(BlockIdExt block_id, BlockIdExt masterchain_block_id, std::string tmp_dir,
+                adnl::AdnlNodeIdShort local_id, overlay::OverlayIdShort overlay_id,
+                adnl::AdnlNodeIdShort download_from, td::uint32 priority, td::Timestamp timeout,
+                td::actor::ActorId<ValidatorManagerInterface> validator_manager, td::actor::ActorId<rldp::Rldp> rldp,
+                td::actor::ActorId<overlay::Overlays> overlays, td::actor::ActorId<adnl::Adnl> adnl,
+                td::actor::ActorId<adnl::AdnlExtClient> client, td::Promise<td::BufferSlice> promise);
 
   void abort_query(td::Status reason);
   void alarm() override;
@@ -45,14 +79,47 @@ class DownloadState : public td::actor::Actor {
 
   void start_up() override;
   void got_block_handle(BlockHandle handle);
-  void got_node_to_download(adnl::AdnlNodeIdShort node);
-  void got_block_state_description(td::BufferSlice data_description);
-  void got_block_state_part(td::BufferSlice data, td::uint32 requested_size);
+  void got_part_file(td::uint64 size, td::BufferSlice header);
+  void got_nodes_to_download(std::vector<adnl::AdnlNodeIdShort> nodes);
+  void got_block_state_description(adnl::AdnlNodeIdShort node, td::BufferSlice data_description);
+  void failed_block_state_description(adnl::AdnlNodeIdShort node, td::Status reason);
+  void got_block_state_part(adnl::AdnlNodeIdShort node, td::uint64 offset, td::uint32 requested_size,
+                            double started_at, td::Result<td::BufferSlice> R);
+  void written_part(td::uint64 size);
   void got_block_state(td::BufferSlice data);
 
+  static constexpr td::uint32 part_size() {
+    return 1 << 18;
+  }
+  static constexpr td::uint32 max_peers() {
+    return 4;
+  }
+  static constexpr td::uint32 max_peer_queries() {
+    return 2;
+  }
+  // parts after a missing one are kept in memory until it arrives, but no more than this many
+  static constexpr td::uint32 max_parts_ahead() {
+    return 64;
+  }
+  static constexpr td::uint32 max_peer_failures() {
+    return 3;
+  }
+  // a state is downloaded in slices, so it is not bound by FullNode::max_state_size(), the limit of one answer
+  static constexpr td::uint64 max_state_size() {
+    return 1ull << 40;
+  }
+
  private:
+  struct Peer {
+    adnl::AdnlNodeIdShort id;
+    td::uint32 in_flight = 0;
+    td::uint32 failures = 0;
+    double throughput = -1;  // bytes per second, negative if unknown
+  };
+
   BlockIdExt block_id_;
   BlockIdExt masterchain_block_id_;
+  std::string tmp_dir_;
   adnl::AdnlNodeIdShort local_id_;
   overlay::OverlayIdShort overlay_id_;
 
@@ -70,8 +137,29 @@ class DownloadState : public td::actor::Actor {
 
   BlockHandle handle_;
   td::BufferSlice state_;
-  std::vector<td::BufferSlice> parts_;
-  td::uint64 sum_ = 0;
+
+  std::vector<Peer> peers_;
+  td::uint32 pending_descriptions_ = 0;
+  bool downloading_zero_state_ = false;
+
+  td::actor::ActorOwn<StatePartFile> part_file_;
+  td::uint64 total_size_ = 0;    // 0 until the header of the bag of cells is received
+  td::uint64 queued_size_ = 0;   // passed to the part file
+  td::uint64 written_size_ = 0;  // written by the part file
+  td::uint64 synced_size_ = 0;
+  td::uint64 next_offset_ = 0;
+  std::map<td::uint64, adnl::AdnlNodeIdShort> retry_offsets_;  // the peer that failed to download the part
+  std::map<td::uint64, td::BufferSlice> parts_;
+  td::uint32 in_flight_ = 0;
+
+  void get_nodes_to_download();
+  void download_zero_state(adnl::AdnlNodeIdShort node);
+  td::Status set_total_size(td::Slice header);
+  Peer *choose_peer(adnl::AdnlNodeIdShort exclude);
+  void download_parts();
+  void download_part(Peer &peer, td::uint64 offset);
+  void write_parts();
+  void finish_download();
 };
 
 }  // namespace fullnode
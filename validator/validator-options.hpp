@@ -108,6 +108,33 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   BlockSeqno sync_upto() const override {
     return sync_upto_;
   }
+  td::uint64 celldb_cache_size() const override {
+    return celldb_cache_size_;
+  }
+  td::uint32 celldb_commit_threads() const override {
+    return celldb_commit_threads_;
+  }
+  td::uint32 celldb_read_threads() const override {
+    return celldb_read_threads_;
+  }
+  td::uint32 celldb_prefetch_threads() const override {
+    return celldb_prefetch_threads_;
+  }
+  td::uint32 state_deserialize_threads() const override {
+    return state_deserialize_threads_;
+  }
+  td::uint32 collator_threads() const override {
+    return collator_threads_;
+  }
+  td::uint32 validate_threads() const override {
+    return validate_threads_;
+  }
+  const td::RocksDbOptions &celldb_rocksdb_options() const override {
+    return celldb_rocksdb_options_;
+  }
+  const td::RocksDbOptions &archive_rocksdb_options() const override {
+    return archive_rocksdb_options_;
+  }
 
   void set_zero_block_id(BlockIdExt block_id) override {
     zero_block_id_ = block_id;
@@ -154,6 +181,33 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_sync_upto(BlockSeqno seqno) override {
     sync_upto_ = seqno;
   }
+  void set_celldb_cache_size(td::uint64 value) override {
+    celldb_cache_size_ = value;
+  }
+  void set_celldb_commit_threads(td::uint32 value) override {
+    celldb_commit_threads_ = value;
+  }
+  void set_celldb_read_threads(td::uint32 value) override {
+    celldb_read_threads_ = value;
+  }
+  void set_celldb_prefetch_threads(td::uint32 value) override {
+    celldb_prefetch_threads_ = value;
+  }
+  void set_state_deserialize_threads(td::uint32 value) override {
+    state_deserialize_threads_ = value;
+  }
+  void set_collator_threads(td::uint32 value) override {
+    collator_threads_ = value;
+  }
+  void set_validate_threads(td::uint32 value) override {
+    validate_threads_ = value;
+  }
+  void set_celldb_rocksdb_options(td::RocksDbOptions value) override {
+    celldb_rocksdb_options_ = std::move(value);
+  }
+  void set_archive_rocksdb_options(td::RocksDbOptions value) override {
+    archive_rocksdb_options_ = std::move(value);
+  }
 
   ValidatorManagerOptionsImpl *make_copy() const override {
     return new ValidatorManagerOptionsImpl(*this);
@@ -193,6 +247,15 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   std::map<CatchainSeqno, std::pair<BlockSeqno, td::uint32>> unsafe_catchain_rotates_;
   BlockSeqno truncate_{0};
   BlockSeqno sync_upto_{0};
+  td::uint64 celldb_cache_size_{0};
+  td::uint32 celldb_commit_threads_{0};
+  td::uint32 celldb_read_threads_{0};
+  td::uint32 celldb_prefetch_threads_{0};
+  td::uint32 state_deserialize_threads_{1};
+  td::uint32 collator_threads_{1};
+  td::uint32 validate_threads_{1};
+  td::RocksDbOptions celldb_rocksdb_options_ = td::RocksDbOptions::cell_db();
+  td::RocksDbOptions archive_rocksdb_options_ = td::RocksDbOptions::archive_index();
 };
 
 }  // namespace validator
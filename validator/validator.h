@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "td/actor/actor.h"
+#include "td/db/RocksDbOptions.h"
 
 #include "ton/ton-types.h"
 
@@ -72,6 +73,15 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual bool need_db_truncate() const = 0;
   virtual BlockSeqno get_truncate_seqno() const = 0;
   virtual BlockSeqno sync_upto() const = 0;
+  virtual td::uint64 celldb_cache_size() const = 0;
+  virtual td::uint32 celldb_commit_threads() const = 0;
+  virtual td::uint32 celldb_read_threads() const = 0;
+  virtual td::uint32 celldb_prefetch_threads() const = 0;
+  virtual td::uint32 state_deserialize_threads() const = 0;
+  virtual td::uint32 collator_threads() const = 0;
+  virtual td::uint32 validate_threads() const = 0;
+  virtual const td::RocksDbOptions &celldb_rocksdb_options() const = 0;
+  virtual const td::RocksDbOptions &archive_rocksdb_options() const = 0;
 
   virtual void set_zero_block_id(BlockIdExt block_id) = 0;
   virtual void set_init_block_id(BlockIdExt block_id) = 0;
@@ -89,6 +99,15 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual void add_unsafe_catchain_rotate(BlockSeqno seqno, CatchainSeqno cc_seqno, td::uint32 value) = 0;
   virtual void truncate_db(BlockSeqno seqno) = 0;
   virtual void set_sync_upto(BlockSeqno seqno) = 0;
+  virtual void set_celldb_cache_size(td::uint64 value) = 0;
+  virtual void set_celldb_commit_threads(td::uint32 value) = 0;
+  virtual void set_celldb_read_threads(td::uint32 value) = 0;
+  virtual void set_celldb_prefetch_threads(td::uint32 value) = 0;
+  virtual void set_state_deserialize_threads(td::uint32 value) = 0;
+  virtual void set_collator_threads(td::uint32 value) = 0;
+  virtual void set_validate_threads(td::uint32 value) = 0;
+  virtual void set_celldb_rocksdb_options(td::RocksDbOptions value) = 0;
+  virtual void set_archive_rocksdb_options(td::RocksDbOptions value) = 0;
 
   static td::Ref<ValidatorManagerOptions> create(
       BlockIdExt zero_block_id, BlockIdExt init_block_id,
@@ -119,7 +138,8 @@ class ValidatorManagerInterface : public td::actor::Actor {
     virtual void download_zero_state(BlockIdExt block_id, td::uint32 priority, td::Timestamp timeout,
                                      td::Promise<td::BufferSlice> promise) = 0;
     virtual void download_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::uint32 priority,
-                                           td::Timestamp timeout, td::Promise<td::BufferSlice> promise) = 0;
+                                           std::string tmp_dir, td::Timestamp timeout,
+                                           td::Promise<td::BufferSlice> promise) = 0;
     virtual void download_block_proof(BlockIdExt block_id, td::uint32 priority, td::Timestamp timeout,
                                       td::Promise<td::BufferSlice> promise) = 0;
     virtual void download_block_proof_link(BlockIdExt block_id, td::uint32 priority, td::Timestamp timeout,